@@ -17,7 +17,7 @@ using namespace std;
 SuffixArray::SuffixArray()
   : m_array(NULL),
     m_index(NULL),
-    m_buffer(NULL),
+    m_lcp(NULL),
     m_wordInSentence(NULL),
     m_sentence(NULL),
     m_sentenceLength(NULL),
@@ -32,8 +32,6 @@ SuffixArray::SuffixArray()
 
 SuffixArray::~SuffixArray()
 {
-  free(m_array);
-  free(m_index);
   free(m_wordInSentence);
   free(m_sentence);
   free(m_sentenceLength);
@@ -81,13 +79,10 @@ void SuffixArray::Create(const string& fileName )
   }
 
   // allocate memory
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  m_arrayBuffer.resize( m_size );
   m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
   m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
   m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
-  CheckAllocation(m_array != NULL, "m_array");
-  CheckAllocation(m_index != NULL, "m_index");
   CheckAllocation(m_wordInSentence != NULL, "m_wordInSentence");
   CheckAllocation(m_sentence != NULL, "m_sentence");
   CheckAllocation(m_sentenceLength != NULL, "m_sentenceLength");
@@ -115,30 +110,68 @@ void SuffixArray::Create(const string& fileName )
     vector< WORD_ID >::const_iterator i;
 
     for( i=words.begin(); i!=words.end(); i++) {
-      m_index[ wordIndex ] = wordIndex;
       m_sentence[ wordIndex ] = sentenceId;
       m_wordInSentence[ wordIndex ] = i-words.begin();
-      m_array[ wordIndex++ ] = *i;
+      m_arrayBuffer[ wordIndex++ ] = *i;
     }
-    m_index[ wordIndex ] = wordIndex;
-    m_array[ wordIndex++ ] = m_endOfSentence;
+    m_arrayBuffer[ wordIndex++ ] = m_endOfSentence;
     m_sentenceLength[ sentenceId++ ] = words.size();
   }
   textFile.close();
   cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
   // List(0,9);
 
-  // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  m_array = m_arrayBuffer.empty() ? NULL : &m_arrayBuffer[0];
 
-  if (m_buffer == NULL) {
-    cerr << "Error: cannot allocate memory to m_buffer" << endl;
-    exit(1);
+  Index();
+  cerr << "done sorting" << endl;
+}
+
+// build suffix array and LCP array, ordering words by their strings
+void SuffixArray::Index()
+{
+  util::RankVocabulary( m_vcb.vocab, m_rank );
+  vector< WORD_ID > ranked( m_size );
+  for( INDEX i=0; i<m_size; i++ ) {
+    ranked[i] = m_rank[ m_array[i] ];
+  }
+  m_indexBuffer.resize( m_size );
+  m_lcpBuffer.resize( m_size );
+  if (m_size) {
+    util::BuildSuffixArray( &ranked[0], m_size, m_rank.size(), &m_indexBuffer[0] );
+    util::BuildLCP( &ranked[0], m_size, &m_indexBuffer[0], &m_lcpBuffer[0] );
   }
+  m_index = m_indexBuffer.empty() ? NULL : &m_indexBuffer[0];
+  m_lcp = m_lcpBuffer.empty() ? NULL : &m_lcpBuffer[0];
+}
 
-  Sort( 0, m_size-1 );
-  free( m_buffer );
-  cerr << "done sorting" << endl;
+// recover sentence boundaries and positions from the corpus
+void SuffixArray::IndexSentences()
+{
+  m_sentenceCount = 0;
+  for( INDEX i=0; i<m_size; i++ ) {
+    if (m_array[i] == m_endOfSentence) {
+      m_sentenceCount++;
+    }
+  }
+  m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
+  m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
+  CheckAllocation(m_wordInSentence != NULL, "m_wordInSentence");
+  CheckAllocation(m_sentence != NULL, "m_sentence");
+  CheckAllocation(m_sentenceLength != NULL, "m_sentenceLength");
+
+  INDEX sentenceId = 0;
+  INDEX sentenceStart = 0;
+  for( INDEX i=0; i<m_size; i++ ) {
+    if (m_array[i] == m_endOfSentence) {
+      m_sentenceLength[ sentenceId++ ] = i - sentenceStart;
+      sentenceStart = i+1;
+    } else {
+      m_sentence[i] = sentenceId;
+      m_wordInSentence[i] = i - sentenceStart;
+    }
+  }
 }
 
 // very specific code to deal with common crawl document ids
@@ -180,54 +213,11 @@ bool SuffixArray::ProcessDocumentLine( const char *line, const size_t sentenceId
   return true;
 }
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
-{
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  INDEX i = start;
-  INDEX j = mid;
-  INDEX k = 0;
-  INDEX length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
-    }
-  }
-
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
-}
-
-int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
-{
-  // skip over identical words
-  INDEX offset = 0;
-  while( a+offset < m_size &&
-         b+offset < m_size &&
-         m_array[ a+offset ] == m_array[ b+offset ] ) {
-    offset++;
-  }
-
-  if( a+offset == m_size ) return -1;
-  if( b+offset == m_size ) return 1;
-  return CompareWord( m_array[ a+offset ], m_array[ b+offset ] );
-}
-
 inline int SuffixArray::CompareWord( WORD_ID a, WORD_ID b ) const
 {
+  if (a < m_rank.size() && b < m_rank.size()) {
+    return (m_rank[a] < m_rank[b]) ? -1 : (m_rank[a] > m_rank[b]) ? 1 : 0;
+  }
   return m_vcb.GetWord(a).compare( m_vcb.GetWord(b) );
 }
 
@@ -284,10 +274,9 @@ SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX st
     INDEX mid = ( start + end + (direction>0 ? 0 : 1) )/2;
 
     int match = Match( phrase, mid );
-    int matchNext = Match( phrase, mid+direction );
-    //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << "," << matchNext << endl;
+    //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << endl;
 
-    if (match == 0 && matchNext != 0) return mid;
+    if (match == 0 && !NextMatches( phrase.size(), mid, direction )) return mid;
 
     if (match == 0) // mid point is a match
       start = mid;
@@ -313,6 +302,16 @@ SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &
   }
 }
 
+// given that the suffix at index matches a phrase, does its neighbour in
+// direction match too?  The LCP array answers that without comparing words.
+bool SuffixArray::NextMatches( size_t phraseLength, INDEX index, int direction ) const
+{
+  if (direction > 0) {
+    return index+1 < m_size && m_lcp[ index+1 ] >= phraseLength;
+  }
+  return index > 0 && m_lcp[ index ] >= phraseLength;
+}
+
 int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
 {
   INDEX pos = m_index[ index ];
@@ -400,100 +399,72 @@ SuffixArray::INDEX SuffixArray::GetDocument( INDEX sentence ) const
   }
 }
 
+// The corpus, suffix array and LCP array go into a persistent index (see
+// util/suffix_array.hh) that Load() maps and moses' fuzzy-match can read;
+// the optional document index goes into fileName.doc
 void SuffixArray::Save(const string& fileName ) const
 {
-  FILE *pFile = fopen ( fileName.c_str() , "w" );
-  if (pFile == NULL) Error("cannot open",fileName);
+  util::SuffixArrayFile::Write( fileName.c_str(), m_vcb.vocab, m_array, m_index, m_lcp, m_size );
 
-  fwrite( &m_size, sizeof(INDEX), 1, pFile );
-  fwrite( m_array, sizeof(WORD_ID), m_size, pFile ); // corpus
-  fwrite( m_index, sizeof(INDEX), m_size, pFile );   // suffix array
-  fwrite( m_wordInSentence, sizeof(char), m_size, pFile); // word index
-  fwrite( m_sentence, sizeof(INDEX), m_size, pFile); // sentence index
-
-  fwrite( &m_sentenceCount, sizeof(INDEX), 1, pFile );
-  fwrite( m_sentenceLength, sizeof(char), m_sentenceCount, pFile); // sentence length
-
-  char useDocument = m_useDocument; // not sure if that is needed
-  fwrite( &useDocument, sizeof(char), 1, pFile );
   if (m_useDocument) {
+    string docFileName = fileName + ".doc";
+    FILE *pFile = fopen ( docFileName.c_str() , "w" );
+    if (pFile == NULL) Error("cannot open",docFileName);
     fwrite( &m_documentCount, sizeof(INDEX), 1, pFile );
     fwrite( m_document, sizeof(INDEX), m_documentCount, pFile );
     fwrite( m_documentName, sizeof(INDEX), m_documentCount, pFile );
     fwrite( &m_documentNameLength, sizeof(INDEX), 1, pFile );
     fwrite( m_documentNameBuffer, sizeof(char), m_documentNameLength, pFile );
+    fclose( pFile );
   }
-  fclose( pFile );
-
-  m_vcb.Save( fileName + ".src-vcb" );
 }
 
 void SuffixArray::Load(const string& fileName )
 {
-  FILE *pFile = fopen ( fileName.c_str() , "r" );
-  if (pFile == NULL) Error("no such file or directory", fileName);
-
   cerr << "loading from " << fileName << endl;
-
-  fread( &m_size, sizeof(INDEX), 1, pFile )
-  || Error("could not read m_size from", fileName);
+  if (!util::SuffixArrayFile::Recognize( fileName.c_str() )) {
+    Error("not a suffix array index (re-create it with --save):", fileName);
+  }
+  m_file.reset( new util::SuffixArrayFile( fileName.c_str() ) );
+  for( size_t i=0; i<m_file->VocabSize(); i++ ) {
+    m_vcb.StoreIfNew( m_file->Word( i ).as_string() );
+  }
+  m_endOfSentence = m_vcb.GetWordID( "<s>" );
+  util::RankVocabulary( m_vcb.vocab, m_rank );
+  m_size = m_file->Size();
+  m_array = m_file->Text();
+  m_index = m_file->Array();
+  m_lcp = m_file->LCP();
   cerr << "words in corpus: " << m_size << endl;
 
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
-  m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  CheckAllocation(m_array != NULL, "m_array");
-  CheckAllocation(m_index != NULL, "m_index");
-  CheckAllocation(m_wordInSentence != NULL, "m_wordInSentence");
-  CheckAllocation(m_sentence != NULL, "m_sentence");
-  fread( m_array, sizeof(WORD_ID), m_size, pFile ) // corpus
-  || Error("could not read m_array from", fileName);
-  fread( m_index, sizeof(INDEX), m_size, pFile )   // suffix array
-  || Error("could not read m_index from", fileName);
-  fread( m_wordInSentence, sizeof(char), m_size, pFile) // word index
-  || Error("could not read m_wordInSentence from", fileName);
-  fread( m_sentence, sizeof(INDEX), m_size, pFile ) // sentence index
-  || Error("could not read m_sentence from", fileName);
-
-  fread( &m_sentenceCount, sizeof(INDEX), 1, pFile )
-  || Error("could not read m_sentenceCount from", fileName);
+  IndexSentences();
   cerr << "sentences in corpus: " << m_sentenceCount << endl;
 
-  m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
-  CheckAllocation(m_sentenceLength != NULL, "m_sentenceLength");
-  fread( m_sentenceLength, sizeof(char), m_sentenceCount, pFile) // sentence length
-  || Error("could not read m_sentenceLength from", fileName);
-
   if (m_useDocument) { // do not read it when you do not need it
-    char useDocument;
-    fread( &useDocument, sizeof(char), 1, pFile )
-    || Error("could not read m_useDocument from", fileName);
-    if (!useDocument) {
+    string docFileName = fileName + ".doc";
+    FILE *pFile = fopen ( docFileName.c_str() , "r" );
+    if (pFile == NULL) {
       cerr << "Error: stored suffix array does not have a document index\n";
       exit(1);
     }
     fread( &m_documentCount, sizeof(INDEX), 1, pFile )
-    || Error("could not read m_documentCount from", fileName);
+    || Error("could not read m_documentCount from", docFileName);
     m_document = (INDEX*) calloc( sizeof( INDEX ), m_documentCount );
     m_documentName = (INDEX*) calloc( sizeof( INDEX ), m_documentCount );
     CheckAllocation(m_document != NULL, "m_document");
     CheckAllocation(m_documentName != NULL, "m_documentName");
     fread( m_document, sizeof(INDEX), m_documentCount, pFile )
-    || Error("could not read m_document from", fileName);
+    || Error("could not read m_document from", docFileName);
     fread( m_documentName, sizeof(INDEX), m_documentCount, pFile )
-    || Error("could not read m_documentName from", fileName);
+    || Error("could not read m_documentName from", docFileName);
     fread( &m_documentNameLength, sizeof(INDEX), 1, pFile )
-    || Error("could not read m_documentNameLength from", fileName);
+    || Error("could not read m_documentNameLength from", docFileName);
     m_documentNameBuffer = (char*) calloc( sizeof( char ), m_documentNameLength );
     CheckAllocation(m_documentNameBuffer != NULL, "m_documentNameBuffer");
     fread( m_documentNameBuffer, sizeof(char), m_documentNameLength, pFile )
-    || Error("could not read m_document from", fileName);
+    || Error("could not read m_document from", docFileName);
+    fclose( pFile );
   }
-
-  fclose( pFile );
-
-  m_vcb.Load( fileName + ".src-vcb" );
 }
 
 void SuffixArray::CheckAllocation( bool check, const char *dataStructure ) const
@@ -2,15 +2,26 @@
 
 #include "Vocabulary.h"
 
+#include <boost/scoped_ptr.hpp>
+
+#include "util/suffix_array.hh"
+
 class SuffixArray
 {
 public:
   typedef unsigned int INDEX;
 
 private:
-  WORD_ID *m_array;
-  INDEX *m_index;
-  INDEX *m_buffer;
+  // corpus, suffix array and LCP array: mapped by Load() or built by Create()
+  boost::scoped_ptr< util::SuffixArrayFile > m_file;
+  std::vector< WORD_ID > m_arrayBuffer;
+  std::vector< INDEX > m_indexBuffer;
+  std::vector< INDEX > m_lcpBuffer;
+  const WORD_ID *m_array;
+  const INDEX *m_index;
+  const INDEX *m_lcp;
+  // rank of each word id in string order, for comparing words as integers
+  std::vector< WORD_ID > m_rank;
   char *m_wordInSentence;
   INDEX *m_sentence;
   char *m_sentenceLength;
@@ -35,8 +46,8 @@ public:
 
   void Create(const std::string& fileName );
   bool ProcessDocumentLine( const char* const, const size_t );
-  void Sort(INDEX start, INDEX end);
-  int CompareIndex( INDEX a, INDEX b ) const;
+  void Index();
+  void IndexSentences();
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
   bool MinCount( const std::vector< WORD > &phrase, INDEX min );
@@ -45,6 +56,7 @@ public:
   int LimitedCount( const std::vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = -1, INDEX search_end = 0 );
   INDEX FindFirst( const std::vector< WORD > &phrase, INDEX &start, INDEX &end );
   INDEX FindLast( const std::vector< WORD > &phrase, INDEX start, INDEX end, int direction );
+  bool NextMatches( size_t phraseLength, INDEX index, int direction ) const;
   int Match( const std::vector< WORD > &phrase, INDEX index );
   void List( INDEX start, INDEX end );
   void PrintSentenceMatches( const std::vector< WORD > &phrase );
@@ -6,9 +6,12 @@
 #include <vector>
 #include <algorithm>
 #include <cstring>
+#include <cctype>
 #include <set>
 #include <glib.h>
 #include <stdexcept>
+#include <deque>
+#include <chrono>
 #include <boost/thread.hpp>
 
 namespace { // anonymous namespace
@@ -424,6 +427,160 @@ split(const std::string& in)
     return outv;
 }
 
+
+// unicode classes of the ascii range, looked up without calling glib
+struct AsciiTypes {
+    GUnicodeType types[0x80];
+
+    AsciiTypes() {
+        for (gunichar uch = 0; uch < 0x80; ++uch)
+            types[uch] = g_unichar_type(uch);
+    }
+};
+
+const AsciiTypes ASCII_TYPES;
+
+inline GUnicodeType
+unichar_type(gunichar uch) {
+    return uch < 0x80 ? ASCII_TYPES.types[uch] : g_unichar_type(uch);
+}
+
+
+// per-thread line buffers of quik_tokenize, reused from line to line
+thread_local std::vector<gunichar> ucs4_buf;
+thread_local std::vector<gunichar> token_buf;
+
+
+//
+// decode utf8 into buf as g_utf8_to_ucs4_fast does, followed by two zeros,
+// returns the number of characters; plain ascii is widened without glib
+//
+inline glong
+utf8_to_ucs4(const char *pt, const char *ep, std::vector<gunichar>& buf)
+{
+    const char *np = pt;
+    while (np < ep && *np && !(*np & 0x80))
+        ++np;
+    glong ulen = 0;
+    if (np == ep) {
+        ulen = ep - pt;
+        if (buf.size() < std::size_t(ulen) + 2)
+            buf.resize(ulen + 2);
+        std::copy((const unsigned char *)pt,(const unsigned char *)ep,buf.begin());
+    } else {
+        gunichar *gbuf = g_utf8_to_ucs4_fast((const gchar *)pt,ep - pt,&ulen); // g_free
+        if (buf.size() < std::size_t(ulen) + 2)
+            buf.resize(ulen + 2);
+        std::copy(gbuf,gbuf + ulen,buf.begin());
+        g_free(gbuf);
+    }
+    buf[ulen] = buf[ulen+1] = 0;
+    return ulen;
+}
+
+
+//
+// append ucs4 characters as utf8, as g_ucs4_to_utf8 does
+//
+inline void
+ucs4_to_utf8(const gunichar *pt, const gunichar *ep, std::string& outs)
+{
+    for ( ; pt < ep; ++pt) {
+        gunichar uch = *pt;
+        if (uch < 0x80) {
+            outs.push_back(char(uch));
+            continue;
+        }
+        char bytes[6];
+        int len;
+        gunichar first;
+        if (uch < 0x800) {
+            first = 0xc0;
+            len = 2;
+        } else if (uch < 0x10000) {
+            first = 0xe0;
+            len = 3;
+        } else if (uch < 0x200000) {
+            first = 0xf0;
+            len = 4;
+        } else if (uch < 0x4000000) {
+            first = 0xf8;
+            len = 5;
+        } else {
+            first = 0xfc;
+            len = 6;
+        }
+        for (int ii = len - 1; ii > 0; --ii) {
+            bytes[ii] = char((uch & 0x3f) | 0x80);
+            uch >>= 6;
+        }
+        bytes[0] = char(uch | first);
+        outs.append(bytes,len);
+    }
+}
+
+
+// a chunk of lines passed from the reader to the workers and on to the writer
+struct LineChunk {
+    std::vector<std::string> lines;
+    std::vector<std::string> results;
+    std::size_t size;
+    bool done_p;
+
+    LineChunk() : size(0), done_p(true) {}
+};
+
+
+// bounded by the chunks the reader owns, so needs no limit of its own
+class LineChunkQueue {
+    boost::mutex mutex;
+    boost::condition_variable todo_cond;
+    boost::condition_variable done_cond;
+    std::deque<LineChunk *> todo;
+    bool stop_p;
+
+public:
+
+    LineChunkQueue() : stop_p(false) {}
+
+    void push(LineChunk *chunk) {
+        boost::mutex::scoped_lock lock(mutex);
+        chunk->done_p = false;
+        todo.push_back(chunk);
+        todo_cond.notify_one();
+    }
+
+    // returns 0 once stopped and empty
+    LineChunk *pop() {
+        boost::mutex::scoped_lock lock(mutex);
+        while (todo.empty() && !stop_p)
+            todo_cond.wait(lock);
+        if (todo.empty())
+            return 0;
+        LineChunk *chunk = todo.front();
+        todo.pop_front();
+        return chunk;
+    }
+
+    void finish(LineChunk *chunk) {
+        boost::mutex::scoped_lock lock(mutex);
+        chunk->done_p = true;
+        done_cond.notify_all();
+    }
+
+    void wait(LineChunk *chunk) {
+        boost::mutex::scoped_lock lock(mutex);
+        while (!chunk->done_p)
+            done_cond.wait(lock);
+    }
+
+    void stop() {
+        boost::mutex::scoped_lock lock(mutex);
+        stop_p = true;
+        todo_cond.notify_all();
+    }
+};
+
 }; // end anonymous namespace
 
 
@@ -911,10 +1068,10 @@ Tokenizer::penn_tokenize(const std::string& buf)
 }
 
 
-std::string
-Tokenizer::quik_tokenize(const std::string& buf)
+void
+Tokenizer::quik_tokenize(const std::string& buf, std::string& text)
 {
-    std::string text(buf);
+    text.assign(buf);
     size_t pos;
     int num = 0;
 
@@ -922,20 +1079,18 @@ Tokenizer::quik_tokenize(const std::string& buf)
 
     // push all the prefixes matching protected patterns
     std::vector<std::string> prot_stack;
-    std::string match;
+    re2::StringPiece match;
 
     for (auto& pat : prot_pat_vec) {
         pos = 0;
-        while (RE2::PartialMatch(text.substr(pos),*pat,&match)) {
-            pos = text.find(match,pos);
-            if (pos == std::string::npos)
-                break;
+        while (RE2::PartialMatch(re2::StringPiece(text.data()+pos,text.size()-pos),*pat,&match)) {
+            pos = match.data() - text.data();
             size_t len = match.size();
             if (text[pos-1] == ' ' || text[pos-1] == '\'' || text[pos-1] == '`'|| text[pos-1] == '"') {
                 char subst[32];
                 int nsubst = snprintf(subst,sizeof(subst)," THISISPROTECTED%.3d ",num++);
+                prot_stack.push_back(match.as_string());
                 text.replace(pos,len,subst,nsubst);
-                prot_stack.push_back(match);
                 pos += nsubst;
             } else {
                 pos += len;
@@ -947,13 +1102,14 @@ Tokenizer::quik_tokenize(const std::string& buf)
     const char *ep(pt + text.size());
     while (pt < ep && *pt >= 0 && *pt <= ' ')
         ++pt;
-    glong ulen(0);
-    gunichar *usrc(g_utf8_to_ucs4_fast((const gchar *)pt,ep - pt, &ulen)); // g_free
-    gunichar *ucs4(usrc);
+    glong ulen(utf8_to_ucs4(pt,ep,ucs4_buf));
+    gunichar *ucs4(ucs4_buf.data());
     gunichar *lim4(ucs4 + ulen);
 
     gunichar *nxt4 = ucs4;
-    gunichar *ubuf(g_new0(gunichar,ulen*6+1)); // g_free
+    if (token_buf.size() < std::size_t(ulen)*6+1)
+        token_buf.resize(ulen*6+1);
+    gunichar *ubuf(token_buf.data());
     gunichar *uptr(ubuf);
 
     gunichar prev_uch(0);
@@ -961,7 +1117,7 @@ Tokenizer::quik_tokenize(const std::string& buf)
     gunichar curr_uch(0);
 
     GUnicodeType curr_type(G_UNICODE_UNASSIGNED);
-    GUnicodeType next_type((ucs4 && *ucs4) ? g_unichar_type(*ucs4) : G_UNICODE_UNASSIGNED);
+    GUnicodeType next_type(*ucs4 ? unichar_type(*ucs4) : G_UNICODE_UNASSIGNED);
     GUnicodeType prev_type(G_UNICODE_UNASSIGNED);
 
     bool post_break_p = false;
@@ -982,7 +1138,7 @@ Tokenizer::quik_tokenize(const std::string& buf)
             next_type = G_UNICODE_UNASSIGNED;
         } else {
             next_uch = *nxt4;
-            next_type = g_unichar_type(next_uch);
+            next_type = unichar_type(next_uch);
         }
 
         if (url_p) {
@@ -1183,7 +1339,7 @@ Tokenizer::quik_tokenize(const std::string& buf)
                         gunichar *eptr = nxt4;
                         GUnicodeType eptr_type(G_UNICODE_UNASSIGNED);
                         for (++eptr; eptr < lim4 && *eptr != gunichar(L';'); ++eptr) {
-                            eptr_type = g_unichar_type(*eptr);
+                            eptr_type = unichar_type(*eptr);
                             if (eptr_type != G_UNICODE_LOWERCASE_LETTER
                                 && eptr_type != G_UNICODE_UPPERCASE_LETTER
                                 && eptr_type != G_UNICODE_DECIMAL_NUMBER)
@@ -1192,11 +1348,11 @@ Tokenizer::quik_tokenize(const std::string& buf)
                         gunichar ech(0);
                         if (*eptr == gunichar(L';') && (ech = get_entity(ucs4,eptr-ucs4+1))) {
                             curr_uch = ech;
-                            curr_type = g_unichar_type(ech);
+                            curr_type = unichar_type(ech);
                             ucs4 = eptr;
                             nxt4 = ++eptr;
                             next_uch = *nxt4;
-                            next_type = nxt4 < lim4 ? g_unichar_type(next_uch) : G_UNICODE_UNASSIGNED;
+                            next_type = nxt4 < lim4 ? unichar_type(next_uch) : G_UNICODE_UNASSIGNED;
                             goto retry;
                         }
                     }
@@ -1211,16 +1367,15 @@ Tokenizer::quik_tokenize(const std::string& buf)
                             since_start = 0;
                         }
                         ++cur4;
-                        memcpy(uptr,ucs4,cur4-ucs4);
-                        uptr += cur4-ucs4;
+                        uptr = std::copy(ucs4,cur4,uptr);
                         ucs4 = cur4;
                         *uptr++ = gunichar(L' ');
                         pre_break_p = post_break_p = false;
                         curr_uch = *ucs4;
-                        curr_type = ucs4 < lim4 ? g_unichar_type(curr_uch) : G_UNICODE_UNASSIGNED;
+                        curr_type = ucs4 < lim4 ? unichar_type(curr_uch) : G_UNICODE_UNASSIGNED;
                         nxt4 = ++cur4;
                         next_uch = *nxt4;
-                        next_type = nxt4 < lim4 ? g_unichar_type(next_uch) : G_UNICODE_UNASSIGNED;
+                        next_type = nxt4 < lim4 ? unichar_type(next_uch) : G_UNICODE_UNASSIGNED;
                         goto retry;
                     }
 
@@ -1292,7 +1447,7 @@ Tokenizer::quik_tokenize(const std::string& buf)
                                         // non-breaking before numeric
                                     } else if (k.find(curr_uch) != std::wstring::npos) {
                                         if (since_start > 1) {
-                                            GUnicodeType tclass = g_unichar_type(*(uptr-2));
+                                            GUnicodeType tclass = unichar_type(*(uptr-2));
                                             switch (tclass) {
                                             case G_UNICODE_UPPERCASE_LETTER:
                                             case G_UNICODE_LOWERCASE_LETTER:
@@ -1304,7 +1459,7 @@ Tokenizer::quik_tokenize(const std::string& buf)
                                         }
                                         // terminal isolated letter does not break
                                     } else if (class_follows_p(nxt4,lim4,G_UNICODE_LOWERCASE_LETTER) ||
-                                               g_unichar_type(*nxt4) == G_UNICODE_DASH_PUNCTUATION) {
+                                               unichar_type(*nxt4) == G_UNICODE_DASH_PUNCTUATION) {
                                         // lower-case look-ahead does not break
                                     } else {
                                         pre_break_p = true;
@@ -1519,14 +1674,10 @@ Tokenizer::quik_tokenize(const std::string& buf)
         ucs4 = nxt4;
     }
 
-    glong nbytes = 0;
-    gchar *utf8 = g_ucs4_to_utf8(ubuf,uptr-ubuf,0,&nbytes,0); // g_free
-    if (utf8[nbytes-1] == ' ')
-        --nbytes;
-    text.assign((const char *)utf8,(const char *)(utf8 + nbytes));
-    g_free(utf8);
-    g_free(usrc);
-    g_free(ubuf);
+    text.clear();
+    ucs4_to_utf8(ubuf,uptr,text);
+    if (!text.empty() && text[text.size()-1] == ' ')
+        text.resize(text.size()-1);
 
     // terminate token at superscript or subscript sequence when followed by lower-case
     if (supersub_p)
@@ -1547,92 +1698,139 @@ Tokenizer::quik_tokenize(const std::string& buf)
     // escape moses meta-characters
     if (escape_p)
         escape(text);
-
-    return text;
 }
 
 
-std::size_t
-Tokenizer::tokenize(std::istream& is, std::ostream& os)
-{
-    std::size_t line_no = 0;
-    std::size_t perchunk = chunksize ? chunksize : 2000;
-    std::vector< std::vector< std::string > > lines(nthreads);
-    std::vector< std::vector< std::string > > results(nthreads);
-    std::vector< boost::thread > workers(nthreads);
-    bool done_p = !(is.good() && os.good());
+namespace {
 
+inline void
+tokenize_chunk(Tokenizer& tokenizer, LineChunk& chunk) {
+    for (std::size_t ii = 0; ii < chunk.size; ++ii)
+        if (chunk.lines[ii].empty())
+            chunk.results[ii].clear();
+        else
+            tokenizer.tokenize(chunk.lines[ii],chunk.results[ii]);
+}
 
-    for (std::size_t tranche = 0; !done_p; ++tranche) {
 
-        // for loop starting threads for chunks of input
-        for (std::size_t ithread = 0; ithread < nthreads; ++ithread) {
+// used for boost::thread
+struct LineChunkWorker {
+    Tokenizer& tokenizer;
+    LineChunkQueue& queue;
 
-            lines[ithread].resize(perchunk);
-            std::size_t line_pos = 0;
+    LineChunkWorker(Tokenizer& _tokenizer, LineChunkQueue& _queue)
+        : tokenizer(_tokenizer)
+        , queue(_queue) {
+    }
 
-            for ( ; line_pos < perchunk; ++line_pos) {
+    void operator()() {
+        while (LineChunk *chunk = queue.pop()) {
+            tokenize_chunk(tokenizer,*chunk);
+            queue.finish(chunk);
+        }
+    }
+};
 
-                std::string istr;
-                std::getline(is,istr);
+}; // end anonymous namespace
 
-                if (skip_alltags_p) {
-                    RE2::GlobalReplace(&istr,genl_tags_x,SPC_BYTE);
-                    istr = trim(istr);
-                }
-                line_no++;
 
-                if (istr.empty()) {
-                    if (is.eof()) {
-                        done_p = true;
-                        lines[ithread].resize(line_pos);
-                        results[ithread].resize(line_pos);
-                        break;
-                    }
-                    lines[ithread][line_pos].clear();
-                } else if (skip_xml_p &&
-                           (RE2::FullMatch(istr,tag_line_x) || RE2::FullMatch(istr,white_line_x))) {
-                    lines[ithread][line_pos].clear();
-                } else {
-                    lines[ithread][line_pos] =
-                        std::string(SPC_BYTE).append(istr).append(SPC_BYTE);
-                }
-            }
-
-            if (line_pos) {
-                workers[ithread] =
-                    boost::thread(VectorTokenizerCallable(this,lines[ithread],results[ithread]));
-            }
-        } // end for loop starting threads
+std::size_t
+Tokenizer::tokenize(std::istream& is, std::ostream& os)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t line_no = 0;
+    std::size_t nbytes = 0;
+    std::size_t perchunk = chunksize ? chunksize : 2000;
+    bool threaded_p = nthreads > 1;
+    std::vector<LineChunk> chunks(threaded_p ? 2*nthreads : 1);
+    LineChunkQueue queue;
+    boost::thread_group workers;
+    if (threaded_p) {
+        for (std::size_t ithread = 0; ithread < nthreads; ++ithread)
+            workers.create_thread(LineChunkWorker(*this,queue));
+    }
 
-        for (std::size_t ithread = 0; ithread < nthreads; ++ithread) {
-            if (!workers[ithread].joinable())
-                continue;
+    std::string istr;
+    std::size_t nread = 0;
+    std::size_t nwritten = 0;
+    bool done_p = !(is.good() && os.good());
 
-            workers[ithread].join();
+    while (!done_p) {
+        // the chunk read next is the oldest in flight, written out first
+        LineChunk& chunk = chunks[nread % chunks.size()];
+        if (nread - nwritten == chunks.size()) {
+            queue.wait(&chunk);
+            for (std::size_t ii = 0; ii < chunk.size; ++ii)
+                os << chunk.results[ii] << '\n';
+            ++nwritten;
+        }
 
-            std::size_t nres = results[ithread].size();
-            std::size_t nlin = lines[ithread].size();
+        if (chunk.lines.size() < perchunk) {
+            chunk.lines.resize(perchunk);
+            chunk.results.resize(perchunk);
+        }
+        chunk.size = 0;
+        while (chunk.size < perchunk) {
+            std::getline(is,istr);
+            nbytes += istr.size() + 1;
 
-            if (nlin != nres) {
-                std::ostringstream emsg;
-                emsg << "Tranche " << tranche
-                     << " worker " << ithread << "/" << nthreads
-                     << " |lines|==" << nlin << " != |results|==" << nres;
-                throw std::runtime_error(emsg.str());
+            if (skip_alltags_p) {
+                if (istr.find('<') != std::string::npos)
+                    RE2::GlobalReplace(&istr,genl_tags_x,SPC_BYTE);
+                istr = trim(istr);
             }
+            line_no++;
 
-            for (std::size_t ires = 0; ires < nres; ++ires)
-                os << results[ithread][ires] << std::endl;
+            std::string& line = chunk.lines[chunk.size];
+            if (istr.empty()) {
+                if (is.eof()) {
+                    done_p = true;
+                    break;
+                }
+                line.clear();
+            } else if (skip_xml_p &&
+                       ((istr[0] == '<' && RE2::FullMatch(istr,tag_line_x)) ||
+                        (std::isspace((unsigned char)istr[0]) && RE2::FullMatch(istr,white_line_x)))) {
+                line.clear();
+            } else {
+                line.assign(SPC_BYTE,1);
+                line.append(istr);
+                line.append(SPC_BYTE,1);
+            }
+            ++chunk.size;
+        }
 
-        } // end loop over joined results
+        if (!chunk.size)
+            break;
+        ++nread;
+        if (threaded_p) {
+            queue.push(&chunk);
+        } else {
+            tokenize_chunk(*this,chunk);
+        }
 
         if (verbose_p) {
             std::cerr << line_no << ' ';
             std::cerr.flush();
         }
+    }
 
-    } // end loop over chunks
+    for ( ; nwritten < nread; ++nwritten) {
+        LineChunk& chunk = chunks[nwritten % chunks.size()];
+        queue.wait(&chunk);
+        for (std::size_t ii = 0; ii < chunk.size; ++ii)
+            os << chunk.results[ii] << '\n';
+    }
+    queue.stop();
+    workers.join_all();
+    os.flush();
+
+    if (verbose_p) {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << std::endl << "%%% tokenized " << nbytes << " bytes in " << secs << " seconds, "
+                  << (secs > 0 ? line_no / secs : 0) << " lines/s, "
+                  << (secs > 0 ? nbytes / secs / 1e6 : 0) << " MB/s" << std::endl;
+    }
 
     return line_no;
 }
@@ -91,32 +91,6 @@ protected:
     // in-place 1 line tokenizer, replaces input string, depends on wrapper to set-up invariants
     void protected_tokenize(std::string& inplace);
 
-    // used for boost::thread
-    struct VectorTokenizerCallable {
-        Tokenizer *tokenizer;
-        std::vector<std::string>& in;
-        std::vector<std::string>& out;
-
-        VectorTokenizerCallable(Tokenizer *_tokenizer,
-                                std::vector<std::string>& _in,
-                                std::vector<std::string>& _out)
-        : tokenizer(_tokenizer)
-        , in(_in)
-        , out(_out) {
-        };
-
-        void operator()() {
-            out.resize(in.size());
-            for (std::size_t ii = 0; ii < in.size(); ++ii)
-                if (in[ii].empty())
-                    out[ii] = in[ii];
-                else if (tokenizer->penn_p)
-                    out[ii] = tokenizer->penn_tokenize(in[ii]);
-                else
-                    out[ii] = tokenizer->quik_tokenize(in[ii]);
-        };
-    };
-
 public:
 
     Tokenizer(); // UNIMPL
@@ -147,10 +121,18 @@ public:
     bool unescape(std::string& inplace);
 
     // streaming select-tokenizer reads from is, writes to os, preserving line breaks (unless splitting)
+    // chunks of lines are tokenized by nthreads workers, with at most 2*nthreads chunks in flight
     std::size_t tokenize(std::istream& is, std::ostream& os);
 
     // quik-tokenize padded line buffer to return string
-    std::string quik_tokenize(const std::string& buf);
+    std::string quik_tokenize(const std::string& buf) {
+        std::string outs;
+        quik_tokenize(buf,outs);
+        return outs;
+    }
+
+    // quik-tokenize padded line buffer into outs, reusing its storage
+    void quik_tokenize(const std::string& buf, std::string& outs);
 
     // penn-tokenize padded line buffer to return string // untested
     std::string penn_tokenize(const std::string& buf);
@@ -162,7 +144,10 @@ public:
 
     // tokenize with output argument
     void tokenize(const std::string& buf, std::string& outs) {
-        outs = tokenize(buf);
+        if (penn_p)
+            outs = penn_tokenize(buf);
+        else
+            quik_tokenize(buf,outs);
     }
 
     // tokenize to a vector
@@ -0,0 +1,153 @@
+// Times the tokenizer on a file read into memory, repeated to a given size,
+// for a fixed set of languages and options.  It only uses the stream and
+// string interfaces, so it builds against older versions of the tokenizer.
+#include "tokenizer.h"
+#include "Parameters.h"
+#include <chrono>
+#include <cstring>
+
+#ifdef TOKENIZER_NAMESPACE
+using namespace TOKENIZER_NAMESPACE ;
+#endif
+
+namespace {
+
+struct Options {
+    const char *lang;
+    const char *flags; // letters of tokenizer_main's options
+};
+
+// the default, then the paths through the RE2 patterns
+const Options kOptions[] = {
+    { "en", "" },
+    { "en", "a" },
+    { "en", "x" },
+    { "en", "y" },
+    { "en", "p" },
+    { "en", "dnNk" },
+    { "fr", "a" },
+    { "de", "" },
+};
+
+Parameters parameters(const Options& opt, int nthreads) {
+    Parameters params;
+    params.lang_iso = opt.lang;
+    params.nthreads = nthreads;
+    for (const char *flag = opt.flags; *flag; ++flag) {
+        switch (*flag) {
+        case 'a': params.aggro_p = true; break;
+        case 'd': params.downcase_p = true; break;
+        case 'k': params.narrow_kana_p = true; break;
+        case 'n': params.narrow_latin_p = true; break;
+        case 'N': params.normalize_p = true; break;
+        case 'p': params.penn_p = true; break;
+        case 'x': params.detag_p = true; break;
+        case 'y': params.alltag_p = true; break;
+        }
+    }
+    return params;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-c DIR] [-m MB] [-t N] FILE" << std::endl;
+    std::cerr << " -c DIR -- config directory, holding nonbreaking_prefixes (./scripts/share)" << std::endl;
+    std::cerr << " -m MB -- repeat FILE to at least this many megabytes (16)" << std::endl;
+    std::cerr << " -t N -- also time the stream with N threads (1)" << std::endl;
+}
+
+} // namespace
+
+int main(int ac, char **av)
+{
+    const char *prog = av[0];
+    const char *cfg_dir = "./scripts/share";
+    std::size_t megabytes = 16;
+    int nthreads = 1;
+    const char *path = 0;
+    for (int ii = 1; ii < ac; ++ii) {
+        if (!std::strcmp(av[ii],"-c") && ii + 1 < ac) {
+            cfg_dir = av[++ii];
+        } else if (!std::strcmp(av[ii],"-m") && ii + 1 < ac) {
+            megabytes = std::strtoul(av[++ii],0,0);
+        } else if (!std::strcmp(av[ii],"-t") && ii + 1 < ac) {
+            nthreads = std::strtoul(av[++ii],0,0);
+        } else if (av[ii][0] != '-' && !path) {
+            path = av[ii];
+        } else {
+            usage(prog);
+            return 1;
+        }
+    }
+    if (!path) {
+        usage(prog);
+        return 1;
+    }
+
+    std::ifstream ifs(path);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    const std::string file(oss.str());
+    if (file.empty() || file[file.size() - 1] != '\n') {
+        std::cerr << path << " is empty or does not end in a newline" << std::endl;
+        return 1;
+    }
+    std::string text;
+    while (text.size() < megabytes << 20)
+        text.append(file);
+    std::size_t nlines = 0;
+    for (char ch : text)
+        nlines += ch == '\n';
+
+    // padded as the stream wrapper does
+    std::vector<std::string> lines;
+    std::istringstream iss(text);
+    for (std::string line; std::getline(iss,line); ) {
+        if (!line.empty())
+            lines.push_back(" " + line + " ");
+    }
+
+    std::vector<int> thread_counts(1,1);
+    if (nthreads > 1)
+        thread_counts.push_back(nthreads);
+
+    std::cout << "# " << nlines << " lines, " << text.size() << " bytes" << std::endl;
+    std::cout << "#options\tinterface\tthreads\tseconds\tlines/s\tMB/s" << std::endl;
+    for (const Options& opt : kOptions) {
+        std::string name(opt.lang);
+        if (*opt.flags)
+            name.append(" -").append(opt.flags);
+
+        // tokenize(string), a line at a time
+        {
+            Tokenizer tize(parameters(opt,1));
+            tize.init(cfg_dir);
+            std::size_t nbytes = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string& line : lines)
+                nbytes += tize.tokenize(line).size();
+            double secs = seconds_since(start);
+            std::cout << name << "\tline\t1\t" << secs << '\t' << nlines / secs << '\t'
+                      << text.size() / secs / (1 << 20) << std::endl;
+            if (!nbytes) // keeps the output in use
+                std::cerr << "no output" << std::endl;
+        }
+
+        // tokenize(istream, ostream), as the tokenizer program runs
+        for (int threads : thread_counts) {
+            Tokenizer tize(parameters(opt,threads));
+            tize.init(cfg_dir);
+            std::istringstream is(text);
+            std::ostringstream os;
+            auto start = std::chrono::steady_clock::now();
+            tize.tokenize(is,os);
+            double secs = seconds_since(start);
+            std::cout << name << "\tstream\t" << threads << '\t' << secs << '\t' << nlines / secs << '\t'
+                      << text.size() / secs / (1 << 20) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -34,7 +34,7 @@ usage(const char *path)
     std::cerr << " -t N[,C] -- use N threads (1), chunksize C lines" << std::endl;
     std::cerr << " -u -- disable url handling" << std::endl;
     std::cerr << " -U -- unescape entities before tokenization, after detokenization" << std::endl;
-    std::cerr << " -v -- verbose" << std::endl;
+    std::cerr << " -v -- verbose, reports tokenization throughput" << std::endl;
     std::cerr << " -w -- word filter" << std::endl;
     std::cerr << " -x -- skip xml tag lines" << std::endl;
     std::cerr << " -y -- skip all xml tags" << std::endl;
@@ -26,6 +26,9 @@ public:
   ~BleuDocScorer();
 
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
+  virtual bool threadSafeStats() const {
+    return false;
+  }
   virtual statscore_t calculateScore(const std::vector<int>& comps) const;
 
   int CalcReferenceLength(std::size_t doc_id, std::size_t sentence_id, std::size_t length);
@@ -146,6 +146,7 @@ void BleuScorer::ProcessReferenceLine(const std::string& line, Reference* ref) c
       ref->get_counts()->operator[](ngram) = newcount;
     }
   }
+  ref->IndexCounts();
   //add in the length
   ref->push_back(length);
 }
@@ -170,28 +171,23 @@ void BleuScorer::prepareStats(size_t sid, const string& text, ScoreStats& entry)
 
 void BleuScorer::CalcBleuStats(const Reference& ref, const std::string& text, ScoreStats& entry) const
 {
-  NgramCounts testcounts;
   // stats for this line
   vector<ScoreStatsType> stats(kBleuNgramOrder * 2);
   string sentence = preprocessSentence(text);
-  const size_t length = CountNgrams(sentence, testcounts, kBleuNgramOrder, true);
+  vector<int> encoded_tokens;
+  TokenizeAndEncodeTesting(sentence, encoded_tokens);
+  const size_t length = encoded_tokens.size();
 
   const int reference_len = CalcReferenceLength(ref, length);
   stats.push_back(reference_len);
 
   //precision on each ngram type
-  for (NgramCounts::const_iterator testcounts_it = testcounts.begin();
-       testcounts_it != testcounts.end(); ++testcounts_it) {
-    const NgramCounts::Value guess = testcounts_it->second;
-    const size_t len = testcounts_it->first.size();
-    NgramCounts::Value correct = 0;
-
-    NgramCounts::Value v = 0;
-    if (ref.get_counts()->Lookup(testcounts_it->first, &v)) {
-      correct = min(v, guess);
-    }
-    stats[len * 2 - 2] += correct;
-    stats[len * 2 - 1] += guess;
+  int correct[kBleuNgramOrder] = {0};
+  int matched[kBleuNgramOrder] = {0};
+  ref.get_index().Match(encoded_tokens, kBleuNgramOrder, correct, matched);
+  for (size_t len = 1; len <= kBleuNgramOrder && len <= length; ++len) {
+    stats[len * 2 - 2] = correct[len - 1];
+    stats[len * 2 - 1] = length - len + 1;
   }
   entry.set(stats);
 }
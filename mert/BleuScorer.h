@@ -37,6 +37,9 @@ public:
 
   virtual void setReferenceFiles(const std::vector<std::string>& referenceFiles);
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
+  virtual bool threadSafeStats() const {
+    return !hasFilter();
+  }
   virtual statscore_t calculateScore(const std::vector<ScoreStatsType>& comps) const;
   virtual std::size_t NumberOfScores() const {
     return 2 * kBleuNgramOrder + 1;
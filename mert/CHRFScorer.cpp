@@ -145,6 +145,7 @@ void CHRFScorer::ProcessReferenceLine(const std::string& line, Reference* ref) c
       ref->get_counts()->operator[](ngram) = newcount;
     }
   }
+  ref->IndexCounts();
   //add in the length
   ref->push_back(length);
 }
@@ -194,7 +195,6 @@ void CHRFScorer::prepareStats(size_t sid, const std::string& text, ScoreStats& e
 
 void CHRFScorer::CalcCHRFStats(const Reference& ref, const std::string& text, ScoreStats& entry) const
 {
-  NgramCounts testcounts;
   // stats for this line
   std::vector<ScoreStatsType> stats(CHRFNgramOrder * 3);
   std::string sentence = preprocessSentence(text);
@@ -209,25 +209,21 @@ void CHRFScorer::CalcCHRFStats(const Reference& ref, const std::string& text, Sc
   sentence=temp_line;
 //  std::cerr<<sentence<<std::endl;
   stats.push_back(sentence.size());
-  const size_t length = CountNgrams(sentence, testcounts, CHRFNgramOrder, true);
+  std::vector<int> encoded_tokens;
+  TokenizeAndEncodeTesting(sentence, encoded_tokens);
+  const size_t length = encoded_tokens.size();
 
   const int reference_len = CalcReferenceLength(ref, length);
   stats.push_back(reference_len);
 
   //precision on each ngram type
-  for (NgramCounts::const_iterator testcounts_it = testcounts.begin();
-       testcounts_it != testcounts.end(); ++testcounts_it) {
-    const NgramCounts::Value guess = testcounts_it->second;
-    const size_t len = testcounts_it->first.size();
-    NgramCounts::Value correct = 0;
-
-    NgramCounts::Value v = 0;
-    if (ref.get_counts()->Lookup(testcounts_it->first, &v)) {
-      correct = std::min(v, guess);
-    }
-    stats[len * 3 - 3] += correct;
-    stats[len * 3 - 2] += guess;
-    stats[len * 3 - 1] += v;
+  int correct[CHRFNgramOrder] = {0};
+  int matched[CHRFNgramOrder] = {0};
+  ref.get_index().Match(encoded_tokens, CHRFNgramOrder, correct, matched);
+  for (size_t len = 1; len <= CHRFNgramOrder && len <= length; ++len) {
+    stats[len * 3 - 3] = correct[len - 1];
+    stats[len * 3 - 2] = length - len + 1;
+    stats[len * 3 - 1] = matched[len - 1];
   }
   entry.set(stats);
 }
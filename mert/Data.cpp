@@ -11,11 +11,17 @@
 #include <fstream>
 
 #include "Data.h"
+#include "NbestStore.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 #include "Util.h"
 #include "util/exception.hh"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
 #include "util/file_piece.hh"
 #include "util/random.hh"
 #include "util/tokenize_piece.hh"
@@ -32,7 +38,8 @@ Data::Data(Scorer* scorer, const string& sparse_weights_file)
     m_score_type(m_scorer->getName()),
     m_num_scores(0),
     m_score_data(new ScoreData(m_scorer)),
-    m_feature_data(new FeatureData)
+    m_feature_data(new FeatureData),
+    m_threads(1)
 {
   TRACE_ERR("Data::m_score_type " << m_score_type << endl);
   TRACE_ERR("Data::Scorer type from Scorer: " << m_scorer->getName() << endl);
@@ -136,30 +143,121 @@ void Data::load(const std::string &featfile, const std::string &scorefile)
   m_score_data->load(scorefile);
 }
 
+void Data::loadStore(const boost::shared_ptr<const NbestStore>& handle)
+{
+  const NbestStore& store = *handle;
+  TRACE_ERR("loading " << store.size() << " sentences from n-best store" << endl);
+  if (store.size() == 0) return;
+  UTIL_THROW_IF(store.ScoreType() != m_score_type, util::Exception,
+                "N-best store holds " << store.ScoreType() << " statistics, not " << m_score_type);
+  if (m_feature_data->size() == 0)
+    m_feature_data->setFeatureMap(store.Features());
+  m_stores.push_back(handle);
+
+  const vector<size_t>& sparse_ids = store.SparseVectorIds();
+  string score_type = m_score_type;
+  for (size_t i = 0; i < store.size(); ++i) {
+    FeatureArray feature_array;
+    feature_array.setIndex(store.getIndex(i));
+    feature_array.NumberOfFeatures(store.NumberOfFeatures());
+    feature_array.Features(store.Features());
+    ScoreArray score_array;
+    score_array.setIndex(store.getIndex(i));
+    score_array.NumberOfScores(store.NumberOfScores());
+    score_array.name(score_type);
+
+    for (size_t j = 0; j < store.NumberOfCandidates(i); ++j) {
+      const NbestStoreCandidate c = store.get(i, j);
+      FeatureStats feature_entry(c.dense, store.NumberOfFeatures());
+      if (m_sparse_weights.size()) {
+        //Merge the sparse features, which copies the dense ones
+        FeatureStatsType merged = 0;
+        for (size_t k = 0; k < c.sparse_size; ++k) {
+          merged += m_sparse_weights.get(sparse_ids[c.sparse_ids[k]]) * c.sparse_values[k];
+        }
+        feature_entry.add(merged);
+      } else {
+        for (size_t k = 0; k < c.sparse_size; ++k) {
+          feature_entry.addSparse(sparse_ids[c.sparse_ids[k]], c.sparse_values[k]);
+        }
+      }
+      feature_array.add(feature_entry);
+
+      score_array.add(ScoreStats(c.scores, store.NumberOfScores()));
+    }
+    m_feature_data->add(feature_array);
+    m_score_data->add(score_array);
+  }
+}
+
+namespace
+{
+
+// Candidates scored per thread in one batch of an n-best list
+const size_t kNBestBatchPerThread = 256;
+
+struct NBestCandidate {
+  int sentence_index;
+  string sentence;
+  string feature_str;
+  ScoreStats score_entry;
+};
+
+// Errors are passed to the thread that adds the batch
+void PrepareStatsStride(Scorer* scorer, size_t first, size_t stride, vector<NBestCandidate>* batch,
+                        string* error)
+{
+  try {
+    for (size_t i = first; i < batch->size(); i += stride) {
+      NBestCandidate& candidate = (*batch)[i];
+      scorer->prepareStats(candidate.sentence_index, candidate.sentence, candidate.score_entry);
+    }
+  } catch (const std::exception& e) {
+    *error = e.what();
+  }
+}
+
+} // namespace
+
 void Data::loadNBest(const string &file, bool oneBest)
 {
   TRACE_ERR("loading nbest from " << file << endl);
   util::FilePiece in(file.c_str());
 
-  ScoreStats scoreentry;
-  string sentence, feature_str, alignment;
-  int sentence_index;
-
-  while (true) {
-    try {
-      StringPiece line = in.ReadLine();
+  // Score statistics are computed for batches of candidates, on several
+  // threads if the scorer allows it, and added in the order of the file.
+  // With oneBest, each candidate depends on the ones added before it.
+  size_t threads = 1;
+#ifdef WITH_THREADS
+  if (m_threads > 1 && !oneBest && m_scorer->threadSafeStats()) threads = m_threads;
+#endif
+  const size_t batch_size = threads > 1 ? threads * kNBestBatchPerThread : 1;
+  vector<NBestCandidate> batch;
+  batch.reserve(batch_size);
+
+  string alignment;
+  bool eof = false;
+  while (!eof) {
+    batch.clear();
+    while (batch.size() < batch_size) {
+      StringPiece line;
+      if (!in.ReadLineOrEOF(line)) {
+        eof = true;
+        break;
+      }
       if (line.empty()) continue;
-      // adding statistics for error measures
-      scoreentry.clear();
 
       util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||"));
 
-      sentence_index = ParseInt(*it);
+      const int sentence_index = ParseInt(*it);
       if (oneBest && m_score_data->exists(sentence_index)) continue;
+      batch.push_back(NBestCandidate());
+      NBestCandidate& candidate = batch.back();
+      candidate.sentence_index = sentence_index;
       ++it;
-      sentence = it->as_string();
+      candidate.sentence = it->as_string();
       ++it;
-      feature_str = it->as_string();
+      candidate.feature_str = it->as_string();
       ++it;
 
       if (it) {
@@ -176,23 +274,39 @@ void Data::loadNBest(const string &file, bool oneBest)
       //TODO check alignment exists if scorers need it
 
       if (m_scorer->useAlignment()) {
-        sentence += "|||";
-        sentence += alignment;
+        candidate.sentence += "|||";
+        candidate.sentence += alignment;
       }
-      m_scorer->prepareStats(sentence_index, sentence, scoreentry);
+    }
+
+    // adding statistics for error measures
+    const size_t batch_threads = max<size_t>(min(threads, batch.size()), 1);
+    vector<string> errors(batch_threads);
+#ifdef WITH_THREADS
+    boost::thread_group group;
+    for (size_t t = 1; t < batch_threads; ++t) {
+      group.create_thread(boost::bind(&PrepareStatsStride, m_scorer, t, batch_threads, &batch, &errors[t]));
+    }
+    PrepareStatsStride(m_scorer, 0, batch_threads, &batch, &errors[0]);
+    group.join_all();
+#else
+    PrepareStatsStride(m_scorer, 0, batch_threads, &batch, &errors[0]);
+#endif
+    for (size_t t = 0; t < batch_threads; ++t) {
+      UTIL_THROW_IF(!errors[t].empty(), util::Exception, errors[t]);
+    }
 
-      m_score_data->add(scoreentry, sentence_index);
+    for (vector<NBestCandidate>::const_iterator i = batch.begin(); i != batch.end(); ++i) {
+      m_score_data->add(i->score_entry, i->sentence_index);
 
       // examine first line for name of features
       if (!existsFeatureNames()) {
-        InitFeatureMap(feature_str);
+        InitFeatureMap(i->feature_str);
       }
-      AddFeatures(feature_str, sentence_index);
-    } catch (util::EndOfFileException &e) {
-      PrintUserTime("Loaded N-best lists");
-      break;
+      AddFeatures(i->feature_str, i->sentence_index);
     }
   }
+  PrintUserTime("Loaded N-best lists");
 }
 
 void Data::save(const std::string &featfile, const std::string &scorefile, bool bin)
@@ -296,6 +410,7 @@ void Data::createShards(size_t shard_count, float shard_size, const string& scor
     shards.push_back(Data(scorer));
     shards.back().m_score_type = m_score_type;
     shards.back().m_num_scores = m_num_scores;
+    shards.back().m_stores = m_stores;
     for (size_t i = 0; i < shard_contents.size(); ++i) {
       shards.back().m_feature_data->add(m_feature_data->get(shard_contents[i]));
       shards.back().m_score_data->add(m_score_data->get(shard_contents[i]));
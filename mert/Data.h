@@ -9,6 +9,7 @@
 #ifndef MERT_DATA_H_
 #define MERT_DATA_H_
 
+#include <algorithm>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 
@@ -20,6 +21,7 @@ namespace MosesTuning
 {
 
 class Scorer;
+class NbestStore;
 
 typedef boost::shared_ptr<ScoreData> ScoreDataHandle;
 typedef boost::shared_ptr<FeatureData> FeatureDataHandle;
@@ -35,6 +37,9 @@ private:
   ScoreDataHandle m_score_data;
   FeatureDataHandle m_feature_data;
   SparseVector m_sparse_weights;
+  std::size_t m_threads;
+  // The n-best stores whose statistics the data views
+  std::vector<boost::shared_ptr<const NbestStore> > m_stores;
 
 public:
   explicit Data(Scorer* scorer, const std::string& sparseweightsfile="");
@@ -67,10 +72,25 @@ public:
     m_feature_data->Features(f);
   }
 
+  /**
+   * Number of threads computing the score statistics in loadNBest, if the
+   * scorer allows it.
+   */
+  void setThreads(std::size_t threads) {
+    m_threads = std::max<std::size_t>(threads, 1);
+  }
+
   void loadNBest(const std::string &file, bool oneBest=false);
 
   void load(const std::string &featfile, const std::string &scorefile);
 
+  /**
+   * Load the candidates of an n-best store, merging the sparse features
+   * with the sparse weights as when loading feature files. The statistics
+   * are views of the mapped store, which the data and its shards keep.
+   */
+  void loadStore(const boost::shared_ptr<const NbestStore>& store);
+
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
 
   //ADDED BY TS
@@ -194,26 +194,35 @@ std::size_t hash_value(SparseVector const& item)
 
 FeatureStats::FeatureStats()
   : m_available_size(kAvailableSize), m_entries(0),
-    m_array(new FeatureStatsType[m_available_size]) {}
+    m_array(new FeatureStatsType[m_available_size]), m_owner(true) {}
 
 FeatureStats::FeatureStats(const size_t size)
   : m_available_size(size), m_entries(size),
-    m_array(new FeatureStatsType[m_available_size])
+    m_array(new FeatureStatsType[m_available_size]), m_owner(true)
 {
   memset(m_array, 0, GetArraySizeWithBytes());
 }
 
+FeatureStats::FeatureStats(const FeatureStatsType* values, size_t size)
+  : m_available_size(size), m_entries(size),
+    m_array(const_cast<FeatureStatsType*>(values)), m_owner(false) {}
+
 FeatureStats::~FeatureStats()
 {
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
 }
 
 void FeatureStats::Copy(const FeatureStats &stats)
 {
   m_available_size = stats.available();
   m_entries = stats.size();
-  m_array = new FeatureStatsType[m_available_size];
-  memcpy(m_array, stats.getArray(), GetArraySizeWithBytes());
+  m_owner = stats.m_owner;
+  if (m_owner) {
+    m_array = new FeatureStatsType[m_available_size];
+    memcpy(m_array, stats.getArray(), GetArraySizeWithBytes());
+  } else {
+    m_array = stats.getArray();
+  }
   m_map = stats.getSparse();
 }
 
@@ -224,18 +233,19 @@ FeatureStats::FeatureStats(const FeatureStats &stats)
 
 FeatureStats& FeatureStats::operator=(const FeatureStats &stats)
 {
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
   Copy(stats);
   return *this;
 }
 
 void FeatureStats::expand()
 {
-  m_available_size *= 2;
+  m_available_size = m_available_size ? 2 * m_available_size : kAvailableSize;
   featstats_t t_ = new FeatureStatsType[m_available_size];
   memcpy(t_, m_array, GetArraySizeWithBytes());
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
   m_array = t_;
+  m_owner = true;
 }
 
 void FeatureStats::add(FeatureStatsType v)
@@ -249,6 +259,11 @@ void FeatureStats::addSparse(const string& name, FeatureStatsType v)
   m_map.set(name,v);
 }
 
+void FeatureStats::addSparse(size_t id, FeatureStatsType v)
+{
+  m_map.set(id,v);
+}
+
 void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
 {
   string substring, stringBuf;
@@ -288,8 +303,18 @@ void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
   cerr << endl;*/
 }
 
+void FeatureStats::own()
+{
+  if (m_owner) return;
+  featstats_t copy = new FeatureStatsType[m_available_size];
+  memcpy(copy, m_array, GetArraySizeWithBytes());
+  m_array = copy;
+  m_owner = true;
+}
+
 void FeatureStats::loadbin(istream* is)
 {
+  own();
   is->read(reinterpret_cast<char*>(m_array),
            static_cast<streamsize>(GetArraySizeWithBytes()));
 }
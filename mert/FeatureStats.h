@@ -72,12 +72,20 @@ private:
 
   // TODO: Use smart pointer for exceptional-safety.
   featstats_t m_array;
+  // Whether m_array is ours, or a view of values kept alive elsewhere
+  bool m_owner;
   SparseVector m_map;
 
 public:
   FeatureStats();
   explicit FeatureStats(const std::size_t size);
 
+  /**
+   * A view of size values that outlive it, such as those of a mapped n-best
+   * store. Copies share the values; changing them makes a copy first.
+   */
+  FeatureStats(const FeatureStatsType* values, std::size_t size);
+
   ~FeatureStats();
 
   // We intentionally allow copying.
@@ -92,8 +100,10 @@ public:
   void expand();
   void add(FeatureStatsType v);
   void addSparse(const std::string& name, FeatureStatsType v);
+  void addSparse(std::size_t id, FeatureStatsType v);
 
   void clear() {
+    own();
     memset((void*)m_array, 0, GetArraySizeWithBytes());
     m_map.clear();
   }
@@ -147,6 +157,9 @@ public:
    * Write the whole object to a stream.
    */
   friend std::ostream& operator<<(std::ostream& o, const FeatureStats& e);
+
+private:
+  void own();
 };
 
 bool operator==(const FeatureStats& f1, const FeatureStats& f2);
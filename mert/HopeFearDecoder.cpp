@@ -24,6 +24,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define BOOST_FILESYSTEM_VERSION 3
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#endif
 
 #include "util/exception.hh"
 #include "util/file_piece.hh"
@@ -135,16 +139,105 @@ InitialiseWeights(const string& denseInitFile, const string& sparseInitFile,
 ValType HopeFearDecoder::Evaluate(const AvgWeightVector& wv)
 {
   vector<ValType> stats(scorer_->NumberOfScores(),0);
-  for(reset(); !finished(); next()) {
-    vector<ValType> sent;
-    MaxModel(wv,&sent);
-    for(size_t i=0; i<sent.size(); i++) {
-      stats[i]+=sent[i];
+  reset();
+  while (!finished()) {
+    const size_t ahead = threads_ > 1 ? Lookahead() : 0;
+    vector<vector<ValType> > sents(max<size_t>(ahead, 1));
+    if (ahead) {
+      // Decode every sentence the decoder reaches at once, then add up the
+      // statistics in order, so the sum does not depend on the threads
+      const size_t threads = min(threads_, ahead);
+#ifdef WITH_THREADS
+      boost::thread_group group;
+      for (size_t t = 1; t < threads; ++t) {
+        group.create_thread(boost::bind(&HopeFearDecoder::MaxModelStride, this,
+                                        t, threads, boost::cref(wv), &sents));
+      }
+      MaxModelStride(0, threads, wv, &sents);
+      group.join_all();
+#else
+      MaxModelStride(0, threads, wv, &sents);
+#endif
+    } else {
+      MaxModel(wv,&sents[0]);
+    }
+    for (size_t s = 0; s < sents.size(); ++s) {
+      next();
+      for(size_t i=0; i<sents[s].size(); i++) {
+        stats[i]+=sents[s][i];
+      }
     }
   }
   return scorer_->calculateScore(stats);
 }
 
+void HopeFearDecoder::HopeFearBatch(
+  const vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  vector<HopeFearData>* batch
+)
+{
+  const size_t ahead = min(batch->size(), Lookahead());
+  if (ahead == 0) {
+    // The decoder only reaches the current sentence
+    size_t size = 0;
+    for (; size < batch->size() && !finished(); ++size, next()) {
+      (*batch)[size] = HopeFearData();
+      HopeFear(backgroundBleu, wv, &(*batch)[size]);
+    }
+    batch->resize(size);
+    return;
+  }
+
+  batch->assign(ahead, HopeFearData());
+  const size_t threads = min(threads_, ahead);
+#ifdef WITH_THREADS
+  boost::thread_group group;
+  for (size_t t = 1; t < threads; ++t) {
+    group.create_thread(boost::bind(&HopeFearDecoder::HopeFearStride, this, t, threads,
+                                    boost::cref(backgroundBleu), boost::cref(wv), batch));
+  }
+  HopeFearStride(0, threads, backgroundBleu, wv, batch);
+  group.join_all();
+#else
+  HopeFearStride(0, threads, backgroundBleu, wv, batch);
+#endif
+  for (size_t i = 0; i < ahead; ++i) next();
+}
+
+void HopeFearDecoder::HopeFearAt(
+  size_t offset,
+  const vector<ValType>&,
+  const MiraWeightVector&,
+  HopeFearData*) const
+{
+  UTIL_THROW(util::Exception, "Decoder only reaches the current sentence, not " << offset << " after it");
+}
+
+void HopeFearDecoder::MaxModelAt(size_t offset, const AvgWeightVector&, vector<ValType>*) const
+{
+  UTIL_THROW(util::Exception, "Decoder only reaches the current sentence, not " << offset << " after it");
+}
+
+void HopeFearDecoder::HopeFearStride(
+  size_t first, size_t stride,
+  const vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  vector<HopeFearData>* batch) const
+{
+  for (size_t i = first; i < batch->size(); i += stride) {
+    HopeFearAt(i, backgroundBleu, wv, &(*batch)[i]);
+  }
+}
+
+void HopeFearDecoder::MaxModelStride(size_t first, size_t stride, const AvgWeightVector& wv,
+                                     vector<vector<ValType> >* stats) const
+{
+  for (size_t i = first; i < stats->size(); i += stride) {
+    MaxModelAt(i, wv, &(*stats)[i]);
+  }
+}
+
 NbestHopeFearDecoder::NbestHopeFearDecoder(
   const vector<string>& featureFiles,
   const vector<string>&  scoreFiles,
@@ -162,6 +255,17 @@ NbestHopeFearDecoder::NbestHopeFearDecoder(
   }
 }
 
+NbestHopeFearDecoder::NbestHopeFearDecoder(
+  const string& storeFile,
+  bool no_shuffle,
+  bool safe_hope,
+  Scorer* scorer
+) : safe_hope_(safe_hope)
+{
+  scorer_ = scorer;
+  train_.reset(new StoreHypPackEnumerator(storeFile, no_shuffle));
+}
+
 
 void NbestHopeFearDecoder::next()
 {
@@ -178,24 +282,49 @@ void NbestHopeFearDecoder::reset()
   train_->reset();
 }
 
+size_t NbestHopeFearDecoder::Lookahead()
+{
+  return train_->lookahead();
+}
+
 void NbestHopeFearDecoder::HopeFear(
   const std::vector<ValType>& backgroundBleu,
   const MiraWeightVector& wv,
   HopeFearData* hopeFear
 )
 {
+  HopeFearPack(*train_, backgroundBleu, wv, hopeFear);
+}
 
+void NbestHopeFearDecoder::HopeFearAt(
+  size_t offset,
+  const std::vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
+  HypPack pack;
+  train_->packAt(offset, &pack);
+  HopeFearPack(pack, backgroundBleu, wv, hopeFear);
+}
 
+template <class Pack> void NbestHopeFearDecoder::HopeFearPack(
+  Pack& pack,
+  const std::vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
   // Hope / fear decode
   ValType hope_scale = 1.0;
   size_t hope_index=0, fear_index=0, model_index=0;
   ValType hope_score=0, fear_score=0, model_score=0;
   for(size_t safe_loop=0; safe_loop<2; safe_loop++) {
     ValType hope_bleu=0, hope_model=0;
-    for(size_t i=0; i< train_->cur_size(); i++) {
-      const MiraFeatureVector& vec=train_->featuresAt(i);
+    for(size_t i=0; i< pack.cur_size(); i++) {
+      const MiraFeatureVector& vec=pack.featuresAt(i);
       ValType score = wv.score(vec);
-      ValType bleu = scorer_->calculateSentenceLevelBackgroundScore(train_->scoresAt(i),backgroundBleu);
+      ValType bleu = scorer_->calculateSentenceLevelBackgroundScore(pack.scoresAt(i),backgroundBleu);
       // Hope
       if(i==0 || (hope_scale*score + bleu) > hope_score) {
         hope_score = hope_scale*score + bleu;
@@ -221,33 +350,47 @@ void NbestHopeFearDecoder::HopeFear(
       hope_scale = abs(hope_bleu) / abs(hope_model);
     else break;
   }
-  hopeFear->modelFeatures = train_->featuresAt(model_index);
-  hopeFear->hopeFeatures = train_->featuresAt(hope_index);
-  hopeFear->fearFeatures = train_->featuresAt(fear_index);
+  hopeFear->modelFeatures = pack.featuresAt(model_index);
+  hopeFear->hopeFeatures = pack.featuresAt(hope_index);
+  hopeFear->fearFeatures = pack.featuresAt(fear_index);
 
-  hopeFear->hopeStats = train_->scoresAt(hope_index);
+  hopeFear->hopeStats = pack.scoresAt(hope_index);
   hopeFear->hopeBleu = scorer_->calculateSentenceLevelBackgroundScore(hopeFear->hopeStats, backgroundBleu);
-  const vector<float>& fear_stats = train_->scoresAt(fear_index);
+  const vector<float>& fear_stats = pack.scoresAt(fear_index);
   hopeFear->fearBleu = scorer_->calculateSentenceLevelBackgroundScore(fear_stats, backgroundBleu);
 
-  hopeFear->modelStats = train_->scoresAt(model_index);
+  hopeFear->modelStats = pack.scoresAt(model_index);
   hopeFear->hopeFearEqual = (hope_index == fear_index);
 }
 
 void NbestHopeFearDecoder::MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats)
+{
+  MaxModelPack(*train_, wv, stats);
+}
+
+void NbestHopeFearDecoder::MaxModelAt(size_t offset, const AvgWeightVector& wv,
+                                      std::vector<ValType>* stats) const
+{
+  HypPack pack;
+  train_->packAt(offset, &pack);
+  MaxModelPack(pack, wv, stats);
+}
+
+template <class Pack> void NbestHopeFearDecoder::MaxModelPack(
+  Pack& pack, const AvgWeightVector& wv, std::vector<ValType>* stats) const
 {
   // Find max model
   size_t max_index=0;
   ValType max_score=0;
-  for(size_t i=0; i<train_->cur_size(); i++) {
-    MiraFeatureVector vec(train_->featuresAt(i));
+  for(size_t i=0; i<pack.cur_size(); i++) {
+    MiraFeatureVector vec(pack.featuresAt(i));
     ValType score = wv.score(vec);
     if(i==0 || score > max_score) {
       max_index = i;
       max_score = score;
     }
   }
-  *stats = train_->scoresAt(max_index);
+  *stats = pack.scoresAt(max_index);
 }
 
 
@@ -328,16 +471,31 @@ bool HypergraphHopeFearDecoder::finished()
   return sentenceIdIter_ == sentenceIds_.end();
 }
 
+size_t HypergraphHopeFearDecoder::Lookahead()
+{
+  return sentenceIds_.end() - sentenceIdIter_;
+}
+
 void HypergraphHopeFearDecoder::HopeFear(
   const vector<ValType>& backgroundBleu,
   const MiraWeightVector& wv,
   HopeFearData* hopeFear
 )
 {
-  size_t sentenceId = *sentenceIdIter_;
+  HopeFearAt(0, backgroundBleu, wv, hopeFear);
+}
+
+void HypergraphHopeFearDecoder::HopeFearAt(
+  size_t offset,
+  const vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
+  size_t sentenceId = sentenceIdIter_[offset];
   SparseVector weights;
   wv.ToSparse(&weights, num_dense_);
-  const Graph& graph = *(graphs_[sentenceId]);
+  const Graph& graph = *(graphs_.find(sentenceId)->second);
 
   // ValType hope_scale = 1.0;
   HgHypothesis hopeHypo, fearHypo, modelHypo;
@@ -428,13 +586,19 @@ void HypergraphHopeFearDecoder::HopeFear(
 void HypergraphHopeFearDecoder::MaxModel(const AvgWeightVector& wv, vector<ValType>* stats)
 {
   assert(!finished());
+  MaxModelAt(0, wv, stats);
+}
+
+void HypergraphHopeFearDecoder::MaxModelAt(size_t offset, const AvgWeightVector& wv,
+    vector<ValType>* stats) const
+{
   HgHypothesis bestHypo;
-  size_t sentenceId = *sentenceIdIter_;
+  size_t sentenceId = sentenceIdIter_[offset];
   SparseVector weights;
   wv.ToSparse(&weights, num_dense_);
   vector<ValType> bg(scorer_->NumberOfScores());
   //cerr << "Calculating bleu on " << sentenceId << endl;
-  Viterbi(*(graphs_[sentenceId]), weights, 0, references_, sentenceId, bg, &bestHypo);
+  Viterbi(*(graphs_.find(sentenceId)->second), weights, 0, references_, sentenceId, bg, &bestHypo);
   stats->resize(bestHypo.bleuStats.size());
   /*
   for (size_t i = 0; i < bestHypo.text.size(); ++i) {
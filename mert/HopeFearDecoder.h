@@ -18,6 +18,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/scoped_ptr.hpp>
@@ -69,6 +70,7 @@ public:
   virtual void next() = 0;
   virtual bool finished() = 0;
 
+  HopeFearDecoder() : threads_(1) {}
   virtual ~HopeFearDecoder() {};
 
   /**
@@ -80,6 +82,19 @@ public:
     HopeFearData* hopeFear
   ) = 0;
 
+  /**
+    * Calculate hope, fear and model hypotheses of the current sentence and
+    * the ones after it, up to batch->size() sentences, and move past them.
+    * All sentences of the batch are decoded with the same weights and
+    * background, on several threads where the decoder can reach them at
+    * once. The batch is shrunk at the end of the epoch.
+    **/
+  void HopeFearBatch(
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    std::vector<HopeFearData>* batch
+  );
+
   /** Max score decoding */
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats)
   = 0;
@@ -87,8 +102,42 @@ public:
   /** Calculate bleu on training set */
   ValType Evaluate(const AvgWeightVector& wv);
 
+  /** Number of threads for HopeFearBatch and Evaluate */
+  void SetThreads(size_t threads) {
+    threads_ = std::max<size_t>(threads, 1);
+  }
+
 protected:
+  /** Number of sentences, from the current one on, that the *At methods reach */
+  virtual size_t Lookahead() {
+    return 0;
+  }
+
+  /**
+    * As HopeFear and MaxModel, for the sentence offset positions after the
+    * current one. Called from several threads at once.
+    **/
+  virtual void HopeFearAt(
+    size_t offset,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+  virtual void MaxModelAt(size_t offset, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
   Scorer* scorer_;
+
+private:
+  // Decode sentences first, first + stride, ... of the batch
+  void HopeFearStride(size_t first, size_t stride,
+                      const std::vector<ValType>& backgroundBleu,
+                      const MiraWeightVector& wv,
+                      std::vector<HopeFearData>* batch) const;
+  void MaxModelStride(size_t first, size_t stride, const AvgWeightVector& wv,
+                      std::vector<std::vector<ValType> >* stats) const;
+
+  size_t threads_;
 };
 
 
@@ -104,6 +153,12 @@ public:
                        Scorer* scorer
                       );
 
+  NbestHopeFearDecoder(const std::string& storeFile,
+                       bool no_shuffle,
+                       bool safe_hope,
+                       Scorer* scorer
+                      );
+
   virtual void reset();
   virtual void next();
   virtual bool finished();
@@ -116,7 +171,28 @@ public:
 
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats);
 
+protected:
+  virtual size_t Lookahead();
+
+  virtual void HopeFearAt(
+    size_t offset,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+  virtual void MaxModelAt(size_t offset, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
 private:
+  template <class Pack> void HopeFearPack(
+    Pack& pack,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+  template <class Pack> void MaxModelPack(Pack& pack, const AvgWeightVector& wv,
+      std::vector<ValType>* stats) const;
+
   boost::scoped_ptr<HypPackEnumerator> train_;
   bool safe_hope_;
 
@@ -152,6 +228,18 @@ public:
 
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats);
 
+protected:
+  virtual size_t Lookahead();
+
+  virtual void HopeFearAt(
+    size_t offset,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+  virtual void MaxModelAt(size_t offset, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
 private:
   size_t num_dense_;
   //maps sentence Id to graph ptr
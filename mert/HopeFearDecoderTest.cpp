@@ -0,0 +1,86 @@
+#include "HopeFearDecoder.h"
+
+#define BOOST_TEST_MODULE MertHopeFearDecoder
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "Data.h"
+#include "NbestStore.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "TestData.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+const size_t kNumSentences = 30;
+const size_t kNbestSize = 10;
+
+// Writes random features and BLEU statistics to a store
+void FillStore(const string& file, Scorer* scorer)
+{
+  Data data(scorer);
+  data.getFeatureData()->setFeatureMap("d_0 lm_0 w_0");
+  srand(1234);
+  for (size_t s = 0; s < kNumSentences; ++s) {
+    for (size_t j = 0; j < kNbestSize; ++j) {
+      FeatureStats features;
+      for (size_t k = 0; k < 3; ++k) features.add(rand() / static_cast<float>(RAND_MAX));
+      data.getFeatureData()->add(features, s);
+
+      data.getScoreData()->add(RandomBleuStats(), s);
+    }
+  }
+  NbestStore::Append(file, data);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(hope_fear_batch_threads)
+{
+  TempFile file;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  FillStore(file.path.string(), scorer.get());
+
+  NbestHopeFearDecoder decoder(file.path.string(), true, false, scorer.get());
+  vector<ValType> init(3, 0.5);
+  init[1] = -0.25;
+  MiraWeightVector wv(init);
+  vector<ValType> bg(scorer->NumberOfScores(), 1);
+
+  vector<HopeFearData> serial;
+  for (decoder.reset(); !decoder.finished(); decoder.next()) {
+    serial.push_back(HopeFearData());
+    decoder.HopeFear(bg, wv, &serial.back());
+  }
+  const ValType bleu = decoder.Evaluate(wv.avg());
+
+  for (size_t threads = 1; threads <= 4; threads += 3) {
+    decoder.SetThreads(threads);
+    BOOST_CHECK_EQUAL(decoder.Evaluate(wv.avg()), bleu);
+
+    // Batches that do not divide the sentences
+    size_t sentence = 0;
+    vector<HopeFearData> batch;
+    for (decoder.reset(); !decoder.finished(); ) {
+      batch.resize(7);
+      decoder.HopeFearBatch(bg, wv, &batch);
+      for (size_t b = 0; b < batch.size(); ++b, ++sentence) {
+        BOOST_REQUIRE(sentence < serial.size());
+        BOOST_CHECK(batch[b].hopeFeatures == serial[sentence].hopeFeatures);
+        BOOST_CHECK(batch[b].fearFeatures == serial[sentence].fearFeatures);
+        BOOST_CHECK(batch[b].modelStats == serial[sentence].modelStats);
+        BOOST_CHECK_EQUAL(batch[b].hopeBleu, serial[sentence].hopeBleu);
+        BOOST_CHECK_EQUAL(batch[b].fearBleu, serial[sentence].fearBleu);
+        BOOST_CHECK_EQUAL(batch[b].hopeFearEqual, serial[sentence].hopeFearEqual);
+      }
+    }
+    BOOST_CHECK_EQUAL(sentence, kNumSentences);
+  }
+}
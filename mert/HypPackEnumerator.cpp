@@ -4,11 +4,17 @@
 #include <algorithm>
 #include <boost/unordered_set.hpp>
 
+#include "util/exception.hh"
+
 using namespace std;
 
 namespace MosesTuning
 {
 
+void HypPackEnumerator::packAt(size_t, HypPack*) const
+{
+  UTIL_THROW(util::Exception, "This hypothesis enumerator only gives access to the current pack");
+}
 
 StreamingHypPackEnumerator::StreamingHypPackEnumerator
 (
@@ -211,6 +217,125 @@ size_t RandomAccessHypPackEnumerator::cur_id()
 {
   return m_indexes[m_cur_index];
 }
+
+size_t RandomAccessHypPackEnumerator::lookahead()
+{
+  return finished() ? 0 : m_indexes.size() - m_cur_index;
+}
+
+void RandomAccessHypPackEnumerator::packAt(size_t offset, HypPack* pack) const
+{
+  const size_t index = m_indexes[m_cur_index + offset];
+  pack->refer(m_features[index], m_scores[index]);
+}
+
+/* --------- StoreHypPackEnumerator ------------- */
+
+StoreHypPackEnumerator::StoreHypPackEnumerator(string const& storeFile, bool no_shuffle)
+  : m_store(storeFile),
+    m_no_shuffle(no_shuffle),
+    m_cur_index(0),
+    m_primed(false)
+{
+  if (m_store.size() == 0) {
+    cerr << "No data to process" << endl;
+    exit(0);
+  }
+  for (size_t i = 0; i < m_store.size(); ++i) {
+    m_indexes.push_back(i);
+  }
+}
+
+size_t StoreHypPackEnumerator::num_dense() const
+{
+  return m_store.NumberOfFeatures();
+}
+
+void StoreHypPackEnumerator::fill(size_t sentence, vector<MiraFeatureVector>& features,
+                                  vector<ScoreDataItem>& scores) const
+{
+  const vector<size_t>& sparse_ids = m_store.SparseVectorIds();
+  features.clear();
+  scores.clear();
+  vector<pair<size_t,ValType> > sparse;
+  for (size_t j = 0; j < m_store.NumberOfCandidates(sentence); ++j) {
+    const NbestStoreCandidate c = m_store.get(sentence, j);
+    // Sparse features follow the dense ones, in increasing order
+    sparse.clear();
+    for (size_t k = 0; k < c.sparse_size; ++k) {
+      sparse.push_back(make_pair(m_store.NumberOfFeatures() + sparse_ids[c.sparse_ids[k]], c.sparse_values[k]));
+    }
+    sort(sparse.begin(), sparse.end());
+    vector<size_t> sparseFeats(sparse.size());
+    vector<ValType> sparseVals(sparse.size());
+    for (size_t k = 0; k < sparse.size(); ++k) {
+      sparseFeats[k] = sparse[k].first;
+      sparseVals[k] = sparse[k].second;
+    }
+    features.push_back(MiraFeatureVector(
+                        vector<ValType>(c.dense, c.dense + m_store.NumberOfFeatures()), sparseFeats, sparseVals));
+    scores.push_back(ScoreDataItem(c.scores, c.scores + m_store.NumberOfScores()));
+  }
+}
+
+void StoreHypPackEnumerator::prime()
+{
+  if (m_primed) return;
+  fill(m_indexes[m_cur_index], m_current_featureVectors, m_current_scores);
+  m_primed = true;
+}
+
+void StoreHypPackEnumerator::reset()
+{
+  m_cur_index = 0;
+  if(!m_no_shuffle) random_shuffle(m_indexes.begin(),m_indexes.end());
+  m_primed = false;
+}
+
+bool StoreHypPackEnumerator::finished()
+{
+  return m_cur_index >= m_indexes.size();
+}
+
+void StoreHypPackEnumerator::next()
+{
+  m_cur_index++;
+  m_primed = false;
+}
+
+size_t StoreHypPackEnumerator::cur_size()
+{
+  prime();
+  return m_current_featureVectors.size();
+}
+
+const MiraFeatureVector& StoreHypPackEnumerator::featuresAt(size_t i)
+{
+  prime();
+  return m_current_featureVectors[i];
+}
+
+const ScoreDataItem& StoreHypPackEnumerator::scoresAt(size_t i)
+{
+  prime();
+  return m_current_scores[i];
+}
+
+size_t StoreHypPackEnumerator::cur_id()
+{
+  return m_indexes[m_cur_index];
+}
+
+size_t StoreHypPackEnumerator::lookahead()
+{
+  return finished() ? 0 : m_indexes.size() - m_cur_index;
+}
+
+void StoreHypPackEnumerator::packAt(size_t offset, HypPack* pack) const
+{
+  fill(m_indexes[m_cur_index + offset], pack->featureCopy(), pack->scoreCopy());
+}
+
 // --Emacs trickery--
 // Local Variables:
 // mode:c++
@@ -17,11 +17,57 @@
 #include "FeatureDataIterator.h"
 #include "ScoreDataIterator.h"
 #include "MiraFeatureVector.h"
+#include "NbestStore.h"
 
 namespace MosesTuning
 {
 
 
+// The candidates of one sentence, handed out by enumerators that can reach
+// several sentences at once. Either refers to the candidates held by the
+// enumerator or holds its own copy of them.
+class HypPack
+{
+public:
+  HypPack() : m_features(NULL), m_scores(NULL) {}
+
+  void refer(const std::vector<MiraFeatureVector>& features,
+             const std::vector<ScoreDataItem>& scores) {
+    m_features = &features;
+    m_scores = &scores;
+  }
+
+  // Storage for a copy of the candidates, which the pack then refers to
+  std::vector<MiraFeatureVector>& featureCopy() {
+    m_features = NULL;
+    return m_featureCopy;
+  }
+  std::vector<ScoreDataItem>& scoreCopy() {
+    m_scores = NULL;
+    return m_scoreCopy;
+  }
+
+  std::size_t cur_size() const {
+    return features().size();
+  }
+  const MiraFeatureVector& featuresAt(std::size_t i) const {
+    return features()[i];
+  }
+  const ScoreDataItem& scoresAt(std::size_t i) const {
+    return m_scores ? (*m_scores)[i] : m_scoreCopy[i];
+  }
+
+private:
+  const std::vector<MiraFeatureVector>& features() const {
+    return m_features ? *m_features : m_featureCopy;
+  }
+
+  const std::vector<MiraFeatureVector>* m_features;
+  const std::vector<ScoreDataItem>* m_scores;
+  std::vector<MiraFeatureVector> m_featureCopy;
+  std::vector<ScoreDataItem> m_scoreCopy;
+};
+
 // Start with these abstract classes
 
 class HypPackEnumerator
@@ -38,6 +84,16 @@ public:
   virtual std::size_t num_dense() const = 0;
   virtual const MiraFeatureVector& featuresAt(std::size_t i) = 0;
   virtual const ScoreDataItem& scoresAt(std::size_t i) = 0;
+
+  // Number of packs, from the current one on, that packAt can reach.
+  // Sequential enumerators only give access to the current pack, through
+  // the methods above, and return 0.
+  virtual std::size_t lookahead() {
+    return 0;
+  }
+  // The pack offset positions after the current one. May be called from
+  // several threads at once, so must not change the enumerator.
+  virtual void packAt(std::size_t offset, HypPack* pack) const;
 };
 
 // Instantiation that streams from disk
@@ -95,6 +151,9 @@ public:
   virtual const MiraFeatureVector& featuresAt(std::size_t i);
   virtual const ScoreDataItem& scoresAt(std::size_t i);
 
+  virtual std::size_t lookahead();
+  virtual void packAt(std::size_t offset, HypPack* pack) const;
+
 private:
   bool m_no_shuffle;
   std::size_t m_cur_index;
@@ -104,6 +163,44 @@ private:
   std::vector<std::vector<ScoreDataItem> > m_scores;
 };
 
+// Instantiation that reads a memory-mapped n-best store
+// Low-memory, high-speed, random access
+// (Randomizes with each call to reset, like RandomAccessHypPackEnumerator)
+class StoreHypPackEnumerator : public HypPackEnumerator
+{
+public:
+  StoreHypPackEnumerator(std::string const& storeFile, bool no_shuffle);
+
+  virtual std::size_t num_dense() const;
+
+  virtual void reset();
+  virtual bool finished();
+  virtual void next();
+
+  virtual std::size_t cur_id();
+  virtual std::size_t cur_size();
+  virtual const MiraFeatureVector& featuresAt(std::size_t i);
+  virtual const ScoreDataItem& scoresAt(std::size_t i);
+
+  virtual std::size_t lookahead();
+  virtual void packAt(std::size_t offset, HypPack* pack) const;
+
+private:
+  // Copy the candidates of a sentence out of the store
+  void fill(std::size_t sentence, std::vector<MiraFeatureVector>& features,
+            std::vector<ScoreDataItem>& scores) const;
+  // Copy the current sentence, the first time it is accessed
+  void prime();
+
+  NbestStore m_store;
+  bool m_no_shuffle;
+  std::size_t m_cur_index;
+  std::vector<std::size_t> m_indexes;
+  bool m_primed;
+  std::vector<MiraFeatureVector> m_current_featureVectors;
+  std::vector<ScoreDataItem> m_current_scores;
+};
+
 }
 
 #endif // MERT_HYP_PACK_COLLECTION_H
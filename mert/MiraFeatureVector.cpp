@@ -171,12 +171,12 @@ bool operator==(const MiraFeatureVector& a,const MiraFeatureVector& b)
   //dense features
   if (a.m_dense.size() != b.m_dense.size()) return false;
   for (size_t i = 0; i < a.m_dense.size(); ++i) {
-    if (fabs(a.m_dense[i]-b.m_dense[i]) < eps) return false;
+    if (fabs(a.m_dense[i]-b.m_dense[i]) >= eps) return false;
   }
   if (a.m_sparseFeats.size() != b.m_sparseFeats.size()) return false;
   for (size_t i = 0; i < a.m_sparseFeats.size(); ++i) {
     if (a.m_sparseFeats[i] != b.m_sparseFeats[i]) return false;
-    if (fabs(a.m_sparseVals[i] != b.m_sparseVals[i])) return false;
+    if (fabs(a.m_sparseVals[i]-b.m_sparseVals[i]) >= eps) return false;
   }
   return true;
 
@@ -48,3 +48,20 @@ BOOST_AUTO_TEST_CASE(from_sparse)
   BOOST_CHECK_CLOSE(sp2.get("sparse2"), 0.1,1e-5);
 
 }
+
+BOOST_AUTO_TEST_CASE(equality)
+{
+  SparseVector sp;
+  sp.set("dense0", 0.2);
+  sp.set("dense1", 0.3);
+  sp.set("sparse0", 0.7);
+  MiraFeatureVector a(sp,2);
+  MiraFeatureVector b(sp,2);
+  BOOST_CHECK(a == b);
+
+  sp.set("sparse0", 0.8);
+  BOOST_CHECK(!(a == MiraFeatureVector(sp,2)));
+  sp.set("sparse0", 0.7);
+  sp.set("dense1", 0.4);
+  BOOST_CHECK(!(a == MiraFeatureVector(sp,2)));
+}
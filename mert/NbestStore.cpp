@@ -0,0 +1,439 @@
+#include "NbestStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
+
+#include "Data.h"
+#include "FeatureDataIterator.h"
+
+using namespace std;
+
+namespace
+{
+
+const char kMagic[8] = "MertNB\n";
+const uint32_t kVersion = 2;
+
+struct BlockHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_dense;
+  uint32_t num_scores;
+  uint32_t reserved;
+  // Size of the whole block, header included.
+  uint64_t bytes;
+  uint64_t num_sentences;
+  uint64_t num_candidates;
+  uint64_t num_sparse;
+  // Sparse feature names introduced by this block.
+  uint64_t num_names;
+  uint64_t string_bytes;
+};
+
+std::size_t Align8(std::size_t in)
+{
+  return (in + 7) & ~static_cast<std::size_t>(7);
+}
+
+void WriteAligned(int fd, const void* data, std::size_t size)
+{
+  const char padding[8] = {0};
+  if (size) util::WriteOrThrow(fd, data, size);
+  if (Align8(size) != size) util::WriteOrThrow(fd, padding, Align8(size) - size);
+}
+
+template <class T> void WriteAligned(int fd, const vector<T>& data)
+{
+  WriteAligned(fd, data.empty() ? NULL : &data[0], data.size() * sizeof(T));
+}
+
+uint64_t HashCandidate(const MosesTuning::FeatureStatsType* dense, std::size_t num_dense,
+                       const MosesTuning::ScoreStatsType* scores, std::size_t num_scores,
+                       const uint32_t* sparse_ids, const MosesTuning::FeatureStatsType* sparse_values,
+                       std::size_t sparse_size)
+{
+  uint64_t hash = util::MurmurHashNative(dense, num_dense * sizeof(*dense));
+  hash = util::MurmurHashNative(scores, num_scores * sizeof(*scores), hash);
+  hash = util::MurmurHashNative(sparse_ids, sparse_size * sizeof(*sparse_ids), hash);
+  return util::MurmurHashNative(sparse_values, sparse_size * sizeof(*sparse_values), hash);
+}
+
+// Whether the candidates a and b are identical, bit for bit as HashCandidate
+// sees them.
+bool SameCandidate(const MosesTuning::NbestStoreCandidate& a, const MosesTuning::NbestStoreCandidate& b,
+                   std::size_t num_dense, std::size_t num_scores)
+{
+  return a.sparse_size == b.sparse_size
+         && !memcmp(a.dense, b.dense, num_dense * sizeof(*a.dense))
+         && !memcmp(a.scores, b.scores, num_scores * sizeof(*a.scores))
+         && !memcmp(a.sparse_ids, b.sparse_ids, a.sparse_size * sizeof(*a.sparse_ids))
+         && !memcmp(a.sparse_values, b.sparse_values, a.sparse_size * sizeof(*a.sparse_values));
+}
+
+// The text feature files drop the '=' that ends sparse feature names in the
+// n-best lists, so the store does too.
+string StoredSparseName(size_t id)
+{
+  string name = MosesTuning::SparseVector::decode(id);
+  if (!name.empty() && name[name.size() - 1] == '=')
+    name.resize(name.size() - 1);
+  return name;
+}
+
+} // namespace
+
+namespace MosesTuning
+{
+
+
+size_t NbestStore::Append(const string& file, Data& data)
+{
+  FeatureDataHandle features = data.getFeatureData();
+  ScoreDataHandle scores = data.getScoreData();
+  UTIL_THROW_IF(features->size() != scores->size(), util::Exception,
+                "Feature data has " << features->size() << " sentences but score data has " << scores->size());
+
+  boost::scoped_ptr<NbestStore> store;
+  struct stat info;
+  if (stat(file.c_str(), &info) == 0) store.reset(new NbestStore(file));
+
+  string score_type = scores->name();
+  string feature_names = features->Features();
+  size_t num_dense = 0, num_scores = 0;
+  if (store.get() && store->size()) {
+    num_dense = store->NumberOfFeatures();
+    num_scores = store->NumberOfScores();
+    UTIL_THROW_IF(store->ScoreType() != score_type, util::Exception,
+                  "N-best store " << file << " holds " << store->ScoreType() << " statistics, not " << score_type);
+    feature_names = store->Features();
+  } else if (features->size() && features->get(0).size()) {
+    num_dense = features->get(0).get(0).size();
+    num_scores = scores->get(0).get(0).size();
+  }
+
+  // Sparse feature names the store holds already. Candidates are found by
+  // hash, then compared in full, so a hash collision can't drop a new
+  // candidate: those of the store through the hash index of its blocks,
+  // those added by this call by their index in the columns below.
+  typedef boost::unordered_multimap<uint64_t, size_t> AddedCandidates;
+  boost::unordered_map<string, uint32_t> name_ids;
+  if (store.get()) {
+    for (size_t id = 0; id < store->NumberOfSparse(); ++id) {
+      name_ids[store->SparseName(id).as_string()] = id;
+    }
+  }
+  const size_t num_old_names = name_ids.size();
+
+  vector<uint64_t> sentence_indices, sentence_offsets(1, 0), sparse_offsets(1, 0);
+  vector<FeatureStatsType> dense, sparse_values;
+  vector<ScoreStatsType> score_stats;
+  vector<uint32_t> sparse_ids;
+  // Hash and index within its sentence of each candidate, sorted by hash
+  // within each sentence
+  vector<pair<uint64_t, uint32_t> > hash_index;
+  vector<string> new_names;
+  vector<pair<uint32_t, FeatureStatsType> > sparse;
+  for (size_t i = 0; i < features->size(); ++i) {
+    const FeatureArray& feature_array = features->get(i);
+    const ScoreArray& score_array = scores->get(i);
+    UTIL_THROW_IF(feature_array.getIndex() != score_array.getIndex() || feature_array.size() != score_array.size(),
+                  util::Exception, "Feature and score data of sentence " << feature_array.getIndex() << " do not match");
+    const size_t stored_sentence = store.get() ? store->FindSentence(feature_array.getIndex()) : 0;
+    const bool in_store = store.get() && stored_sentence < store->size();
+    AddedCandidates sentence_added;
+    const size_t sentence_first = hash_index.size();
+
+    for (size_t j = 0; j < feature_array.size(); ++j) {
+      const FeatureStats& feature_stats = feature_array.get(j);
+      const ScoreStats& stats = score_array.get(j);
+      UTIL_THROW_IF(feature_stats.size() != num_dense || stats.size() != num_scores, util::Exception,
+                    "Sentence " << feature_array.getIndex() << " has " << feature_stats.size() << " dense features and "
+                    << stats.size() << " scores instead of " << num_dense << " and " << num_scores);
+
+      sparse.clear();
+      const SparseVector& sparse_vector = feature_stats.getSparse();
+      const vector<size_t> feats = sparse_vector.feats();
+      for (size_t k = 0; k < feats.size(); ++k) {
+        const string name = StoredSparseName(feats[k]);
+        boost::unordered_map<string, uint32_t>::const_iterator it = name_ids.find(name);
+        uint32_t id;
+        if (it == name_ids.end()) {
+          id = name_ids.size();
+          name_ids[name] = id;
+          new_names.push_back(name);
+        } else {
+          id = it->second;
+        }
+        sparse.push_back(make_pair(id, sparse_vector.get(feats[k])));
+      }
+      sort(sparse.begin(), sparse.end());
+      vector<uint32_t> ids(sparse.size());
+      vector<FeatureStatsType> values(sparse.size());
+      for (size_t k = 0; k < sparse.size(); ++k) {
+        ids[k] = sparse[k].first;
+        values[k] = sparse[k].second;
+      }
+
+      NbestStoreCandidate candidate;
+      candidate.dense = feature_stats.getArray();
+      candidate.scores = stats.getArray();
+      candidate.sparse_ids = ids.empty() ? NULL : &ids[0];
+      candidate.sparse_values = values.empty() ? NULL : &values[0];
+      candidate.sparse_size = ids.size();
+      const uint64_t hash = HashCandidate(candidate.dense, num_dense, candidate.scores, num_scores,
+                                          candidate.sparse_ids, candidate.sparse_values, candidate.sparse_size);
+      bool duplicate = in_store && store->Holds(stored_sentence, candidate, hash);
+      pair<AddedCandidates::const_iterator, AddedCandidates::const_iterator> now = sentence_added.equal_range(hash);
+      for (AddedCandidates::const_iterator it = now.first; it != now.second && !duplicate; ++it) {
+        const size_t k = it->second;
+        NbestStoreCandidate other;
+        other.dense = &dense[k * num_dense];
+        other.scores = &score_stats[k * num_scores];
+        other.sparse_ids = sparse_ids.empty() ? NULL : &sparse_ids[0] + sparse_offsets[k];
+        other.sparse_values = sparse_values.empty() ? NULL : &sparse_values[0] + sparse_offsets[k];
+        other.sparse_size = sparse_offsets[k + 1] - sparse_offsets[k];
+        duplicate = SameCandidate(candidate, other, num_dense, num_scores);
+      }
+      if (duplicate) continue;
+      sentence_added.insert(make_pair(hash, sparse_offsets.size() - 1));
+      hash_index.push_back(make_pair(hash, static_cast<uint32_t>(hash_index.size() - sentence_first)));
+
+      if (sentence_indices.empty() || sentence_indices.back() != static_cast<uint64_t>(feature_array.getIndex())) {
+        sentence_indices.push_back(feature_array.getIndex());
+        sentence_offsets.push_back(sentence_offsets.back());
+      }
+      ++sentence_offsets.back();
+      dense.insert(dense.end(), feature_stats.getArray(), feature_stats.getArray() + num_dense);
+      score_stats.insert(score_stats.end(), stats.getArray(), stats.getArray() + num_scores);
+      sparse_ids.insert(sparse_ids.end(), ids.begin(), ids.end());
+      sparse_values.insert(sparse_values.end(), values.begin(), values.end());
+      sparse_offsets.push_back(sparse_ids.size());
+    }
+    sort(hash_index.begin() + sentence_first, hash_index.end());
+  }
+
+  const size_t num_candidates = sparse_offsets.size() - 1;
+  const int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+  UTIL_THROW_IF(-1 == fd, util::ErrnoException, "while opening " << file);
+  util::scoped_fd out(fd);
+  // Cut off a block that a killed run left half written, so the new one
+  // follows the last complete block
+  if (store.get() && util::SizeOrThrow(out.get()) != store->m_bytes)
+    util::ResizeOrThrow(out.get(), store->m_bytes);
+  if (!num_candidates) return 0;
+
+  string strings;
+  strings.append(score_type).push_back('\0');
+  strings.append(feature_names).push_back('\0');
+  for (size_t i = 0; i < new_names.size(); ++i) {
+    strings.append(new_names[i]).push_back('\0');
+  }
+  strings.resize(Align8(strings.size()), '\0');
+
+  BlockHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_dense = num_dense;
+  header.num_scores = num_scores;
+  header.num_sentences = sentence_indices.size();
+  header.num_candidates = num_candidates;
+  header.num_sparse = sparse_ids.size();
+  header.num_names = name_ids.size() - num_old_names;
+  header.string_bytes = strings.size();
+  header.bytes = sizeof(header) + strings.size()
+                 + (2 * sentence_indices.size() + 1) * sizeof(uint64_t)
+                 + Align8(dense.size() * sizeof(FeatureStatsType))
+                 + Align8(score_stats.size() * sizeof(ScoreStatsType))
+                 + sparse_offsets.size() * sizeof(uint64_t)
+                 + Align8(sparse_ids.size() * sizeof(uint32_t))
+                 + Align8(sparse_values.size() * sizeof(FeatureStatsType))
+                 + num_candidates * sizeof(uint64_t)
+                 + Align8(num_candidates * sizeof(uint32_t));
+
+  WriteAligned(out.get(), &header, sizeof(header));
+  WriteAligned(out.get(), strings.data(), strings.size());
+  WriteAligned(out.get(), sentence_indices);
+  WriteAligned(out.get(), sentence_offsets);
+  WriteAligned(out.get(), dense);
+  WriteAligned(out.get(), score_stats);
+  WriteAligned(out.get(), sparse_offsets);
+  WriteAligned(out.get(), sparse_ids);
+  WriteAligned(out.get(), sparse_values);
+  vector<uint64_t> hashes(num_candidates);
+  vector<uint32_t> hash_order(num_candidates);
+  for (size_t k = 0; k < num_candidates; ++k) {
+    hashes[k] = hash_index[k].first;
+    hash_order[k] = hash_index[k].second;
+  }
+  WriteAligned(out.get(), hashes);
+  WriteAligned(out.get(), hash_order);
+  return num_candidates;
+}
+
+NbestStore::NbestStore(const string& file, util::LoadMethod method)
+  : m_bytes(0), m_num_dense(0), m_num_scores(0)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(file.c_str()));
+  const uint64_t file_size = util::SizeOrThrow(fd.get());
+  if (!file_size) return;
+  util::MapRead(method, fd.get(), 0, file_size, m_mem);
+
+  map<int, Sentence> sentences;
+  const char* begin = static_cast<const char*>(m_mem.get());
+  for (uint64_t offset = 0; offset < file_size;) {
+    // A block is appended in one go, so only the last one can be incomplete,
+    // if the run writing it was killed. It is ignored, and cut off by the
+    // next Append.
+    const BlockHeader* header = reinterpret_cast<const BlockHeader*>(begin + offset);
+    if (file_size - offset < sizeof(BlockHeader) || header->bytes > file_size - offset) {
+      UTIL_THROW_IF(file_size - offset >= sizeof(kMagic) && memcmp(header->magic, kMagic, sizeof(kMagic)),
+                    util::Exception, file << " is not an n-best store");
+      cerr << "Ignoring the incomplete last block of n-best store " << file << endl;
+      break;
+    }
+    UTIL_THROW_IF(memcmp(header->magic, kMagic, sizeof(kMagic)), util::Exception, file << " is not an n-best store");
+    UTIL_THROW_IF(header->version != kVersion, util::Exception,
+                  "N-best store " << file << " has version " << header->version << " but this code reads version " << kVersion);
+
+    // Score type, dense feature names, then the new sparse feature names
+    const char* strings = reinterpret_cast<const char*>(header + 1);
+    const char* strings_end = strings + header->string_bytes;
+    vector<StringPiece> names;
+    for (const char* i = strings; names.size() < header->num_names + 2;) {
+      const char* end = static_cast<const char*>(memchr(i, '\0', strings_end - i));
+      UTIL_THROW_IF(!end, util::Exception, "N-best store " << file << " has corrupt feature names");
+      names.push_back(StringPiece(i, end - i));
+      i = end + 1;
+    }
+    if (m_blocks.empty()) {
+      m_num_dense = header->num_dense;
+      m_num_scores = header->num_scores;
+      m_score_type = names[0].as_string();
+      m_features = names[1].as_string();
+    }
+    UTIL_THROW_IF(header->num_dense != m_num_dense || header->num_scores != m_num_scores || names[0] != m_score_type,
+                  util::Exception, "Blocks of n-best store " << file << " do not match");
+    m_sparse_names.insert(m_sparse_names.end(), names.begin() + 2, names.end());
+
+    Block block;
+    const uint64_t* sentence_indices = reinterpret_cast<const uint64_t*>(strings_end);
+    block.sentence_offsets = sentence_indices + header->num_sentences;
+    block.dense = reinterpret_cast<const FeatureStatsType*>(block.sentence_offsets + header->num_sentences + 1);
+    block.scores = reinterpret_cast<const ScoreStatsType*>(
+                     reinterpret_cast<const char*>(block.dense) + Align8(header->num_candidates * m_num_dense * sizeof(FeatureStatsType)));
+    block.sparse_offsets = reinterpret_cast<const uint64_t*>(
+                             reinterpret_cast<const char*>(block.scores) + Align8(header->num_candidates * m_num_scores * sizeof(ScoreStatsType)));
+    block.sparse_ids = reinterpret_cast<const uint32_t*>(block.sparse_offsets + header->num_candidates + 1);
+    block.sparse_values = reinterpret_cast<const FeatureStatsType*>(
+                            reinterpret_cast<const char*>(block.sparse_ids) + Align8(header->num_sparse * sizeof(uint32_t)));
+    block.hashes = reinterpret_cast<const uint64_t*>(
+                     reinterpret_cast<const char*>(block.sparse_values) + Align8(header->num_sparse * sizeof(FeatureStatsType)));
+    block.hash_order = reinterpret_cast<const uint32_t*>(block.hashes + header->num_candidates);
+    const char* end = reinterpret_cast<const char*>(block.hash_order) + Align8(header->num_candidates * sizeof(uint32_t));
+    UTIL_THROW_IF(end != begin + offset + header->bytes, util::Exception, "N-best store " << file << " has a corrupt block");
+
+    for (uint64_t s = 0; s < header->num_sentences; ++s) {
+      Sentence& sentence = sentences[sentence_indices[s]];
+      Segment segment;
+      segment.block = m_blocks.size();
+      segment.first = block.sentence_offsets[s];
+      segment.size = block.sentence_offsets[s + 1] - block.sentence_offsets[s];
+      sentence.segments.push_back(segment);
+    }
+    m_blocks.push_back(block);
+    offset += header->bytes;
+    m_bytes = offset;
+  }
+
+  m_sentences.reserve(sentences.size());
+  for (map<int, Sentence>::iterator it = sentences.begin(); it != sentences.end(); ++it) {
+    m_sentences.push_back(Sentence());
+    Sentence& sentence = m_sentences.back();
+    sentence.index = it->first;
+    sentence.size = 0;
+    sentence.segments.swap(it->second.segments);
+    for (size_t i = 0; i < sentence.segments.size(); ++i) {
+      sentence.size += sentence.segments[i].size;
+    }
+  }
+
+  m_sparse_vector_ids.reserve(m_sparse_names.size());
+  for (size_t id = 0; id < m_sparse_names.size(); ++id) {
+    m_sparse_vector_ids.push_back(SparseVector::encode(m_sparse_names[id].as_string()));
+  }
+}
+
+NbestStoreCandidate NbestStore::get(size_t i, size_t j) const
+{
+  const Sentence& sentence = m_sentences[i];
+  size_t s = 0;
+  for (; j >= sentence.segments[s].size; ++s) {
+    j -= sentence.segments[s].size;
+  }
+  return Candidate(m_blocks[sentence.segments[s].block], sentence.segments[s].first + j);
+}
+
+NbestStoreCandidate NbestStore::Candidate(const Block& block, uint64_t candidate) const
+{
+  NbestStoreCandidate ret;
+  ret.dense = block.dense + candidate * m_num_dense;
+  ret.scores = block.scores + candidate * m_num_scores;
+  ret.sparse_ids = block.sparse_ids + block.sparse_offsets[candidate];
+  ret.sparse_values = block.sparse_values + block.sparse_offsets[candidate];
+  ret.sparse_size = block.sparse_offsets[candidate + 1] - block.sparse_offsets[candidate];
+  return ret;
+}
+
+size_t NbestStore::FindSentence(int index) const
+{
+  size_t first = 0, last = m_sentences.size();
+  while (first < last) {
+    const size_t middle = first + (last - first) / 2;
+    if (m_sentences[middle].index < index) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return (first < m_sentences.size() && m_sentences[first].index == index) ? first : m_sentences.size();
+}
+
+bool NbestStore::Holds(size_t i, const NbestStoreCandidate& candidate, uint64_t hash) const
+{
+  const Sentence& sentence = m_sentences[i];
+  for (size_t s = 0; s < sentence.segments.size(); ++s) {
+    const Segment& segment = sentence.segments[s];
+    const Block& block = m_blocks[segment.block];
+    const uint64_t* begin = block.hashes + segment.first;
+    const uint64_t* end = begin + segment.size;
+    for (const uint64_t* it = lower_bound(begin, end, hash); it != end && *it == hash; ++it) {
+      const uint64_t other = segment.first + block.hash_order[it - block.hashes];
+      if (SameCandidate(candidate, Candidate(block, other), m_num_dense, m_num_scores)) return true;
+    }
+  }
+  return false;
+}
+
+void NbestStore::get(size_t i, size_t j, FeatureDataItem& item) const
+{
+  const NbestStoreCandidate c = get(i, j);
+  item.dense.assign(c.dense, c.dense + m_num_dense);
+  item.sparse.clear();
+  for (size_t k = 0; k < c.sparse_size; ++k) {
+    item.sparse.set(m_sparse_vector_ids[c.sparse_ids[k]], c.sparse_values[k]);
+  }
+}
+
+}
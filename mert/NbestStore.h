@@ -0,0 +1,172 @@
+/*
+ *  NbestStore.h
+ *  mert - Minimum Error Rate Training
+ *
+ *  A binary, memory-mapped store of the n-best feature and score statistics
+ *  accumulated over the tuning iterations.
+ */
+
+#ifndef MERT_NBEST_STORE_H_
+#define MERT_NBEST_STORE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+#include "Types.h"
+
+namespace MosesTuning
+{
+
+class Data;
+class FeatureDataItem;
+
+/**
+ * One candidate of a sentence. All pointers point into the mapped store.
+ */
+struct NbestStoreCandidate {
+  const FeatureStatsType* dense;
+  const ScoreStatsType* scores;
+  // Ids into the sparse feature names of the store, in increasing order.
+  const uint32_t* sparse_ids;
+  const FeatureStatsType* sparse_values;
+  std::size_t sparse_size;
+};
+
+/**
+ * The store is a sequence of blocks, one per call to Append. Each block holds
+ * the candidates it adds in columns: dense features, score statistics and
+ * sparse features, with sentence offsets. Sparse feature names are interned
+ * once, in the block that first uses them, and referred to by id afterwards.
+ * Each block ends with an index of the candidates of each sentence sorted by
+ * hash, so Append finds duplicates without reading the candidates of the
+ * store into memory. A store is read zero-copy by mapping it. A block left incomplete by a
+ * killed run is ignored when reading and cut off by the next Append.
+ */
+class NbestStore
+{
+public:
+  /**
+   * Append the candidates of data that the store does not hold yet as a new
+   * block, creating the store if it does not exist. Candidates are found by
+   * a hash of their features and statistics and then compared in full.
+   * Returns the number of candidates added.
+   */
+  static std::size_t Append(const std::string& file, Data& data);
+
+  explicit NbestStore(const std::string& file, util::LoadMethod method = util::LAZY);
+
+  /**
+   * Number of sentences, in increasing order of their index.
+   */
+  std::size_t size() const {
+    return m_sentences.size();
+  }
+
+  int getIndex(std::size_t i) const {
+    return m_sentences[i].index;
+  }
+
+  std::size_t NumberOfCandidates(std::size_t i) const {
+    return m_sentences[i].size;
+  }
+
+  NbestStoreCandidate get(std::size_t i, std::size_t j) const;
+
+  /**
+   * Copy candidate j of sentence i, with the sparse features in the ids of
+   * SparseVector.
+   */
+  void get(std::size_t i, std::size_t j, FeatureDataItem& item) const;
+
+  std::size_t NumberOfFeatures() const {
+    return m_num_dense;
+  }
+
+  /**
+   * Names of the dense features, as in the header of a feature file.
+   */
+  const std::string& Features() const {
+    return m_features;
+  }
+
+  std::size_t NumberOfScores() const {
+    return m_num_scores;
+  }
+
+  const std::string& ScoreType() const {
+    return m_score_type;
+  }
+
+  std::size_t NumberOfSparse() const {
+    return m_sparse_names.size();
+  }
+
+  StringPiece SparseName(std::size_t id) const {
+    return m_sparse_names[id];
+  }
+
+  /**
+   * The SparseVector id of each sparse feature of the store.
+   */
+  const std::vector<std::size_t>& SparseVectorIds() const {
+    return m_sparse_vector_ids;
+  }
+
+private:
+  struct Block {
+    const uint64_t* sentence_offsets;
+    const FeatureStatsType* dense;
+    const ScoreStatsType* scores;
+    const uint64_t* sparse_offsets;
+    const uint32_t* sparse_ids;
+    const FeatureStatsType* sparse_values;
+    // Sorted hashes of the candidates of each sentence, and the index of
+    // each within the sentence
+    const uint64_t* hashes;
+    const uint32_t* hash_order;
+  };
+
+  // Candidates [first, first + size) of a sentence in one block.
+  struct Segment {
+    std::size_t block;
+    uint64_t first;
+    uint64_t size;
+  };
+
+  struct Sentence {
+    int index;
+    std::size_t size;
+    std::vector<Segment> segments;
+  };
+
+  util::scoped_memory m_mem;
+  // Size of the complete blocks
+  uint64_t m_bytes;
+
+  std::size_t m_num_dense;
+  std::size_t m_num_scores;
+  std::string m_features;
+  std::string m_score_type;
+  std::vector<StringPiece> m_sparse_names;
+  std::vector<std::size_t> m_sparse_vector_ids;
+
+  std::vector<Block> m_blocks;
+  std::vector<Sentence> m_sentences;
+
+  NbestStoreCandidate Candidate(const Block& block, uint64_t candidate) const;
+
+  // The position of the sentence with this index, or size() if there is none.
+  std::size_t FindSentence(int index) const;
+
+  // Whether sentence i holds the candidate, whose hash is given.
+  bool Holds(std::size_t i, const NbestStoreCandidate& candidate, uint64_t hash) const;
+};
+
+}
+
+#endif  // MERT_NBEST_STORE_H_
@@ -0,0 +1,195 @@
+#include "NbestStore.h"
+
+#define BOOST_TEST_MODULE MertNbestStore
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Data.h"
+#include "FeatureDataIterator.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "TestData.h"
+
+using namespace MosesTuning;
+
+namespace
+{
+
+void AddCandidate(Data& data, int sentence, float dense, float sparse)
+{
+  FeatureStats features;
+  features.add(dense);
+  features.add(1.0);
+  if (sparse != 0) features.addSparse("pp_x=", sparse);
+  data.getFeatureData()->add(features, sentence);
+
+  ScoreStats scores;
+  for (int i = 0; i < 9; ++i) scores.add(i + dense);
+  data.getScoreData()->add(scores, sentence);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(store_append_dedup)
+{
+  TempFile file;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 0, 1.0, 0.5);
+    AddCandidate(data, 0, 2.0, 0);
+    AddCandidate(data, 1, 3.0, 0);
+    BOOST_CHECK_EQUAL(NbestStore::Append(file.path.string(), data), (std::size_t)3);
+    // The same candidates again
+    BOOST_CHECK_EQUAL(NbestStore::Append(file.path.string(), data), (std::size_t)0);
+  }
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 1, 3.0, 0);
+    AddCandidate(data, 1, 4.0, 0.25);
+    AddCandidate(data, 2, 5.0, 0);
+    BOOST_CHECK_EQUAL(NbestStore::Append(file.path.string(), data), (std::size_t)2);
+  }
+
+  NbestStore store(file.path.string());
+  BOOST_CHECK_EQUAL(store.ScoreType(), "BLEU");
+  BOOST_CHECK_EQUAL(store.NumberOfFeatures(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(store.NumberOfScores(), (std::size_t)9);
+  BOOST_REQUIRE_EQUAL(store.size(), (std::size_t)3);
+  BOOST_CHECK_EQUAL(store.NumberOfCandidates(0), (std::size_t)2);
+  BOOST_CHECK_EQUAL(store.NumberOfCandidates(1), (std::size_t)2);
+  BOOST_CHECK_EQUAL(store.NumberOfCandidates(2), (std::size_t)1);
+  BOOST_CHECK_EQUAL(store.getIndex(2), 2);
+
+  // Sparse feature names are interned once, without the trailing '='
+  BOOST_REQUIRE_EQUAL(store.NumberOfSparse(), (std::size_t)1);
+  BOOST_CHECK_EQUAL(store.SparseName(0), "pp_x");
+
+  // The second candidate of sentence 1 comes from the second block
+  NbestStoreCandidate c = store.get(1, 1);
+  BOOST_CHECK_EQUAL(c.dense[0], 4.0);
+  BOOST_CHECK_EQUAL(c.scores[8], 12.0);
+  BOOST_REQUIRE_EQUAL(c.sparse_size, (std::size_t)1);
+  BOOST_CHECK_EQUAL(c.sparse_ids[0], (uint32_t)0);
+  BOOST_CHECK_EQUAL(c.sparse_values[0], 0.25);
+
+  FeatureDataItem item;
+  store.get(0, 0, item);
+  BOOST_CHECK_EQUAL(item.dense.size(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(item.sparse.get("pp_x"), 0.5);
+
+  Data data(scorer.get());
+  data.loadStore(boost::shared_ptr<const NbestStore>(new NbestStore(file.path.string())));
+  BOOST_CHECK_EQUAL(data.getFeatureData()->size(), (std::size_t)3);
+  BOOST_CHECK_EQUAL(data.getScoreData()->size(), (std::size_t)3);
+  BOOST_CHECK_EQUAL(data.NumberOfFeatures(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(data.getFeatureData()->get(1).size(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(data.getFeatureData()->get(0, 0).getSparse().get("pp_x"), 0.5);
+  BOOST_CHECK_EQUAL(data.getScoreData()->get(2, 0).get(0), 5.0);
+}
+
+BOOST_AUTO_TEST_CASE(store_torn_block)
+{
+  TempFile file;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 0, 1.0, 0.5);
+    NbestStore::Append(file.path.string(), data);
+  }
+  const uintmax_t complete = boost::filesystem::file_size(file.path);
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 1, 2.0, 0);
+    NbestStore::Append(file.path.string(), data);
+  }
+  // As if the run writing the second block had been killed
+  boost::filesystem::resize_file(file.path, complete + sizeof(uint64_t) * 12);
+  {
+    NbestStore store(file.path.string());
+    BOOST_REQUIRE_EQUAL(store.size(), (std::size_t)1);
+    BOOST_CHECK_EQUAL(store.getIndex(0), 0);
+  }
+
+  // The next append replaces the incomplete block
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 1, 2.0, 0);
+    BOOST_CHECK_EQUAL(NbestStore::Append(file.path.string(), data), (std::size_t)1);
+  }
+  NbestStore store(file.path.string());
+  BOOST_REQUIRE_EQUAL(store.size(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(store.get(1, 0).dense[0], 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(store_append_dedup_over_blocks)
+{
+  TempFile file;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  // Each append adds one candidate to every sentence, which the hash index
+  // of a different block then holds
+  for (int block = 0; block < 4; ++block) {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    for (int sentence = 0; sentence < 3; ++sentence) {
+      for (int k = 0; k <= block; ++k) {
+        AddCandidate(data, sentence, 10 * sentence + k, k % 2 ? 0.5 : 0);
+      }
+    }
+    BOOST_CHECK_EQUAL(NbestStore::Append(file.path.string(), data), (std::size_t)3);
+  }
+
+  NbestStore store(file.path.string());
+  BOOST_REQUIRE_EQUAL(store.size(), (std::size_t)3);
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(store.NumberOfCandidates(i), (std::size_t)4);
+    for (std::size_t j = 0; j < 4; ++j) {
+      BOOST_CHECK_EQUAL(store.get(i, j).dense[0], 10.0 * i + j);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(store_load_views)
+{
+  TempFile file;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  {
+    Data data(scorer.get());
+    data.getFeatureData()->setFeatureMap("d_0 w_0");
+    AddCandidate(data, 0, 1.0, 0);
+    AddCandidate(data, 0, 2.0, 0);
+    NbestStore::Append(file.path.string(), data);
+  }
+
+  boost::shared_ptr<const NbestStore> store(new NbestStore(file.path.string()));
+  Data data(scorer.get());
+  data.loadStore(store);
+  // The statistics point into the mapped store
+  const FeatureStats& features = data.getFeatureData()->get(0, 1);
+  BOOST_CHECK(features.getArray() == store->get(0, 1).dense);
+  BOOST_CHECK(data.getScoreData()->get(0, 1).getArray() == store->get(0, 1).scores);
+
+  // Changing the statistics copies them, and leaves the store alone
+  FeatureStats changed = features;
+  BOOST_CHECK(changed.getArray() == features.getArray());
+  changed.add(3.0);
+  BOOST_CHECK(changed.getArray() != features.getArray());
+  BOOST_CHECK_EQUAL(changed.size(), (std::size_t)3);
+  BOOST_CHECK_EQUAL(changed.get(0), 2.0);
+  ScoreStats scores = data.getScoreData()->get(0, 0);
+  scores.set(std::vector<ScoreStatsType>(9, 0));
+  BOOST_CHECK_EQUAL(scores.get(0), 0);
+  BOOST_CHECK_EQUAL(store->get(0, 0).scores[0], 1.0);
+
+  // The data keeps the store mapped
+  store.reset();
+  BOOST_CHECK_EQUAL(data.getFeatureData()->get(0, 1).get(0), 2.0);
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <string>
+#include <stdint.h>
 
 #include <boost/unordered_map.hpp>
 
+#include "util/murmur_hash.hh"
+#include "util/probing_hash_table.hh"
+
 namespace MosesTuning
 {
 
@@ -118,5 +123,119 @@ private:
   boost::unordered_map<Key, Value> m_counts;
 };
 
-}
+/**
+ * A read-only index of the n-grams of NgramCounts for clipping the counts of
+ * hypotheses. Each n-gram gets an id and is keyed by the id of its prefix and
+ * its last token packed into 64 bits, in a flat linear probing table, so a
+ * hypothesis is matched by walking its tokens without building n-gram keys.
+ * The index does not change while matching, so several threads may match
+ * against it at once.
+ */
+class NgramIndex
+{
+public:
+  // No packed key is all ones, as no n-gram gets id 2^32 - 1
+  NgramIndex() : m_table(16, ~static_cast<uint64_t>(0)) {
+    clear();
+  }
+
+  /**
+   * Index the n-grams of counts, replacing the previous ones.
+   */
+  void Build(const NgramCounts& counts) {
+    clear();
+    for (NgramCounts::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+      uint32_t id = 0;
+      for (std::size_t i = 0; i < it->first.size(); ++i) {
+        Entry entry;
+        entry.key = Pack(id, it->first[i]);
+        entry.id = m_counts.size();
+        Table::MutableIterator found;
+        if (!m_table.FindOrInsert(entry, found)) {
+          // Prefixes missing from counts are indexed with count 0
+          m_counts.push_back(0);
+          m_orders.push_back(i + 1);
+        }
+        id = found->id;
+      }
+      m_counts[id] = it->second;
+    }
+  }
 
+  /**
+   * Match the n-grams of tokens up to order n. For each order k,
+   * clipped[k - 1] is increased by the sum over the distinct n-grams of
+   * min(count in tokens, count in the index), and matched[k - 1] by the sum
+   * of their counts in the index.
+   */
+  template <class Value> void Match(const std::vector<int>& tokens, std::size_t n,
+                                    Value* clipped, Value* matched) const {
+    std::vector<uint32_t> ids;
+    ids.reserve(tokens.size() * n);
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+      uint32_t id = 0;
+      for (std::size_t j = i; j < tokens.size() && j < i + n; ++j) {
+        Table::ConstIterator found;
+        if (!m_table.Find(Pack(id, tokens[j]), found)) break;
+        id = found->id;
+        ids.push_back(id);
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    for (std::vector<uint32_t>::const_iterator it = ids.begin(); it != ids.end();) {
+      std::vector<uint32_t>::const_iterator next = it + 1;
+      while (next != ids.end() && *next == *it) ++next;
+      const int count = m_counts[*it];
+      if (count) {
+        const std::size_t order = m_orders[*it];
+        clipped[order - 1] += std::min<int>(next - it, count);
+        matched[order - 1] += count;
+      }
+      it = next;
+    }
+  }
+
+  /**
+   * Remove all n-grams from the index.
+   */
+  void clear() {
+    m_table.Clear();
+    // id 0 is the empty n-gram
+    m_counts.assign(1, 0);
+    m_orders.assign(1, 0);
+  }
+
+  /**
+   * Number of n-grams in the index, including prefixes with count 0.
+   */
+  std::size_t size() const {
+    return m_counts.size() - 1;
+  }
+
+private:
+  static uint64_t Pack(uint32_t prefix, int token) {
+    return (static_cast<uint64_t>(prefix) << 32) | static_cast<uint32_t>(token);
+  }
+
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    uint32_t id;
+
+    uint64_t GetKey() const {
+      return key;
+    }
+    void SetKey(uint64_t to) {
+      key = to;
+    }
+  };
+
+  // packed keys differ in few bits
+  typedef util::AutoProbing<Entry, util::MurmurMixHash> Table;
+
+  Table m_table;
+  std::vector<int> m_counts;
+  std::vector<std::size_t> m_orders;
+};
+
+}
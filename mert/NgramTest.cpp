@@ -86,3 +86,43 @@ BOOST_AUTO_TEST_CASE(ngram_lookup)
     BOOST_CHECK(!counts.Lookup(key, &v));
   }
 }
+
+BOOST_AUTO_TEST_CASE(ngram_index_match)
+{
+  // Reference "1 2 1 2" up to bigrams
+  NgramCounts counts;
+  NgramCounts::Key key;
+  key.push_back(1);
+  counts[key] = 2;
+  key[0] = 2;
+  counts[key] = 2;
+  key.push_back(1);
+  counts[key] = 1;
+  key[0] = 1;
+  key[1] = 2;
+  counts[key] = 2;
+
+  NgramIndex index;
+  index.Build(counts);
+  BOOST_CHECK_EQUAL(index.size(), 4);
+
+  // Hypothesis "1 1 1 2 3"
+  std::vector<int> tokens;
+  tokens.push_back(1);
+  tokens.push_back(1);
+  tokens.push_back(1);
+  tokens.push_back(2);
+  tokens.push_back(3);
+  int clipped[2] = {0, 0};
+  int matched[2] = {0, 0};
+  index.Match(tokens, 2, clipped, matched);
+  // Unigrams: min(3, 2) for 1 and min(1, 2) for 2
+  BOOST_CHECK_EQUAL(clipped[0], 3);
+  BOOST_CHECK_EQUAL(matched[0], 4);
+  // Bigrams: only "1 2"
+  BOOST_CHECK_EQUAL(clipped[1], 1);
+  BOOST_CHECK_EQUAL(matched[1], 2);
+
+  index.clear();
+  BOOST_CHECK_EQUAL(index.size(), 0);
+}
@@ -8,6 +8,12 @@
 #include <cfloat>
 #include <iostream>
 #include <stdint.h>
+#include <algorithm>
+
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#endif
 
 #include "Point.h"
 #include "Util.h"
@@ -39,7 +45,7 @@ namespace MosesTuning
 
 
 Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool>& pos, const vector<parameter_t>& start, unsigned int nrandom)
-  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_positive(pos)
+  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_num_threads(1), m_positive(pos)
 {
   // Warning: the init vector is a full set of parameters, of dimension m_pdim!
   Point::m_pdim = Pd;
@@ -71,196 +77,219 @@ statscore_t Optimizer::GetStatScore(const Point& param) const
   return score;
 }
 
-map<float,diff_t >::iterator AddThreshold(map<float,diff_t >& thresholdmap, float newt, const pair<unsigned,unsigned>& newdiff)
-{
-  map<float,diff_t>::iterator it = thresholdmap.find(newt);
-  if (it != thresholdmap.end()) {
-    // the threshold already exists!! this is very unlikely
-    if (it->second.back().first == newdiff.first)
-      // there was already a diff for this sentence, we change the 1 best;
-      it->second.back().second = newdiff.second;
-    else
-      it->second.push_back(newdiff);
-  } else {
-    // normal case
-    pair<map<float,diff_t>::iterator, bool> ins = thresholdmap.insert(threshold(newt, diff_t(1, newdiff)));
-    UTIL_THROW_IF(!ins.second, util::Exception, "Error");                // we really inserted something
-    it = ins.first;
-  }
-  return it;
-}
-
-statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+unsigned int Optimizer::SentenceEnvelope(const Point& origin, const Point& direction, unsigned int S, vector<Breakpoint>& breakpoints) const
 {
-  // We are looking for the best Point on the line y=Origin+x*direction
   float min_int = 0.0001;
-  //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
-  //list<threshold> thresholdlist;
-
-  map<float,diff_t> thresholdmap;
-  thresholdmap[MIN_FLOAT] = diff_t();
-  vector<unsigned> first1best;       // the vector of nbests for x=-inf
-  for (unsigned int S = 0; S < size(); S++) {
-    map<float,diff_t >::iterator previnserted = thresholdmap.begin();
-    // First, we determine the translation with the best feature score
-    // for each sentence and each value of x.
-    //cerr << "Sentence " << S << endl;
-    multimap<float, unsigned> gradient;
-    vector<float> f0;
-    f0.resize(m_feature_data->get(S).size());
-    for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
-      // gradient of the feature function for this particular target sentence
-      gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
-      // compute the feature function at the origin point
-      f0[j] = origin * m_feature_data->get(S, j);
-    }
-    // Now let's compute the 1best for each value of x.
-
-    //    vector<pair<float,unsigned> > onebest;
-
+  // Breakpoints of this sentence start at first; the ones before belong to
+  // other sentences of the same shard.
+  const size_t first = breakpoints.size();
+
+  // First, we determine the translation with the best feature score
+  // for each sentence and each value of x.
+  multimap<float, unsigned> gradient;
+  vector<float> f0;
+  f0.resize(m_feature_data->get(S).size());
+  for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
+    // gradient of the feature function for this particular target sentence
+    gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
+    // compute the feature function at the origin point
+    f0[j] = origin * m_feature_data->get(S, j);
+  }
+  // Now let's compute the 1best for each value of x.
 
-    multimap<float,unsigned>::iterator gradientit = gradient.begin();
-    multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
+  multimap<float,unsigned>::iterator gradientit = gradient.begin();
+  multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
 
-    float smallest = gradientit->first;//smallest gradient
-    // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
+  float smallest = gradientit->first;//smallest gradient
+  // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
 
+  gradientit++;
+  while (gradientit != gradient.end() && gradientit->first == smallest) {
+    if (f0[gradientit->second] > f0[highest_f0->second])
+      highest_f0 = gradientit;//the highest line is the one with he highest f0
     gradientit++;
-    while (gradientit != gradient.end() && gradientit->first == smallest) {
-      //   cerr<<"ni"<<gradientit->second<<endl;;
-      //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
-      if (f0[gradientit->second] > f0[highest_f0->second])
-        highest_f0 = gradientit;//the highest line is the one with he highest f0
-      gradientit++;
-    }
+  }
 
-    gradientit = highest_f0;
-    first1best.push_back(highest_f0->second);
-
-    // Now we look for the intersections points indicating a change of 1 best.
-    // We use the fact that the function is convex, which means that the gradient can only go up.
-    while (gradientit != gradient.end()) {
-      map<float,unsigned>::iterator leftmost = gradientit;
-      float m = gradientit->first;
-      float b = f0[gradientit->second];
-      multimap<float,unsigned>::iterator gradientit2 = gradientit;
-      gradientit2++;
-      float leftmostx = MAX_FLOAT;
-      for (; gradientit2 != gradient.end(); gradientit2++) {
-        //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
-        // Look for all candidate with a gradient bigger than the current one, and
-        // find the one with the leftmost intersection.
-        float curintersect;
-        if (m != gradientit2->first) {
-          curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
-          //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
-          if (curintersect<=leftmostx) {
-            // We have found an intersection to the left of the leftmost we had so far.
-            // We might have curintersect==leftmostx for example is 2 candidates are the same
-            // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
-            leftmostx = curintersect;
-            leftmost = gradientit2; // this is the new reference
-          }
+  gradientit = highest_f0;
+  const unsigned int first1best = highest_f0->second;
+
+  // Now we look for the intersections points indicating a change of 1 best.
+  // We use the fact that the function is convex, which means that the gradient can only go up.
+  while (gradientit != gradient.end()) {
+    map<float,unsigned>::iterator leftmost = gradientit;
+    float m = gradientit->first;
+    float b = f0[gradientit->second];
+    multimap<float,unsigned>::iterator gradientit2 = gradientit;
+    gradientit2++;
+    float leftmostx = MAX_FLOAT;
+    for (; gradientit2 != gradient.end(); gradientit2++) {
+      // Look for all candidate with a gradient bigger than the current one, and
+      // find the one with the leftmost intersection.
+      float curintersect;
+      if (m != gradientit2->first) {
+        curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
+        if (curintersect<=leftmostx) {
+          // We have found an intersection to the left of the leftmost we had so far.
+          // We might have curintersect==leftmostx for example is 2 candidates are the same
+          // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
+          leftmostx = curintersect;
+          leftmost = gradientit2; // this is the new reference
         }
       }
-      if (leftmost == gradientit) {
-        // We didn't find any more intersections.
-        // The rightmost bestindex is the one with the highest slope.
-
-        // They should be equal but there might be.
-        UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
-                      util::Exception, "Error");
-        // A small difference due to rounding error
-        break;
+    }
+    if (leftmost == gradientit) {
+      // We didn't find any more intersections.
+      // The rightmost bestindex is the one with the highest slope.
+
+      // They should be equal but there might be.
+      UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
+                    util::Exception, "Error");
+      // A small difference due to rounding error
+      break;
+    }
+    // We have found the next intersection!
+
+    if (breakpoints.size() > first && leftmostx - breakpoints.back().x < min_int) {
+      // Require that the intersection Point be at least min_int to the right of the previous
+      // one (for this sentence). If not, we replace the previous intersection Point with
+      // this one.
+      // Yes, it can even happen that the new intersection Point is slightly to the left of
+      // the old one, because of numerical imprecision. We do not check that we are to the
+      // right of the penultimate point also. We replace the previous one by the new one
+      // because we do not want to keep 2 very close threshold: if the minima is there
+      // it could be an artifact.
+      breakpoints.back().x = leftmostx;
+      breakpoints.back().best = leftmost->second;
+    } else {
+      Breakpoint newbp;
+      newbp.x = leftmostx;
+      newbp.sentence = S;
+      newbp.best = leftmost->second;//new onebest for Sentence S is leftmost->second
+      breakpoints.push_back(newbp);
+    }
+    gradientit = leftmost;
+  } // while (gradientit!=gradient.end()){
+
+  return first1best;
+}
+
+void Optimizer::ShardEnvelopes(const Point& origin, const Point& direction, unsigned int begin, unsigned int end, vector<unsigned>& first1best, vector<Breakpoint>& breakpoints) const
+{
+  for (unsigned int S = begin; S < end; S++) {
+    first1best[S] = SentenceEnvelope(origin, direction, S, breakpoints);
+  }
+  // Stable, so that sentences sharing a threshold stay in order.
+  stable_sort(breakpoints.begin(), breakpoints.end());
+}
+
+void Optimizer::MergeBreakpoints(const vector<Breakpoint>& left, const vector<Breakpoint>& right, vector<Breakpoint>& merged)
+{
+  merged.resize(left.size() + right.size());
+  merge(left.begin(), left.end(), right.begin(), right.end(), merged.begin());
+}
+
+statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+{
+  // We are looking for the best Point on the line y=Origin+x*direction.
+  // The envelope of each sentence only depends on its own n-best list, so the
+  // sentences are split into contiguous shards, one per thread.
+  const unsigned int num_shards = max(1u, min(m_num_threads, size()));
+  vector<unsigned> first1best(size());       // the vector of nbests for x=-inf
+  vector<vector<Breakpoint> > shards(num_shards);
+  {
+#ifdef WITH_THREADS
+    boost::thread_group threads;
+#endif
+    for (unsigned int i = 0; i < num_shards; i++) {
+      const unsigned int begin = size() * i / num_shards;
+      const unsigned int end = size() * (i + 1) / num_shards;
+#ifdef WITH_THREADS
+      if (num_shards > 1) {
+        threads.create_thread(boost::bind(&Optimizer::ShardEnvelopes, this,
+                                          boost::cref(origin), boost::cref(direction), begin, end,
+                                          boost::ref(first1best), boost::ref(shards[i])));
+        continue;
       }
-      // We have found the next intersection!
-
-      pair<unsigned,unsigned> newd(S, leftmost->second);//new onebest for Sentence S is leftmost->second
-
-      if (leftmostx-previnserted->first < min_int) {
-        // Require that the intersection Point be at least min_int to the right of the previous
-        // one (for this sentence). If not, we replace the previous intersection Point with
-        // this one.
-        // Yes, it can even happen that the new intersection Point is slightly to the left of
-        // the old one, because of numerical imprecision. We do not check that we are to the
-        // right of the penultimate point also. It this happen the 1best the interval will
-        // be wrong we are going to replace previnsert by the new one because we do not want to keep
-        // 2 very close threshold: if the minima is there it could be an artifact.
-
-        map<float,diff_t>::iterator tit = thresholdmap.find(leftmostx);
-        if (tit == previnserted) {
-          // The threshold is the same as before can happen if 2 candidates are the same for example.
-          UTIL_THROW_IF(previnserted->second.back().first != newd.first,
-                        util::Exception,
-                        "Error");
-          previnserted->second.back()=newd; // just replace the 1 best for sentence S
-          // previnsert doesn't change
-        } else {
-
-          if (tit == thresholdmap.end()) {
-            thresholdmap[leftmostx]=previnserted->second; // We keep the diffs at previnsert
-            thresholdmap.erase(previnserted); // erase old previnsert
-            previnserted = thresholdmap.find(leftmostx); // point previnsert to the new threshold
-            previnserted->second.back()=newd; // We update the diff for sentence S
-            // Threshold already exists but is not the previous one.
-          } else {
-            // We append the diffs in previnsert to tit before destroying previnsert.
-            tit->second.insert(tit->second.end(),previnserted->second.begin(),previnserted->second.end());
-            UTIL_THROW_IF(tit->second.back().first != newd.first,
-                          util::Exception,
-                          "Error");
-            tit->second.back()=newd;    // change diff for sentence S
-            thresholdmap.erase(previnserted); // erase old previnsert
-            previnserted = tit;  // point previnsert to the new threshold
-          }
-        }
+#endif
+      ShardEnvelopes(origin, direction, begin, end, first1best, shards[i]);
+    }
+#ifdef WITH_THREADS
+    threads.join_all();
+#endif
+  }
 
-        UTIL_THROW_IF(previnserted == thresholdmap.end(),
-                      util::Exception,
-                      "Error");
-      } else { //normal insertion process
-        previnserted = AddThreshold(thresholdmap, leftmostx, newd);
+  // Merge the sorted breakpoint lists pairwise until one is left. Left shards
+  // hold lower sentence indices, and merge keeps them first on ties.
+  while (shards.size() > 1) {
+    vector<vector<Breakpoint> > merged((shards.size() + 1) / 2);
+#ifdef WITH_THREADS
+    boost::thread_group threads;
+#endif
+    for (size_t i = 0; i < merged.size(); i++) {
+      if (2 * i + 1 == shards.size()) {
+        merged[i].swap(shards[2 * i]);
+        continue;
       }
-      gradientit = leftmost;
-    } // while (gradientit!=gradient.end()){
-  }   // loop on S
+#ifdef WITH_THREADS
+      threads.create_thread(boost::bind(&Optimizer::MergeBreakpoints,
+                                        boost::cref(shards[2 * i]), boost::cref(shards[2 * i + 1]),
+                                        boost::ref(merged[i])));
+#else
+      MergeBreakpoints(shards[2 * i], shards[2 * i + 1], merged[i]);
+#endif
+    }
+#ifdef WITH_THREADS
+    threads.join_all();
+#endif
+    shards.swap(merged);
+  }
+  const vector<Breakpoint>& breakpoints = shards.front();
 
-  // Now the thresholdlist is up to date: it contains a list of all the parameter_ts where
-  // the function changed its value, along with the nbest list for the interval after each threshold.
+  // Group the breakpoints into thresholds: the parameter_ts where the function
+  // changes its value, along with the nbest diffs for the interval after each
+  // threshold. The first threshold corresponds to MIN_FLOAT and first1best.
+  vector<float> thresholds(1, MIN_FLOAT);
+  diffs_t diffs;
+  for (size_t i = 0; i < breakpoints.size(); i++) {
+    const pair<unsigned,unsigned> newd(breakpoints[i].sentence, breakpoints[i].best);
+    if (breakpoints[i].x != thresholds.back()) {
+      thresholds.push_back(breakpoints[i].x);
+      diffs.push_back(diff_t(1, newd));
+    } else if (diffs.empty()) {
+      // this is very unlikely, a change of 1 best at MIN_FLOAT
+      first1best[newd.first] = newd.second;
+    } else if (diffs.back().back().first == newd.first) {
+      // there was already a diff for this sentence, we change the 1 best;
+      diffs.back().back().second = newd.second;
+    } else {
+      diffs.back().push_back(newd);
+    }
+  }
 
-  map<float,diff_t >::iterator thrit;
   if (verboselevel() > 6) {
-    cerr << "Thresholds:(" << thresholdmap.size() << ")" << endl;
-    for (thrit = thresholdmap.begin(); thrit != thresholdmap.end(); thrit++) {
-      cerr << "x: " << thrit->first << " diffs";
-      for (size_t j = 0; j < thrit->second.size(); ++j) {
-        cerr << " " <<thrit->second[j].first << "," << thrit->second[j].second;
+    cerr << "Thresholds:(" << thresholds.size() << ")" << endl;
+    for (size_t t = 1; t < thresholds.size(); t++) {
+      cerr << "x: " << thresholds[t] << " diffs";
+      for (size_t j = 0; j < diffs[t - 1].size(); ++j) {
+        cerr << " " << diffs[t - 1][j].first << "," << diffs[t - 1][j].second;
       }
       cerr << endl;
     }
   }
 
   // Last thing to do is compute the Stat score (i.e., BLEU) and find the minimum.
-  thrit = thresholdmap.begin();
-  ++thrit;       // first diff corrrespond to MIN_FLOAT and first1best
-  diffs_t diffs;
-  for (; thrit != thresholdmap.end(); thrit++)
-    diffs.push_back(thrit->second);
   vector<statscore_t> scores = GetIncStatScore(first1best, diffs);
 
-  thrit = thresholdmap.begin();
   statscore_t bestscore = MIN_FLOAT;
   float bestx = MIN_FLOAT;
 
-  // We skipped the first el of thresholdlist but GetIncStatScore return 1 more for first1best.
-  UTIL_THROW_IF(scores.size() != thresholdmap.size(),
+  // GetIncStatScore return 1 more than the diffs, for first1best.
+  UTIL_THROW_IF(scores.size() != thresholds.size(),
                 util::Exception,
                 "Error");
   for (unsigned int sc = 0; sc != scores.size(); sc++) {
-    //cerr << "x=" << thrit->first << " => " << scores[sc] << endl;
-
     //enforce positivity
-    Point respoint = origin + direction * thrit->first;
+    Point respoint = origin + direction * thresholds[sc];
     bool is_valid = true;
     for (unsigned int k=0; k < respoint.getdim(); k++) {
       if (m_positive[k] && respoint[k] <= 0.0)
@@ -268,9 +297,9 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
     }
 
     if (is_valid && scores[sc] > bestscore) {
-      // This is the score for the interval [lit2->first, (lit2+1)->first]
+      // This is the score for the interval [thresholds[sc], thresholds[sc+1]]
       // unless we're at the last score, when it's the score
-      // for the interval [lit2->first,+inf].
+      // for the interval [thresholds[sc],+inf].
       bestscore = scores[sc];
 
       // If we're not in [-inf,x1] or [xn,+inf], then just take the value
@@ -278,17 +307,14 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       // take x to be the last interval boundary + 0.1, and for the leftmost
       // interval, take x to be the first interval boundary - 1000.
       // These values are taken from cmert.
-      float leftx = thrit->first;
-      if (thrit == thresholdmap.begin()) {
+      float leftx = thresholds[sc];
+      if (sc == 0) {
         leftx = MIN_FLOAT;
       }
-      ++thrit;
       float rightx = MAX_FLOAT;
-      if (thrit != thresholdmap.end()) {
-        rightx = thrit->first;
+      if (sc + 1 < thresholds.size()) {
+        rightx = thresholds[sc + 1];
       }
-      --thrit;
-      //cerr << "leftx: " << leftx << " rightx: " << rightx << endl;
       if (leftx == MIN_FLOAT) {
         bestx = rightx-1000;
       } else if (rightx == MAX_FLOAT) {
@@ -296,9 +322,7 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       } else {
         bestx = 0.5 * (rightx + leftx);
       }
-      //cerr << "x = " << "set new bestx to: " << bestx << endl;
     }
-    ++thrit;
   }
 
   if (abs(bestx) < 0.00015) {
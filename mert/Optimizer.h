@@ -25,9 +25,35 @@ protected:
   Scorer *m_scorer;      // no accessor for them only child can use them
   FeatureDataHandle m_feature_data;  // no accessor for them only child can use them
   unsigned int m_num_random_directions;
+  unsigned int m_num_threads;
 
   const std::vector<bool>& m_positive;
 
+  /**
+   * A change of the 1-best of one sentence at position x on the line.
+   */
+  struct Breakpoint {
+    float x;
+    unsigned int sentence;
+    unsigned int best;
+    bool operator<(const Breakpoint& other) const {
+      return x < other.x;
+    }
+  };
+
+  /**
+   * Compute the upper envelope of the n-best list of sentence S along the line:
+   * the 1-best at x=-inf and the points where it changes, in increasing x.
+   */
+  unsigned int SentenceEnvelope(const Point& origin, const Point& direction, unsigned int S, std::vector<Breakpoint>& breakpoints) const;
+
+  /**
+   * Envelopes of sentences [begin,end), with their breakpoints sorted by x.
+   */
+  void ShardEnvelopes(const Point& origin, const Point& direction, unsigned int begin, unsigned int end, std::vector<unsigned>& first1best, std::vector<Breakpoint>& breakpoints) const;
+
+  static void MergeBreakpoints(const std::vector<Breakpoint>& left, const std::vector<Breakpoint>& right, std::vector<Breakpoint>& merged);
+
 public:
   Optimizer(unsigned Pd, const std::vector<unsigned>& i2O, const std::vector<bool>& positive, const std::vector<parameter_t>& start, unsigned int nrandom);
 
@@ -37,6 +63,12 @@ public:
   void SetFeatureData(FeatureDataHandle feature_data) {
     m_feature_data = feature_data;
   }
+  /**
+   * Number of threads for the envelope computation of each line search.
+   */
+  void SetNumThreads(unsigned int num_threads) {
+    m_num_threads = num_threads ? num_threads : 1;
+  }
   virtual ~Optimizer();
 
   unsigned size() const {
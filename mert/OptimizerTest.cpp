@@ -0,0 +1,160 @@
+#include "Optimizer.h"
+
+#define BOOST_TEST_MODULE MertOptimizer
+#include <boost/test/unit_test.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdlib>
+
+#include "Data.h"
+#include "Point.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "TestData.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+const unsigned int kDim = 3;
+const unsigned int kNumSentences = 50;
+const unsigned int kNbestSize = 20;
+
+// Fills data with random features and BLEU statistics.
+void FillData(Data& data)
+{
+  srand(1234);
+  for (unsigned int s = 0; s < kNumSentences; ++s) {
+    for (unsigned int j = 0; j < kNbestSize; ++j) {
+      FeatureStats features;
+      for (unsigned int k = 0; k < kDim; ++k) {
+        // a few integer features, so that some lines are parallel
+        features.add(k == 0 ? rand() % 5 : rand() / static_cast<float>(RAND_MAX));
+      }
+      data.getFeatureData()->add(features, s);
+
+      data.getScoreData()->add(RandomBleuStats(), s);
+    }
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(line_optimize_threads)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  FillData(data);
+
+  vector<unsigned> to_optimize;
+  for (unsigned int k = 0; k < kDim; ++k)
+    to_optimize.push_back(k);
+  vector<parameter_t> start(kDim, 0.3);
+  vector<bool> positive(kDim, false);
+
+  SimpleOptimizer optimizer(kDim, to_optimize, positive, start, 0);
+  optimizer.SetScorer(data.getScorer());
+  optimizer.SetFeatureData(data.getFeatureData());
+
+  vector<parameter_t> min(kDim, -1.0);
+  vector<parameter_t> max(kDim, 1.0);
+  Point origin(start, min, max);
+  for (unsigned int d = 0; d < 10; ++d) {
+    Point direction;
+    if (d < kDim) {
+      for (unsigned int k = 0; k < kDim; ++k)
+        direction[k] = (k == d) ? 1.0 : 0.0;
+    } else {
+      direction.Randomize();
+    }
+
+    optimizer.SetNumThreads(1);
+    Point serial;
+    const statscore_t serial_score = optimizer.LineOptimize(origin, direction, serial);
+    BOOST_CHECK_EQUAL(serial_score, optimizer.GetStatScore(serial));
+
+    for (unsigned int threads = 2; threads <= 7; threads += 5) {
+      optimizer.SetNumThreads(threads);
+      Point parallel;
+      BOOST_CHECK_EQUAL(optimizer.LineOptimize(origin, direction, parallel), serial_score);
+      for (unsigned int k = 0; k < kDim; ++k)
+        BOOST_CHECK_EQUAL(parallel[k], serial[k]);
+    }
+  }
+}
+
+namespace
+{
+
+ScoreStats BleuStats(bool good)
+{
+  ScoreStats scores;
+  for (int n = 1; n <= 4; ++n) {
+    const int total = 10 - n + 1;
+    scores.add(good ? total : 0);
+    scores.add(total);
+  }
+  scores.add(10);
+  return scores;
+}
+
+void AddCandidate(Data& data, unsigned int sentence, float slope, float intercept, bool good)
+{
+  FeatureStats features;
+  features.add(slope);
+  features.add(intercept);
+  data.getFeatureData()->add(features, sentence);
+  data.getScoreData()->add(BleuStats(good), sentence);
+}
+
+} // namespace
+
+// Along the direction (1,0) from the origin (0,1), a candidate with features
+// (a,b) scores a*x+b.  Sentence 0 changes from A to B at x=1.  Sentence 1
+// changes from C to D at x=1 and from D to E at x=1.00005, closer than
+// min_int, so its two breakpoints collapse into one at x=1.00005 that goes
+// straight to E.  Only the breakpoint of sentence 1 may move: sentence 0
+// still switches to B at x=1, so (B,C) is the 1-best in [1,1.00005).  If the
+// whole threshold at x=1 moved, the line search would only see (A,C) and
+// (B,E), which both score 0.5.
+BOOST_AUTO_TEST_CASE(line_optimize_collapse_breakpoint)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  AddCandidate(data, 0, 0.0, 0.0, false);       // A
+  AddCandidate(data, 0, 1.0, -1.0, true);       // B
+  AddCandidate(data, 1, 0.0, 0.0, true);        // C
+  AddCandidate(data, 1, 1.0, -1.0, false);      // D
+  AddCandidate(data, 1, 2.0, -2.00005, false);  // E
+
+  vector<unsigned> to_optimize;
+  to_optimize.push_back(0);
+  to_optimize.push_back(1);
+  vector<parameter_t> start;
+  start.push_back(0.0);
+  start.push_back(1.0);
+  vector<bool> positive(2, false);
+
+  SimpleOptimizer optimizer(2, to_optimize, positive, start, 0);
+  optimizer.SetScorer(data.getScorer());
+  optimizer.SetFeatureData(data.getFeatureData());
+
+  vector<parameter_t> min(2, -10.0);
+  vector<parameter_t> max(2, 10.0);
+  Point origin(start, min, max);
+  vector<parameter_t> along;
+  along.push_back(1.0);
+  along.push_back(0.0);
+  Point direction(along, min, max);
+
+  for (unsigned int threads = 1; threads <= 2; ++threads) {
+    optimizer.SetNumThreads(threads);
+    Point best;
+    BOOST_CHECK_CLOSE(optimizer.LineOptimize(origin, direction, best), 1.0, 1e-4);
+    BOOST_CHECK_GT(best[0], 1.0);
+    BOOST_CHECK_LT(best[0], 1.00005);
+    BOOST_CHECK_EQUAL(best[1], 1.0);
+  }
+}
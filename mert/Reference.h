@@ -34,6 +34,20 @@ public:
     return m_counts;
   }
 
+  /**
+   * The index of the counts, valid after the last call to IndexCounts.
+   */
+  const NgramIndex& get_index() const {
+    return m_index;
+  }
+
+  /**
+   * Index the counts for matching hypotheses; call after changing them.
+   */
+  void IndexCounts() {
+    m_index.Build(*m_counts);
+  }
+
   iterator begin() {
     return m_length.begin();
   }
@@ -62,10 +76,12 @@ public:
   void clear() {
     m_length.clear();
     m_counts->clear();
+    m_index.clear();
   }
 
 private:
   NgramCounts* m_counts;
+  NgramIndex m_index;
 
   // multiple reference lengths
   std::vector<std::size_t> m_length;
@@ -24,18 +24,22 @@ namespace MosesTuning
 
 ScoreStats::ScoreStats()
   : m_available_size(kAvailableSize), m_entries(0),
-    m_array(new ScoreStatsType[m_available_size]) {}
+    m_array(new ScoreStatsType[m_available_size]), m_owner(true) {}
 
 ScoreStats::ScoreStats(const size_t size)
   : m_available_size(size), m_entries(size),
-    m_array(new ScoreStatsType[m_available_size])
+    m_array(new ScoreStatsType[m_available_size]), m_owner(true)
 {
   memset(m_array, 0, GetArraySizeWithBytes());
 }
 
+ScoreStats::ScoreStats(const ScoreStatsType* values, size_t size)
+  : m_available_size(size), m_entries(size),
+    m_array(const_cast<ScoreStatsType*>(values)), m_owner(false) {}
+
 ScoreStats::~ScoreStats()
 {
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
   m_array = NULL;
 }
 
@@ -43,8 +47,13 @@ void ScoreStats::Copy(const ScoreStats &stats)
 {
   m_available_size = stats.available();
   m_entries = stats.size();
-  m_array = new ScoreStatsType[m_available_size];
-  memcpy(m_array, stats.getArray(), GetArraySizeWithBytes());
+  m_owner = stats.m_owner;
+  if (m_owner) {
+    m_array = new ScoreStatsType[m_available_size];
+    memcpy(m_array, stats.getArray(), GetArraySizeWithBytes());
+  } else {
+    m_array = stats.getArray();
+  }
 }
 
 ScoreStats::ScoreStats(const ScoreStats &stats)
@@ -54,18 +63,19 @@ ScoreStats::ScoreStats(const ScoreStats &stats)
 
 ScoreStats& ScoreStats::operator=(const ScoreStats &stats)
 {
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
   Copy(stats);
   return *this;
 }
 
 void ScoreStats::expand()
 {
-  m_available_size *= 2;
+  m_available_size = m_available_size ? 2 * m_available_size : kAvailableSize;
   scorestats_t buf = new ScoreStatsType[m_available_size];
   memcpy(buf, m_array, GetArraySizeWithBytes());
-  delete [] m_array;
+  if (m_owner) delete [] m_array;
   m_array = buf;
+  m_owner = true;
 }
 
 void ScoreStats::add(ScoreStatsType v)
@@ -85,8 +95,18 @@ void ScoreStats::set(const string& str)
   }
 }
 
+void ScoreStats::own()
+{
+  if (m_owner) return;
+  scorestats_t copy = new ScoreStatsType[m_available_size];
+  memcpy(copy, m_array, GetArraySizeWithBytes());
+  m_array = copy;
+  m_owner = true;
+}
+
 void ScoreStats::loadbin(istream* is)
 {
+  own();
   is->read(reinterpret_cast<char*>(m_array),
            static_cast<streamsize>(GetArraySizeWithBytes()));
 }
@@ -28,11 +28,19 @@ private:
 
   // TODO: Use smart pointer for exceptional-safety.
   scorestats_t m_array;
+  // Whether m_array is ours, or a view of values kept alive elsewhere
+  bool m_owner;
 
 public:
   ScoreStats();
   explicit ScoreStats(const std::size_t size);
 
+  /**
+   * A view of size values that outlive it, such as those of a mapped n-best
+   * store. Copies share the values; changing them makes a copy first.
+   */
+  ScoreStats(const ScoreStatsType* values, std::size_t size);
+
   ~ScoreStats();
 
   // We intentionally allow copying.
@@ -49,6 +57,7 @@ public:
   void add(ScoreStatsType v);
 
   void clear() {
+    own();
     std::memset((void*)m_array, 0, GetArraySizeWithBytes());
   }
 
@@ -106,6 +115,9 @@ public:
    * Write the whole object to a stream.
    */
   friend std::ostream& operator<<(std::ostream& o, const ScoreStats& e);
+
+private:
+  void own();
 };
 
 bool operator==(const ScoreStats& s1, const ScoreStats& s2);
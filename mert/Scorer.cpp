@@ -83,27 +83,22 @@ void Scorer::TokenizeAndEncode(const string& line, vector<int>& encoded) const
 
 void Scorer::TokenizeAndEncodeTesting(const string& line, vector<int>& encoded) const
 {
+  // The vocabulary is only read, and one token buffer serves all tokens
+  string token;
   for (util::TokenIter<util::AnyCharacter, true> it(line, util::AnyCharacter(" "));
        it; ++it) {
+    token.assign(it->data(), it->size());
     if (!m_enable_preserve_case) {
-      string token = it->as_string();
       for (std::string::iterator sit = token.begin();
            sit != token.end(); ++sit) {
         *sit = tolower(*sit);
       }
-      mert::Vocabulary::const_iterator cit = m_vocab->find(token);
-      if (cit == m_vocab->end()) {
-        encoded.push_back(kUnknownToken);
-      } else {
-        encoded.push_back(cit->second);
-      }
+    }
+    mert::Vocabulary::const_iterator cit = m_vocab->find(token);
+    if (cit == m_vocab->end()) {
+      encoded.push_back(kUnknownToken);
     } else {
-      mert::Vocabulary::const_iterator cit = m_vocab->find(it->as_string());
-      if (cit == m_vocab->end()) {
-        encoded.push_back(kUnknownToken);
-      } else {
-        encoded.push_back(cit->second);
-      }
+      encoded.push_back(cit->second);
     }
   }
 }
@@ -182,6 +177,15 @@ string Scorer::applyFilter(const string& sentence) const
   return sentence;
 }
 
+bool Scorer::hasFilter() const
+{
+#if defined(__GLIBCXX__) || defined(__GLIBCPP__)
+  return m_filter != NULL;
+#else
+  return false;
+#endif
+}
+
 float Scorer::score(const candidates_t& candidates) const
 {
   diffs_t diffs;
@@ -135,6 +135,14 @@ public:
     return false;
   };
 
+  /**
+   * The scorer returns if prepareStats may be called from several threads
+   * at once, once the references are set
+   **/
+  virtual bool threadSafeStats() const {
+    return false;
+  }
+
   /**
    * Set the factors, which should be used for this metric
    */
@@ -205,6 +213,12 @@ protected:
     return applyFactors(applyFilter(sentence));
   }
 
+  /**
+   * Return true iff a filter preprocesses the sentences. The filter is a
+   * single process, so preprocessing is not thread safe with it.
+   */
+  bool hasFilter() const;
+
 };
 
 namespace
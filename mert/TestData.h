@@ -0,0 +1,51 @@
+/*
+ *  TestData.h
+ *  mert - Minimum Error Rate Training
+ *
+ *  Helpers shared by the unit tests.
+ */
+
+#ifndef MERT_TEST_DATA_H_
+#define MERT_TEST_DATA_H_
+
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include "ScoreStats.h"
+
+namespace MosesTuning
+{
+
+/**
+ * A unique path in the temporary directory, removed when it goes out of
+ * scope.
+ */
+struct TempFile {
+  TempFile() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {}
+  ~TempFile() {
+    boost::filesystem::remove(path);
+  }
+  boost::filesystem::path path;
+};
+
+/**
+ * BLEU statistics of a random hypothesis of 5 to 14 words against a 10 word
+ * reference, drawn with rand().
+ */
+inline ScoreStats RandomBleuStats()
+{
+  const int length = 5 + rand() % 10;
+  ScoreStats scores;
+  for (int n = 1; n <= 4; ++n) {
+    const int total = length - n + 1;
+    scores.add(rand() % (total + 1));
+    scores.add(total);
+  }
+  scores.add(10);
+  return scores;
+}
+
+}
+
+#endif  // MERT_TEST_DATA_H_
@@ -12,6 +12,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "Data.h"
+#include "NbestStore.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 #include "Timer.h"
@@ -39,6 +40,10 @@ void usage()
   cerr << "[--factors|-f] list of factors passed to the scorer (e.g. 0|2)" << endl;
   cerr << "[--filter|-l] filter command used to preprocess the sentences" << endl;
   cerr << "[--allow-duplicates|-d] omit the duplicate removal step" << endl;
+  cerr << "[--store] append the new candidates to this n-best store" << endl;
+#ifdef WITH_THREADS
+  cerr << "[--threads|-T] compute the score statistics with multiple threads, if the scorer allows it (default 1)" << endl;
+#endif
   cerr << "[-v] verbose level" << endl;
   cerr << "[--help|-h] print this message and exit" << endl;
   exit(1);
@@ -59,6 +64,10 @@ static struct option long_options[] = {
   {"verbose", required_argument, 0, 'v'},
   {"help", no_argument, 0, 'h'},
   {"allow-duplicates", no_argument, 0, 'd'},
+  {"store", required_argument, 0, 'B'},
+#ifdef WITH_THREADS
+  {"threads", required_argument, 0, 'T'},
+#endif
   {0, 0, 0, 0}
 };
 
@@ -74,9 +83,11 @@ struct ProgramOption {
   string featureDataFile;
   string prevScoreDataFile;
   string prevFeatureDataFile;
+  string storeFile;
   bool binmode;
   bool allowDuplicates;
   int verbosity;
+  size_t threads;
 
   ProgramOption()
     : scorerType("BLEU"),
@@ -89,9 +100,11 @@ struct ProgramOption {
       featureDataFile("features.data"),
       prevScoreDataFile(""),
       prevFeatureDataFile(""),
+      storeFile(""),
       binmode(false),
       allowDuplicates(false),
-      verbosity(0) { }
+      verbosity(0),
+      threads(1) { }
 };
 
 void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
@@ -99,7 +112,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:hbd", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:T:hbd", long_options, &option_index)) != -1) {
     switch (c) {
     case 's':
       opt->scorerType = string(optarg);
@@ -140,6 +153,15 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
     case 'd':
       opt->allowDuplicates = true;
       break;
+    case 'B':
+      opt->storeFile = string(optarg);
+      break;
+#ifdef WITH_THREADS
+    case 'T':
+      opt->threads = strtol(optarg, NULL, 10);
+      if (opt->threads < 1) opt->threads = 1;
+      break;
+#endif
     default:
       usage();
     }
@@ -157,12 +179,12 @@ int main(int argc, char** argv)
 
   try {
     // check whether score statistics file is specified
-    if (option.scoreDataFile.length() == 0) {
+    if (option.scoreDataFile.length() == 0 && option.storeFile.length() == 0) {
       throw runtime_error("Error: output score statistics file is not specified");
     }
 
     // check wheter feature file is specified
-    if (option.featureDataFile.length() == 0) {
+    if (option.featureDataFile.length() == 0 && option.storeFile.length() == 0) {
       throw runtime_error("Error: output feature file is not specified");
     }
 
@@ -217,6 +239,7 @@ int main(int argc, char** argv)
 //    PrintUserTime("References loaded");
 
     Data data(scorer.get());
+    data.setThreads(option.threads);
 
     // load old data
     for (size_t i = 0; i < prevScoreDataFiles.size(); i++) {
@@ -239,6 +262,11 @@ int main(int argc, char** argv)
     //END_ADDED
 
     data.save(option.featureDataFile, option.scoreDataFile, option.binmode);
+
+    if (!option.storeFile.empty()) {
+      size_t added = NbestStore::Append(option.storeFile, data);
+      cerr << "Appended " << added << " new candidates to " << option.storeFile << endl;
+    }
     PrintUserTime("Stopping...");
 
     return EXIT_SUCCESS;
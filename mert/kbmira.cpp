@@ -66,6 +66,7 @@ int main(int argc, char** argv)
   string scconfig = "";
   vector<string> scoreFiles;
   vector<string> featureFiles;
+  string storeFile;
   vector<string> referenceFiles; //for hg mira
   string hgDir;
   int seed;
@@ -80,6 +81,8 @@ int main(int argc, char** argv)
   bool verbose = false; // Verbose updates
   bool safe_hope = false; // Model score cannot have more than BLEU_RATIO times more influence than BLEU
   size_t hgPruning = 50; //prune hypergraphs to have this many edges per reference word
+  size_t threads = 1; // Threads for hope/fear decoding
+  size_t batchSize = 1; // Sentences decoded with the same weights
 
   // Command-line processing follows pro.cpp
   po::options_description desc("Allowed options");
@@ -90,6 +93,7 @@ int main(int argc, char** argv)
   ("scconfig,c", po::value<string>(&scconfig), "configuration string passed to scorer")
   ("scfile,S", po::value<vector<string> >(&scoreFiles), "Scorer data files")
   ("ffile,F", po::value<vector<string> > (&featureFiles), "Feature data files")
+  ("store", po::value<string>(&storeFile), "N-best store to read instead of the scorer and feature data files")
   ("hgdir,H", po::value<string> (&hgDir), "Directory containing hypergraphs")
   ("reference,R", po::value<vector<string> > (&referenceFiles), "Reference files, only required for hypergraph mira")
   ("random-seed,r", po::value<int>(&seed), "Seed for random number generation")
@@ -106,6 +110,8 @@ int main(int argc, char** argv)
   ("verbose", po::value(&verbose)->zero_tokens()->default_value(false), "Verbose updates")
   ("safe-hope", po::value(&safe_hope)->zero_tokens()->default_value(false), "Mode score's influence on hope decoding is limited")
   ("hg-prune", po::value<size_t>(&hgPruning), "Prune hypergraphs to have this many edges per reference word")
+  ("threads", po::value<size_t>(&threads), "Number of threads for hope/fear decoding and evaluation (default 1)")
+  ("batch-size", po::value<size_t>(&batchSize), "Number of sentences decoded with the same weights before their updates are applied in order (default 1). The weights depend on this but not on --threads; set it to at least --threads for the threads to help hope/fear decoding")
   ;
 
   po::options_description cmdline_options;
@@ -120,7 +126,12 @@ int main(int argc, char** argv)
     exit(0);
   }
 
+  if (threads == 0) threads = 1;
+  if (batchSize == 0) batchSize = 1;
+
   cerr << "kbmira with c=" << c << " decay=" << decay << " no_shuffle=" << no_shuffle << endl;
+  if (batchSize > 1)
+    cerr << "Decoding batches of " << batchSize << " sentences with " << threads << " threads" << endl;
 
   if (vm.count("random-seed")) {
     cerr << "Initialising random seed to " << seed << endl;
@@ -146,12 +157,17 @@ int main(int argc, char** argv)
 
   boost::scoped_ptr<HopeFearDecoder> decoder;
   if (type == "nbest") {
-    decoder.reset(new NbestHopeFearDecoder(featureFiles, scoreFiles, streaming, no_shuffle, safe_hope, scorer.get()));
+    if (!storeFile.empty()) {
+      decoder.reset(new NbestHopeFearDecoder(storeFile, no_shuffle, safe_hope, scorer.get()));
+    } else {
+      decoder.reset(new NbestHopeFearDecoder(featureFiles, scoreFiles, streaming, no_shuffle, safe_hope, scorer.get()));
+    }
   } else if (type == "hypergraph") {
     decoder.reset(new HypergraphHopeFearDecoder(hgDir, referenceFiles, initDenseSize, streaming, no_shuffle, safe_hope, hgPruning, *wv, scorer.get()));
   } else {
     UTIL_THROW(util::Exception, "Unknown batch mira type: '" << type << "'");
   }
+  decoder->SetThreads(threads);
 
   // Training loop
   if (!streaming_out)
@@ -163,48 +179,54 @@ int main(int argc, char** argv)
     int iNumUpdates = 0;
     ValType totalLoss = 0.0;
     size_t sentenceIndex = 0;
-    for(decoder->reset(); !decoder->finished(); decoder->next()) {
-      HopeFearData hfd;
-      decoder->HopeFear(bg,*wv,&hfd);
+    vector<HopeFearData> batch;
+    for(decoder->reset(); !decoder->finished(); ) {
+      // Decode a batch with the current weights, then update on each of its
+      // sentences in order, so the updates do not depend on the threads
+      batch.resize(batchSize);
+      decoder->HopeFearBatch(bg,*wv,&batch);
+      for(size_t b=0; b<batch.size(); b++) {
+        const HopeFearData& hfd = batch[b];
 
-      // Update weights
-      if (!hfd.hopeFearEqual && hfd.hopeBleu  > hfd.fearBleu) {
-        // Vector difference
-        MiraFeatureVector diff = hfd.hopeFeatures - hfd.fearFeatures;
-        // Bleu difference
-        //assert(hfd.hopeBleu + 1e-8 >= hfd.fearBleu);
-        ValType delta = hfd.hopeBleu - hfd.fearBleu;
-        // Loss and update
-        ValType diff_score = wv->score(diff);
-        ValType loss = delta - diff_score;
-        if(verbose) {
-          cerr << "Updating sent " << sentenceIndex << endl;
-          cerr << "Wght: " << *wv << endl;
-          cerr << "Hope: " << hfd.hopeFeatures << " BLEU:" << hfd.hopeBleu << " Score:" << wv->score(hfd.hopeFeatures) << endl;
-          cerr << "Fear: " << hfd.fearFeatures << " BLEU:" << hfd.fearBleu << " Score:" << wv->score(hfd.fearFeatures) << endl;
-          cerr << "Diff: " << diff << " BLEU:" << delta << " Score:" << diff_score << endl;
-          cerr << "Loss: " << loss <<  " Scale: " << 1 << endl;
-          cerr << endl;
-        }
-        if(loss > 0) {
-          ValType eta = min(c, loss / diff.sqrNorm());
-          wv->update(diff,eta);
-          totalLoss+=loss;
-          iNumUpdates++;
-        }
-        // Update BLEU statistics
-        for(size_t k=0; k<bg.size(); k++) {
-          bg[k]*=decay;
-          if(model_bg)
-            bg[k]+=hfd.modelStats[k];
-          else
-            bg[k]+=hfd.hopeStats[k];
+        // Update weights
+        if (!hfd.hopeFearEqual && hfd.hopeBleu  > hfd.fearBleu) {
+          // Vector difference
+          MiraFeatureVector diff = hfd.hopeFeatures - hfd.fearFeatures;
+          // Bleu difference
+          //assert(hfd.hopeBleu + 1e-8 >= hfd.fearBleu);
+          ValType delta = hfd.hopeBleu - hfd.fearBleu;
+          // Loss and update
+          ValType diff_score = wv->score(diff);
+          ValType loss = delta - diff_score;
+          if(verbose) {
+            cerr << "Updating sent " << sentenceIndex << endl;
+            cerr << "Wght: " << *wv << endl;
+            cerr << "Hope: " << hfd.hopeFeatures << " BLEU:" << hfd.hopeBleu << " Score:" << wv->score(hfd.hopeFeatures) << endl;
+            cerr << "Fear: " << hfd.fearFeatures << " BLEU:" << hfd.fearBleu << " Score:" << wv->score(hfd.fearFeatures) << endl;
+            cerr << "Diff: " << diff << " BLEU:" << delta << " Score:" << diff_score << endl;
+            cerr << "Loss: " << loss <<  " Scale: " << 1 << endl;
+            cerr << endl;
+          }
+          if(loss > 0) {
+            ValType eta = min(c, loss / diff.sqrNorm());
+            wv->update(diff,eta);
+            totalLoss+=loss;
+            iNumUpdates++;
+          }
+          // Update BLEU statistics
+          for(size_t k=0; k<bg.size(); k++) {
+            bg[k]*=decay;
+            if(model_bg)
+              bg[k]+=hfd.modelStats[k];
+            else
+              bg[k]+=hfd.hopeStats[k];
+          }
         }
+        iNumExamples++;
+        ++sentenceIndex;
+        if (streaming_out)
+          cout << *wv << endl;
       }
-      iNumExamples++;
-      ++sentenceIndex;
-      if (streaming_out)
-        cout << *wv << endl;
     }
     // Training Epoch summary
     cerr << iNumUpdates << "/" << iNumExamples << " updates"
@@ -19,6 +19,7 @@
 #include "ScorerFactory.h"
 #include "ScoreData.h"
 #include "FeatureData.h"
+#include "NbestStore.h"
 #include "Optimizer.h"
 #include "OptimizerFactory.h"
 #include "Types.h"
@@ -115,9 +116,10 @@ void usage(int ret)
   cerr<<"[--scfile|-S] comma separated list of scorer data files (default score.data)"<<endl;
   cerr<<"[--ffile|-F] comma separated list of feature data files (default feature.data)"<<endl;
   cerr<<"[--ifile|-i] the starting point data file (default init.opt)"<<endl;
+  cerr<<"[--store] n-best store to load, instead of the default scorer and feature data files"<<endl;
   cerr<<"[--sparse-weights|-p] required for merging sparse features"<<endl;
 #ifdef WITH_THREADS
-  cerr<<"[--threads|-T] use multiple threads (default 1)"<<endl;
+  cerr<<"[--threads|-T] use multiple threads (default 1); threads left over by the start points parallelize each line search"<<endl;
 #endif
   cerr<<"[--shard-count] Split data into shards, optimize for each shard and average"<<endl;
   cerr<<"[--shard-size] Shard size as proportion of data. If 0, use non-overlapping shards"<<endl;
@@ -138,6 +140,7 @@ static struct option long_options[] = {
   {"scfile",1,0,'S'},
   {"ffile",1,0,'F'},
   {"ifile",1,0,'i'},
+  {"store",required_argument,0,'B'},
   {"sparse-weights",required_argument,0,'p'},
 #ifdef WITH_THREADS
   {"threads", required_argument,0,'T'},
@@ -162,6 +165,7 @@ struct ProgramOption {
   string scorer_file;
   string feature_file;
   string init_file;
+  string store_file;
   string positive_string;
   string sparse_weights_file;
   size_t num_threads;
@@ -181,6 +185,7 @@ struct ProgramOption {
       scorer_file(kDefaultScorerFile),
       feature_file(kDefaultFeatureFile),
       init_file(kDefaultInitFile),
+      store_file(""),
       positive_string(kDefaultPositiveString),
       sparse_weights_file(kDefaultSparseWeightsFile),
       num_threads(1),
@@ -229,6 +234,9 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
     case 'i':
       opt->init_file = string(optarg);
       break;
+    case 'B':
+      opt->store_file = string(optarg);
+      break;
     case 'p':
       opt->sparse_weights_file=string(optarg);
       break;
@@ -342,6 +350,12 @@ int main(int argc, char **argv)
     opt.close();
   }
 
+  if (!option.store_file.empty()) {
+    // the store replaces the default files, but not ones given explicitly
+    if (option.scorer_file == kDefaultScorerFile) option.scorer_file = "";
+    if (option.feature_file == kDefaultFeatureFile) option.feature_file = "";
+  }
+
   vector<string> ScoreDataFiles;
   if (option.scorer_file.length() > 0) {
     Tokenize(option.scorer_file.c_str(), ',', &ScoreDataFiles);
@@ -368,6 +382,11 @@ int main(int argc, char **argv)
     data.load(FeatureDataFiles.at(i), ScoreDataFiles.at(i));
   }
 
+  if (!option.store_file.empty()) {
+    cerr<<"Loading Data from: "<< option.store_file << endl;
+    data.loadStore(boost::shared_ptr<const NbestStore>(new NbestStore(option.store_file)));
+  }
+
   scorer->setScoreData(data.getScoreData().get());
 
   data.removeDuplicates();
@@ -471,6 +490,10 @@ int main(int argc, char **argv)
     Optimizer *optimizer = OptimizerFactory::BuildOptimizer(option.pdim, to_optimize, positive, start_list[0], option.optimize_type, option.nrandom);
     optimizer->SetScorer(data_ref.getScorer());
     optimizer->SetFeatureData(data_ref.getFeatureData());
+#ifdef WITH_THREADS
+    // Threads the pool cannot fill with start points go to the line searches.
+    optimizer->SetNumThreads(option.num_threads / (allTasks.size() * startingPoints.size()));
+#endif
     // A task for each start point
     for (size_t j = 0; j < startingPoints.size(); ++j) {
       boost::shared_ptr<OptimizationTask>
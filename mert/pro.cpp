@@ -40,6 +40,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "BleuScorer.h"
 #include "FeatureDataIterator.h"
+#include "NbestStore.h"
 #include "ScoreDataIterator.h"
 #include "BleuScorer.h"
 #include "Util.h"
@@ -53,6 +54,12 @@ namespace po = boost::program_options;
 namespace MosesTuning
 {
 
+// TODO: Add these constants to options
+const unsigned int n_candidates = 5000; // Gamma, in Hopkins & May
+const unsigned int n_samples = 50; // Xi, in Hopkins & May
+const float min_diff = 0.05;
+const float bleuSmoothing = 1.0f;
+
 class SampledPair
 {
 private:
@@ -102,6 +109,66 @@ static void outputSample(ostream& out, const FeatureDataItem& f1, const FeatureD
   }
 }
 
+
+/**
+ * Sample pairs of hypotheses of one sentence and write them out. Hypotheses
+ * are (list, index) pairs into features and scores.
+ */
+static void outputSamples(ostream& out, const vector<pair<size_t,size_t> >& hypotheses,
+                          const vector<const vector<FeatureDataItem>*>& features,
+                          const vector<const vector<ScoreDataItem>*>& scores,
+                          bool smoothBP)
+{
+  //collect the candidates
+  vector<SampledPair> samples;
+  vector<float> diffs;
+  size_t n_translations = hypotheses.size();
+  for(size_t  i=0; i<n_candidates; i++) {
+    size_t rand1 = util::rand_excl(n_translations);
+    pair<size_t,size_t> translation1 = hypotheses[rand1];
+    float bleu1 = smoothedSentenceBleu((*scores[translation1.first])[translation1.second], bleuSmoothing, smoothBP);
+
+    size_t rand2 = util::rand_excl(n_translations);
+    pair<size_t,size_t> translation2 = hypotheses[rand2];
+    float bleu2 = smoothedSentenceBleu((*scores[translation2.first])[translation2.second], bleuSmoothing, smoothBP);
+
+    /*
+    cerr << "t(" << translation1.first << "," << translation1.second << ") = " << bleu1 <<
+      " t(" << translation2.first << "," << translation2.second << ") = " <<
+        bleu2  << " diff = " << abs(bleu1-bleu2) << endl;
+    */
+    if (abs(bleu1-bleu2) < min_diff)
+      continue;
+
+    samples.push_back(SampledPair(translation1, translation2, bleu1-bleu2));
+    diffs.push_back(1.0-abs(bleu1-bleu2));
+  }
+
+  float sample_threshold = -1.0;
+  if (samples.size() > n_samples) {
+    NTH_ELEMENT3(diffs.begin(), diffs.begin() + (n_samples-1), diffs.end());
+    sample_threshold = 0.99999-diffs[n_samples-1];
+  }
+
+  size_t collected = 0;
+  for (size_t i = 0; collected < n_samples && i < samples.size(); ++i) {
+    if (samples[i].getDiff() < sample_threshold) continue;
+    ++collected;
+    size_t file_id1 = samples[i].getTranslation1().first;
+    size_t hypo_id1 = samples[i].getTranslation1().second;
+    size_t file_id2 = samples[i].getTranslation2().first;
+    size_t hypo_id2 = samples[i].getTranslation2().second;
+    out << "1";
+    outputSample(out, (*features[file_id1])[hypo_id1],
+                 (*features[file_id2])[hypo_id2]);
+    out << endl;
+    out << "0";
+    outputSample(out, (*features[file_id2])[hypo_id2],
+                 (*features[file_id1])[hypo_id1]);
+    out << endl;
+  }
+}
+
 }
 
 int main(int argc, char** argv)
@@ -111,18 +178,15 @@ int main(int argc, char** argv)
   vector<string> featureFiles;
   int seed;
   string outputFile;
-  // TODO: Add these constants to options
-  const unsigned int n_candidates = 5000; // Gamma, in Hopkins & May
-  const unsigned int n_samples = 50; // Xi, in Hopkins & May
-  const float min_diff = 0.05;
+  string storeFile;
   bool smoothBP = false;
-  const float bleuSmoothing = 1.0f;
 
   po::options_description desc("Allowed options");
   desc.add_options()
   ("help,h", po::value(&help)->zero_tokens()->default_value(false), "Print this help message and exit")
   ("scfile,S", po::value<vector<string> >(&scoreFiles), "Scorer data files")
   ("ffile,F", po::value<vector<string> > (&featureFiles), "Feature data files")
+  ("store", po::value<string>(&storeFile), "N-best store to read instead of the scorer and feature data files")
   ("random-seed,r", po::value<int>(&seed), "Seed for random number generation")
   ("output-file,o", po::value<string>(&outputFile), "Output file")
   ("smooth-brevity-penalty,b", po::value(&smoothBP)->zero_tokens()->default_value(false), "Smooth the brevity penalty, as in Nakov et al. (Coling 2012)")
@@ -148,7 +212,7 @@ int main(int argc, char** argv)
     util::rand_init();
   }
 
-  if (scoreFiles.size() == 0 || featureFiles.size() == 0) {
+  if (storeFile.empty() && (scoreFiles.size() == 0 || featureFiles.size() == 0)) {
     cerr << "No data to process" << endl;
     exit(0);
   }
@@ -172,6 +236,27 @@ int main(int argc, char** argv)
     out = &cout;
   }
 
+  if (!storeFile.empty()) {
+    // the store is already de-duplicated
+    NbestStore store(storeFile);
+    vector<FeatureDataItem> features;
+    vector<ScoreDataItem> scores;
+    for (size_t i = 0; i < store.size(); ++i) {
+      vector<pair<size_t,size_t> > hypotheses;
+      features.resize(store.NumberOfCandidates(i));
+      scores.resize(store.NumberOfCandidates(i));
+      for (size_t j = 0; j < store.NumberOfCandidates(i); ++j) {
+        store.get(i, j, features[j]);
+        const NbestStoreCandidate c = store.get(i, j);
+        scores[j].assign(c.scores, c.scores + store.NumberOfScores());
+        hypotheses.push_back(pair<size_t,size_t>(0,j));
+      }
+      outputSamples(*out, hypotheses, vector<const vector<FeatureDataItem>*>(1, &features),
+                    vector<const vector<ScoreDataItem>*>(1, &scores), smoothBP);
+    }
+    outFile.close();
+    return 0;
+  }
 
   vector<FeatureDataIterator> featureDataIters;
   vector<ScoreDataIterator> scoreDataIters;
@@ -207,54 +292,14 @@ int main(int argc, char** argv)
       }
     }
 
-    //collect the candidates
-    vector<SampledPair> samples;
-    vector<float> scores;
-    size_t n_translations = hypotheses.size();
-    for(size_t  i=0; i<n_candidates; i++) {
-      size_t rand1 = util::rand_excl(n_translations);
-      pair<size_t,size_t> translation1 = hypotheses[rand1];
-      float bleu1 = smoothedSentenceBleu(scoreDataIters[translation1.first]->operator[](translation1.second), bleuSmoothing, smoothBP);
-
-      size_t rand2 = util::rand_excl(n_translations);
-      pair<size_t,size_t> translation2 = hypotheses[rand2];
-      float bleu2 = smoothedSentenceBleu(scoreDataIters[translation2.first]->operator[](translation2.second), bleuSmoothing, smoothBP);
-
-      /*
-      cerr << "t(" << translation1.first << "," << translation1.second << ") = " << bleu1 <<
-        " t(" << translation2.first << "," << translation2.second << ") = " <<
-          bleu2  << " diff = " << abs(bleu1-bleu2) << endl;
-      */
-      if (abs(bleu1-bleu2) < min_diff)
-        continue;
-
-      samples.push_back(SampledPair(translation1, translation2, bleu1-bleu2));
-      scores.push_back(1.0-abs(bleu1-bleu2));
-    }
-
-    float sample_threshold = -1.0;
-    if (samples.size() > n_samples) {
-      NTH_ELEMENT3(scores.begin(), scores.begin() + (n_samples-1), scores.end());
-      sample_threshold = 0.99999-scores[n_samples-1];
+    vector<const vector<FeatureDataItem>*> features;
+    vector<const vector<ScoreDataItem>*> scores;
+    for (size_t i = 0; i < featureFiles.size(); ++i) {
+      features.push_back(&*featureDataIters[i]);
+      scores.push_back(&*scoreDataIters[i]);
     }
+    outputSamples(*out, hypotheses, features, scores, smoothBP);
 
-    size_t collected = 0;
-    for (size_t i = 0; collected < n_samples && i < samples.size(); ++i) {
-      if (samples[i].getDiff() < sample_threshold) continue;
-      ++collected;
-      size_t file_id1 = samples[i].getTranslation1().first;
-      size_t hypo_id1 = samples[i].getTranslation1().second;
-      size_t file_id2 = samples[i].getTranslation2().first;
-      size_t hypo_id2 = samples[i].getTranslation2().second;
-      *out << "1";
-      outputSample(*out, featureDataIters[file_id1]->operator[](hypo_id1),
-                   featureDataIters[file_id2]->operator[](hypo_id2));
-      *out << endl;
-      *out << "0";
-      outputSample(*out, featureDataIters[file_id2]->operator[](hypo_id2),
-                   featureDataIters[file_id1]->operator[](hypo_id1));
-      *out << endl;
-    }
     //advance all iterators
     for (size_t i = 0; i < featureFiles.size(); ++i) {
       ++featureDataIters[i];
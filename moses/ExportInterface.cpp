@@ -43,6 +43,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TypeDef.h"
 #include "Util.h"
 #include "Timer.h"
+#include "Metrics.h"
 #include "TranslationModel/PhraseDictionary.h"
 #include "FF/StatefulFeatureFunction.h"
 #include "FF/StatelessFeatureFunction.h"
@@ -343,6 +344,12 @@ int decoder_main(int argc, char const** argv)
     if (!StaticData::LoadDataStatic(&params, argv[0]))
       exit(1);
 
+    const PARAM_VEC *metricsDump = params.GetParam("metrics-dump");
+    if (metricsDump && metricsDump->size()) {
+      Metrics::Instance().StartDump(Scan<double>((*metricsDump)[0]),
+                                    metricsDump->size() > 1 ? (*metricsDump)[1] : "");
+    }
+
     //
 #if 1
     pid_t pid;
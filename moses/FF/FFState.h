@@ -4,11 +4,12 @@
 #include <vector>
 #include <stddef.h>
 #include "util/exception.hh"
+#include "moses/MemoryArena.h"
 
 namespace Moses
 {
 
-class FFState
+class FFState : public MemoryArenaObject
 {
 public:
   virtual ~FFState();
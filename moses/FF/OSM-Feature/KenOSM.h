@@ -1,22 +1,101 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include "lm/enumerate_vocab.hh"
 #include "lm/model.hh"
+#include "util/probing_hash_table.hh"
 
 namespace Moses
 {
 
-class KenOSMBase
+class KenOSMBase : public lm::EnumerateVocab
 {
 public:
+  // Operations that name words
+  enum WordOperation {
+    Translate, // _TRANS_<target words>_TO_<source words>, joined by ^_^
+    Insert,    // _INS_<source word>
+    Delete     // _DEL_<target word>
+  };
+
+  KenOSMBase();
   virtual ~KenOSMBase() {}
 
   virtual float Score(const lm::ngram::State&, StringPiece,
                       lm::ngram::State&) const = 0;
 
+  virtual float Score(const lm::ngram::State&, lm::WordIndex,
+                      lm::ngram::State&) const = 0;
+
+  virtual lm::WordIndex Index(StringPiece) const = 0;
+
   virtual const lm::ngram::State &BeginSentenceState() const = 0;
 
   virtual const lm::ngram::State &NullContextState() const = 0;
+
+  // Ids of the operations that do not name words, looked up when loading
+  lm::WordIndex InsertGap() const {
+    return m_insertGap;
+  }
+  lm::WordIndex JumpForward() const {
+    return m_jumpForward;
+  }
+  lm::WordIndex ContinueCept() const {
+    return m_continueCept;
+  }
+  lm::WordIndex TranslateSelf() const {
+    return m_translateSelf;
+  }
+  // _JMP_BCK_ over the given number of gaps
+  lm::WordIndex JumpBack(int gaps) const;
+
+  // Id of an operation on the target words /english/ and the source words
+  // /german/, given by factor id; <unk> if the model has no such operation
+  lm::WordIndex Index(WordOperation op, const std::vector<size_t> &english,
+                      const std::vector<size_t> &german) const;
+
+  // Factor id of _TRANS_SLF_, the target word of an unknown word
+  size_t TranslateSelfFactor() const {
+    return m_translateSelfFactor;
+  }
+
+  // Called by KenLM for each word of the model while loading it
+  void Add(lm::WordIndex index, const StringPiece &str);
+
+protected:
+  void IndexOperations();
+
+  static lm::ngram::Config Enumerating(lm::ngram::Config config, KenOSMBase &to) {
+    config.enumerate_vocab = &to;
+    return config;
+  }
+
+private:
+  struct OperationEntry {
+    typedef uint64_t Key;
+    uint64_t key;
+    lm::WordIndex index;
+
+    uint64_t GetKey() const {
+      return key;
+    }
+    void SetKey(uint64_t to) {
+      key = to;
+    }
+  };
+
+  // keys are hashes already
+  typedef util::AutoProbing<OperationEntry, util::IdentityHash> OperationTable;
+
+  lm::WordIndex m_insertGap, m_jumpForward, m_continueCept, m_translateSelf;
+  std::vector<lm::WordIndex> m_jumpBack;
+  size_t m_translateSelfFactor;
+  // the operations that name words, by a hash of their words' factor ids
+  OperationTable m_wordOperations;
+  std::vector<size_t> m_english, m_german;
+
+  void AddWordOperation(WordOperation op, lm::WordIndex index);
 };
 
 template <class KenModel>
@@ -24,7 +103,9 @@ class KenOSM : public KenOSMBase
 {
 public:
   KenOSM(const char *file, const lm::ngram::Config &config)
-    : m_kenlm(file, config) {}
+    : m_kenlm(file, Enumerating(config, *this)) {
+    IndexOperations();
+  }
 
   float Score(const lm::ngram::State &in_state,
               StringPiece word,
@@ -33,6 +114,16 @@ public:
                          out_state);
   }
 
+  float Score(const lm::ngram::State &in_state,
+              lm::WordIndex word,
+              lm::ngram::State &out_state) const {
+    return m_kenlm.Score(in_state, word, out_state);
+  }
+
+  lm::WordIndex Index(StringPiece word) const {
+    return m_kenlm.GetVocabulary().Index(word);
+  }
+
   const lm::ngram::State &BeginSentenceState() const {
     return m_kenlm.BeginSentenceState();
   }
@@ -44,47 +44,59 @@ void OpSequenceModel::Load(AllOptions::ptr const& opts)
 
 
 
+osmHypothesis &OpSequenceModel::GetHypothesis() const
+{
+  osmHypothesis *obj = m_hypothesis.get();
+  if (obj == NULL) {
+    obj = new osmHypothesis(*OSM);
+    m_hypothesis.reset(obj);
+  } else {
+    obj->clear();
+  }
+  return *obj;
+}
+
+void OpSequenceModel::SetTargetPhrase(osmHypothesis &obj, const TargetPhrase &target) const
+{
+  vector <size_t> &myTargetPhrase = obj.targetPhrase();
+  for (size_t i = 0; i < target.GetSize(); i++) {
+    if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
+      myTargetPhrase.push_back(OSM->TranslateSelfFactor());
+    else
+      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetId());
+  }
+
+  const AlignmentInfo &align = target.GetAlignTerm();
+  AlignmentInfo::const_iterator iter;
+
+  for (iter = align.begin(); iter != align.end(); ++iter) {
+    obj.addAlignment(iter->first, iter->second);
+  }
+}
+
 void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
     , const TargetPhrase &targetPhrase
     , ScoreComponentCollection &scoreBreakdown
     , ScoreComponentCollection &estimatedScores) const
 {
 
-  osmHypothesis obj;
+  osmHypothesis &obj = GetHypothesis();
   obj.setState(OSM->NullContextState());
   Bitmap myBitmap(source.GetSize());
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
-  vector<float> scores;
-  vector <int> alignments;
   int startIndex = 0;
   int endIndex = source.GetSize();
 
-  const AlignmentInfo &align = targetPhrase.GetAlignTerm();
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-  for (size_t i = 0; i < targetPhrase.GetSize(); i++) {
-    if (targetPhrase.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(targetPhrase.GetWord(i).GetFactor(tFactor)->GetString().as_string());
-  }
+  SetTargetPhrase(obj, targetPhrase);
 
+  vector <size_t> &mySourcePhrase = obj.sourcePhrase();
   for (size_t i = 0; i < source.GetSize(); i++) {
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
+    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetId());
   }
 
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
-  obj.constructCepts(alignments,startIndex,endIndex-1,targetPhrase.GetSize());
+  obj.constructCepts(startIndex,endIndex-1,targetPhrase.GetSize());
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
-  obj.populateScores(scores,numFeatures);
-  estimatedScores.PlusEquals(this, scores);
+  estimatedScores.PlusEquals(this, obj.populateScores(numFeatures));
 
 }
 
@@ -99,101 +111,28 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
   Bitmap myBitmap(bitmap);
   const Manager &manager = cur_hypo.GetManager();
   const InputType &source = manager.GetSource();
-  // const Sentence &sourceSentence = static_cast<const Sentence&>(source);
-  osmHypothesis obj;
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
-  vector<float> scores;
-
-
-  //target.GetWord(0)
-
-  //cerr << target <<" --- "<<target.GetSourcePhrase()<< endl;  // English ...
-
-  //cerr << align << endl;   // Alignments ...
-  //cerr << cur_hypo.GetCurrSourceWordsRange() << endl;
-
-  //cerr << source <<endl;
-
-// int a = sourceRange.GetStartPos();
-// cerr << source.GetWord(a);
-  //cerr <<a<<endl;
-
-  //const Sentence &sentence = static_cast<const Sentence&>(curr_hypo.GetManager().GetSource());
-
+  osmHypothesis &obj = GetHypothesis();
 
   const Range & sourceRange = cur_hypo.GetCurrSourceWordsRange();
   int startIndex  = sourceRange.GetStartPos();
   int endIndex = sourceRange.GetEndPos();
-  const AlignmentInfo &align = cur_hypo.GetCurrTargetPhrase().GetAlignTerm();
-  // osmState * statePtr;
-
-  vector <int> alignments;
-
-
-
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    //cerr << iter->first << "----" << iter->second << " ";
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-
-  //cerr<<bitmap<<endl;
-  //cerr<<startIndex<<" "<<endIndex<<endl;
 
+  SetTargetPhrase(obj, target);
 
+  vector <size_t> &mySourcePhrase = obj.sourcePhrase();
   for (int i = startIndex; i <= endIndex; i++) {
     myBitmap.SetValue(i,0); // resetting coverage of this phrase ...
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
-    // cerr<<mySourcePhrase[i]<<endl;
+    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetId());
   }
 
-  for (size_t i = 0; i < target.GetSize(); i++) {
-
-    if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString().as_string());
-
-  }
-
-
-  //cerr<<myBitmap<<endl;
-
   obj.setState(prev_state);
-  obj.constructCepts(alignments,startIndex,endIndex,target.GetSize());
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
+  obj.constructCepts(startIndex,endIndex,target.GetSize());
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
-  obj.populateScores(scores,numFeatures);
-  //obj.print();
-
-  /*
-    if (bitmap.GetFirstGapPos() == NOT_FOUND)
-    {
-
-      int xx;
-  	 cerr<<bitmap<<endl;
-  	 int a = bitmap.GetFirstGapPos();
-  	 obj.print();
-      cin>>xx;
-    }
-    */
-
 
-
-  accumulator->PlusEquals(this, scores);
+  accumulator->PlusEquals(this, obj.populateScores(numFeatures));
 
   return obj.saveState();
-
-
-
-
-  //return statePtr;
-// return NULL;
 }
 
 FFState* OpSequenceModel::EvaluateWhenApplied(
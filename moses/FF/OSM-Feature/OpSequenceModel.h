@@ -3,6 +3,11 @@
 #include <string>
 #include <map>
 #include <vector>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/Manager.h"
 #include "moses/FF/OSM-Feature/osmHyp.h"
@@ -57,10 +62,18 @@ protected:
   typedef std::vector<float> Scores;
   std::map<ParallelPhrase, Scores> m_futureCost;
 
-  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
-  std::set <int> targetNullWords;
   std::string m_lmPath;
 
+  // reused by the phrases a thread scores
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<osmHypothesis> m_hypothesis;
+#else
+  mutable boost::scoped_ptr<osmHypothesis> m_hypothesis;
+#endif
+
+  osmHypothesis &GetHypothesis() const;
+  void SetTargetPhrase(osmHypothesis &obj, const TargetPhrase &target) const;
+
 
 };
 
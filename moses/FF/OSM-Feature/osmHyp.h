@@ -19,18 +19,18 @@ public:
   virtual size_t hash() const;
   virtual bool operator==(const FFState& other) const;
 
-  void saveState(int jVal, int eVal, std::map <int , std::string> & gapVal);
+  void saveState(int jVal, int eVal, const std::vector <int> & gapVal);
   int getJ()const {
     return j;
   }
   int getE()const {
     return E;
   }
-  std::map <int , std::string> getGap() const {
+  const std::vector <int> & getGap() const {
     return gap;
   }
 
-  lm::ngram::State getLMState() const {
+  const lm::ngram::State & getLMState() const {
     return lmState;
   }
 
@@ -39,18 +39,21 @@ public:
 
 protected:
   int j, E;
-  std::map <int,std::string> gap;
+  std::vector <int> gap;
   lm::ngram::State lmState;
 };
 
+// Scores one phrase. An object is reused for the phrases a thread scores,
+// so the buffers below keep their memory.
 class osmHypothesis
 {
 
 private:
 
 
-  std::vector <std::string> operations;	// List of operations required to generated this hyp ...
-  std::map <int,std::string> gap;	// Maintains gap history ...
+  const OSMLM & osm;
+  std::vector <lm::WordIndex> operations;	// Ids of the operations required to generated this hyp ...
+  std::vector <int> gap;	// Maintains gap history: position << 1, | 1 once filled, sorted by position ...
   int j;	// Position after the last source word generated ...
   int E; // Position after the right most source word so far generated ...
   lm::ngram::State lmState; // KenLM's Model State ...
@@ -61,38 +64,60 @@ private:
   int gapWidth;
   double opProb;
 
-  std::vector <std::string> currE;
-  std::vector <std::string> currF;
-  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
-  std::set <int> targetNullWords;
-  std::set <int> sourceNullWords;
-
-  int closestGap(std::map <int,std::string> gap,int j1, int & gp);
+  int startIndex; // Position of the first source word of the phrase ...
+  std::vector <size_t> currE;	// Factor ids of the target and source words of the phrase ...
+  std::vector <size_t> currF;
+  std::vector <int> alignments;	// Source and target position of each alignment point ...
+  std::vector <size_t> ceptEnglish;	// Factor ids of the words of the operation being composed ...
+  std::vector <size_t> ceptSource;
+  std::vector <size_t> noWords;
+  std::vector <size_t> oneWord;
+  std::vector <int> ceptF;	// Cepts of the phrase, ordered by their first target word: positions of the ...
+  std::vector <int> ceptE;	// ... source and target words of each, sorted ...
+  std::vector <size_t> ceptFEnd;	// ... and where each cept ends in ceptF and ceptE ...
+  std::vector <size_t> ceptEEnd;
+  std::vector <int> component;	// Connected source (first) and target words, while finding cepts ...
+  std::vector <char> targetNullWords;	// Per source word of the phrase: unaligned ...
+  std::vector <char> sourceNullWords;	// Per target word of the phrase: unaligned ...
+  std::vector <char> doneTargetIndexes;
+  std::vector <float> scores;
+
+  void setGap(int pos, bool filled);
+  int closestGap(int j1, int & gp);
   int firstOpenGap(std::vector <int> & coverageVector);
-  std::string intToString(int);
   int  getOpenGaps();
-  int isTranslationOperation(int j);
-  void removeReorderingOperations();
-
-  void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
+  int findComponent(int node);
+  bool isTargetNull(int j1) const;
+  bool isSourceNull(int targetIndex) const;
+  bool isDone(int targetIndex) const;
+  void generateOperations(int j1 , int contFlag , Bitmap & coverageVector);
+  void generateDeleteOperations(int currTargetIndex);
 
 public:
 
-  osmHypothesis();
+  explicit osmHypothesis(const OSMLM & osm);
   ~osmHypothesis() {};
-  void generateOperations(int & startIndex, int j1 , int contFlag , Bitmap & coverageVector , std::string english , std::string german , std::set <int> & targetNullWords , std::vector <std::string> & currF);
-  void generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes);
-  void calculateOSMProb(OSMLM& ptrOp);
+  // Forgets the last phrase, keeping the memory of the buffers
+  void clear();
+  void calculateOSMProb(const OSMLM& ptrOp);
   void computeOSMFeature(int startIndex , Bitmap & coverageVector);
-  void constructCepts(std::vector <int> & align , int startIndex , int endIndex, int targetPhraseLength);
-  void setPhrases(std::vector <std::string> & val1 , std::vector <std::string> & val2) {
-    currF = val1;
-    currE = val2;
+  void constructCepts(int startIndex , int endIndex, int targetPhraseLength);
+  // Factor ids of the source and target words, and the alignment, to fill
+  // in before constructCepts
+  std::vector <size_t> & sourcePhrase() {
+    return currF;
+  }
+  std::vector <size_t> & targetPhrase() {
+    return currE;
+  }
+  void addAlignment(int src, int tgt) {
+    alignments.push_back(src);
+    alignments.push_back(tgt);
   }
   void setState(const FFState* prev_state);
   osmState * saveState();
   void print();
-  void populateScores(std::vector <float> & scores , const int numFeatures);
+  const std::vector <float> & populateScores(const int numFeatures);
   void setState(const lm::ngram::State & val) {
     lmState = val;
   }
@@ -100,6 +125,3 @@ public:
 };
 
 } // namespace
-
-
-
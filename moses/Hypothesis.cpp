@@ -32,12 +32,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "InputType.h"
 #include "Manager.h"
+#include "SentenceStats.h"
 #include "IOWrapper.h"
 #include "moses/FF/FFState.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/StatelessFeatureFunction.h"
 
 #include <boost/foreach.hpp>
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -171,6 +173,9 @@ EvaluateWhenApplied(float estimatedScore)
 
   const vector<const StatefulFeatureFunction*>& ffs =
     StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  SentenceStats &stats = m_manager.GetSentenceStats();
+  const bool timed = stats.SampleStatefulEvaluation();
+  const double start = timed ? util::WallTime() : 0;
   for (unsigned i = 0; i < ffs.size(); ++i) {
     const StatefulFeatureFunction &ff = *ffs[i];
     if(!staticData.IsFeatureFunctionIgnored(ff)) {
@@ -178,6 +183,7 @@ EvaluateWhenApplied(float estimatedScore)
       m_ffStates[i] = ff.EvaluateWhenApplied(*this, s, &m_currScoreBreakdown);
     }
   }
+  if (timed) stats.AddTimeStatefulSampled(util::WallTime() - start);
 
   // FUTURE COST
   m_estimatedScore = estimatedScore;
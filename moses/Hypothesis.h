@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
 #include "ObjectPool.h"
+#include "MemoryArena.h"
 #include "xmlrpc-c.h"
 
 namespace Moses
@@ -54,6 +55,11 @@ struct ReportingOptions;
 
 typedef std::vector<Hypothesis*> ArcList;
 
+//! accumulated score breakdown of a hypothesis; lives in the sentence arena if there is one
+class HypothesisScoreBreakdown : public ScoreComponentCollection, public MemoryArenaObject
+{
+};
+
 /** Used to store a state in the beam search
     for the best translation. With its link back to the previous hypothesis
     m_prevHypo, we can trace back to the sentence start to read of the
@@ -62,7 +68,7 @@ typedef std::vector<Hypothesis*> ArcList;
 		The expansion of hypotheses is handled in the class Manager, which
     stores active hypothesis in the search in hypothesis stacks.
 ***/
-class Hypothesis
+class Hypothesis : public MemoryArenaObject
 {
   friend std::ostream& operator<<(std::ostream&, const Hypothesis&);
 protected:
@@ -75,7 +81,7 @@ protected:
   float							m_futureScore;  /*! score so far */
   float							m_estimatedScore; /*! estimated future cost to translate rest of sentence */
   /*! sum of scores of this hypothesis, and previous hypotheses. Lazily initialised.  */
-  mutable boost::scoped_ptr<ScoreComponentCollection> m_scoreBreakdown;
+  mutable boost::scoped_ptr<HypothesisScoreBreakdown> m_scoreBreakdown;
   ScoreComponentCollection m_currScoreBreakdown; /*! scores for this hypothesis only */
   std::vector<const FFState*> m_ffStates;
   const Hypothesis 	*m_winningHypo;
@@ -210,7 +216,7 @@ public:
   }
   const ScoreComponentCollection& GetScoreBreakdown() const {
     if (!m_scoreBreakdown) {
-      m_scoreBreakdown.reset(new ScoreComponentCollection);
+      m_scoreBreakdown.reset(new HypothesisScoreBreakdown);
       m_scoreBreakdown->PlusEquals(m_currScoreBreakdown);
       if (m_prevHypo) {
         m_scoreBreakdown->PlusEquals(m_prevHypo->GetScoreBreakdown());
@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
 #include "Timer.h"
+#include "Metrics.h"
 #include "moses/OutputCollector.h"
 #include "moses/FF/DistortionScoreProducer.h"
 #include "moses/LM/Base.h"
@@ -73,6 +74,10 @@ Manager::Manager(ttasksptr const& ttask)
   boost::shared_ptr<InputType> source = ttask->GetSource();
   m_transOptColl = source->CreateTranslationOptionCollection(ttask);
 
+  if (options()->search.hypothesis_arena) {
+    m_arena.reset(new MemoryArena);
+  }
+
   switch(options()->search.algo) {
   case Normal:
     m_search = new SearchNormal(*this, *m_transOptColl);
@@ -90,6 +95,7 @@ Manager::Manager(ttasksptr const& ttask)
 Manager::~Manager()
 {
   delete m_transOptColl;
+  // hypotheses in the arena are destroyed here, their memory goes with m_arena
   delete m_search;
   StaticData::Instance().CleanUpAfterSentenceProcessing(m_ttask.lock());
 }
@@ -144,7 +150,25 @@ void Manager::Decode()
   // search for best translation with the specified algorithm
   Timer searchTime;
   searchTime.start();
-  m_search->Decode();
+  {
+    MemoryArenaScope arenaScope(m_arena.get());
+    m_search->Decode();
+  }
+  if (m_arena) {
+    GetSentenceStats().SetArenaStats(m_arena->GetStats());
+  }
+  searchTime.stop();
+
+  Metrics &metrics = Metrics::Instance();
+  const SentenceStats &stats = GetSentenceStats();
+  metrics.Observe(Metrics::Search, searchTime.get_elapsed_time());
+  metrics.Observe(Metrics::LM, stats.GetTimeStateful());
+  metrics.Add(Metrics::Sentences, 1);
+  metrics.Add(Metrics::HyposCreated, stats.GetTotalHypos());
+  metrics.Add(Metrics::HyposRecombined, stats.GetNumHyposRecombined());
+  metrics.Add(Metrics::HyposPruned, stats.GetNumHyposPruned());
+  metrics.Add(Metrics::HyposDiscarded, stats.GetNumHyposDiscarded()
+              + stats.GetNumHyposEarlyDiscarded());
   VERBOSE(1, "Line " << m_source.GetTranslationId()
           << ": Search took " << searchTime << " seconds" << endl);
   IFVERBOSE(2) {
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <vector>
 #include <list>
+#include <boost/scoped_ptr.hpp>
 #include "InputType.h"
 #include "Hypothesis.h"
 #include "StaticData.h"
@@ -35,6 +36,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Search.h"
 #include "SearchCubePruning.h"
 #include "BaseManager.h"
+#include "MemoryArena.h"
 
 namespace Moses
 {
@@ -119,6 +121,7 @@ protected:
   size_t interrupted_flag;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   int m_hypoId; //used to number the hypos as they are created.
+  boost::scoped_ptr<MemoryArena> m_arena; /**< owns hypotheses and states of this sentence if search.hypothesis_arena is set */
 
   void GetConnectedGraph(
     std::map< int, bool >* pConnected,
@@ -0,0 +1,173 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <new>
+
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+#include "MemoryArena.h"
+
+namespace Moses
+{
+
+namespace
+{
+// every allocation is rounded up to this, and arena objects carry a header
+// of this size, so that anything placed in the arena is suitably aligned
+const size_t ARENA_ALIGN = 16;
+
+enum ArenaObjectOrigin {
+  FromHeap = 0,
+  FromArena = 1
+};
+
+inline size_t RoundUp(size_t size)
+{
+  return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+#ifdef WITH_THREADS
+// the arena is owned by its Manager, never by the thread
+void NoCleanup(MemoryArena *) {}
+boost::thread_specific_ptr<MemoryArena> s_currentArena(&NoCleanup);
+#else
+MemoryArena *s_currentArena = NULL;
+#endif
+}
+
+MemoryArena::MemoryArena(size_t blockSize)
+  : m_blockSize(RoundUp(blockSize))
+  , m_firstBlockSize(0)
+  , m_current(NULL)
+  , m_end(NULL)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    free(m_blocks[i]);
+  }
+}
+
+void *MemoryArena::Allocate(size_t size)
+{
+  size = RoundUp(size);
+  if (size > (size_t) (m_end - m_current)) {
+    NewBlock(size);
+  }
+  void *ret = m_current;
+  m_current += size;
+
+  ++m_stats.numAllocs;
+  m_stats.bytesUsed += size;
+  return ret;
+}
+
+void MemoryArena::NewBlock(size_t minSize)
+{
+  size_t size = minSize > m_blockSize ? minSize : m_blockSize;
+  char *block = static_cast<char*>(malloc(size));
+  if (block == NULL) {
+    throw std::bad_alloc();
+  }
+  if (m_blocks.empty()) {
+    m_firstBlockSize = size;
+  }
+  m_blocks.push_back(block);
+  m_current = block;
+  m_end = block + size;
+
+  ++m_stats.numBlocks;
+  m_stats.bytesReserved += size;
+}
+
+void MemoryArena::Reset()
+{
+  if (m_blocks.empty()) {
+    m_stats = Stats();
+    return;
+  }
+
+  for (size_t i = 1; i < m_blocks.size(); ++i) {
+    free(m_blocks[i]);
+  }
+  m_blocks.resize(1);
+
+  m_current = m_blocks[0];
+  m_end = m_current + m_firstBlockSize;
+
+  m_stats = Stats();
+  m_stats.numBlocks = 1;
+  m_stats.bytesReserved = m_firstBlockSize;
+}
+
+MemoryArena *MemoryArena::GetCurrent()
+{
+#ifdef WITH_THREADS
+  return s_currentArena.get();
+#else
+  return s_currentArena;
+#endif
+}
+
+void MemoryArena::SetCurrent(MemoryArena *arena)
+{
+#ifdef WITH_THREADS
+  s_currentArena.reset(arena);
+#else
+  s_currentArena = arena;
+#endif
+}
+
+void *MemoryArenaObject::operator new(size_t size)
+{
+  MemoryArena *arena = MemoryArena::GetCurrent();
+  char *mem;
+  if (arena) {
+    mem = static_cast<char*>(arena->Allocate(size + ARENA_ALIGN));
+    *reinterpret_cast<size_t*>(mem) = FromArena;
+  } else {
+    mem = static_cast<char*>(malloc(size + ARENA_ALIGN));
+    if (mem == NULL) {
+      throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(mem) = FromHeap;
+  }
+  return mem + ARENA_ALIGN;
+}
+
+void MemoryArenaObject::operator delete(void *p)
+{
+  if (p == NULL) {
+    return;
+  }
+  char *mem = static_cast<char*>(p) - ARENA_ALIGN;
+  if (*reinterpret_cast<size_t*>(mem) == FromHeap) {
+    free(mem);
+  }
+  // arena memory is released in bulk by MemoryArena::Reset()
+}
+
+}
+
@@ -0,0 +1,114 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_MemoryArena_h
+#define moses_MemoryArena_h
+
+#include <cstddef>
+#include <vector>
+
+namespace Moses
+{
+
+/** Bump allocator owning all the search objects of one sentence.
+ *
+ * Unlike ObjectPool, which hands out objects of a single type, the arena
+ * serves raw memory of any size. Nothing is given back individually; Reset()
+ * releases everything at once and keeps the first block for the next
+ * sentence.
+ *
+ * The phrase-based Manager installs its arena as the current arena of the
+ * decoding thread for the duration of the search. Classes derived from
+ * MemoryArenaObject (Hypothesis, FFState, ...) then allocate from it
+ * transparently, so plain new/delete at the call sites keeps working.
+ */
+class MemoryArena
+{
+public:
+  struct Stats {
+    Stats() : numAllocs(0), numBlocks(0), bytesUsed(0), bytesReserved(0) {}
+    size_t numAllocs;
+    size_t numBlocks;
+    size_t bytesUsed;
+    size_t bytesReserved;
+  };
+
+  explicit MemoryArena(size_t blockSize = 1 << 20);
+  ~MemoryArena();
+
+  //! aligned, uninitialised memory; freed on Reset() or destruction
+  void *Allocate(size_t size);
+
+  //! release all memory except the first block
+  void Reset();
+
+  const Stats &GetStats() const {
+    return m_stats;
+  }
+
+  //! arena used by MemoryArenaObject::operator new in the calling thread
+  static MemoryArena *GetCurrent();
+  static void SetCurrent(MemoryArena *arena);
+
+protected:
+  size_t m_blockSize, m_firstBlockSize;
+  std::vector<char*> m_blocks;
+  char *m_current, *m_end;
+  Stats m_stats;
+
+  void NewBlock(size_t minSize);
+
+private:
+  MemoryArena(const MemoryArena &);
+  MemoryArena &operator=(const MemoryArena &);
+};
+
+/** Installs an arena as the current arena of this thread for the lifetime
+ * of the object, restoring the previous one afterwards.
+ */
+class MemoryArenaScope
+{
+public:
+  explicit MemoryArenaScope(MemoryArena *arena)
+    : m_prev(MemoryArena::GetCurrent()) {
+    MemoryArena::SetCurrent(arena);
+  }
+  ~MemoryArenaScope() {
+    MemoryArena::SetCurrent(m_prev);
+  }
+private:
+  MemoryArena *m_prev;
+};
+
+/** Base class for objects which may live in the current MemoryArena.
+ * Each object is prefixed with a small header recording where it came from,
+ * so that delete only returns heap memory and is a no-op for arena memory
+ * (the destructor still runs either way).
+ */
+class MemoryArenaObject
+{
+public:
+  static void *operator new(size_t size);
+  static void operator delete(void *p);
+};
+
+}
+
+#endif
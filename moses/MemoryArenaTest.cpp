@@ -0,0 +1,89 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "MemoryArena.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+struct Counted : public MemoryArenaObject {
+  static int live;
+  double value;
+  Counted() : value(1.5) {
+    ++live;
+  }
+  ~Counted() {
+    --live;
+  }
+};
+int Counted::live = 0;
+}
+
+BOOST_AUTO_TEST_SUITE(memory_arena)
+
+BOOST_AUTO_TEST_CASE(allocate_and_reset)
+{
+  MemoryArena arena(1024);
+  char *a = static_cast<char*>(arena.Allocate(3));
+  char *b = static_cast<char*>(arena.Allocate(5));
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(a) % 16, 0);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(b) % 16, 0);
+  BOOST_CHECK_EQUAL(b - a, 16);
+
+  // larger than a block: gets its own
+  arena.Allocate(4000);
+  BOOST_CHECK_EQUAL(arena.GetStats().numAllocs, 3);
+  BOOST_CHECK_EQUAL(arena.GetStats().numBlocks, 2);
+
+  arena.Reset();
+  BOOST_CHECK_EQUAL(arena.GetStats().numAllocs, 0);
+  BOOST_CHECK_EQUAL(arena.GetStats().numBlocks, 1);
+  BOOST_CHECK_EQUAL(arena.GetStats().bytesReserved, 1024);
+  BOOST_CHECK(arena.Allocate(8) == a);
+}
+
+BOOST_AUTO_TEST_CASE(arena_objects)
+{
+  MemoryArena arena;
+  BOOST_CHECK(MemoryArena::GetCurrent() == NULL);
+
+  Counted *onHeap = new Counted;
+  Counted *inArena;
+  {
+    MemoryArenaScope scope(&arena);
+    BOOST_CHECK(MemoryArena::GetCurrent() == &arena);
+    inArena = new Counted;
+  }
+  BOOST_CHECK(MemoryArena::GetCurrent() == NULL);
+  BOOST_CHECK_EQUAL(arena.GetStats().numAllocs, 1);
+  BOOST_CHECK_EQUAL(Counted::live, 2);
+  BOOST_CHECK_EQUAL(inArena->value, 1.5);
+
+  // both kinds can be deleted the same way, whichever arena is current
+  delete inArena;
+  delete onHeap;
+  BOOST_CHECK_EQUAL(Counted::live, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
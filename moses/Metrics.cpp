@@ -0,0 +1,134 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "Metrics.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+const char *s_phaseNames[Metrics::NumPhases] = {
+  "lookup", "future_cost", "search", "lm", "nbest", "output"
+};
+const char *s_counterNames[Metrics::NumCounters] = {
+  "moses_sentences_total",
+  "moses_hypotheses_created_total",
+  "moses_hypotheses_recombined_total",
+  "moses_hypotheses_pruned_total",
+  "moses_hypotheses_discarded_total"
+};
+
+#ifdef WITH_THREADS
+void DumpLoop(double interval, string path)
+{
+  for (;;) {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(int64_t(interval * 1000)));
+    if (path.empty()) {
+      Metrics::Instance().Write(cerr);
+      continue;
+    }
+    // replace the file in one step, so that a scraper never sees half of it
+    string tmp = path + ".tmp";
+    {
+      ofstream out(tmp.c_str());
+      Metrics::Instance().Write(out);
+    }
+    rename(tmp.c_str(), path.c_str());
+  }
+}
+#endif
+}
+
+const double Metrics::s_bucketBounds[Metrics::NumBuckets] = {
+  0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+  0.01, 0.025, 0.05, 0.1, 0.5, 2.5
+};
+
+Metrics &Metrics::Instance()
+{
+  static Metrics s_instance;
+  return s_instance;
+}
+
+Metrics::Metrics()
+{
+  for (size_t p = 0; p < NumPhases; ++p) {
+    for (size_t b = 0; b <= NumBuckets; ++b) m_buckets[p][b] = 0;
+    m_microseconds[p] = 0;
+  }
+  for (size_t c = 0; c < NumCounters; ++c) m_counters[c] = 0;
+}
+
+void Metrics::Observe(Phase phase, double seconds)
+{
+  size_t b = 0;
+  while (b < NumBuckets && seconds > s_bucketBounds[b]) ++b;
+  m_buckets[phase][b].fetch_add(1, boost::memory_order_relaxed);
+  m_microseconds[phase].fetch_add(uint64_t(seconds * 1e6), boost::memory_order_relaxed);
+}
+
+void Metrics::Write(ostream &out) const
+{
+  ostringstream text;
+  text << "# TYPE moses_phase_seconds histogram\n";
+  for (size_t p = 0; p < NumPhases; ++p) {
+    uint64_t count = 0;
+    for (size_t b = 0; b <= NumBuckets; ++b) {
+      count += m_buckets[p][b].load(boost::memory_order_relaxed);
+      text << "moses_phase_seconds_bucket{phase=\"" << s_phaseNames[p] << "\",le=\"";
+      if (b < NumBuckets) text << s_bucketBounds[b];
+      else text << "+Inf";
+      text << "\"} " << count << "\n";
+    }
+    text << "moses_phase_seconds_sum{phase=\"" << s_phaseNames[p] << "\"} "
+         << m_microseconds[p].load(boost::memory_order_relaxed) / 1e6 << "\n";
+    text << "moses_phase_seconds_count{phase=\"" << s_phaseNames[p] << "\"} "
+         << count << "\n";
+  }
+  for (size_t c = 0; c < NumCounters; ++c) {
+    text << "# TYPE " << s_counterNames[c] << " counter\n"
+         << s_counterNames[c] << " "
+         << m_counters[c].load(boost::memory_order_relaxed) << "\n";
+  }
+  out << text.str() << flush;
+}
+
+void Metrics::StartDump(double interval, const string &path)
+{
+#ifdef WITH_THREADS
+  boost::thread(DumpLoop, interval, path).detach();
+#else
+  TRACE_ERR("Periodic metrics dumps need threads; ignoring metrics-dump" << endl);
+#endif
+}
+
+}
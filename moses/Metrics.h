@@ -0,0 +1,103 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_Metrics_h
+#define moses_Metrics_h
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include <boost/atomic.hpp>
+#include "util/usage.hh"
+
+namespace Moses
+{
+
+/**
+ * Process-wide decoder metrics, collected for every sentence regardless of
+ * the verbosity: a latency histogram per decoding phase and counts of what
+ * happened to the hypotheses. Updates are lock-free; Write() prints them
+ * in the Prometheus text format.
+ */
+class Metrics
+{
+public:
+  enum Phase {
+    Lookup,     // collecting translation options
+    FutureCost, // the future cost matrix
+    Search,
+    LM,         // stateful feature functions, estimated from a sample
+    NBest,
+    Output,
+    NumPhases
+  };
+
+  enum Counter {
+    Sentences,
+    HyposCreated,
+    HyposRecombined,
+    HyposPruned,
+    HyposDiscarded,
+    NumCounters
+  };
+
+  static Metrics &Instance();
+
+  void Observe(Phase phase, double seconds);
+
+  void Add(Counter counter, uint64_t n) {
+    m_counters[counter].fetch_add(n, boost::memory_order_relaxed);
+  }
+
+  void Write(std::ostream &out) const;
+
+  /** Rewrite the metrics to path (stderr if empty) every interval seconds */
+  void StartDump(double interval, const std::string &path);
+
+private:
+  static const size_t NumBuckets = 12;
+  static const double s_bucketBounds[NumBuckets];
+
+  Metrics();
+
+  // the last bucket counts observations above all bounds
+  boost::atomic<uint64_t> m_buckets[NumPhases][NumBuckets + 1];
+  boost::atomic<uint64_t> m_microseconds[NumPhases];
+  boost::atomic<uint64_t> m_counters[NumCounters];
+};
+
+/** Observes the wall time from construction to destruction */
+class MetricsTimer
+{
+public:
+  MetricsTimer(Metrics::Phase phase)
+    : m_phase(phase), m_start(util::WallTime()) {}
+  ~MetricsTimer() {
+    Metrics::Instance().Observe(m_phase, util::WallTime() - m_start);
+  }
+
+private:
+  Metrics::Phase m_phase;
+  double m_start;
+};
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_ParallelLineParser_h
+#define moses_ParallelLineParser_h
+
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread.hpp>
+#endif
+
+#include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+/** Parses the lines of a (possibly compressed) text file on several threads
+ * while handing the results over in file order.
+ *
+ * Lines are read in batches on the calling thread, and for each line
+ * parse.Prepare(line, lineNum, item) is called there, in file order. This is
+ * the place for work whose result depends on the order, such as creating
+ * factors, which get their ids in creation order. Each batch is then split
+ * into one contiguous slice per worker, parse(line, lineNum, item) finishes
+ * every item on the workers, and the items are passed to merge(item) on the
+ * calling thread, in the order of the input. Anything built by merge() is
+ * therefore the same as with a sequential read; parse() must be safe to call
+ * concurrently. Line numbers start at 1.
+ *
+ * Items are heap-allocated and owned by the parser until the whole batch has
+ * been merged, so an Item that owns resources should release them in its
+ * destructor: if parse() or merge() throws, the items of the current batch
+ * are destroyed, and merge() takes ownership by clearing what it keeps.
+ *
+ * With one thread (or without thread support) lines are parsed and merged
+ * one at a time with no copying.
+ */
+template<typename Item>
+class ParallelLineParser
+{
+public:
+  ParallelLineParser(util::FilePiece &in, size_t numThreads,
+                     size_t linesPerThread = 10000)
+    : m_in(in)
+    , m_numThreads(numThreads ? numThreads : 1)
+    , m_linesPerThread(linesPerThread) {
+  }
+
+  template<typename ParseFn, typename MergeFn>
+  void Run(ParseFn &parse, MergeFn &merge) {
+#ifdef WITH_THREADS
+    if (m_numThreads > 1) {
+      RunParallel(parse, merge);
+      return;
+    }
+#endif
+    RunSequential(parse, merge);
+  }
+
+private:
+  template<typename ParseFn, typename MergeFn>
+  void RunSequential(ParseFn &parse, MergeFn &merge) {
+    size_t lineNum = 0;
+    StringPiece line;
+    while (true) {
+      try {
+        line = m_in.ReadLine();
+      } catch (const util::EndOfFileException &e) {
+        break;
+      }
+      ++lineNum;
+      Item item;
+      parse.Prepare(line, lineNum, item);
+      parse(line, lineNum, item);
+      merge(item);
+    }
+  }
+
+#ifdef WITH_THREADS
+  template<typename ParseFn>
+  struct Worker {
+    ParseFn *parse;
+    const std::vector<std::string> *lines;
+    boost::ptr_vector<Item> *items;
+    size_t begin, end, firstLineNum;
+    std::string error;
+
+    void operator()() {
+      try {
+        for (size_t i = begin; i < end; ++i) {
+          parse->operator()(StringPiece((*lines)[i]), firstLineNum + i, (*items)[i]);
+        }
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+    }
+  };
+
+  template<typename ParseFn, typename MergeFn>
+  void RunParallel(ParseFn &parse, MergeFn &merge) {
+    const size_t batchSize = m_numThreads * m_linesPerThread;
+    std::vector<std::string> lines;
+    boost::ptr_vector<Item> items;
+    std::vector<Worker<ParseFn> > workers(m_numThreads);
+    // number of the first line of the batch
+    size_t lineNum = 1;
+    bool eof = false;
+
+    while (!eof) {
+      lines.clear();
+      items.clear();
+      try {
+        while (lines.size() < batchSize) {
+          StringPiece line = m_in.ReadLine();
+          lines.push_back(std::string(line.data(), line.size()));
+          items.push_back(new Item());
+          parse.Prepare(line, lineNum + lines.size() - 1, items.back());
+        }
+      } catch (const util::EndOfFileException &e) {
+        eof = true;
+      }
+      if (lines.empty()) {
+        break;
+      }
+
+      const size_t slice = (lines.size() + m_numThreads - 1) / m_numThreads;
+      boost::thread_group threads;
+      for (size_t t = 0; t < m_numThreads; ++t) {
+        Worker<ParseFn> &worker = workers[t];
+        worker.parse = &parse;
+        worker.lines = &lines;
+        worker.items = &items;
+        worker.begin = std::min(t * slice, lines.size());
+        worker.end = std::min(worker.begin + slice, lines.size());
+        worker.firstLineNum = lineNum;
+        worker.error.clear();
+        if (worker.begin < worker.end) {
+          threads.create_thread(boost::ref(worker));
+        }
+      }
+      threads.join_all();
+
+      for (size_t t = 0; t < m_numThreads; ++t) {
+        UTIL_THROW_IF2(!workers[t].error.empty(), workers[t].error);
+      }
+      for (size_t i = 0; i < items.size(); ++i) {
+        merge(items[i]);
+      }
+      lineNum += lines.size();
+    }
+  }
+#endif
+
+  util::FilePiece &m_in;
+  size_t m_numThreads;
+  size_t m_linesPerThread;
+};
+
+}
+
+#endif
@@ -58,6 +58,7 @@ Parameter::Parameter()
   AddParam(main_opts,"verbose", "v", "verbosity level of the logging");
   AddParam(main_opts,"version", "show version of Moses and libraries used");
   AddParam(main_opts,"show-weights", "print feature weights and exit");
+  AddParam(main_opts,"metrics-dump", "write decoder metrics every N seconds, to the given file or stderr: N [file]");
   AddParam(main_opts,"time-out", "seconds after which is interrupted (-1=no time-out, default is -1)");
   AddParam(main_opts,"segment-time-out", "seconds for single segment after which is interrupted (-1=no time-out, default is -1)");
 
@@ -107,6 +108,7 @@ Parameter::Parameter()
 
   // miscellaneous search options
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
+  AddParam(search_opts,"hypothesis-arena", "allocate hypotheses, feature states and score breakdowns from a per-sentence arena (phrase-based only)");
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
 
@@ -234,6 +236,8 @@ Parameter::Parameter()
            "Max. number of seconds the server will keep a persistent connection alive.");
   AddParam(server_opts,"server-timeout",
            "Max. number of seconds the server will wait for a client to submit a request once a connection has been established.");
+  AddParam(server_opts,"server-result-cache",
+           "Max. No. of translations the server caches for repeated requests (default 0 = no cache). Requests in a session are not cached.");
   // session timeout and session cache size are for moses translation session handling
   // they have nothing to do with the abyss server (but relate to the moses server)
   AddParam(server_opts,"session-timeout",
@@ -257,6 +261,7 @@ Parameter::Parameter()
   AddParam(misc_opts,"description", "Source language, target language, description");
   AddParam(misc_opts,"no-cache", "Disable all phrase-table caching. Default = false (ie. enable caching)");
   AddParam(misc_opts,"default-non-term-for-empty-range-only", "Don't add [X] to all ranges, just ranges where there isn't a source non-term. Default = false (ie. add [X] everywhere)");
+  AddParam(misc_opts,"loading-threads", "Number of threads used to parse text rule tables (hierarchical and syntax models) at load time (default = 1)");
   AddParam(misc_opts,"s2t-parsing-algorithm", "Which S2T parsing algorithm to use. 0=recursive CYK+, 1=scope-3 (default = 0)");
 
   //AddParam(o,"continue-partial-translation", "cpt", "start from nonempty hypothesis");
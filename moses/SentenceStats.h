@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Timer.h"
 #include "Phrase.h"
 #include "Hypothesis.h"
+#include "MemoryArena.h"
 #include "TypeDef.h" //FactorArray
 #include "InputType.h"
 #include "Util.h" //Join()
@@ -66,6 +67,9 @@ public:
     m_numHyposDiscarded = 0;
     m_numHyposEarlyDiscarded = 0;
     m_numHyposNotBuilt = 0;
+    m_numStatefulEvaluations = 0;
+    m_timeStatefulSampled = 0;
+    m_arenaStats = MemoryArena::Stats();
     m_totalSourceWords = source.GetSize();
     m_recombinationInfos.clear();
     m_deletedWords.clear();
@@ -98,6 +102,10 @@ public:
   unsigned int GetNumHyposNotBuilt() const {
     return m_numHyposNotBuilt;
   }
+  //! estimated time in stateful feature functions, from a 1 in 16 sample
+  double GetTimeStateful() const {
+    return m_timeStatefulSampled * 16;
+  }
   double GetTimeCollectOpts() const {
     return m_timeCollectOpts.get_elapsed_time();
   }
@@ -125,6 +133,9 @@ public:
   double GetTimeTotal() const {
     return m_timeTotal.get_elapsed_time();
   }
+  const MemoryArena::Stats &GetArenaStats() const {
+    return m_arenaStats;
+  }
   size_t GetTotalSourceWords() const {
     return m_totalSourceWords;
   }
@@ -160,9 +171,19 @@ public:
   void AddNotBuilt() {
     m_numHyposNotBuilt++;
   }
+  //! true for the evaluations of stateful features that should be timed
+  bool SampleStatefulEvaluation() {
+    return (m_numStatefulEvaluations++ & 15) == 0;
+  }
+  void AddTimeStatefulSampled(double seconds) {
+    m_timeStatefulSampled += seconds;
+  }
   void AddDiscarded() {
     m_numHyposDiscarded++;
   }
+  void SetArenaStats(const MemoryArena::Stats &stats) {
+    m_arenaStats = stats;
+  }
 
   void StartTimeCollectOpts() {
     m_timeCollectOpts.start();
@@ -237,6 +258,8 @@ protected:
   unsigned int m_numHyposDiscarded;
   unsigned int m_numHyposEarlyDiscarded;
   unsigned int m_numHyposNotBuilt;
+  unsigned int m_numStatefulEvaluations;
+  double m_timeStatefulSampled;
   Timer m_timeCollectOpts;
   Timer m_timeBuildHyp;
   Timer m_timeEstimateScore;
@@ -247,6 +270,9 @@ protected:
   Timer m_timeManageCubes;
   Timer m_timeTotal;
 
+  //allocator
+  MemoryArena::Stats m_arenaStats;
+
   //words
   size_t m_totalSourceWords;
   std::vector<const Phrase*> m_deletedWords; //count deleted words/phrases in the final hypothesis
@@ -276,6 +302,10 @@ inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
          << "        manage stacks   " << ss.GetTimeStack()         << " (" << (int)(100 * ss.GetTimeStack()/totalTime) << "%)" << std::endl
          << "        other           " << otherTime                 << " (" << (int)(100 * otherTime/totalTime) << "%)" << std::endl
 
+         << "arena allocations = " << ss.GetArenaStats().numAllocs << std::endl
+         << "       bytes used = " << ss.GetArenaStats().bytesUsed << std::endl
+         << "   bytes reserved = " << ss.GetArenaStats().bytesReserved << " in " << ss.GetArenaStats().numBlocks << " blocks" << std::endl
+
          << "total source words = " << ss.GetTotalSourceWords() << std::endl
          << "     words deleted = " << ss.GetNumWordsDeleted() << " (" << Join(" ", ss.GetDeletedWords()) << ")" << std::endl
          << "    words inserted = " << ss.GetNumWordsInserted() << " (" << Join(" ", ss.GetInsertedWords()) << ")" << std::endl;
@@ -67,6 +67,7 @@ StaticData StaticData::s_instance;
 StaticData::StaticData()
   : m_options(new AllOptions)
   , m_requireSortingAfterSourceContext(false)
+  , m_loadingThreadCount(1)
   , m_currentWeightSetting("default")
   , m_treeStructure(NULL)
   , m_coordSpaceNextID(1)
@@ -170,6 +171,23 @@ StaticData
 #endif
     }
   }
+
+  m_loadingThreadCount = 1;
+  params = m_parameter->GetParam("loading-threads");
+  if (params && params->size()) {
+    m_loadingThreadCount = Scan<int>(params->at(0));
+    if (m_loadingThreadCount < 1) {
+      std::cerr << "Specify at least one loading thread.";
+      return false;
+    }
+#ifndef WITH_THREADS
+    if (m_loadingThreadCount > 1) {
+      std::cerr << "Error: Loading thread count of " << params->at(0)
+                << " but moses not built with thread support";
+      return false;
+    }
+#endif
+  }
   return true;
 }
 
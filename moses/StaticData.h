@@ -111,6 +111,7 @@ protected:
   UnknownLHSList m_unknownLHS;
 
   int m_threadCount;
+  int m_loadingThreadCount; //! threads used to parse text rule tables
   // long m_startTranslationId;
 
   // alternate weight settings
@@ -265,6 +266,10 @@ public:
     return m_threadCount;
   }
 
+  int LoadingThreadCount() const {
+    return m_loadingThreadCount;
+  }
+
   void SetExecPath(const std::string &path);
   const std::string &GetBinDirectory() const;
 
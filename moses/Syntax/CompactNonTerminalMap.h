@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "moses/FactorCollection.h"
+#include "moses/Word.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Compact alternative to NonTerminalMap for containers that are created in
+// large numbers but typically hold only a handful of entries (e.g. chart
+// cells).  Membership is recorded in a bitset indexed by non-terminal ID and
+// the values are kept in insertion order, so a Find() is a bit test followed
+// by a short linear scan instead of a per-container vector with one slot for
+// every non-terminal in the grammar.  As with NonTerminalMap, values can be
+// modified but not removed and their addresses are stable.
+template<typename T>
+class CompactNonTerminalMap
+{
+public:
+  CompactNonTerminalMap()
+    : m_bits(FactorCollection::Instance().GetNumNonTerminals()) {}
+
+  CompactNonTerminalMap(const CompactNonTerminalMap &other)
+    : m_bits(other.m_bits)
+    , m_ids(other.m_ids) {
+    CopyValues(other);
+  }
+
+  CompactNonTerminalMap &operator=(const CompactNonTerminalMap &other) {
+    if (this != &other) {
+      Clear();
+      m_bits = other.m_bits;
+      m_ids = other.m_ids;
+      CopyValues(other);
+    }
+    return *this;
+  }
+
+  ~CompactNonTerminalMap() {
+    Clear();
+  }
+
+  std::size_t Size() const {
+    return m_values.size();
+  }
+
+  bool IsEmpty() const {
+    return m_values.empty();
+  }
+
+  bool Contains(const Word &w) const {
+    const std::size_t i = w[0]->GetId();
+    return i < m_bits.size() && m_bits.test(i);
+  }
+
+  // Returns a pointer to the value for key (whether newly inserted or not)
+  // and a flag indicating whether the insertion took place.
+  std::pair<T *, bool> Insert(const Word &key, const T &value);
+
+  T *Find(const Word &w) const {
+    return Contains(w) ? Lookup(w[0]->GetId()) : NULL;
+  }
+
+private:
+  T *Lookup(std::size_t id) const {
+    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+      if (m_ids[i] == id) {
+        return m_values[i];
+      }
+    }
+    return NULL;
+  }
+
+  void CopyValues(const CompactNonTerminalMap &other) {
+    m_values.reserve(other.m_values.size());
+    for (std::size_t i = 0; i < other.m_values.size(); ++i) {
+      m_values.push_back(new T(*other.m_values[i]));
+    }
+  }
+
+  void Clear() {
+    for (std::size_t i = 0; i < m_values.size(); ++i) {
+      delete m_values[i];
+    }
+    m_values.clear();
+  }
+
+  boost::dynamic_bitset<> m_bits;
+  std::vector<std::size_t> m_ids;
+  std::vector<T *> m_values;
+};
+
+template<typename T>
+std::pair<T *, bool> CompactNonTerminalMap<T>::Insert(const Word &key,
+    const T &value)
+{
+  const std::size_t i = key[0]->GetId();
+  if (i < m_bits.size() && m_bits.test(i)) {
+    return std::make_pair(Lookup(i), false);
+  }
+  if (i >= m_bits.size()) {
+    m_bits.resize(i+1);
+  }
+  m_bits.set(i);
+  m_ids.push_back(i);
+  m_values.push_back(new T(value));
+  return std::make_pair(m_values.back(), true);
+}
+
+}  // namespace Syntax
+}  // namespace Moses
@@ -39,6 +39,7 @@ boost::shared_ptr<RuleTrie> OovHandler<RuleTrie>::SynthesizeRuleTrie(
     }
   }
 
+  SortAndPrune(*trie, 0);
   return trie;
 }
 
@@ -4,7 +4,7 @@
 
 #include <boost/unordered_map.hpp>
 
-#include "moses/Syntax/NonTerminalMap.h"
+#include "moses/Syntax/CompactNonTerminalMap.h"
 #include "moses/Syntax/PVertex.h"
 #include "moses/Syntax/SymbolEqualityPred.h"
 #include "moses/Syntax/SymbolHasher.h"
@@ -23,7 +23,7 @@ public:
   struct Cell {
     typedef boost::unordered_map<Word, PVertex, SymbolHasher,
             SymbolEqualityPred> TMap;
-    typedef NonTerminalMap<PVertex> NMap;
+    typedef CompactNonTerminalMap<PVertex> NMap;
     // Collection of terminal vertices (keyed by terminal symbol).
     TMap terminalVertices;
     // Collection of non-terminal vertices (keyed by non-terminal symbol).
@@ -63,15 +63,20 @@ public:
     }
     // If v is a non-terminal vertex add it to the cell's nonTerminalVertices
     // map and update the compressed chart (if enabled).
-    std::pair<Cell::NMap::Iterator, bool> result =
+    std::pair<PVertex *, bool> result =
       cell.nonTerminalVertices.Insert(v.symbol, v);
     if (result.second && m_compressedChart) {
       CompressedItem item;
       item.end = end;
-      item.vertex = &(result.first->second);
-      (*m_compressedChart)[start][v.symbol[0]->GetId()].push_back(item);
+      item.vertex = result.first;
+      CompressedMatrix &matrix = (*m_compressedChart)[start];
+      const std::size_t label = v.symbol[0]->GetId();
+      if (label >= matrix.size()) {
+        matrix.resize(label+1);
+      }
+      matrix[label].push_back(item);
     }
-    return result.first->second;
+    return *result.first;
   }
 
   const CompressedMatrix &GetCompressedMatrix(std::size_t start) const {
@@ -54,25 +54,26 @@ void RecursiveCYKPlusParser<Callback>::GetNonTerminalExtensions(
   std::size_t minEnd,
   std::size_t maxEnd)
 {
-  // Non-terminal labels in node's outgoing edge set.
-  const RuleTrie::Node::SymbolMap &nonTermMap = node.GetNonTerminalMap();
+  // Non-terminal labels in node's outgoing edge set, sorted by label ID.
+  const RuleTrie::Node::FlatChildren &nonTerms = node.GetFlatNonTerminals();
 
   // Compressed matrix from PChart.
   const PChart::CompressedMatrix &matrix =
     Base::m_chart.GetCompressedMatrix(start);
 
   // Loop over possible expansions of the rule.
-  RuleTrie::Node::SymbolMap::const_iterator p;
-  RuleTrie::Node::SymbolMap::const_iterator p_end = nonTermMap.end();
-  for (p = nonTermMap.begin(); p != p_end; ++p) {
-    const Word &nonTerm = p->first;
-    const std::vector<PChart::CompressedItem> &items =
-      matrix[nonTerm[0]->GetId()];
+  RuleTrie::Node::FlatChildren::const_iterator p;
+  RuleTrie::Node::FlatChildren::const_iterator p_end = nonTerms.end();
+  for (p = nonTerms.begin(); p != p_end; ++p) {
+    const std::size_t label = p->first;
+    if (label >= matrix.size()) {
+      break;
+    }
+    const std::vector<PChart::CompressedItem> &items = matrix[label];
     for (std::vector<PChart::CompressedItem>::const_iterator q = items.begin();
          q != items.end(); ++q) {
       if (q->end >= minEnd && q->end <= maxEnd) {
-        const RuleTrie::Node &child = p->second;
-        AddAndExtend(child, q->end, *(q->vertex));
+        AddAndExtend(*(p->second), q->end, *(q->vertex));
       }
     }
   }
@@ -93,29 +94,13 @@ void RecursiveCYKPlusParser<Callback>::GetTerminalExtension(
     return;
   }
 
-  const RuleTrie::Node::SymbolMap &terminals = node.GetTerminalMap();
-
   for (PChart::Cell::TMap::const_iterator p = vertexMap.begin();
        p != vertexMap.end(); ++p) {
     const Word &terminal = p->first;
     const PVertex &vertex = p->second;
-
-    // if node has small number of terminal edges, test word equality for each.
-    if (terminals.size() < 5) {
-      for (RuleTrie::Node::SymbolMap::const_iterator iter = terminals.begin();
-           iter != terminals.end(); ++iter) {
-        const Word &word = iter->first;
-        if (word == terminal) {
-          const RuleTrie::Node *child = & iter->second;
-          AddAndExtend(*child, end, vertex);
-          break;
-        }
-      }
-    } else { // else, do hash lookup
-      const RuleTrie::Node *child = node.GetChild(terminal);
-      if (child != NULL) {
-        AddAndExtend(*child, end, vertex);
-      }
+    const RuleTrie::Node *child = node.GetFlatChild(terminal[0]->GetId());
+    if (child != NULL) {
+      AddAndExtend(*child, end, vertex);
     }
   }
 }
@@ -141,12 +126,12 @@ void RecursiveCYKPlusParser<Callback>::AddAndExtend(
   // Get all further extensions of rule (until reaching end of sentence or
   // max-chart-span).
   if (end < m_maxEnd) {
-    if (!node.GetTerminalMap().empty()) {
+    if (!node.GetFlatTerminals().empty()) {
       for (std::size_t newEndPos = end+1; newEndPos <= m_maxEnd; newEndPos++) {
         GetTerminalExtension(node, end+1, newEndPos);
       }
     }
-    if (!node.GetNonTerminalMap().empty()) {
+    if (!node.GetFlatNonTerminals().empty()) {
       GetNonTerminalExtensions(node, end+1, end+1, m_maxEnd);
     }
   }
@@ -33,6 +33,8 @@ private:
                                     const TargetPhrase &target,
                                     const Word *sourceLHS) = 0;
 
+  // Called once all rules have been added.  A limit of zero means no
+  // pruning, but implementations may still reorganize their internal layout.
   virtual void SortAndPrune(std::size_t) = 0;
 };
 
@@ -1,5 +1,6 @@
 #include "RuleTrieCYKPlus.h"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -52,6 +53,47 @@ void RuleTrieCYKPlus::Node::Sort(std::size_t tableLimit)
   m_targetPhraseCollection->Sort(true, tableLimit);
 }
 
+void RuleTrieCYKPlus::Node::Freeze()
+{
+  m_flatTerminals.clear();
+  m_flatTerminals.reserve(m_sourceTermMap.size());
+  for (SymbolMap::iterator p = m_sourceTermMap.begin();
+       p != m_sourceTermMap.end(); ++p) {
+    p->second.Freeze();
+    m_flatTerminals.push_back(std::make_pair(p->first[0]->GetId(), &p->second));
+  }
+  std::sort(m_flatTerminals.begin(), m_flatTerminals.end());
+
+  m_flatNonTerminals.clear();
+  m_flatNonTerminals.reserve(m_nonTermMap.size());
+  for (SymbolMap::iterator p = m_nonTermMap.begin();
+       p != m_nonTermMap.end(); ++p) {
+    p->second.Freeze();
+    m_flatNonTerminals.push_back(std::make_pair(p->first[0]->GetId(),
+                                 &p->second));
+  }
+  std::sort(m_flatNonTerminals.begin(), m_flatNonTerminals.end());
+}
+
+const RuleTrieCYKPlus::Node *RuleTrieCYKPlus::Node::GetFlatChild(
+  std::size_t id) const
+{
+  // Most nodes have very few terminal children, so scan those linearly.
+  if (m_flatTerminals.size() < 8) {
+    for (FlatChildren::const_iterator p = m_flatTerminals.begin();
+         p != m_flatTerminals.end(); ++p) {
+      if (p->first == id) {
+        return p->second;
+      }
+    }
+    return NULL;
+  }
+  FlatChildren::const_iterator p = std::lower_bound(
+                                     m_flatTerminals.begin(), m_flatTerminals.end(),
+                                     std::make_pair(id, static_cast<const Node *>(NULL)));
+  return (p != m_flatTerminals.end() && p->first == id) ? p->second : NULL;
+}
+
 RuleTrieCYKPlus::Node *RuleTrieCYKPlus::Node::GetOrCreateChild(
   const Word &sourceTerm)
 {
@@ -132,6 +174,7 @@ void RuleTrieCYKPlus::SortAndPrune(std::size_t tableLimit)
   if (tableLimit) {
     m_root.Sort(tableLimit);
   }
+  m_root.Freeze();
 }
 
 bool RuleTrieCYKPlus::HasPreterminalRule(const Word &w) const
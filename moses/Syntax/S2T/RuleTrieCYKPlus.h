@@ -33,6 +33,10 @@ public:
     typedef boost::unordered_map<Word, Node, SymbolHasher,
             SymbolEqualityPred> SymbolMap;
 
+    // Children as (symbol ID, node) pairs sorted by ID.  These are built by
+    // Freeze() once loading is complete and are what the parser scans.
+    typedef std::vector<std::pair<std::size_t, const Node *> > FlatChildren;
+
     bool IsLeaf() const {
       return m_sourceTermMap.empty() && m_nonTermMap.empty();
     }
@@ -44,6 +48,10 @@ public:
     void Prune(std::size_t tableLimit);
     void Sort(std::size_t tableLimit);
 
+    // Recursively build the flat child arrays.  Must be called again if the
+    // node's children change.
+    void Freeze();
+
     Node *GetOrCreateChild(const Word &sourceTerm);
     Node *GetOrCreateNonTerminalChild(const Word &targetNonTerm);
 
@@ -68,11 +76,24 @@ public:
       return m_nonTermMap;
     }
 
+    const FlatChildren &GetFlatTerminals() const {
+      return m_flatTerminals;
+    }
+
+    const FlatChildren &GetFlatNonTerminals() const {
+      return m_flatNonTerminals;
+    }
+
+    // Lookup in the flat terminal array by factor ID.
+    const Node *GetFlatChild(std::size_t id) const;
+
     Node() : m_targetPhraseCollection(new TargetPhraseCollection) {}
 
   private:
     SymbolMap m_sourceTermMap;
     SymbolMap m_nonTermMap;
+    FlatChildren m_flatTerminals;
+    FlatChildren m_flatNonTerminals;
     TargetPhraseCollection::shared_ptr m_targetPhraseCollection;
   };
 
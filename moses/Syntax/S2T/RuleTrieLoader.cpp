@@ -19,6 +19,8 @@
 #include "moses/Range.h"
 #include "moses/ChartTranslationOptionList.h"
 #include "moses/FactorCollection.h"
+#include "moses/ParallelLineParser.h"
+#include "moses/TranslationModel/RuleTable/LineParser.h"
 #include "moses/Syntax/RuleTableFF.h"
 #include "util/file_piece.hh"
 #include "util/string_piece.hh"
@@ -36,6 +38,33 @@ namespace Syntax
 namespace S2T
 {
 
+// Adds parsed rules to the trie, in file order.
+class RuleTrieLoader::RuleMerger
+{
+public:
+  RuleMerger(RuleTrieLoader &loader, RuleTrie &trie)
+    : m_loader(loader)
+    , m_trie(trie) {}
+
+  void operator()(ParsedRule &rule) {
+    if (rule.targetPhrase == NULL) {
+      return;
+    }
+    TargetPhraseCollection::shared_ptr phraseColl
+    = m_loader.GetOrCreateTargetPhraseCollection(m_trie, *rule.sourcePhrase,
+        *rule.targetPhrase, rule.sourceLHS);
+    phraseColl->Add(rule.targetPhrase);
+    rule.targetPhrase = NULL;
+
+    // source phrase and LHS are not kept by the memory pt; the rule deletes
+    // them
+  }
+
+private:
+  RuleTrieLoader &m_loader;
+  RuleTrie &m_trie;
+};
+
 bool RuleTrieLoader::Load(Moses::AllOptions const& opts,
                           const std::vector<FactorType> &input,
                           const std::vector<FactorType> &output,
@@ -45,104 +74,21 @@ bool RuleTrieLoader::Load(Moses::AllOptions const& opts,
 {
   PrintUserTime(std::string("Start loading text phrase table. Moses format"));
 
-  // const StaticData &staticData = StaticData::Instance();
-
-  std::size_t count = 0;
-
   std::ostream *progress = NULL;
   IFVERBOSE(1) progress = &std::cerr;
   util::FilePiece in(inFile.c_str(), progress);
 
-  // reused variables
-  std::vector<float> scoreVector;
-  StringPiece line;
-
-  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
-
-  while(true) {
-    try {
-      line = in.ReadLine();
-    } catch (const util::EndOfFileException &e) {
-      break;
-    }
-
-    util::TokenIter<util::MultiCharacter> pipes(line, "|||");
-    StringPiece sourcePhraseString(*pipes);
-    StringPiece targetPhraseString(*++pipes);
-    StringPiece scoreString(*++pipes);
-
-    StringPiece alignString;
-    if (++pipes) {
-      StringPiece temp(*pipes);
-      alignString = temp;
-    }
-
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == std::string::npos);
-    if (isLHSEmpty && !opts.unk.word_deletion_enabled) { // staticData.IsWordDeletionEnabled()) {
-      TRACE_ERR( ff.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
-    }
-
-    scoreVector.clear();
-    for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
-      int processed;
-      float score = converter.StringToFloat(s->data(), s->length(), &processed);
-      UTIL_THROW_IF2(std::isnan(score), "Bad score " << *s << " on line " << count);
-      scoreVector.push_back(FloorScore(TransformScore(score)));
-    }
-    const size_t numScoreComponents = ff.GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
-    }
-
-    // parse source & find pt node
-
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
-
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ff);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
-
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
-
-    ++pipes;  // skip over counts field.
-
-    if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ff, sparseString);
-    }
-
-    if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
-    }
-
-    targetPhrase->GetScoreBreakdown().Assign(&ff, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ff.GetFeaturesToApply());
-
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(trie, sourcePhrase,
-                                        *targetPhrase, sourceLHS);
-    phraseColl->Add(targetPhrase);
-
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
-
-    count++;
-  }
-
-  // sort and prune each target phrase collection
-  if (ff.GetTableLimit()) {
-    SortAndPrune(trie, ff.GetTableLimit());
-  }
+  // lines are parsed on the loading threads, but added to the trie in file
+  // order so the result does not depend on the number of threads
+  RuleTableLineParser parse(opts, MosesFormat, input, output, ff);
+  RuleMerger merge(*this, trie);
+  ParallelLineParser<ParsedRule> parser(
+    in, StaticData::Instance().LoadingThreadCount());
+  parser.Run(parse, merge);
+
+  // sort and prune each target phrase collection (if there is a table limit)
+  // and let the trie finalize its layout for parsing
+  SortAndPrune(trie, ff.GetTableLimit());
 
   return true;
 }
@@ -20,6 +20,9 @@ namespace S2T
 
 class RuleTrieLoader : public RuleTrieCreator
 {
+private:
+  class RuleMerger;
+
 public:
   bool Load(Moses::AllOptions const& opts,
             const std::vector<FactorType> &input,
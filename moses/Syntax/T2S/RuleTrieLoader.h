@@ -19,6 +19,9 @@ namespace T2S
 
 class RuleTrieLoader : public RuleTrieCreator
 {
+private:
+  class RuleMerger;
+
 public:
   bool Load(Moses::AllOptions const& opts,
             const std::vector<FactorType> &input,
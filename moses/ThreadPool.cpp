@@ -31,7 +31,7 @@ namespace Moses
 {
 
 ThreadPool::ThreadPool( size_t numThreads )
-  : m_stopped(false), m_stopping(false), m_queueLimit(0)
+  : m_stopped(false), m_stopping(false), m_queueLimit(0), m_submitted(0)
 {
   for (size_t i = 0; i < numThreads; ++i) {
     m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
@@ -49,7 +49,7 @@ void ThreadPool::Execute()
         m_threadNeeded.wait(lock);
       }
       if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
+        task = m_tasks.top().task;
         m_tasks.pop();
       }
     }
@@ -70,7 +70,8 @@ void ThreadPool::Submit(boost::shared_ptr<Task> task)
   while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
     m_threadAvailable.wait(lock);
   }
-  m_tasks.push(task);
+  QueuedTask queued = { task->GetPriority(), m_submitted++, task };
+  m_tasks.push(queued);
   m_threadNeeded.notify_all();
 }
 
@@ -0,0 +1,135 @@
+#include "LineParser.h"
+
+#include <cmath>
+#include <string>
+
+#include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
+#include "moses/Util.h"
+#include "moses/Word.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
+#include "moses/parameters/AllOptions.h"
+#include "util/double-conversion/double-conversion.h"
+#include "util/exception.hh"
+#include "util/tokenize_piece.hh"
+#include "LoaderStandard.h"
+
+namespace Moses
+{
+
+ParsedRule::~ParsedRule()
+{
+  delete sourcePhrase;
+  delete sourceLHS;
+  delete targetPhrase;
+}
+
+void RuleTableLineParser::Prepare(StringPiece line, std::size_t lineNum,
+                                  ParsedRule &rule) const
+{
+  if (m_format == HieroFormat) { // inefficiently reformat line
+    std::string hiero_before(line.data(), line.size());
+    ReformatHieroRule(hiero_before, rule.reformatted);
+    line = rule.reformatted;
+  }
+
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourcePhraseString(*pipes);
+  StringPiece targetPhraseString(*++pipes);
+  ++pipes;  // scores
+  ++pipes;  // alignment
+  ++pipes;  // counts
+
+  bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == std::string::npos);
+  if (isLHSEmpty && !m_opts.unk.word_deletion_enabled) {
+    TRACE_ERR( m_ff.GetFilePath() << ":" << lineNum << ": pt entry contains empty target, skipping\n");
+    return;
+  }
+
+  // the rule owns everything from here on, so nothing leaks if a later
+  // field turns out to be malformed
+
+  // constituent labels
+  Word *targetLHS;
+
+  // create target phrase obj
+  TargetPhrase *targetPhrase = rule.targetPhrase = new TargetPhrase(&m_ff);
+  targetPhrase->CreateFromString(Output, m_output, targetPhraseString, &targetLHS);
+  targetPhrase->SetTargetLHS(targetLHS);
+  rule.targetLHS = targetLHS;
+  // source
+  rule.sourcePhrase = new Phrase();
+  rule.sourcePhrase->CreateFromString(Input, m_input, sourcePhraseString, &rule.sourceLHS);
+
+  if (++pipes) {
+    StringPiece sparseString(*pipes);
+    targetPhrase->SetSparseScore(&m_ff, sparseString);
+    if (m_keepRawFields) {
+      sparseString.CopyToString(&rule.sparseString);
+    }
+  }
+}
+
+void RuleTableLineParser::operator()(StringPiece line, std::size_t lineNum,
+                                     ParsedRule &rule) const
+{
+  if (rule.targetPhrase == NULL) {
+    // skipped by Prepare()
+    return;
+  }
+  if (!rule.reformatted.empty()) {
+    line = rule.reformatted;
+  }
+
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  ++pipes;  // source, made by Prepare()
+  ++pipes;  // target, made by Prepare()
+  StringPiece scoreString(*pipes);
+
+  StringPiece alignString;
+  if (++pipes) {
+    StringPiece temp(*pipes);
+    alignString = temp;
+  }
+
+  ++pipes;  // counts
+  ++pipes;  // sparse scores, set by Prepare()
+
+  int noflags = double_conversion::StringToDoubleConverter::NO_FLAGS;
+  double_conversion::StringToDoubleConverter
+  converter(noflags, NAN, NAN, "inf", "nan");
+
+  std::vector<float> scoreVector;
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
+    int processed;
+    float score = converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(std::isnan(score), "Bad score " << *s << " on line " << lineNum);
+    scoreVector.push_back(FloorScore(TransformScore(score)));
+  }
+  const std::size_t numScoreComponents = m_ff.GetNumScoreComponents();
+  if (scoreVector.size() != numScoreComponents) {
+    UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
+                << numScoreComponents << ") of score components on line " << lineNum);
+  }
+
+  // rest of target phrase
+  TargetPhrase *targetPhrase = rule.targetPhrase;
+  targetPhrase->SetAlignmentInfo(alignString);
+
+  if (++pipes) {
+    StringPiece propertiesString(*pipes);
+    targetPhrase->SetProperties(propertiesString);
+    if (m_keepRawFields) {
+      propertiesString.CopyToString(&rule.propertiesString);
+    }
+  }
+
+  targetPhrase->GetScoreBreakdown().Assign(&m_ff, scoreVector);
+  targetPhrase->EvaluateInIsolation(*rule.sourcePhrase, m_ff.GetFeaturesToApply());
+
+  if (m_keepRawFields) {
+    rule.scores.swap(scoreVector);
+  }
+}
+
+}  // namespace Moses
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "moses/TypeDef.h"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+class AllOptions;
+class Phrase;
+class PhraseDictionary;
+class TargetPhrase;
+class Word;
+
+// A rule read from a text rule table but not yet added to a trie.  If the
+// line was skipped then targetPhrase is NULL.  The rule owns the pointers
+// until they are handed over: whoever adds the rule to a trie takes what it
+// keeps and resets the pointer to NULL.
+struct ParsedRule : private boost::noncopyable {
+  ParsedRule()
+    : sourcePhrase(NULL), sourceLHS(NULL), targetPhrase(NULL), targetLHS(NULL) {}
+  ~ParsedRule();
+
+  Phrase *sourcePhrase;
+  Word *sourceLHS;
+  TargetPhrase *targetPhrase;
+  const Word *targetLHS;  // owned by targetPhrase, NULL if there is none
+
+  // the line in Moses format, if it had to be reformatted
+  std::string reformatted;
+
+  // only filled in if the parser keeps the raw fields (for snapshots)
+  std::vector<float> scores;
+  std::string sparseString;
+  std::string propertiesString;
+};
+
+// Parses one line of a Moses- or Hiero-format rule table.  This is shared by
+// RuleTableLoaderStandard and the S2T and T2S loaders.  Prepare() builds the
+// phrases and sparse scores, which creates factors and feature names, and
+// must be called in file order so that their ids do not depend on the number
+// of threads.  operator() does the rest and is safe to call from several
+// threads at once (see ParallelLineParser).
+class RuleTableLineParser
+{
+public:
+  RuleTableLineParser(const AllOptions &opts,
+                      FormatType format,
+                      const std::vector<FactorType> &input,
+                      const std::vector<FactorType> &output,
+                      const PhraseDictionary &ff,
+                      bool keepRawFields = false)
+    : m_opts(opts)
+    , m_format(format)
+    , m_input(input)
+    , m_output(output)
+    , m_ff(ff)
+    , m_keepRawFields(keepRawFields) {}
+
+  void Prepare(StringPiece line, std::size_t lineNum, ParsedRule &rule) const;
+
+  void operator()(StringPiece line, std::size_t lineNum, ParsedRule &rule) const;
+
+private:
+  const AllOptions &m_opts;
+  FormatType m_format;
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+  const PhraseDictionary &m_ff;
+  bool m_keepRawFields;
+};
+
+}  // namespace Moses
@@ -0,0 +1,130 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "moses/Factor.h"
+#include "moses/ParallelLineParser.h"
+#include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
+#include "moses/Util.h"
+#include "moses/parameters/AllOptions.h"
+#include "util/file_piece.hh"
+#include "LineParser.h"
+#include "TestTable.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// A phrase table in which line i translates the new words prefix<i>, so that
+// the ids of their factors show the order in which they were created.
+string MakeTable(const string &prefix, size_t numLines)
+{
+  ostringstream table;
+  for (size_t i = 0; i < numLines; ++i) {
+    table << prefix << "s" << i << " das ||| " << prefix << "t" << i
+          << " the ||| 0." << i % 10 + 1 << " 0.5 ||| 0-0 1-1 ||| 10 10 10"
+          << " ||| " << prefix << "sparse" << i << " 1\n";
+  }
+  return table.str();
+}
+
+// Collects every parsed rule as text, in merge order.
+class Collect
+{
+public:
+  void operator()(ParsedRule &rule) {
+    BOOST_REQUIRE(rule.targetPhrase != NULL);
+    rules.push_back(rule.sourcePhrase->ToString() + "||| " +
+                    rule.targetPhrase->ToString());
+    sourceIds.push_back(rule.sourcePhrase->GetWord(0)[0]->GetId());
+    targetIds.push_back(rule.targetPhrase->GetWord(0)[0]->GetId());
+  }
+
+  vector<string> rules;
+  vector<size_t> sourceIds;
+  vector<size_t> targetIds;
+};
+
+void Parse(const string &text, const PhraseDictionary &table,
+           size_t numThreads, Collect &collect)
+{
+  istringstream stream(text);
+  util::FilePiece in(stream);
+  AllOptions opts;
+  RuleTableLineParser parse(opts, MosesFormat, table.GetInput(),
+                            table.GetOutput(), table);
+  ParallelLineParser<ParsedRule> parser(in, numThreads, 3);
+  parser.Run(parse, collect);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(rule_table_line_parser)
+
+BOOST_AUTO_TEST_CASE(parallel_matches_sequential)
+{
+  TestTable *table = new TestTable("PhraseDictionaryMemory name=LineParserTest"
+                                   " num-features=2 input-factor=0 output-factor=0"
+                                   " path=/dev/null");
+  const size_t numLines = 40;
+  const string text = MakeTable("lineparsertest", numLines);
+
+  // the words are new to the parallel run, so it creates their factors
+  Collect parallel;
+  Parse(text, *table, 4, parallel);
+  BOOST_REQUIRE_EQUAL(numLines, parallel.rules.size());
+  for (size_t i = 1; i < numLines; ++i) {
+    BOOST_CHECK_LT(parallel.sourceIds[i - 1], parallel.sourceIds[i]);
+    BOOST_CHECK_LT(parallel.targetIds[i - 1], parallel.targetIds[i]);
+  }
+
+  Collect sequential;
+  Parse(text, *table, 1, sequential);
+  BOOST_CHECK(parallel.rules == sequential.rules);
+  BOOST_CHECK(parallel.sourceIds == sequential.sourceIds);
+  BOOST_CHECK(parallel.targetIds == sequential.targetIds);
+}
+
+BOOST_AUTO_TEST_CASE(line_numbers_start_at_one)
+{
+  TestTable *table = new TestTable("PhraseDictionaryMemory name=LineParserTestBad"
+                                   " num-features=2 input-factor=0 output-factor=0"
+                                   " path=/dev/null");
+  const string text = MakeTable("lineparsertestbad", 4) +
+                      "a ||| b ||| 0.5 ||| 0-0 ||| 10 10 10\n";
+  for (size_t numThreads = 1; numThreads <= 2; ++numThreads) {
+    Collect collect;
+    try {
+      Parse(text, *table, numThreads, collect);
+      BOOST_ERROR("missing score not reported");
+    } catch (const util::Exception &e) {
+      BOOST_CHECK_MESSAGE(string(e.what()).find("on line 5") != string::npos,
+                          e.what());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,7 +23,9 @@
 #include "moses/InputFileStream.h"
 #include "LoaderCompact.h"
 #include "LoaderHiero.h"
+#include "LoaderSnapshot.h"
 #include "LoaderStandard.h"
+#include "SnapshotWriter.h"
 
 #include <sstream>
 #include <iostream>
@@ -45,7 +47,9 @@ Create(const std::string &path)
   if (std::getline(input, line)) {
     std::vector<std::string> tokens;
     Tokenize(tokens, line);
-    if (tokens.size() == 1) {
+    if (!tokens.empty() && tokens[0] == RuleTableSnapshotWriter::Magic()) {
+      return std::auto_ptr<RuleTableLoader>(new RuleTableLoaderSnapshot());
+    } else if (tokens.size() == 1) {
       if (tokens[0] == "1") {
         return std::auto_ptr<RuleTableLoader>(new RuleTableLoaderCompact());
       }
@@ -0,0 +1,217 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "LoaderSnapshot.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "moses/AlignmentInfoCollection.h"
+#include "moses/FactorCollection.h"
+#include "moses/TargetPhrase.h"
+#include "moses/Timer.h"
+#include "moses/Util.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/mmap.hh"
+#include "SnapshotWriter.h"
+#include "Trie.h"
+
+namespace Moses
+{
+
+bool RuleTableLoaderSnapshot::Load(AllOptions const& opts,
+                                   const std::vector<FactorType> &input,
+                                   const std::vector<FactorType> &output,
+                                   const std::string &inFile,
+                                   size_t /* tableLimit */,
+                                   RuleTableTrie &ruleTable)
+{
+  PrintUserTime("Start loading rule table snapshot");
+
+  util::scoped_fd fd(util::OpenReadOrThrow(inFile.c_str()));
+  const uint64_t size = util::SizeOrThrow(fd.get());
+  util::scoped_memory mem;
+  util::MapRead(util::POPULATE_OR_READ, fd.get(), 0, size, mem);
+
+  const char *begin = static_cast<const char*>(mem.get());
+  Cursor cursor(begin, begin + size);
+
+  // Header line.
+  const char *eol = static_cast<const char*>(std::memchr(begin, '\n', size));
+  UTIL_THROW_IF2(eol == NULL, "Not a rule table snapshot: " << inFile);
+  std::vector<std::string> header = Tokenize(std::string(begin, eol));
+  if (header.size() != 2 || header[0] != RuleTableSnapshotWriter::Magic()) {
+    std::cerr << "Not a rule table snapshot: " << inFile;
+    return false;
+  }
+  if (Scan<uint32_t>(header[1]) != RuleTableSnapshotWriter::Version) {
+    std::cerr << "Unsupported rule table snapshot version: " << header[1];
+    return false;
+  }
+  cursor.Skip(eol - begin + 1);
+
+  const uint32_t numInputFactors = cursor.ReadInt();
+  const uint32_t numOutputFactors = cursor.ReadInt();
+  const uint32_t numScoreComponents = cursor.ReadInt();
+  UTIL_THROW_IF2(numInputFactors != input.size() ||
+                 numOutputFactors != output.size(),
+                 "Rule table snapshot " << inFile
+                 << " was written with different input or output factors");
+  UTIL_THROW_IF2(numScoreComponents != ruleTable.GetNumScoreComponents(),
+                 "Rule table snapshot " << inFile << " has "
+                 << numScoreComponents << " score components, expected "
+                 << ruleTable.GetNumScoreComponents());
+
+  std::vector<Word> sourceVocab, targetVocab;
+  std::vector<float> scoreVector(numScoreComponents);
+  AlignmentInfo::CollType alignTerm, alignNonTerm;
+  size_t count = 0;
+  bool complete = false;
+
+  while (!cursor.AtEnd()) {
+    const char type = cursor.ReadChar();
+    if (type == RuleTableSnapshotWriter::End) {
+      const uint32_t numRules = cursor.ReadInt();
+      UTIL_THROW_IF2(numRules != count || !cursor.AtEnd(),
+                     "Corrupt rule table snapshot " << inFile << ": "
+                     << count << " rules, but the end record says " << numRules);
+      complete = true;
+      break;
+    } else if (type == RuleTableSnapshotWriter::SourceWord) {
+      ReadWord(cursor, input, sourceVocab);
+      continue;
+    } else if (type == RuleTableSnapshotWriter::TargetWord) {
+      ReadWord(cursor, output, targetVocab);
+      continue;
+    }
+    UTIL_THROW_IF2(type != RuleTableSnapshotWriter::Rule,
+                   "Corrupt rule table snapshot " << inFile << " at rule "
+                   << count);
+
+    Phrase sourcePhrase;
+    const uint32_t sourceSize = cursor.ReadInt();
+    for (uint32_t i = 0; i < sourceSize; ++i) {
+      sourcePhrase.AddWord(sourceVocab.at(cursor.ReadInt()));
+    }
+    const uint32_t sourceLHSId = cursor.ReadInt();
+
+    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
+    const uint32_t targetSize = cursor.ReadInt();
+    for (uint32_t i = 0; i < targetSize; ++i) {
+      targetPhrase->AddWord(targetVocab.at(cursor.ReadInt()));
+    }
+    const uint32_t targetLHSId = cursor.ReadInt();
+    if (targetLHSId) {
+      targetPhrase->SetTargetLHS(new Word(targetVocab.at(targetLHSId - 1)));
+    }
+
+    ReadAlignment(cursor, alignTerm);
+    ReadAlignment(cursor, alignNonTerm);
+    targetPhrase->SetAlignTerm(alignTerm);
+    targetPhrase->SetAlignNonTerm(alignNonTerm);
+
+    std::memcpy(&scoreVector[0], cursor.Skip(numScoreComponents * sizeof(float)),
+                numScoreComponents * sizeof(float));
+
+    StringPiece sparseString = cursor.ReadString();
+    if (!sparseString.empty()) {
+      targetPhrase->SetSparseScore(&ruleTable, sparseString);
+    }
+    StringPiece propertiesString = cursor.ReadString();
+    if (!propertiesString.empty()) {
+      targetPhrase->SetProperties(propertiesString);
+    }
+
+    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
+    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
+
+    const Word *sourceLHS = sourceLHSId ? &sourceVocab.at(sourceLHSId - 1) : NULL;
+    TargetPhraseCollection::shared_ptr phraseColl
+    = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase,
+                                        *targetPhrase, sourceLHS);
+    phraseColl->Add(targetPhrase);
+
+    count++;
+  }
+  UTIL_THROW_IF2(!complete, "Incomplete rule table snapshot " << inFile
+                 << ": no end record after " << count << " rules");
+
+  // sort and prune each target phrase collection
+  SortAndPrune(ruleTable);
+
+  return true;
+}
+
+void RuleTableLoaderSnapshot::ReadWord(Cursor &cursor,
+                                       const std::vector<FactorType> &factors,
+                                       std::vector<Word> &vocab)
+{
+  FactorCollection &factorCollection = FactorCollection::Instance();
+  const bool isNonTerm = cursor.ReadChar();
+  vocab.push_back(Word(isNonTerm));
+  Word &word = vocab.back();
+  for (size_t i = 0; i < factors.size(); ++i) {
+    StringPiece str = cursor.ReadString();
+    if (!str.empty()) {
+      word.SetFactor(factors[i], factorCollection.AddFactor(str, isNonTerm));
+    }
+  }
+}
+
+void RuleTableLoaderSnapshot::ReadAlignment(
+  Cursor &cursor, std::set<std::pair<size_t, size_t> > &alignment)
+{
+  alignment.clear();
+  const uint32_t size = cursor.ReadInt();
+  for (uint32_t i = 0; i < size; ++i) {
+    const size_t sourcePos = cursor.ReadInt();
+    const size_t targetPos = cursor.ReadInt();
+    alignment.insert(std::make_pair(sourcePos, targetPos));
+  }
+}
+
+char RuleTableLoaderSnapshot::Cursor::ReadChar()
+{
+  return *Skip(1);
+}
+
+uint32_t RuleTableLoaderSnapshot::Cursor::ReadInt()
+{
+  uint32_t value;
+  std::memcpy(&value, Skip(sizeof(value)), sizeof(value));
+  return value;
+}
+
+StringPiece RuleTableLoaderSnapshot::Cursor::ReadString()
+{
+  const uint32_t size = ReadInt();
+  return StringPiece(Skip(size), size);
+}
+
+const char *RuleTableLoaderSnapshot::Cursor::Skip(size_t bytes)
+{
+  UTIL_THROW_IF2(static_cast<size_t>(m_end - m_pos) < bytes,
+                 "Truncated rule table snapshot");
+  const char *ret = m_pos;
+  m_pos += bytes;
+  return ret;
+}
+
+}  // namespace Moses
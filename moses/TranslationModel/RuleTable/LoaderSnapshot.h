@@ -0,0 +1,68 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "moses/TypeDef.h"
+#include "moses/Word.h"
+#include "util/string_piece.hh"
+#include "Loader.h"
+
+namespace Moses
+{
+class RuleTableTrie;
+
+//! Loader for binary rule table snapshots (see RuleTableSnapshotWriter)
+class RuleTableLoaderSnapshot : public RuleTableLoader
+{
+public:
+  bool Load(AllOptions const& opts,
+            const std::vector<FactorType> &input,
+            const std::vector<FactorType> &output,
+            const std::string &inFile,
+            size_t tableLimit,
+            RuleTableTrie &);
+
+private:
+  // Sequential reader over the mapped file.
+  struct Cursor {
+    Cursor(const char *begin, const char *end) : m_pos(begin), m_end(end) {}
+    bool AtEnd() const {
+      return m_pos == m_end;
+    }
+    char ReadChar();
+    uint32_t ReadInt();
+    StringPiece ReadString();
+    const char *Skip(size_t bytes);
+
+    const char *m_pos;
+    const char *m_end;
+  };
+
+  void ReadWord(Cursor &, const std::vector<FactorType> &, std::vector<Word> &);
+  void ReadAlignment(Cursor &, std::set<std::pair<size_t, size_t> > &);
+};
+
+}  // namespace Moses
@@ -27,6 +27,7 @@
 #include <sys/stat.h>
 #include <cstdlib>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "Trie.h"
 #include "moses/FactorCollection.h"
 #include "moses/Word.h"
@@ -36,6 +37,9 @@
 #include "moses/Range.h"
 #include "moses/ChartTranslationOptionList.h"
 #include "moses/FactorCollection.h"
+#include "moses/ParallelLineParser.h"
+#include "LineParser.h"
+#include "SnapshotWriter.h"
 #include "util/file_piece.hh"
 #include "util/string_piece.hh"
 #include "util/tokenize_piece.hh"
@@ -140,6 +144,42 @@ void ReformatHieroRule(const string &lineOrig, string &out)
   out = ret.str();
 }
 
+// Adds parsed rules to the trie, in file order.
+class RuleTableLoaderStandard::RuleMerger
+{
+public:
+  RuleMerger(RuleTableLoaderStandard &loader, RuleTableTrie &ruleTable,
+             RuleTableSnapshotWriter *snapshot)
+    : m_loader(loader)
+    , m_ruleTable(ruleTable)
+    , m_snapshot(snapshot) {
+  }
+
+  void operator()(ParsedRule &rule) {
+    if (rule.targetPhrase == NULL) {
+      return;
+    }
+    if (m_snapshot) {
+      m_snapshot->AddRule(*rule.sourcePhrase, rule.sourceLHS,
+                          *rule.targetPhrase, rule.targetLHS, rule.scores,
+                          rule.sparseString, rule.propertiesString);
+    }
+    TargetPhraseCollection::shared_ptr phraseColl
+    = m_loader.GetOrCreateTargetPhraseCollection(m_ruleTable, *rule.sourcePhrase,
+        *rule.targetPhrase, rule.sourceLHS);
+    phraseColl->Add(rule.targetPhrase);
+    rule.targetPhrase = NULL;
+
+    // source phrase and LHS are not kept by the memory pt; the rule deletes
+    // them
+  }
+
+private:
+  RuleTableLoaderStandard &m_loader;
+  RuleTableTrie &m_ruleTable;
+  RuleTableSnapshotWriter *m_snapshot;
+};
+
 bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
                                    , const std::vector<FactorType> &input
                                    , const std::vector<FactorType> &output
@@ -149,106 +189,25 @@ bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
 {
   PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
 
-  // const StaticData &staticData = StaticData::Instance();
-
-  string lineOrig;
-  size_t count = 0;
-
   std::ostream *progress = NULL;
   IFVERBOSE(1) progress = &std::cerr;
   util::FilePiece in(inFile.c_str(), progress);
 
-  // reused variables
-  vector<float> scoreVector;
-  StringPiece line;
-  std::string hiero_before, hiero_after;
-
-  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
-
-  while(true) {
-    try {
-      line = in.ReadLine();
-    } catch (const util::EndOfFileException &e) {
-      break;
-    }
-
-    if (format == HieroFormat) { // inefficiently reformat line
-      hiero_before.assign(line.data(), line.size());
-      ReformatHieroRule(hiero_before, hiero_after);
-      line = hiero_after;
-    }
-
-    util::TokenIter<util::MultiCharacter> pipes(line, "|||");
-    StringPiece sourcePhraseString(*pipes);
-    StringPiece targetPhraseString(*++pipes);
-    StringPiece scoreString(*++pipes);
-
-    StringPiece alignString;
-    if (++pipes) {
-      StringPiece temp(*pipes);
-      alignString = temp;
-    }
-
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !opts.unk.word_deletion_enabled) {
-      TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
-    }
-
-    scoreVector.clear();
-    for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
-      int processed;
-      float score = converter.StringToFloat(s->data(), s->length(), &processed);
-      UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
-      scoreVector.push_back(FloorScore(TransformScore(score)));
-    }
-    const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
-    }
-
-    // parse source & find pt node
-
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
-
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
-
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
-
-    ++pipes;  // skip over counts field
-
-    if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ruleTable, sparseString);
-    }
-
-    if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
-    }
-
-    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
-
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase,
-                                        *targetPhrase, sourceLHS);
-    phraseColl->Add(targetPhrase);
-
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
+  boost::scoped_ptr<RuleTableSnapshotWriter> snapshot;
+  if (!ruleTable.GetSnapshotPath().empty()) {
+    snapshot.reset(new RuleTableSnapshotWriter(ruleTable.GetSnapshotPath(),
+                   input, output, ruleTable.GetNumScoreComponents()));
+  }
 
-    count++;
+  // lines are parsed on the loading threads, but added to the trie in file
+  // order so the result does not depend on the number of threads
+  RuleTableLineParser parse(opts, format, input, output, ruleTable,
+                            snapshot.get() != NULL);
+  RuleMerger merge(*this, ruleTable, snapshot.get());
+  ParallelLineParser<ParsedRule> parser(in, StaticData::Instance().LoadingThreadCount());
+  parser.Run(parse, merge);
+  if (snapshot) {
+    snapshot->Commit();
   }
 
   // sort and prune each target phrase collection
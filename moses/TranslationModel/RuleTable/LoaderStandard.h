@@ -19,15 +19,21 @@
 
 #pragma once
 
+#include <string>
+
 #include "Loader.h"
 
 namespace Moses
 {
 
+//! Rewrites a Hiero-format rule table line in Moses format
+void ReformatHieroRule(const std::string &lineOrig, std::string &out);
+
 //! Loader to load Moses-formatted SCFG rules from a text file
 class RuleTableLoaderStandard : public RuleTableLoader
 {
 protected:
+  class RuleMerger;
 
   bool Load(AllOptions const& opts,
             FormatType format,
@@ -76,6 +76,7 @@ protected:
 
   std::map<long, PhraseDictionaryNodeMemory> m_collection;
   std::vector<std::string> m_config;
+  size_t m_lsedCacheBits; //! log2 of the letter sed cache entries, 0 = off
 
   tmmt::FuzzyMatchWrapper *m_FuzzyMatchWrapper;
 
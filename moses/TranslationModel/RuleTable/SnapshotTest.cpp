@@ -0,0 +1,234 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <fstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "moses/ScoreComponentCollection.h"
+#include "moses/TargetPhrase.h"
+#include "moses/TargetPhraseCollection.h"
+#include "moses/Util.h"
+#include "moses/TranslationModel/PhraseDictionaryMemory.h"
+#include "moses/parameters/AllOptions.h"
+#include "LoaderSnapshot.h"
+#include "LoaderStandard.h"
+#include "SnapshotWriter.h"
+#include "TestTable.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+const char *phraseBasedTable =
+  "das Haus ||| the house ||| 0.8 0.5 ||| 0-0 1-1 ||| 10 10 10\n"
+  "das Haus ||| the building ||| 0.2 0.1 ||| 0-0 1-1 ||| 10 10 10\n"
+  "Haus ||| house ||| 0.9 0.7 ||| 0-0 ||| 10 10 10\n";
+
+const char *hierarchicalTable =
+  "das [X][X] [X] ||| the [X][X] [X] ||| 0.6 0.4 ||| 0-0 1-1 ||| 10 10 10\n"
+  "[X][X] Haus [X] ||| [X][X] house [X] ||| 0.3 0.2 ||| 0-0 1-1 ||| 10 10 10\n"
+  "Haus [X] ||| house [X] ||| 0.9 0.7 ||| 0-0 ||| 10 10 10\n";
+
+// Deletes the files of one round trip when the test ends.
+struct TempFiles {
+  TempFiles()
+    : text(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    , snapshot(text.string() + ".snapshot") {}
+  ~TempFiles() {
+    boost::filesystem::remove(text);
+    boost::filesystem::remove(snapshot);
+  }
+  boost::filesystem::path text;
+  boost::filesystem::path snapshot;
+};
+
+// The target LHS, words and alignments of a rule, followed by the scores of
+// its own table.  The full ToString() can't be compared because the two
+// tables' scores sit at different positions of the dense vector.
+string Describe(const TargetPhrase &targetPhrase, const PhraseDictionary &table)
+{
+  string ret = targetPhrase.ToString();
+  ret = ret.substr(0, ret.find(" core="));
+  vector<float> scores = targetPhrase.GetScoreBreakdown().GetScoresForProducer(&table);
+  for (size_t i = 0; i < scores.size(); ++i) {
+    ret += " " + SPrint(scores[i]);
+  }
+  return ret;
+}
+
+// Checks that both tries hold the same rules, in the same order, at the same
+// nodes.
+void CompareNodes(const PhraseDictionary &expectedTable,
+                  const PhraseDictionaryNodeMemory &expected,
+                  const PhraseDictionary &actualTable,
+                  const PhraseDictionaryNodeMemory &actual)
+{
+  const TargetPhraseCollection &expectedColl = *expected.GetTargetPhraseCollection();
+  const TargetPhraseCollection &actualColl = *actual.GetTargetPhraseCollection();
+  BOOST_REQUIRE_EQUAL(expectedColl.GetSize(), actualColl.GetSize());
+  for (size_t i = 0; i < expectedColl.GetSize(); ++i) {
+    BOOST_CHECK_EQUAL(Describe(*expectedColl.GetTargetPhrase(i), expectedTable),
+                      Describe(*actualColl.GetTargetPhrase(i), actualTable));
+  }
+
+  BOOST_REQUIRE_EQUAL(expected.GetTerminalMap().size(),
+                      actual.GetTerminalMap().size());
+  PhraseDictionaryNodeMemory::TerminalMap::const_iterator p;
+  for (p = expected.GetTerminalMap().begin();
+       p != expected.GetTerminalMap().end(); ++p) {
+    const PhraseDictionaryNodeMemory *child = actual.GetChild(p->first);
+    BOOST_REQUIRE(child != NULL);
+    CompareNodes(expectedTable, p->second, actualTable, *child);
+  }
+
+  BOOST_REQUIRE_EQUAL(expected.GetNonTerminalMap().size(),
+                      actual.GetNonTerminalMap().size());
+  PhraseDictionaryNodeMemory::NonTerminalMap::const_iterator q;
+  for (q = expected.GetNonTerminalMap().begin();
+       q != expected.GetNonTerminalMap().end(); ++q) {
+#if defined(UNLABELLED_SOURCE)
+    const PhraseDictionaryNodeMemory *child = actual.GetNonTerminalChild(q->first);
+#else
+    const PhraseDictionaryNodeMemory *child = actual.GetChild(q->first.first,
+        q->first.second);
+#endif
+    BOOST_REQUIRE(child != NULL);
+    CompareNodes(expectedTable, q->second, actualTable, *child);
+  }
+}
+
+// Loads text into one table while writing a snapshot, loads the snapshot into
+// a second table and compares the two.
+void RoundTrip(const string &name, const char *text,
+               TestTable *&fromText, TestTable *&fromSnapshot,
+               const TempFiles &files)
+{
+  {
+    ofstream out(files.text.string().c_str());
+    out << text;
+  }
+
+  fromText = new TestTable("PhraseDictionaryMemory name=" + name + "Text"
+                           " num-features=2 input-factor=0 output-factor=0"
+                           " path=" + files.text.string() +
+                           " save-snapshot=" + files.snapshot.string());
+  fromSnapshot = new TestTable("PhraseDictionaryMemory name=" + name + "Snapshot"
+                               " num-features=2 input-factor=0 output-factor=0"
+                               " path=" + files.snapshot.string());
+
+  AllOptions opts;
+  RuleTableLoaderStandard standard;
+  BOOST_REQUIRE(standard.Load(opts, fromText->GetInput(), fromText->GetOutput(),
+                              files.text.string(), 0, *fromText));
+  RuleTableLoaderSnapshot snapshot;
+  BOOST_REQUIRE(snapshot.Load(opts, fromSnapshot->GetInput(),
+                              fromSnapshot->GetOutput(),
+                              files.snapshot.string(), 0, *fromSnapshot));
+
+  CompareNodes(*fromText, fromText->GetRootNode(),
+               *fromSnapshot, fromSnapshot->GetRootNode());
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(rule_table_snapshot)
+
+BOOST_AUTO_TEST_CASE(phrase_based)
+{
+  TempFiles files;
+  TestTable *fromText, *fromSnapshot;
+  RoundTrip("SnapshotPB", phraseBasedTable, fromText, fromSnapshot, files);
+
+  Phrase source;
+  source.CreateFromString(Input, fromSnapshot->GetInput(), "das Haus", NULL);
+  TargetPhraseCollection::shared_ptr expected
+  = fromText->GetTargetPhraseCollectionLEGACY(source);
+  TargetPhraseCollection::shared_ptr actual
+  = fromSnapshot->GetTargetPhraseCollectionLEGACY(source);
+  BOOST_REQUIRE(expected && actual);
+  BOOST_REQUIRE_EQUAL(2, actual->GetSize());
+  for (size_t i = 0; i < actual->GetSize(); ++i) {
+    BOOST_CHECK_EQUAL(Describe(*expected->GetTargetPhrase(i), *fromText),
+                      Describe(*actual->GetTargetPhrase(i), *fromSnapshot));
+  }
+  BOOST_CHECK_EQUAL("the house", actual->GetTargetPhrase(0)->GetStringRep(
+                      fromSnapshot->GetOutput()));
+  vector<float> scores = actual->GetTargetPhrase(0)->GetScoreBreakdown()
+                         .GetScoresForProducer(fromSnapshot);
+  BOOST_CHECK_CLOSE(FloorScore(TransformScore(0.8f)), scores[0], 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(hierarchical)
+{
+  TempFiles files;
+  TestTable *fromText, *fromSnapshot;
+  RoundTrip("SnapshotHiero", hierarchicalTable, fromText, fromSnapshot,
+            files);
+
+  // the rule for "Haus [X]"
+  Phrase source;
+  source.CreateFromString(Input, fromSnapshot->GetInput(), "Haus", NULL);
+  TargetPhraseCollection::shared_ptr actual
+  = fromSnapshot->GetTargetPhraseCollectionLEGACY(source);
+  BOOST_REQUIRE(actual);
+  BOOST_REQUIRE_EQUAL(1, actual->GetSize());
+  const TargetPhrase &target = *actual->GetTargetPhrase(0);
+  BOOST_CHECK(target.GetTargetLHS().IsNonTerminal());
+  BOOST_CHECK_EQUAL("X", target.GetTargetLHS().GetString(0).as_string());
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+  TempFiles files;
+  TestTable *fromText, *fromSnapshot;
+  RoundTrip("SnapshotTrunc", phraseBasedTable, fromText, fromSnapshot, files);
+  BOOST_CHECK(!boost::filesystem::exists(files.snapshot.string() + ".tmp"));
+
+  // cut into the end record, as if the decoder had been killed while
+  // writing it
+  boost::filesystem::resize_file(files.snapshot,
+                                 boost::filesystem::file_size(files.snapshot) - 2);
+  TestTable *truncated = new TestTable("PhraseDictionaryMemory name=SnapshotTruncCut"
+                                       " num-features=2 input-factor=0 output-factor=0"
+                                       " path=" + files.snapshot.string());
+  AllOptions opts;
+  RuleTableLoaderSnapshot snapshot;
+  BOOST_CHECK_THROW(snapshot.Load(opts, truncated->GetInput(),
+                                  truncated->GetOutput(),
+                                  files.snapshot.string(), 0, *truncated),
+                    util::Exception);
+}
+
+BOOST_AUTO_TEST_CASE(uncommitted)
+{
+  TempFiles files;
+  std::vector<FactorType> factors(1, 0);
+  {
+    RuleTableSnapshotWriter writer(files.snapshot.string(), factors, factors, 2);
+    BOOST_CHECK(boost::filesystem::exists(files.snapshot.string() + ".tmp"));
+  }
+  BOOST_CHECK(!boost::filesystem::exists(files.snapshot));
+  BOOST_CHECK(!boost::filesystem::exists(files.snapshot.string() + ".tmp"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "SnapshotWriter.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "moses/AlignmentInfo.h"
+#include "moses/Factor.h"
+#include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
+#include "util/exception.hh"
+
+namespace Moses
+{
+
+RuleTableSnapshotWriter::RuleTableSnapshotWriter(
+  const std::string &path,
+  const std::vector<FactorType> &input,
+  const std::vector<FactorType> &output,
+  size_t numScoreComponents)
+  : m_path(path)
+  , m_tempPath(path + ".tmp")
+  , m_out(m_tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc)
+  , m_input(input)
+  , m_output(output)
+  , m_numRules(0)
+  , m_committed(false)
+{
+  UTIL_THROW_IF2(!m_out, "Cannot open rule table snapshot " << m_tempPath);
+  m_out << Magic() << " " << Version << "\n";
+  WriteInt(input.size());
+  WriteInt(output.size());
+  WriteInt(numScoreComponents);
+}
+
+RuleTableSnapshotWriter::~RuleTableSnapshotWriter()
+{
+  if (!m_committed) {
+    m_out.close();
+    std::remove(m_tempPath.c_str());
+  }
+}
+
+void RuleTableSnapshotWriter::AddRule(const Phrase &sourcePhrase,
+                                      const Word *sourceLHS,
+                                      const TargetPhrase &targetPhrase,
+                                      const Word *targetLHS,
+                                      const std::vector<float> &scores,
+                                      const StringPiece &sparseString,
+                                      const StringPiece &propertiesString)
+{
+  // Vocabulary definitions must precede the rule that uses them.
+  std::vector<uint32_t> sourceIds(sourcePhrase.GetSize());
+  for (size_t i = 0; i < sourcePhrase.GetSize(); ++i) {
+    sourceIds[i] = GetId(sourcePhrase.GetWord(i), SourceWord, m_input,
+                         m_sourceVocab);
+  }
+  uint32_t sourceLHSId = sourceLHS ?
+                         GetId(*sourceLHS, SourceWord, m_input, m_sourceVocab) + 1 : 0;
+  std::vector<uint32_t> targetIds(targetPhrase.GetSize());
+  for (size_t i = 0; i < targetPhrase.GetSize(); ++i) {
+    targetIds[i] = GetId(targetPhrase.GetWord(i), TargetWord, m_output,
+                         m_targetVocab);
+  }
+  uint32_t targetLHSId = targetLHS ?
+                         GetId(*targetLHS, TargetWord, m_output, m_targetVocab) + 1 : 0;
+
+  m_out.put(Rule);
+  WriteInt(sourceIds.size());
+  WriteArray(sourceIds);
+  WriteInt(sourceLHSId);
+  WriteInt(targetIds.size());
+  WriteArray(targetIds);
+  WriteInt(targetLHSId);
+  WriteAlignment(targetPhrase.GetAlignTerm());
+  WriteAlignment(targetPhrase.GetAlignNonTerm());
+  WriteArray(scores);
+  WriteString(sparseString);
+  WriteString(propertiesString);
+  ++m_numRules;
+
+  UTIL_THROW_IF2(!m_out, "Error writing rule table snapshot " << m_tempPath);
+}
+
+void RuleTableSnapshotWriter::Commit()
+{
+  m_out.put(End);
+  WriteInt(m_numRules);
+  m_out.close();
+  UTIL_THROW_IF2(!m_out, "Error writing rule table snapshot " << m_tempPath);
+  UTIL_THROW_IF2(std::rename(m_tempPath.c_str(), m_path.c_str()) != 0,
+                 "Cannot rename " << m_tempPath << " to " << m_path
+                 << ": " << std::strerror(errno));
+  m_committed = true;
+}
+
+uint32_t RuleTableSnapshotWriter::GetId(const Word &word, RecordType type,
+                                        const std::vector<FactorType> &factors,
+                                        Vocab &vocab)
+{
+  std::pair<Vocab::iterator, bool> ret =
+    vocab.insert(Vocab::value_type(word, vocab.size()));
+  if (ret.second) {
+    m_out.put(type);
+    m_out.put(word.IsNonTerminal() ? 1 : 0);
+    for (size_t i = 0; i < factors.size(); ++i) {
+      const Factor *factor = word[factors[i]];
+      WriteString(factor ? factor->GetString() : StringPiece());
+    }
+  }
+  return ret.first->second;
+}
+
+void RuleTableSnapshotWriter::WriteAlignment(const AlignmentInfo &alignment)
+{
+  WriteInt(alignment.GetSize());
+  for (AlignmentInfo::const_iterator p = alignment.begin();
+       p != alignment.end(); ++p) {
+    WriteInt(p->first);
+    WriteInt(p->second);
+  }
+}
+
+void RuleTableSnapshotWriter::WriteString(const StringPiece &str)
+{
+  WriteInt(str.size());
+  m_out.write(str.data(), str.size());
+}
+
+template<typename T>
+void RuleTableSnapshotWriter::WriteArray(const std::vector<T> &values)
+{
+  if (!values.empty()) {
+    m_out.write(reinterpret_cast<const char*>(&values[0]),
+                values.size() * sizeof(T));
+  }
+}
+
+void RuleTableSnapshotWriter::WriteInt(uint32_t value)
+{
+  m_out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace Moses
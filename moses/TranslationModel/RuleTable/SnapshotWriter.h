@@ -0,0 +1,114 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+#include <stdint.h>
+
+#include "moses/TypeDef.h"
+#include "moses/Word.h"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+class AlignmentInfo;
+class Phrase;
+class TargetPhrase;
+
+/** Binary log of the rules of a text rule table, written while the text
+ * table is loaded and replayed by RuleTableLoaderSnapshot.
+ *
+ * The file starts with a text line "MosesRuleTableSnapshot <version>" (so
+ * RuleTableLoaderFactory can recognise it), followed by the factor and score
+ * counts and a stream of records in load order:
+ *   'S' / 'T'  definition of the next source / target vocabulary entry
+ *   'R'        a rule: word IDs, LHS, alignments, final dense scores, and the
+ *              raw sparse-score and property fields.  An LHS is stored as its
+ *              ID + 1, with 0 for none (phrase-based tables have no LHS)
+ *   'E'        the end of the file: the number of rules written
+ * All integers are native-endian uint32_t.  Replaying the rules in order
+ * rebuilds exactly the trie the text table produced, without tokenizing,
+ * factor splitting or score parsing.  This is not an image of the trie:
+ * loading still builds the trie rule by rule.
+ *
+ * The log is written to a temporary file next to the path and only renamed
+ * to it by Commit(), so an interrupted load never leaves a partial log.
+ */
+class RuleTableSnapshotWriter
+{
+public:
+  static const char *Magic() {
+    return "MosesRuleTableSnapshot";
+  }
+  static const uint32_t Version = 3;
+
+  enum RecordType {
+    SourceWord = 'S',
+    TargetWord = 'T',
+    Rule = 'R',
+    End = 'E'
+  };
+
+  RuleTableSnapshotWriter(const std::string &path,
+                          const std::vector<FactorType> &input,
+                          const std::vector<FactorType> &output,
+                          size_t numScoreComponents);
+
+  //! Removes the temporary file unless the log was committed.
+  ~RuleTableSnapshotWriter();
+
+  void AddRule(const Phrase &sourcePhrase,
+               const Word *sourceLHS,
+               const TargetPhrase &targetPhrase,
+               const Word *targetLHS,
+               const std::vector<float> &scores,
+               const StringPiece &sparseString,
+               const StringPiece &propertiesString);
+
+  //! Writes the end record and moves the log to its path.
+  void Commit();
+
+private:
+  typedef boost::unordered_map<Word, uint32_t> Vocab;
+
+  uint32_t GetId(const Word &, RecordType, const std::vector<FactorType> &,
+                 Vocab &);
+  void WriteAlignment(const AlignmentInfo &);
+  void WriteString(const StringPiece &);
+  template<typename T> void WriteArray(const std::vector<T> &);
+  void WriteInt(uint32_t);
+
+  std::string m_path;
+  std::string m_tempPath;
+  std::ofstream m_out;
+  uint32_t m_numRules;
+  bool m_committed;
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+  Vocab m_sourceVocab;
+  Vocab m_targetVocab;
+};
+
+}  // namespace Moses
@@ -0,0 +1,41 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#pragma once
+
+#include <string>
+
+#include "moses/ScoreComponentCollection.h"
+#include "moses/TranslationModel/PhraseDictionaryMemory.h"
+
+namespace Moses
+{
+
+// A rule table for unit tests.  Only the score indexes are registered, so
+// that the table neither needs nor disturbs the global feature function
+// collection.  Tables are never deleted because PhraseDictionary keeps a
+// pointer to every table that has been constructed.
+class TestTable : public PhraseDictionaryMemory
+{
+public:
+  TestTable(const std::string &line) : PhraseDictionaryMemory(line) {
+    ScoreComponentCollection::RegisterScoreProducer(this);
+  }
+};
+
+}
@@ -51,4 +51,13 @@ void RuleTableTrie::Load(AllOptions::ptr const& opts)
   }
 }
 
+void RuleTableTrie::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "save-snapshot") {
+    m_snapshotPath = value;
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 }  // namespace Moses
@@ -48,6 +48,13 @@ public:
 
   void Load(AllOptions::ptr const& opts);
 
+  void SetParameter(const std::string& key, const std::string& value);
+
+  //! if non-empty, a binary log of the rules of the text table is written here
+  const std::string &GetSnapshotPath() const {
+    return m_snapshotPath;
+  }
+
 private:
   friend class RuleTableLoader;
 
@@ -58,6 +65,7 @@ private:
 
   virtual void SortAndPrune() = 0;
 
+  std::string m_snapshotPath;
 };
 
 }  // namespace Moses
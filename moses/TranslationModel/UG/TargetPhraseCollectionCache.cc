@@ -1,4 +1,5 @@
 #include "TargetPhraseCollectionCache.h"
+#include <algorithm>
 
 namespace Moses
 {
@@ -6,97 +7,103 @@ namespace Moses
 
   TPCollCache::
   TPCollCache(size_t capacity)
+    : m_hits(0), m_misses(0)
   {
-    m_qfirst = m_qlast = m_cache.end();
-    m_capacity = capacity;
-    UTIL_THROW_IF2(m_capacity <= 2, "Cache capacity must be > 1!");
+    UTIL_THROW_IF2(capacity <= 2, "Cache capacity must be > 1!");
+    m_capacity = (capacity + NUM_STRIPES - 1) / NUM_STRIPES;
   }
 
-  SPTR<TPCollWrapper>
+  size_t
   TPCollCache::
-  get(uint64_t key, size_t revision)
+  stripeIndex(uint64_t key)
   {
-    using namespace boost;
-    unique_lock<shared_mutex> lock(m_lock);
+    // keys are phrase ids shifted by one, mix them before picking a stripe
+    return (key * 0x9E3779B97F4A7C15ULL) >> 60;
+  }
 
-#if 0
-    size_t ctr=0;
-    std::cerr << "BEFORE" << std::endl;
-    for (cache_t::iterator m = m_qfirst; m != m_cache.end(); m = m->second->next)
-      {
-	std::cerr << ++ctr << "/" << m_cache.size() << " " 
-		  << (m->second->key == key ? "*" : " ")
-		  << m->second->key << " " 
-		  << m->second.use_count();
-	if (m->second->prev != m_cache.end())
-	  std::cerr << " => " << m->second->prev->second->key;
-	std::cerr << std::endl;
-      } 
-    std::cerr << "\n" << std::endl;
-#endif
+  TPCollCache::Stripe&
+  TPCollCache::
+  stripe(uint64_t key)
+  {
+    return m_stripes[stripeIndex(key)];
+  }
 
-    std::pair<uint64_t, SPTR<TPCollWrapper> > e(key, SPTR<TPCollWrapper>());
-    std::pair<cache_t::iterator, bool> foo = m_cache.insert(e);
-    SPTR<TPCollWrapper>& ret = foo.first->second;
-    if (ret && m_cache.size() > 1 && m_qlast != foo.first)
-      {
-	if (m_qfirst == foo.first) m_qfirst = ret->next;
-	else ret->prev->second->next = ret->next;
-	if (m_qlast != foo.first)
-	  ret->next->second->prev = ret->prev;
-      }
-    if (!ret || ret->revision != revision)
-      {
-	ret.reset(new TPCollWrapper(key,revision));
-      }
-    if (m_cache.size() == 1) 
-      {
-	m_qfirst = m_qlast = foo.first;
-	ret->prev = m_cache.end();
-      }
-    else if (m_qlast != foo.first)
+  size_t
+  TPCollCache::
+  size()
+  {
+    size_t ret = 0;
+    for (size_t i = 0; i < NUM_STRIPES; ++i)
       {
-	ret->prev = m_qlast;
-	m_qlast->second->next = foo.first;
-	m_qlast = foo.first;
+        boost::unique_lock<boost::mutex> lock(m_stripes[i].lock);
+        ret += m_stripes[i].cache.size();
       }
-    ret->next = m_cache.end();
+    return ret;
+  }
 
-#if 0
-    std::cerr << "AFTER" << std::endl;
-    ctr=0;
-    for (cache_t::iterator m = m_qfirst; m != m_cache.end(); m = m->second->next)
-      {
-	std::cerr << ++ctr << "/" << m_cache.size() << " " 
-		  << (m->second->key == key ? "*" : " ")
-		  << m->second->key << " " 
-		  << m->second.use_count();
-	if (m->second->prev != m_cache.end())
-	  std::cerr << " => " << m->second->prev->second->key;
-	std::cerr << std::endl;
-      } 
-    std::cerr << "\n" << std::endl;
-#endif
+  SPTR<TPCollWrapper>
+  TPCollCache::
+  get(uint64_t key, size_t revision)
+  {
+    Stripe& s = stripe(key);
+    boost::unique_lock<boost::mutex> lock(s.lock);
 
-    if (m_cache.size() > m_capacity)
+    SPTR<TPCollWrapper>& entry = s.cache[key];
+    if (entry)
+      s.queue.erase(std::make_pair(entry->priority, key));
+    if (entry && entry->revision == revision)
+      ++m_hits;
+    else
       {
-	// size_t ctr = 0;
-	// size_t oldsize = m_cache.size();
-	while (m_cache.size() > m_capacity && m_qfirst->second.use_count() == 1)
-	  {
-	    m_qfirst = m_qfirst->second->next;
-	    // std::cerr << "erasing " << ++ctr << "/" << m_cache.size() << " " 
-	    // << m_qfirst->second->key << std::endl;
-	    m_cache.erase(m_qfirst->second->prev);
-	  }
-	// if (oldsize > m_cache.size()) std::cerr << "\n" << std::endl;
+        entry.reset(new TPCollWrapper(key,revision));
+        ++m_misses;
       }
+    entry->priority = s.clock + entry->cost;
+    s.queue.insert(std::make_pair(entry->priority, key));
+
+    SPTR<TPCollWrapper> ret = entry; // keeps /ret/ from being evicted
+    evict(s);
     return ret;
   } // TPCollCache::get(...)
+
+  void
+  TPCollCache::
+  setCost(SPTR<TPCollWrapper> const& item, double cost)
+  {
+    Stripe& s = stripe(item->key);
+    boost::unique_lock<boost::mutex> lock(s.lock);
+    cache_t::iterator m = s.cache.find(item->key);
+    if (m == s.cache.end() || m->second != item) 
+      { // evicted or replaced in the meantime
+        item->cost = cost;
+        return;
+      }
+    s.queue.erase(std::make_pair(item->priority, item->key));
+    item->cost = cost;
+    item->priority = s.clock + cost;
+    s.queue.insert(std::make_pair(item->priority, item->key));
+  }
+
+  // Evict entries with the lowest priority until the stripe is within
+  // capacity. Entries still in use elsewhere are skipped.
+  void
+  TPCollCache::
+  evict(Stripe& s)
+  {
+    queue_t::iterator q = s.queue.begin();
+    while (s.cache.size() > m_capacity && q != s.queue.end())
+      {
+        cache_t::iterator m = s.cache.find(q->second);
+        if (m->second.use_count() > 1) { ++q; continue; }
+        s.clock = std::max(s.clock, q->first);
+        s.cache.erase(m);
+        s.queue.erase(q++);
+      }
+  }
   
   TPCollWrapper::
   TPCollWrapper(uint64_t key_, size_t revision_)
-    : revision(revision_), key(key_)
+    : priority(0), cost(0), revision(revision_), key(key_)
   { }
 
   TPCollWrapper::
@@ -1,6 +1,7 @@
 // -*- c++ -*-
 #pragma once
 #include <time.h>
+#include <set>
 #include "moses/TargetPhraseCollection.h"
 #include <boost/atomic.hpp>
 #include "mm/ug_typedefs.h"
@@ -9,22 +10,53 @@ namespace Moses
 
   class TPCollWrapper;
 
+  // Cache of target phrase collections, split into stripes that are
+  // locked independently, so that lookups from different threads rarely
+  // wait for each other. Within a stripe, entries are evicted by their
+  // cost (the time it took to build them), aged by the priority of the
+  // last evicted entry (GreedyDual), so that entries that were expensive
+  // to sample stay cached longer than cheap ones used as recently.
   class TPCollCache
   {
   public:
     // typedef boost::unordered_map<uint64_t, SPTR<TPCollWrapper> > cache_t;
     typedef std::map<uint64_t, SPTR<TPCollWrapper> > cache_t;
+    typedef std::set<std::pair<double, uint64_t> > queue_t; // eviction order
+    static const size_t NUM_STRIPES = 16;
   private:
-    uint32_t m_capacity; // capacity of cache
-    cache_t     m_cache; // maps from ids to items
-    cache_t::iterator m_qfirst, m_qlast;
-    mutable boost::shared_mutex  m_lock; 
+    struct Stripe
+    {
+      boost::mutex lock;
+      cache_t      cache; // maps from ids to items
+      queue_t      queue; // lowest priority is evicted first
+      double       clock; // priority of the last entry evicted
+      Stripe() : clock(0) { }
+    };
+    uint32_t m_capacity; // capacity of each stripe
+    Stripe   m_stripes[NUM_STRIPES];
+    boost::atomic<size_t> m_hits, m_misses;
+
+    Stripe& stripe(uint64_t key);
+    void evict(Stripe& s);
   public:
     TPCollCache(size_t capacity=10000);
 
     SPTR<TPCollWrapper>
     get(uint64_t key, size_t revision);
 
+    // record what it cost to build the item, once it is filled
+    void
+    setCost(SPTR<TPCollWrapper> const& item, double cost);
+
+    size_t hits()   const { return m_hits; }
+    size_t misses() const { return m_misses; }
+
+    // number of entries cached, over all stripes
+    size_t size();
+
+    // the stripe that caches /key/; each holds up to capacity/NUM_STRIPES
+    // entries (rounded up)
+    static size_t stripeIndex(uint64_t key);
   };
 
   // wrapper around TargetPhraseCollection with reference counting
@@ -34,8 +66,8 @@ namespace Moses
   {
     friend class TPCollCache;
     friend class Mmsapt;
-  public:
-    TPCollCache::cache_t::iterator prev, next;
+    double priority; // position in the eviction queue of the cache
+    double cost;     // time it took to build the collection
   public:
     mutable boost::shared_mutex lock; 
     size_t   const revision; // rev. No. of the underlying corpus
@@ -10,6 +10,7 @@
 #include "util/exception.hh"
 #include <set>
 #include "util/usage.hh"
+#include <fcntl.h>
 
 namespace Moses
 {
@@ -29,6 +30,24 @@ namespace Moses
       }
   }
 
+  // Runs a sampler and adds the time it took to the counters of the table.
+  class TimedSampler
+  {
+    BitextSampler<Mmsapt::Token> m_sampler;
+    boost::atomic<uint64_t>* m_usec;
+  public:
+    TimedSampler(BitextSampler<Mmsapt::Token> const& sampler,
+                 boost::atomic<uint64_t>* usec)
+      : m_sampler(sampler), m_usec(usec) { }
+
+    void operator()()
+    {
+      double start = util::WallTime();
+      m_sampler();
+      *m_usec += uint64_t((util::WallTime() - start) * 1e6);
+    }
+  };
+
   void
   parseLine(string const& line, map<string,string> & param)
   {
@@ -70,6 +89,10 @@ namespace Moses
     , bias_key(((char*)this)+3)
     , cache_key(((char*)this)+2)
     , context_key(((char*)this)+1)
+    , m_prefetch(0)
+    , m_samples(0)
+    , m_sampling_usec(0)
+    , m_prefetched(0)
     , m_track_coord(false)
       // , m_tpc_ctr(0)
       // , m_ifactor(1,0)
@@ -86,6 +109,17 @@ namespace Moses
     // Register();
   }
 
+  Mmsapt::
+  ~Mmsapt()
+  {
+    // pending updates are in the log and will be replayed on the next Load()
+    if (m_merger)
+      {
+        m_merger->interrupt();
+        m_merger->join();
+      }
+  }
+
   void
   Mmsapt::
   read_config_file(string fname, map<string,string>& param)
@@ -207,6 +241,10 @@ namespace Moses
     // this cache keeps track of the most frequently used target
     // phrase collections even when not actively in use
 
+    // sample source spans up to this length as soon as the input arrives
+    dflt = pair<string,string>("prefetch","0");
+    m_prefetch = atoi(param.insert(dflt).first->second.c_str());
+
     // Feature functions are initialized  in function Load();
     param.insert(pair<string,string>("pfwd",   "g"));
     param.insert(pair<string,string>("pbwd",   "g"));
@@ -254,6 +292,9 @@ namespace Moses
     if ((m = param.find("extra")) != param.end())
       m_extra_data = m->second;
 
+    if ((m = param.find("update-log")) != param.end())
+      m_update_log = m->second;
+
     if ((m = param.find("method")) != param.end())
       {
         if (m->second == "random")
@@ -343,6 +384,7 @@ namespace Moses
     known_parameters.push_back("path");
     known_parameters.push_back("pbwd");
     known_parameters.push_back("pfwd");
+    known_parameters.push_back("prefetch");
     known_parameters.push_back("prov");
     known_parameters.push_back("rare");
     known_parameters.push_back("sample");
@@ -351,6 +393,7 @@ namespace Moses
     known_parameters.push_back("table-limit");
     known_parameters.push_back("tuneable");
     known_parameters.push_back("unal");
+    known_parameters.push_back("update-log");
     known_parameters.push_back("workers");
     sort(known_parameters.begin(),known_parameters.end());
     for (map<string,string>::iterator m = param.begin(); m != param.end(); ++m)
@@ -545,6 +588,9 @@ namespace Moses
     if (m_extra_data.size())
       load_extra_data(m_extra_data, false);
 
+    if (m_update_log.size())
+      replay_update_log();
+
 #if 0
     // currently not used
     LexicalPhraseScorer2<Token>::table_t & COOC = calc_lex.scorer.COOC;
@@ -559,15 +605,195 @@ namespace Moses
     // cerr << "LOADED " << HERE << endl;
   }
 
+  // Adds the sentence pairs logged by earlier runs to the dynamic bitext
+  // and opens the log for appending. After a header line "#base N", each
+  // record is a line "source ||| target ||| alignment"; an incomplete last
+  // line is what a crash during add() leaves behind and is cut off. If the
+  // static corpus has grown since the log was started, the log has been
+  // folded into it: the records it holds already are dropped and the log is
+  // rewritten with the new base.
   void
   Mmsapt::
-  add(string const& s1, string const& s2, string const& a)
+  replay_update_log()
   {
-    vector<string> S1(1,s1);
-    vector<string> S2(1,s2);
-    vector<string> ALN(1,a);
-    boost::unique_lock<boost::shared_mutex> guard(m_lock);
-    btdyn = btdyn->add(S1,S2,ALN);
+    vector<string> text1,text2,symal;
+    uint64_t const corpus_size = btfix->T1->size();
+    uint64_t base = corpus_size;
+    bool has_base = false;
+    uint64_t complete = 0; // bytes in complete lines
+    {
+      ifstream in(m_update_log.c_str());
+      string line;
+      while (getline(in,line) && !in.eof())
+        {
+          complete += line.size() + 1;
+          if (complete == line.size() + 1 && line.compare(0, 6, "#base ") == 0)
+            {
+              base = atoll(line.c_str() + 6);
+              has_base = true;
+              continue;
+            }
+          size_t i = line.find(" ||| ");
+          size_t k = i == string::npos ? i : line.find(" ||| ", i + 5);
+          UTIL_THROW_IF2(k == string::npos, "Malformed line in update log '"
+                         << m_update_log << "':\n" << line);
+          text1.push_back(line.substr(0, i));
+          text2.push_back(line.substr(i + 5, k - i - 5));
+          symal.push_back(line.substr(k + 5));
+        }
+    }
+
+    UTIL_THROW_IF2(corpus_size < base || corpus_size - base > text1.size(),
+                   "Update log '" << m_update_log << "' was started on a corpus of "
+                   << base << " sentence pairs and holds " << text1.size()
+                   << ", but the corpus has " << corpus_size
+                   << "; it was not folded into this corpus");
+    size_t const folded = corpus_size - base;
+    if (folded)
+      {
+        text1.erase(text1.begin(), text1.begin() + folded);
+        text2.erase(text2.begin(), text2.begin() + folded);
+        symal.erase(symal.begin(), symal.begin() + folded);
+        cerr << "Dropped " << folded << " sentence pairs of " << m_update_log
+             << " that are in the corpus now" << endl;
+      }
+
+    if (folded || !has_base)
+      {
+        // write the new log next to the old one and swap it in, so that a
+        // crash leaves one or the other
+        string tmp = m_update_log + ".tmp";
+        util::scoped_fd out(util::CreateOrThrow(tmp.c_str()));
+        ostringstream buf;
+        buf << "#base " << corpus_size << "\n";
+        for (size_t i = 0; i < text1.size(); ++i)
+          buf << text1[i] << " ||| " << text2[i] << " ||| " << symal[i] << "\n";
+        string const& log = buf.str();
+        util::WriteOrThrow(out.get(), log.data(), log.size());
+        util::FSyncOrThrow(out.get());
+        UTIL_THROW_IF(rename(tmp.c_str(), m_update_log.c_str()), util::ErrnoException,
+                      "Could not replace update log " << m_update_log);
+        complete = log.size();
+      }
+
+    if (text1.size())
+      {
+        btdyn = btdyn->add(text1,text2,symal);
+        cerr << "Replayed " << text1.size() << " sentence pairs from "
+             << m_update_log << endl;
+      }
+
+    m_update_log_fd.reset(open(m_update_log.c_str(), O_WRONLY | O_APPEND));
+    UTIL_THROW_IF(m_update_log_fd.get() == -1, util::ErrnoException,
+                  "Could not open update log " << m_update_log);
+    if (util::SizeOrThrow(m_update_log_fd.get()) != complete)
+      util::ResizeOrThrow(m_update_log_fd.get(), complete);
+  }
+
+  void
+  Mmsapt::
+  add(string const& s1, string const& s2, string const& a, bool wait)
+  {
+    // a record is one line of the update log with its fields separated by
+    // " ||| ", so a segment that contains either would corrupt the log and
+    // make the next Load() fail
+    UTIL_THROW_IF2(s1.find('\n') != string::npos || s2.find('\n') != string::npos
+                   || a.find('\n') != string::npos,
+                   "[" << HERE << "] Sentence pair to add contains a newline");
+    UTIL_THROW_IF2(s1.find(" ||| ") != string::npos
+                   || s2.find(" ||| ") != string::npos,
+                   "[" << HERE << "] Sentence pair to add contains ' ||| '");
+
+    // check the alignment here, as the merger thread can't report errors
+    istringstream ibuf(a);
+    uint32_t row,col; char c;
+    while (ibuf >> row >> c >> col)
+      UTIL_THROW_IF2(c != '-', "[" << HERE << "] "
+                     << "Error in alignment information:\n" << a);
+
+    boost::unique_lock<boost::mutex> lock(m_update_lock);
+    if (m_update_log_fd.get() != -1)
+      {
+        string record = s1 + " ||| " + s2 + " ||| " + a + "\n";
+        util::WriteOrThrow(m_update_log_fd.get(), record.data(), record.size());
+        util::FSyncOrThrow(m_update_log_fd.get());
+      }
+    if (m_pending1.empty())
+      m_pending_status.reset(new merge_status);
+    m_pending1.push_back(s1);
+    m_pending2.push_back(s2);
+    m_pending_aln.push_back(a);
+    if (!m_merger)
+      m_merger.reset(new boost::thread(&Mmsapt::merge_updates, this));
+    m_update_ready.notify_one();
+
+    if (!wait) return;
+    SPTR<merge_status> status = m_pending_status;
+    while (!status->done) m_merged.wait(lock);
+    UTIL_THROW_IF2(status->error.size(), "[" << HERE << "] "
+                   << "Could not merge the sentence pair: " << status->error);
+  }
+
+  // Runs in the background: takes all sentence pairs queued so far and
+  // builds the next dynamic bitext from them in one go. Lookups keep using
+  // the previous one until it is swapped in. A batch that can't be merged
+  // is reported and dropped; it stays in the update log, so the next Load()
+  // tries again.
+  void
+  Mmsapt::
+  merge_updates()
+  {
+    vector<string> s1, s2, aln;
+    SPTR<merge_status> status;
+    boost::unique_lock<boost::mutex> lock(m_update_lock);
+    while (true)
+      {
+        while (m_pending1.empty()) m_update_ready.wait(lock);
+        s1.swap(m_pending1);
+        s2.swap(m_pending2);
+        aln.swap(m_pending_aln);
+        status.swap(m_pending_status);
+        lock.unlock();
+
+        string error;
+        try
+          {
+            SPTR<imbitext> dyn;
+            {
+              boost::shared_lock<boost::shared_mutex> guard(m_lock);
+              dyn = btdyn;
+            }
+            // only this thread replaces btdyn after Load(), so no update is
+            // lost
+            dyn = dyn->add(s1,s2,aln);
+            {
+              boost::unique_lock<boost::shared_mutex> guard(m_lock);
+              btdyn = dyn;
+            }
+          }
+        catch (boost::thread_interrupted const&)
+          {
+            throw;
+          }
+        catch (std::exception const& e)
+          {
+            error = e.what();
+          }
+        catch (...)
+          {
+            error = "unknown error";
+          }
+        if (error.size())
+          cerr << "[" << HERE << "] Could not merge " << s1.size()
+               << " sentence pairs into the dynamic bitext: " << error << endl;
+        s1.clear(); s2.clear(); aln.clear();
+
+        lock.lock();
+        status->done = true;
+        status->error = error;
+        status.reset();
+        m_merged.notify_all();
+      }
   }
 
 
@@ -772,6 +998,7 @@ namespace Moses
     if (ret->GetSize()) return ret;
 
     // OK: pt entry NOT found or NOT up to date
+    double start = util::WallTime();
     // lookup and expansion could be done in parallel threads,
     // but ppdyn is probably small anyway
     // TO DO: have Bitexts return lists of PhrasePairs instead of pstats
@@ -791,7 +1018,8 @@ namespace Moses
                                    m_default_sample_size, 
                                    m_sampling_method,
                                    m_track_coord);
-            s();
+            TimedSampler(s, &m_sampling_usec)();
+            ++m_samples;
             sfix = s.stats();
           }
       }
@@ -829,6 +1057,9 @@ namespace Moses
     if (m_tableLimit) ret->Prune(true, m_tableLimit);
     else ret->Prune(true,ret->GetSize());
 
+    // expensive entries are kept in the cache longer
+    cache->setCost(ret, util::WallTime() - start);
+
 #if 1
     if (m_bias_log && m_lr_func && m_bias_loglevel > 3)
       {
@@ -855,7 +1086,19 @@ namespace Moses
   void
   Mmsapt::
   CleanUpAfterSentenceProcessing(ttasksptr const& ttask)
-  { }
+  {
+    IFVERBOSE(2)
+      {
+        SPTR<TPCollCache> cache = ttask->GetScope()->get<TPCollCache>(cache_key);
+        if (!cache) cache = m_cache;
+        size_t lookups = cache->hits() + cache->misses();
+        VERBOSE(2, GetScoreProducerDescription() << ": "
+                << cache->hits() << " of " << lookups << " cache lookups hit, "
+                << m_samples << " phrases sampled in "
+                << m_sampling_usec / 1e6 << " seconds, "
+                << m_prefetched << " of them prefetched" << endl);
+      }
+  }
 
 
   ChartRuleLookupManager*
@@ -957,6 +1200,54 @@ namespace Moses
         // todo: verify that lr_func implements a hierarchical reordering model
       }
 #endif
+
+    // sampling doesn't need the locks; the bias is set up by now
+    ctxlock.unlock();
+    mylock.unlock();
+    if (m_prefetch) prefetch(ttask);
+  }
+
+  bool
+  Mmsapt::
+  submit_sampling(SPTR<ContextForQuery> const& context,
+                  tsa::tree_iterator const& m) const
+  {
+    uint64_t pid = m.getPid();
+    if (context->cache1->get(pid)) return false;
+    BitextSampler<Token> s(btfix, m, context->bias, 
+                           m_min_sample_size, m_default_sample_size, 
+                           m_sampling_method, m_track_coord);
+    if (*context->cache1->get(pid, s.stats()) != s.stats()) 
+      return false; // another thread got there first
+    TimedSampler job(s, &m_sampling_usec);
+    m_thread_pool->add(job);
+    ++m_samples;
+    return true;
+  }
+
+  // Submits sampling jobs for all spans of the input that occur in the
+  // fixed bitext, so that the workers are busy before the decoder asks
+  // for the first phrase.
+  void
+  Mmsapt::
+  prefetch(ttasksptr const& ttask) const
+  {
+    Phrase const* src = dynamic_cast<Phrase const*>(ttask->GetSource().get());
+    if (!src) return; // e.g. confusion networks and lattices
+
+    vector<id_type> sphrase;
+    fillIdSeq(*src, m_ifactor, *btfix->V1, sphrase);
+    SPTR<ContextScope> const& scope = ttask->GetScope();
+    SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get(), true);
+    for (size_t i = 0; i < sphrase.size(); ++i)
+      {
+        tsa::tree_iterator m(btfix->I1.get());
+        for (size_t k = i; k < sphrase.size() && k - i < m_prefetch; ++k)
+          {
+            if (!m.extend(sphrase[k])) break;
+            if (submit_sampling(context, m)) ++m_prefetched;
+          }
+      }
   }
 
   bool
@@ -973,15 +1264,7 @@ namespace Moses
     if (mfix.size() == myphrase.size())
       {
         SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get(), true);
-        uint64_t pid = mfix.getPid();
-        if (!context->cache1->get(pid))
-          {
-            BitextSampler<Token> s(btfix, mfix, context->bias, 
-                                   m_min_sample_size, m_default_sample_size, 
-                                   m_sampling_method, m_track_coord);
-            if (*context->cache1->get(pid, s.stats()) == s.stats())
-              m_thread_pool->add(s);
-          }
+        submit_sampling(context, mfix);
         // btfix->prep(ttask, mfix);
         // cerr << phrase << " " << mfix.approxOccurrenceCount() << endl;
         return true;
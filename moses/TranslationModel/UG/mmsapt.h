@@ -36,6 +36,7 @@
 #include <boost/dynamic_bitset.hpp>
 #include "moses/TargetPhraseCollection.h"
 #include "util/usage.hh"
+#include "util/file.hh"
 #include <map>
 
 #include "moses/TranslationModel/PhraseDictionary.h"
@@ -102,6 +103,12 @@ namespace Moses
     boost::shared_ptr<sapt::SamplingBias> m_bias; // for global default bias
     boost::shared_ptr<TPCollCache> m_cache; // for global default bias
     size_t m_cache_size;  //
+    size_t m_prefetch; // max. length of source spans sampled when the input arrives
+
+    // counters, reported at verbosity level 2
+    mutable boost::atomic<size_t>   m_samples;       // sampling runs
+    mutable boost::atomic<uint64_t> m_sampling_usec; // time spent sampling
+    mutable boost::atomic<size_t>   m_prefetched;    // spans sampled ahead of lookup
     // size_t input_factor;  //
     // size_t output_factor; // we can actually return entire Tokens!
 
@@ -164,6 +171,43 @@ namespace Moses
     void setup_local_feature_functions();
     void setup_bias(ttasksptr const& ttask);
 
+    // Sentence pairs given to add() are appended to the update log (if
+    // any) and queued; a background thread merges each queued batch into
+    // the dynamic bitext, so that decoding never waits for re-indexing.
+    //
+    // The log starts with a line "#base N", N being the number of sentence
+    // pairs of the static corpus it was started on. To fold the log into
+    // the static corpus, append its records, in order, to the corpus and
+    // rebuild it with mtt-build. The next Load() sees that the corpus has
+    // grown by k pairs, drops the first k records and rewrites the log with
+    // the new base, so no pair is applied twice.
+    std::string m_update_log;     // append-only log, replayed on Load()
+    util::scoped_fd m_update_log_fd;
+    // Whether a queued batch has been merged, and the error if that failed
+    struct merge_status
+    {
+      bool done;
+      std::string error;
+      merge_status() : done(false) { }
+    };
+    std::vector<std::string> m_pending1, m_pending2, m_pending_aln;
+    SPTR<merge_status> m_pending_status;
+    boost::mutex m_update_lock;   // for the log and the queue
+    boost::condition_variable m_update_ready;
+    boost::condition_variable m_merged; // a batch is done
+    boost::scoped_ptr<boost::thread> m_merger;
+    void merge_updates();
+    void replay_update_log();
+
+    // submit sampling of the phrase at /m/ to the worker threads, unless
+    // there are sampling results for it already; true if submitted
+    bool
+    submit_sampling(SPTR<sapt::ContextForQuery> const& context,
+                    tsa::tree_iterator const& m) const;
+
+    // sample all source spans of the input up to length m_prefetch
+    void prefetch(ttasksptr const& ttask) const;
+
 #if PROVIDES_RANKED_SAMPLING
     void 
     set_bias_for_ranking(ttasksptr const& ttask, SPTR<sapt::Bitext<Token> const> bt);
@@ -216,6 +260,7 @@ namespace Moses
   public:
     // Mmsapt(std::string const& description, std::string const& line);
     Mmsapt(std::string const& line);
+    ~Mmsapt();
 
     void Load(AllOptions::ptr const& opts);
     void Load(AllOptions::ptr const& opts, bool with_checks);
@@ -242,8 +287,14 @@ namespace Moses
 			    std::size_t);
 #endif
 
-    void add(std::string const& s1, std::string const& s2, std::string const& a);
-    // add a new sentence pair to the dynamic bitext
+    void add(std::string const& s1, std::string const& s2, std::string const& a,
+             bool wait = false);
+    // add a new sentence pair to the dynamic bitext; it is logged before
+    // add() returns and becomes visible once the merger thread gets to it.
+    // Unless /wait/ is set, add() does not wait for the merge, so a
+    // translate call right after it may not see the new pair yet; with
+    // /wait/, it also throws if the merge failed.
+    // Segments must not contain a newline or " ||| " (throws otherwise)
 
     void setWeights(std::vector<float> const& w);
 
@@ -73,7 +73,7 @@ int main(int argc, char* argv[])
       cout << "[H] " << translate(source) << endl;
       cout << "[T] " << target << endl;
       Mmsapt* pdsa = reinterpret_cast<Mmsapt*>(PhraseDictionary::GetColl()[0]);
-      pdsa->add(source,target,alignment);
+      pdsa->add(source,target,alignment,true);
       cout << "[X] " << translate(source) << endl;
       cout << endl;
     }
@@ -0,0 +1,93 @@
+// -*- c++ -*-
+// Unit tests for the eviction policy of TPCollCache.
+#include <vector>
+#include "TargetPhraseCollectionCache.h"
+
+#define BOOST_TEST_MODULE TPCollCache
+#include <boost/test/unit_test.hpp>
+
+using namespace Moses;
+
+namespace
+{
+  // the first n keys, counting from /start/, that share a stripe with /start/
+  std::vector<uint64_t>
+  sameStripe(uint64_t start, size_t n)
+  {
+    std::vector<uint64_t> ret;
+    size_t s = TPCollCache::stripeIndex(start);
+    for (uint64_t key = start; ret.size() < n; ++key)
+      if (TPCollCache::stripeIndex(key) == s) ret.push_back(key);
+    return ret;
+  }
+
+  // two entries per stripe
+  const size_t capacity = 2 * TPCollCache::NUM_STRIPES;
+}
+
+BOOST_AUTO_TEST_CASE(costly_entries_outlive_cheap_ones)
+{
+  TPCollCache cache(capacity);
+  std::vector<uint64_t> k = sameStripe(1, 3);
+
+  // the costly entry is the least recently used when the stripe overflows
+  cache.setCost(cache.get(k[0], 0), 10);
+  cache.setCost(cache.get(k[1], 0), 1);
+  cache.get(k[2], 0);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+
+  size_t hits = cache.hits();
+  cache.get(k[0], 0);
+  BOOST_CHECK_EQUAL(cache.hits(), hits + 1);
+
+  size_t misses = cache.misses();
+  cache.get(k[1], 0);
+  BOOST_CHECK_EQUAL(cache.misses(), misses + 1);
+}
+
+BOOST_AUTO_TEST_CASE(entries_in_use_are_not_evicted)
+{
+  TPCollCache cache(capacity);
+  std::vector<uint64_t> k = sameStripe(1, 4);
+
+  std::vector<SPTR<TPCollWrapper> > held;
+  for (size_t i = 0; i < 3; ++i)
+    held.push_back(cache.get(k[i], 0));
+  BOOST_CHECK_EQUAL(cache.size(), 3);
+  for (size_t i = 0; i < 3; ++i)
+    BOOST_CHECK(cache.get(k[i], 0) == held[i]);
+
+  // once released they can go, but the newest entry stays
+  held.clear();
+  SPTR<TPCollWrapper> last = cache.get(k[3], 0);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.get(k[3], 0) == last);
+}
+
+BOOST_AUTO_TEST_CASE(capacity_is_per_stripe)
+{
+  TPCollCache cache(capacity);
+
+  // fill every stripe to capacity: nothing is evicted
+  for (size_t s = 0; s < TPCollCache::NUM_STRIPES; ++s)
+    {
+      uint64_t key = 1;
+      while (TPCollCache::stripeIndex(key) != s) ++key;
+      std::vector<uint64_t> k = sameStripe(key, 2);
+      cache.get(k[0], 0);
+      cache.get(k[1], 0);
+    }
+  BOOST_CHECK_EQUAL(cache.size(), capacity);
+
+  // one more key evicts from its own stripe only
+  std::vector<uint64_t> k = sameStripe(1, 3);
+  size_t misses = cache.misses();
+  cache.get(k[2], 0);
+  BOOST_CHECK_EQUAL(cache.misses(), misses + 1);
+  BOOST_CHECK_EQUAL(cache.size(), capacity);
+
+  // and many keys never grow the cache beyond its capacity
+  for (uint64_t key = 1; key < 10000; ++key)
+    cache.get(key, 0);
+  BOOST_CHECK_EQUAL(cache.size(), capacity);
+}
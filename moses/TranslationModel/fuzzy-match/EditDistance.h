@@ -0,0 +1,131 @@
+//
+//  EditDistance.h
+//  fuzzy-match
+//
+//  Unit-cost edit distance kernels used by FuzzyMatchWrapper, for words
+//  over letters and for sentences over word ids.
+//
+
+#ifndef fuzzy_match_EditDistance_h
+#define fuzzy_match_EditDistance_h
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "Vocabulary.h"
+
+namespace tmmt
+{
+
+/* Myers' bit-parallel edit distance (as formulated by Hyyro): each column of
+ the unit-cost DP matrix is kept as vertical delta bit-vectors, so one word of
+ the pattern (up to 64 symbols) advances by a column in a few word operations.
+ peq(symbol) gives the bit mask of pattern positions holding the symbol.
+ Since the score at the bottom row changes by at most 1 per column, the
+ computation stops as soon as the distance must exceed max_cost. */
+
+template< typename Peq, typename Symbol >
+inline unsigned int myers_sed( const Peq &peq, size_t m, const Symbol *b, size_t n, unsigned int max_cost )
+{
+  uint64_t pv = ~(uint64_t) 0;
+  uint64_t mv = 0;
+  const uint64_t high = (uint64_t) 1 << (m-1);
+  unsigned int score = m;
+
+  for( size_t j=0; j<n; j++ ) {
+    uint64_t eq = peq( b[j] );
+    uint64_t xv = eq | mv;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    if (ph & high) {
+      score++;
+    } else if (mh & high) {
+      score--;
+    }
+    ph = (ph << 1) | 1;
+    mh <<= 1;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+
+    if (score > max_cost + (n-j-1)) {
+      return max_cost + 1;
+    }
+  }
+  return score;
+}
+
+struct LetterPeq {
+  uint64_t mask[256];
+
+  LetterPeq( const std::string &a ) {
+    std::fill( mask, mask+256, 0 );
+    for( size_t i=0; i<a.size(); i++ ) {
+      mask[ (unsigned char) a[i] ] |= (uint64_t) 1 << i;
+    }
+  }
+  uint64_t operator()( char c ) const {
+    return mask[ (unsigned char) c ];
+  }
+};
+
+struct WordPeq {
+  // distinct words of the pattern, sorted, with their position masks
+  std::vector< std::pair< WORD_ID, uint64_t > > mask;
+
+  WordPeq( const std::vector< WORD_ID > &a ) {
+    for( size_t i=0; i<a.size(); i++ ) {
+      mask.push_back( std::make_pair( a[i], (uint64_t) 1 << i ) );
+    }
+    std::sort( mask.begin(), mask.end() );
+    size_t k = 0;
+    for( size_t i=0; i<mask.size(); i++ ) {
+      if (k > 0 && mask[k-1].first == mask[i].first) {
+        mask[k-1].second |= mask[i].second;
+      } else {
+        mask[k++] = mask[i];
+      }
+    }
+    mask.resize( k );
+  }
+  uint64_t operator()( WORD_ID w ) const {
+    std::vector< std::pair< WORD_ID, uint64_t > >::const_iterator it =
+      std::lower_bound( mask.begin(), mask.end(), std::make_pair( w, (uint64_t) 0 ) );
+    return (it != mask.end() && it->first == w) ? it->second : 0;
+  }
+};
+
+/* two-row unit-cost DP for patterns longer than 64 symbols; stops when a
+ whole row exceeds max_cost */
+
+template< typename Symbol >
+inline unsigned int row_sed( const Symbol *a, size_t m, const Symbol *b, size_t n, unsigned int max_cost )
+{
+  std::vector< unsigned int > prev( n+1 ), cur( n+1 );
+  for( size_t j=0; j<=n; j++ ) {
+    prev[j] = j;
+  }
+  for( size_t i=1; i<=m; i++ ) {
+    cur[0] = i;
+    unsigned int row_min = cur[0];
+    for( size_t j=1; j<=n; j++ ) {
+      unsigned int ins = prev[j] + 1;
+      unsigned int del = cur[j-1] + 1;
+      unsigned int diag = prev[j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+      unsigned int min = (ins < del) ? ins : del;
+      cur[j] = (diag < min) ? diag : min;
+      row_min = (cur[j] < row_min) ? cur[j] : row_min;
+    }
+    if (row_min > max_cost) {
+      return max_cost + 1;
+    }
+    prev.swap( cur );
+  }
+  return (prev[n] > max_cost) ? max_cost + 1 : prev[n];
+}
+
+}
+
+#endif
@@ -0,0 +1,175 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "EditDistance.h"
+
+using namespace tmmt;
+using namespace std;
+
+namespace
+{
+
+// the full unit-cost DP matrix, without any cut-off
+template <typename Seq>
+unsigned int MatrixSed(const Seq &a, const Seq &b)
+{
+  vector<vector<unsigned int> > cost(a.size() + 1,
+                                     vector<unsigned int>(b.size() + 1));
+  for (size_t i = 0; i <= a.size(); ++i) {
+    cost[i][0] = i;
+  }
+  for (size_t j = 0; j <= b.size(); ++j) {
+    cost[0][j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    for (size_t j = 1; j <= b.size(); ++j) {
+      unsigned int best = cost[i-1][j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+      best = min(best, cost[i-1][j] + 1);
+      best = min(best, cost[i][j-1] + 1);
+      cost[i][j] = best;
+    }
+  }
+  return cost[a.size()][b.size()];
+}
+
+// deterministic, so that a failure can be reproduced
+class Random
+{
+public:
+  Random() : m_state(12345) {}
+  size_t operator()(size_t n) {
+    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (m_state >> 33) % n;
+  }
+private:
+  uint64_t m_state;
+};
+
+// a random sequence, or a random edit of base, over a small alphabet so that
+// there are many matches
+template <typename Seq>
+Seq RandomSeq(Random &random, size_t length, size_t alphabet, const Seq *base)
+{
+  Seq seq;
+  if (base == NULL) {
+    for (size_t i = 0; i < length; ++i) {
+      seq.push_back('a' + random(alphabet));
+    }
+    return seq;
+  }
+  for (size_t i = 0; i < base->size(); ++i) {
+    switch (random(8)) {
+    case 0: // delete
+      break;
+    case 1: // substitute
+      seq.push_back('a' + random(alphabet));
+      break;
+    case 2: // insert
+      seq.push_back('a' + random(alphabet));
+      seq.push_back((*base)[i]);
+      break;
+    default:
+      seq.push_back((*base)[i]);
+    }
+  }
+  return seq;
+}
+
+// the kernels as FuzzyMatchWrapper dispatches them: bit-parallel over the
+// shorter sequence if it has at most 64 symbols, else the two-row DP
+unsigned int KernelSed(const string &a, const string &b, unsigned int maxCost)
+{
+  const string &p = (a.size() <= b.size()) ? a : b;
+  const string &t = (a.size() <= b.size()) ? b : a;
+  if (p.empty()) {
+    return min<unsigned int>(t.size(), maxCost + 1);
+  }
+  if (p.size() <= 64) {
+    return myers_sed(LetterPeq(p), p.size(), t.data(), t.size(), maxCost);
+  }
+  return row_sed(p.data(), p.size(), t.data(), t.size(), maxCost);
+}
+
+unsigned int KernelSed(const vector<WORD_ID> &a, const vector<WORD_ID> &b,
+                       unsigned int maxCost)
+{
+  const vector<WORD_ID> &p = (a.size() <= b.size()) ? a : b;
+  const vector<WORD_ID> &t = (a.size() <= b.size()) ? b : a;
+  if (p.empty()) {
+    return min<unsigned int>(t.size(), maxCost + 1);
+  }
+  if (p.size() <= 64) {
+    return myers_sed(WordPeq(p), p.size(), &t[0], t.size(), maxCost);
+  }
+  return row_sed(&p[0], p.size(), &t[0], t.size(), maxCost);
+}
+
+template <typename Seq>
+void CheckRandom(size_t alphabet)
+{
+  Random random;
+  for (size_t n = 0; n < 2000; ++n) {
+    // lengths up to 150 cover patterns below, at and above 64 symbols
+    size_t length = (n % 4 == 0) ? 60 + random(10) : random(150);
+    Seq a = RandomSeq<Seq>(random, length, alphabet, NULL);
+    Seq b = (n % 2) ? RandomSeq<Seq>(random, random(150), alphabet, NULL)
+            : RandomSeq<Seq>(random, 0, alphabet, &a);
+    unsigned int expected = MatrixSed(a, b);
+    unsigned int unbounded = max(a.size(), b.size());
+    BOOST_REQUIRE_EQUAL(KernelSed(a, b, unbounded), expected);
+    BOOST_REQUIRE_EQUAL(KernelSed(b, a, unbounded), expected);
+
+    // a cut-off either gives the distance or reports max_cost+1
+    unsigned int maxCost = random(unbounded + 1);
+    BOOST_REQUIRE_EQUAL(KernelSed(a, b, maxCost), min(expected, maxCost + 1));
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(fuzzy_match_edit_distance)
+
+BOOST_AUTO_TEST_CASE(letters_match_dp)
+{
+  CheckRandom<string>(4);
+}
+
+BOOST_AUTO_TEST_CASE(words_match_dp)
+{
+  CheckRandom<vector<WORD_ID> >(6);
+}
+
+BOOST_AUTO_TEST_CASE(pattern_of_64_symbols)
+{
+  // the top bit of the bit vector is the last pattern symbol
+  string a(64, 'a');
+  string b = a;
+  b[63] = 'b';
+  BOOST_CHECK_EQUAL(KernelSed(a, b, 64), 1u);
+  // a^63 b a b: insert one 'b' on each side of the last 'a'
+  b += "ab";
+  BOOST_CHECK_EQUAL(KernelSed(a, b, 66), 2u);
+  BOOST_CHECK_EQUAL(KernelSed(a, b, 1), 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,13 +6,15 @@
 //  Copyright 2012 __MyCompanyName__. All rights reserved.
 //
 
+#include <algorithm>
 #include <iostream>
 #include "FuzzyMatchWrapper.h"
 #include "SentenceAlignment.h"
 #include "Match.h"
 #include "create_xml.h"
+#include "EditDistance.h"
 #include "moses/Util.h"
-#include "moses/StaticData.h"
+#include "util/exception.hh"
 #include "util/file.hh"
 
 using namespace std;
@@ -20,7 +22,24 @@ using namespace std;
 namespace tmmt
 {
 
-FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath)
+namespace
+{
+
+// letter sed cache entries pack 24-bit word ids for a and b and the cost+1
+// in the low 16 bits (0 marks an empty slot)
+const size_t LSEDCacheProbes = 8;
+const WORD_ID LSEDMaxWordId = (1 << 24) - 1;
+const unsigned int LSEDMaxCost = 0xfffe;
+
+inline size_t LSEDCacheSlot( WORD_ID aIdx, WORD_ID bIdx, size_t cacheBits )
+{
+  uint64_t h = ((uint64_t) aIdx << 32 | bIdx) * 0x9e3779b97f4a7c15ULL;
+  return h >> (64 - cacheBits);
+}
+
+}
+
+FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath, size_t lsedCacheBits)
   :basic_flag(false)
   ,lsed_flag(true)
   ,refined_flag(true)
@@ -30,7 +49,14 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   ,multiple_flag(true)
   ,multiple_slack(0)
   ,multiple_max(100)
+  ,m_lsedBits(lsedCacheBits)
+  ,m_lsed(lsedCacheBits ? size_t(1) << lsedCacheBits : 0)
 {
+  UTIL_THROW_IF2(lsedCacheBits > 32, "Letter sed cache of 2^" << lsedCacheBits << " entries is too large");
+  for( size_t i=0; i<m_lsed.size(); i++ ) {
+    m_lsed[i] = 0;
+  }
+
   cerr << "creating suffix array" << endl;
   suffixArray = new tmmt::SuffixArray( sourcePath );
 
@@ -49,64 +75,61 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   cerr << "loading completed" << endl;
 }
 
-string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::Extract(long translationId, const string &input,
+                                vector<FuzzyMatchRule> &rules)
 {
-  const Moses::StaticData &staticData = Moses::StaticData::Instance();
-
   WordIndex wordIndex;
+  RuleCounts ruleCounts;
+
+  ExtractTM(wordIndex, translationId, GetVocabulary().Tokenize(input.c_str()), ruleCounts);
+
+  // score the rules by relative frequency, as the phrase scorer would with
+  // --NoLex. The most frequent alignment of each rule is kept.
+  map<string, float> sourceCounts, targetCounts;
+  map<pair<string, string>, float> totals;
+  for (RuleCounts::const_iterator iter = ruleCounts.begin(); iter != ruleCounts.end(); ++iter) {
+    float &total = totals[iter->first];
+    for (map<string, float>::const_iterator align = iter->second.begin();
+         align != iter->second.end(); ++align) {
+      total += align->second;
+    }
+    sourceCounts[iter->first.first] += total;
+    targetCounts[iter->first.second] += total;
+  }
 
-  string fuzzyMatchFile = ExtractTM(wordIndex, translationId, dirNameStr);
-
-  // create extrac files
-  create_xml(fuzzyMatchFile);
-
-  // create phrase table with usual Moses scoring and consolidate programs
-  string cmd;
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract | gzip -c > "
-        + fuzzyMatchFile + ".extract.sorted.gz";
-  system(cmd.c_str());
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract.inv | gzip -c > "
-        + fuzzyMatchFile + ".extract.inv.sorted.gz";
-  system(cmd.c_str());
-
-#ifdef IS_XCODE
-  cmd = "/Users/hieuhoang/unison/workspace/github/moses-smt/bin";
-#elif IS_ECLIPSE
-  cmd = "/home/hieu/workspace/github/moses-smt/bin";
-#else
-  cmd = staticData.GetBinDirectory();
-#endif
-
-  cmd += string("/../scripts/training/train-model.perl -dont-zip -first-step 6 -last-step 6 -f en -e fr -hierarchical ")
-         + " -extract-file " + fuzzyMatchFile + ".extract -lexical-file - -score-options \"--NoLex\" "
-         + " -phrase-translation-table " + fuzzyMatchFile + ".pt";
-  system(cmd.c_str());
-
+  rules.reserve(ruleCounts.size());
+  for (RuleCounts::const_iterator iter = ruleCounts.begin(); iter != ruleCounts.end(); ++iter) {
+    const map<string, float> &alignments = iter->second;
+    map<string, float>::const_iterator bestAlign = alignments.begin();
+    for (map<string, float>::const_iterator align = alignments.begin();
+         align != alignments.end(); ++align) {
+      if (align->second > bestAlign->second) {
+        bestAlign = align;
+      }
+    }
 
-  return fuzzyMatchFile + ".pt.gz";
+    const float total = totals[iter->first];
+    FuzzyMatchRule rule;
+    rule.source = iter->first.first + " [X]";
+    rule.target = iter->first.second + " [X]";
+    rule.alignment = bestAlign->first;
+    rule.inverseProb = total / targetCounts[iter->first.second];
+    rule.directProb = total / sourceCounts[iter->first.first];
+    rules.push_back(rule);
+  }
 }
 
-string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const vector< WORD_ID > &input, RuleCounts &ruleCounts)
 {
   const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
 
-  string inputPath = dirNameStr + "/in";
-  string fuzzyMatchFile = dirNameStr + "/fuzzyMatchFile";
-  ofstream fuzzyMatchStream(fuzzyMatchFile.c_str());
-
-  vector< vector< WORD_ID > > input;
-  load_corpus(inputPath, input);
-
-  assert(input.size() == 1);
-  size_t sentenceInd = 0;
-
   clock_t start_clock = clock();
   // if (i % 10 == 0) cerr << ".";
 
   // establish some basic statistics
 
   // int input_length = compute_length( input[i] );
-  int input_length = input[sentenceInd].size();
+  int input_length = input.size();
   int best_cost = input_length * (100-min_match) / 100 + 1;
 
   int match_count = 0; // how many substring matches to be considered
@@ -114,15 +137,15 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
 
   // find match ranges in suffix array
   vector< vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > > match_range;
-  for(int start=0; start<input[sentenceInd].size(); start++) {
+  for(int start=0; start<input.size(); start++) {
     SuffixArray::INDEX prior_first_match = 0;
     SuffixArray::INDEX prior_last_match = suffixArray->GetSize()-1;
     vector< string > substring;
     bool stillMatched = true;
     vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > matchedAtThisStart;
     //cerr << "start: " << start;
-    for(size_t word=start; stillMatched && word<input[sentenceInd].size(); word++) {
-      substring.push_back( GetVocabulary().GetWord( input[sentenceInd][word] ) );
+    for(size_t word=start; stillMatched && word<input.size(); word++) {
+      substring.push_back( GetVocabulary().GetWord( input[word] ) );
 
       // only look up, if needed (i.e. no unnecessary short gram lookups)
       //				if (! word-start+1 <= short_match_max_length( input_length ) )
@@ -149,14 +172,14 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   map< int, int > sentence_match_word_count;
 
   // go through all matches, longest first
-  for(int length = input[sentenceInd].size(); length >= 1; length--) {
+  for(int length = input.size(); length >= 1; length--) {
     // do not create matches, if these are handled by the short match function
     if (length <= short_match_max_length( input_length ) ) {
       continue;
     }
 
     unsigned int count = 0;
-    for(int start = 0; start <= input[sentenceInd].size() - length; start++) {
+    for(int start = 0; start <= input.size() - length; start++) {
       if (match_range[start].size() >= length) {
         pair< SuffixArray::INDEX, SuffixArray::INDEX > &range = match_range[start][length-1];
         // cerr << " (" << range.first << "," << range.second << ")";
@@ -244,7 +267,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   int tm_count_word_match2 = 0;
   int pruned_match_count = 0;
   if (short_match_max_length( input_length )) {
-    init_short_matches(wordIndex, translationId, input[sentenceInd] );
+    init_short_matches(wordIndex, translationId, input );
   }
   vector< int > best_tm;
   typedef map< int, vector< Match > >::iterator I;
@@ -289,8 +312,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     clock_t clock_validation_start = clock();
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
-      string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
+      cost = sed_cost( input, source[tmID], best_cost );
       if (cost <  best_cost) {
         best_cost = cost;
       }
@@ -315,10 +337,10 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
 
   cerr << "pruned matches: " << ((float)pruned_match_count/(float)tm_count_word_match2) << endl;
 
-  // create xml and extract files
+  // create rules
   string inputStr, sourceStr;
   for (size_t pos = 0; pos < input_length; ++pos) {
-    inputStr += GetVocabulary().GetWord(input[sentenceInd][pos]) + " ";
+    inputStr += GetVocabulary().GetWord(input[pos]) + " ";
   }
 
   // do not try to find the best ... report multiple matches
@@ -326,10 +348,10 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     for(size_t si=0; si<best_tm.size(); si++) {
       int s = best_tm[si];
       string path;
-      sed( input[sentenceInd], source[s], path, true );
+      sed( input, source[s], path, true );
       const vector<WORD_ID> &sourceSentence = source[s];
       vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
+      create_extract(sourceSentence, targets, inputStr, path, ruleCounts);
 
     }
   } // if (multiple_flag)
@@ -340,11 +362,11 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     int best_match = -1;
     unsigned int best_letter_cost;
     if (lsed_flag) {
-      best_letter_cost = compute_length( input[sentenceInd] ) * min_match / 100 + 1;
+      best_letter_cost = compute_length( input ) * min_match / 100 + 1;
       for(size_t si=0; si<best_tm.size(); si++) {
         int s = best_tm[si];
         string path;
-        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
+        unsigned int letter_cost = sed( input, source[s], path, true );
         if (letter_cost < best_letter_cost) {
           best_letter_cost = letter_cost;
           best_path = path;
@@ -356,7 +378,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     else {
       if (best_tm.size() > 0) {
         string path;
-        sed( input[sentenceInd], source[best_tm[0]], path, false );
+        sed( input, source[best_tm[0]], path, false );
         best_path = path;
         best_match = best_tm[0];
       }
@@ -368,7 +390,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
          << " (validation: " << (1000 * (clock_validation_sum) / CLOCKS_PER_SEC) << ")"
          << " )" << endl;
     if (lsed_flag) {
-      //cout << best_letter_cost << "/" << compute_length( input[sentenceInd] ) << " (";
+      //cout << best_letter_cost << "/" << compute_length( input ) << " (";
     }
     //cout << best_cost <<"/" << input_length;
     if (lsed_flag) {
@@ -384,13 +406,10 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     // creat xml & extracts
     const vector<WORD_ID> &sourceSentence = source[best_match];
     vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
+    create_extract(sourceSentence, targets, inputStr, best_path, ruleCounts);
 
   } // else if (multiple_flag)
 
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
 }
 
 void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
@@ -513,13 +532,20 @@ void FuzzyMatchWrapper::load_alignment(const std::string &fileName, vector< vect
 
 bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, unsigned int &value) const
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif
-  map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
-  if (lookup != m_lsed.end()) {
-    value = lookup->second;
-    return true;
+  if (m_lsed.empty() || key.first > LSEDMaxWordId || key.second > LSEDMaxWordId) {
+    return false;
+  }
+  const uint64_t tag = (uint64_t) key.first << 40 | (uint64_t) key.second << 16;
+  size_t slot = LSEDCacheSlot( key.first, key.second, m_lsedBits );
+  for( size_t p=0; p<LSEDCacheProbes; p++ ) {
+    uint64_t entry = m_lsed[ (slot + p) & (m_lsed.size()-1) ];
+    if (entry == 0) {
+      return false;
+    }
+    if ((entry & ~(uint64_t) 0xffff) == tag) {
+      value = (entry & 0xffff) - 1;
+      return true;
+    }
   }
 
   return false;
@@ -527,10 +553,31 @@ bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, u
 
 void FuzzyMatchWrapper::SetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, const unsigned int &value)
 {
+  if (m_lsed.empty() || key.first > LSEDMaxWordId || key.second > LSEDMaxWordId || value > LSEDMaxCost) {
+    return;
+  }
+  const uint64_t entry = (uint64_t) key.first << 40 | (uint64_t) key.second << 16 | (value + 1);
+  size_t slot = LSEDCacheSlot( key.first, key.second, m_lsedBits );
+  // take the first free slot of the probe sequence, else evict its head
+  for( size_t p=0; p<LSEDCacheProbes; p++ ) {
+    size_t i = (slot + p) & (m_lsed.size()-1);
 #ifdef WITH_THREADS
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+    uint64_t expected = 0;
+    if (m_lsed[i].compare_exchange_strong( expected, entry )) {
+      return;
+    }
+#else
+    uint64_t expected = m_lsed[i];
+    if (expected == 0) {
+      m_lsed[i] = entry;
+      return;
+    }
 #endif
-  m_lsed[ key ] = value;
+    if ((expected & ~(uint64_t) 0xffff) == (entry & ~(uint64_t) 0xffff)) {
+      return;
+    }
+  }
+  m_lsed[ slot ] = entry;
 }
 
 /* Letter string edit distance, e.g. sub 'their' to 'there' costs 2 */
@@ -549,42 +596,40 @@ unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx )
   const string &a = GetVocabulary().GetWord( aIdx );
   const string &b = GetVocabulary().GetWord( bIdx );
 
-  // initialize cost matrix
-  unsigned int **cost  = (unsigned int**) calloc( sizeof( unsigned int*  ), a.size()+1 );
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    cost[i] = (unsigned int*) calloc( sizeof(unsigned int), b.size()+1 );
-    cost[i][0] = i;
-  }
-  for( unsigned int j=0; j<=b.size(); j++ ) {
-    cost[0][j] = j;
+  // bit-parallel over the letters of the shorter word if it fits in 64 bits
+  const string &p = (a.size() <= b.size()) ? a : b;
+  const string &t = (a.size() <= b.size()) ? b : a;
+  unsigned int final;
+  if (p.empty()) {
+    final = t.size();
+  } else if (p.size() <= 64) {
+    final = myers_sed( LetterPeq( p ), p.size(), t.data(), t.size(), t.size() );
+  } else {
+    final = row_sed( p.data(), p.size(), t.data(), t.size(), t.size() );
   }
 
-  // core string edit distance loop
-  for( unsigned int i=1; i<=a.size(); i++ ) {
-    for( unsigned int j=1; j<=b.size(); j++ ) {
-
-      unsigned int ins = cost[i-1][j] + 1;
-      unsigned int del = cost[i][j-1] + 1;
-      bool match = (a.substr(i-1,1).compare( b.substr(j-1,1) ) == 0);
-      unsigned int diag = cost[i-1][j-1] + (match ? 0 : 1);
+  // cache and return result
+  SetLSEDCache(pIdx, final);
+  return final;
+}
 
-      unsigned int min = (ins < del) ? ins : del;
-      min = (diag < min) ? diag : min;
+/* word string edit distance, cost only: bit-parallel if the shorter
+ sentence has at most 64 words */
 
-      cost[i][j] = min;
-    }
+unsigned int FuzzyMatchWrapper::sed_cost( const vector< WORD_ID > &a, const vector< WORD_ID > &b, unsigned int max_cost )
+{
+  const vector< WORD_ID > &p = (a.size() <= b.size()) ? a : b;
+  const vector< WORD_ID > &t = (a.size() <= b.size()) ? b : a;
+  if (t.size() - p.size() > max_cost) {
+    return max_cost + 1;
   }
-
-  // clear out memory
-  unsigned int final = cost[a.size()][b.size()];
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    free( cost[i] );
+  if (p.empty()) {
+    return t.size();
   }
-  free( cost );
-
-  // cache and return result
-  SetLSEDCache(pIdx, final);
-  return final;
+  if (p.size() <= 64) {
+    return myers_sed( WordPeq( p ), p.size(), &t[0], t.size(), max_cost );
+  }
+  return row_sed( &p[0], p.size(), &t[0], t.size(), max_cost );
 }
 
 /* string edit distance implementation */
@@ -592,45 +637,44 @@ unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx )
 unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< WORD_ID > &b, string &best_path, bool use_letter_sed )
 {
 
-  // initialize cost and path matrices
-  unsigned int **cost  = (unsigned int**) calloc( sizeof( unsigned int* ), a.size()+1 );
-  char **path = (char**) calloc( sizeof( char* ), a.size()+1 );
+  // initialize cost and path matrices (row-major, one allocation each)
+  const size_t width = b.size()+1;
+  vector< unsigned int > cost( (a.size()+1) * width );
+  vector< char > path( (a.size()+1) * width );
 
   for( unsigned int i=0; i<=a.size(); i++ ) {
-    cost[i] = (unsigned int*) calloc( sizeof(unsigned int), b.size()+1 );
-    path[i] = (char*) calloc( sizeof(char), b.size()+1 );
     if (i>0) {
-      cost[i][0] = cost[i-1][0];
+      cost[i*width] = cost[(i-1)*width];
       if (use_letter_sed) {
-        cost[i][0] += GetVocabulary().GetWord( a[i-1] ).size();
+        cost[i*width] += GetVocabulary().GetWord( a[i-1] ).size();
       } else {
-        cost[i][0]++;
+        cost[i*width]++;
       }
     } else {
-      cost[i][0] = 0;
+      cost[i*width] = 0;
     }
-    path[i][0] = 'I';
+    path[i*width] = 'I';
   }
 
   for( unsigned int j=0; j<=b.size(); j++ ) {
     if (j>0) {
-      cost[0][j] = cost[0][j-1];
+      cost[j] = cost[j-1];
       if (use_letter_sed) {
-        cost[0][j] +=	GetVocabulary().GetWord( b[j-1] ).size();
+        cost[j] +=	GetVocabulary().GetWord( b[j-1] ).size();
       } else {
-        cost[0][j]++;
+        cost[j]++;
       }
     } else {
-      cost[0][j] = 0;
+      cost[j] = 0;
     }
-    path[0][j] = 'D';
+    path[j] = 'D';
   }
 
   // core string edit distance algorithm
   for( unsigned int i=1; i<=a.size(); i++ ) {
     for( unsigned int j=1; j<=b.size(); j++ ) {
-      unsigned int ins = cost[i-1][j];
-      unsigned int del = cost[i][j-1];
+      unsigned int ins = cost[(i-1)*width + j];
+      unsigned int del = cost[i*width + j-1];
       unsigned int match;
       if (use_letter_sed) {
         ins += GetVocabulary().GetWord( a[i-1] ).size();
@@ -641,7 +685,7 @@ unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< W
         del++;
         match = ( a[i-1] == b[j-1] ) ? 0 : 1;
       }
-      unsigned int diag = cost[i-1][j-1] + match;
+      unsigned int diag = cost[(i-1)*width + j-1] + match;
 
       char action = (ins < del) ? 'I' : 'D';
       unsigned int min = (ins < del) ? ins : del;
@@ -650,8 +694,8 @@ unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< W
         min = diag;
       }
 
-      cost[i][j] = min;
-      path[i][j] = action;
+      cost[i*width + j] = min;
+      path[i*width + j] = action;
     }
   }
 
@@ -660,30 +704,21 @@ unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< W
   unsigned int j = b.size();
   best_path = "";
   while( i>0 || j>0 ) {
-    best_path = path[i][j] + best_path;
-    if (path[i][j] == 'I') {
+    char action = path[i*width + j];
+    best_path += action;
+    if (action == 'I') {
       i--;
-    } else if (path[i][j] == 'D') {
+    } else if (action == 'D') {
       j--;
     } else {
       i--;
       j--;
     }
   }
-
-
-  // clear out memory
-  unsigned int final = cost[a.size()][b.size()];
-
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    free( cost[i] );
-    free( path[i] );
-  }
-  free( cost );
-  free( path );
+  reverse( best_path.begin(), best_path.end() );
 
   // return result
-  return final;
+  return cost[a.size()*width + b.size()];
 }
 
 /* utlility function: compute length of sentence in characters
@@ -1000,7 +1035,7 @@ int FuzzyMatchWrapper::parse_matches( vector< Match > &match, int input_length,
 }
 
 
-void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, ofstream &outputFile)
+void FuzzyMatchWrapper::create_extract(const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, RuleCounts &ruleCounts)
 {
   string sourceStr;
   for (size_t pos = 0; pos < sourceSentence.size(); ++pos) {
@@ -1013,16 +1048,8 @@ void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector<
     string targetStr = sentenceAlignment.getTargetString(GetVocabulary());
     string alignStr = sentenceAlignment.getAlignmentString();
 
-    outputFile
-        << sentenceInd << endl
-        << cost << endl
-        << sourceStr << endl
-        << inputStr << endl
-        << targetStr << endl
-        << alignStr << endl
-        << path << endl
-        << sentenceAlignment.count << endl;
-
+    CreateXMLRetValues ret = createXML(sourceStr, inputStr, targetStr, alignStr, path + "X");
+    ruleCounts[make_pair(ret.ruleS, ret.ruleT)][ret.ruleAlignment] += sentenceAlignment.count;
   }
 }
 
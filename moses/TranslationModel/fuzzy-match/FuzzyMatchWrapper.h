@@ -10,11 +10,13 @@
 #define moses_FuzzyMatchWrapper_h
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/atomic.hpp>
 #endif
 
 #include <fstream>
 #include <string>
+#include <vector>
+#include <stdint.h>
 #include "SuffixArray.h"
 #include "Vocabulary.h"
 #include "Match.h"
@@ -25,12 +27,24 @@ namespace tmmt
 class Match;
 struct SentenceAlignment;
 
+//! A hierarchical rule built from the best translation memory matches of a
+//! sentence, in Moses rule table format, with relative-frequency scores
+struct FuzzyMatchRule {
+  std::string source;
+  std::string target;
+  std::string alignment;
+  float inverseProb;
+  float directProb;
+};
+
 class FuzzyMatchWrapper
 {
 public:
-  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
+  /** lsedCacheBits: the letter sed cache holds 2^lsedCacheBits entries of
+   8 bytes each (the default of 20 takes 8 MB); 0 turns the cache off */
+  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment, size_t lsedCacheBits = 20);
 
-  std::string Extract(long translationId, const std::string &dirNameStr);
+  void Extract(long translationId, const std::string &input, std::vector<FuzzyMatchRule> &rules);
 
 protected:
   // tm-mt
@@ -48,12 +62,21 @@ protected:
 
   typedef std::map< WORD_ID,std::vector< int > > WordIndex;
 
-  // global cache for word pairs
-  std::map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
+  // extracted rule (source, target) -> alignment -> count
+  typedef std::map< std::pair< std::string, std::string >, std::map< std::string, float > > RuleCounts;
+
+  // global cache for letter edit distances of word pairs: a fixed-size,
+  // open-addressing table of packed (aIdx, bIdx, cost) entries, so that
+  // lookups and inserts from several threads need no lock. Entries may be
+  // overwritten when a probe sequence is full; a miss only means the
+  // distance is computed again.
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  typedef boost::atomic< uint64_t > LSEDCacheEntry;
+#else
+  typedef uint64_t LSEDCacheEntry;
 #endif
+  size_t m_lsedBits;
+  std::vector< LSEDCacheEntry > m_lsed;
 
   void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
   void load_target( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus);
@@ -68,15 +91,18 @@ protected:
   unsigned int compute_length( const std::vector< tmmt::WORD_ID > &sentence );
   unsigned int letter_sed( WORD_ID aIdx, WORD_ID bIdx );
   unsigned int sed( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, std::string &best_path, bool use_letter_sed );
+  /** word edit distance without the path; any result above max_cost is
+   reported as max_cost+1 as soon as it is certain */
+  unsigned int sed_cost( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, unsigned int max_cost );
   void init_short_matches(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input );
   int short_match_max_length( int input_length );
   void add_short_matches(WordIndex &wordIndex, long translationId, std::vector< Match > &match, const std::vector< WORD_ID > &tm, int input_length, int best_cost );
   std::vector< Match > prune_matches( const std::vector< Match > &match, int best_cost );
   int parse_matches( std::vector< Match > &match, int input_length, int tm_length, int &best_cost );
 
-  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::ofstream &outputFile);
+  void create_extract(const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, RuleCounts &ruleCounts);
 
-  std::string ExtractTM(WordIndex &wordIndex, long translationId, const std::string &inputPath);
+  void ExtractTM(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input, RuleCounts &ruleCounts);
   Vocabulary &GetVocabulary() {
     return suffixArray->GetVocabulary();
   }
@@ -1,5 +1,6 @@
 #include "SuffixArray.h"
 #include <string>
+#include "util/exception.hh"
 #include <stdlib.h>
 #include <cstring>
 
@@ -10,123 +11,95 @@ namespace tmmt
 
 SuffixArray::SuffixArray( string fileName )
 {
-  m_vcb.StoreIfNew( "<uNk>" );
-  m_endOfSentence = m_vcb.StoreIfNew( "<s>" );
+  if (util::SuffixArrayFile::Recognize( fileName.c_str() )) {
+    // persistent index: map it and recover the vocabulary in id order
+    m_file.reset( new util::SuffixArrayFile( fileName.c_str() ) );
+    for( size_t i=0; i<m_file->VocabSize(); i++ ) {
+      WORD_ID id = m_vcb.StoreIfNew( m_file->Word( i ).as_string() );
+      UTIL_THROW_IF2( id != i, "Duplicate word in suffix array index " << fileName );
+    }
+    m_endOfSentence = m_vcb.GetWordID( "<s>" );
+    m_size = m_file->Size();
+    m_array = m_file->Text();
+    m_index = m_file->Array();
+    m_lcp = m_file->LCP();
+    cerr << "loaded index of " << m_size << " words (incl. sentence boundaries)" << endl;
+  } else {
+    m_vcb.StoreIfNew( "<uNk>" );
+    m_endOfSentence = m_vcb.StoreIfNew( "<s>" );
+
+    ifstream extractFile( fileName.c_str() );
+    UTIL_THROW_IF2( !extractFile, "Cannot open " << fileName );
+    string line;
+    while(getline(extractFile, line)) {
+      vector< WORD_ID > words = m_vcb.Tokenize( line.c_str() );
+      m_arrayBuffer.insert( m_arrayBuffer.end(), words.begin(), words.end() );
+      m_arrayBuffer.push_back( m_endOfSentence );
+    }
+    m_size = m_arrayBuffer.size();
+    m_array = m_arrayBuffer.empty() ? NULL : &m_arrayBuffer[0];
+    cerr << m_size << " words (incl. sentence boundaries)" << endl;
+  }
 
-  ifstream extractFile;
+  // suffixes are ordered by the strings of their words; compare ranks instead
+  util::RankVocabulary( m_vcb.vocab, m_rank );
 
-  // count the number of words first;
-  extractFile.open(fileName.c_str());
-  istream *fileP = &extractFile;
-  m_size = 0;
-  size_t sentenceCount = 0;
-  string line;
-  while(getline(*fileP, line)) {
-
-    vector< WORD_ID > words = m_vcb.Tokenize( line.c_str() );
-    m_size += words.size() + 1;
-    sentenceCount++;
+  if (!m_file) {
+    vector< WORD_ID > ranked( m_size );
+    for( INDEX i=0; i<m_size; i++ ) {
+      ranked[i] = m_rank[ m_array[i] ];
+    }
+    m_indexBuffer.resize( m_size );
+    m_lcpBuffer.resize( m_size );
+    if (m_size) {
+      util::BuildSuffixArray( &ranked[0], m_size, m_rank.size(), &m_indexBuffer[0] );
+      util::BuildLCP( &ranked[0], m_size, &m_indexBuffer[0], &m_lcpBuffer[0] );
+    }
+    m_index = m_indexBuffer.empty() ? NULL : &m_indexBuffer[0];
+    m_lcp = m_lcpBuffer.empty() ? NULL : &m_lcpBuffer[0];
+    cerr << "done sorting" << endl;
   }
-  extractFile.close();
-  cerr << m_size << " words (incl. sentence boundaries)" << endl;
 
-  // allocate memory
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  // sentence structure, in one pass over the corpus
+  size_t sentenceCount = 0;
+  for( INDEX i=0; i<m_size; i++ ) {
+    if (m_array[i] == m_endOfSentence) {
+      sentenceCount++;
+    }
+  }
   m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
   m_sentence = (size_t*) calloc( sizeof( size_t ), m_size );
   m_sentenceLength = (char*) calloc( sizeof( char ), sentenceCount );
-
-  // fill the array
-  int wordIndex = 0;
-  int sentenceId = 0;
-  extractFile.open(fileName.c_str());
-  fileP = &extractFile;
-  while(getline(*fileP, line)) {
-    vector< WORD_ID > words = m_vcb.Tokenize( line.c_str() );
-
-    // add to corpus vector
-    corpus.push_back(words);
-
-    // create SA
-
-    vector< WORD_ID >::const_iterator i;
-    for( i=words.begin(); i!=words.end(); i++) {
-      m_index[ wordIndex ] = wordIndex;
-      m_sentence[ wordIndex ] = sentenceId;
-      m_wordInSentence[ wordIndex ] = i-words.begin();
-      m_array[ wordIndex++ ] = *i;
-    }
-    m_index[ wordIndex ] = wordIndex;
-    m_array[ wordIndex++ ] = m_endOfSentence;
-    m_sentenceLength[ sentenceId++ ] = words.size();
-  }
-  extractFile.close();
-  cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
-  // List(0,9);
-
-  // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  Sort( 0, m_size-1 );
-  free( m_buffer );
-  cerr << "done sorting" << endl;
-}
-
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
-{
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  size_t i = start;
-  size_t j = mid;
-  size_t k = 0;
-  size_t length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
+  corpus.resize( sentenceCount );
+
+  size_t sentenceId = 0;
+  INDEX sentenceStart = 0;
+  for( INDEX i=0; i<m_size; i++ ) {
+    if (m_array[i] == m_endOfSentence) {
+      corpus[ sentenceId ].assign( m_array + sentenceStart, m_array + i );
+      m_sentenceLength[ sentenceId++ ] = i - sentenceStart;
+      sentenceStart = i+1;
     } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
+      m_sentence[i] = sentenceId;
+      m_wordInSentence[i] = i - sentenceStart;
     }
   }
-
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+  cerr << "done reading " << m_size << " words, " << sentenceId << " sentences." << endl;
 }
 
 SuffixArray::~SuffixArray()
 {
-  free(m_index);
-  free(m_array);
-}
-
-int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
-{
-  // skip over identical words
-  INDEX offset = 0;
-  while( a+offset < m_size &&
-         b+offset < m_size &&
-         m_array[ a+offset ] == m_array[ b+offset ] ) {
-    offset++;
-  }
-
-  if( a+offset == m_size ) return -1;
-  if( b+offset == m_size ) return 1;
-  return CompareWord( m_array[ a+offset ], m_array[ b+offset ] );
+  free(m_wordInSentence);
+  free(m_sentence);
+  free(m_sentenceLength);
 }
 
 inline int SuffixArray::CompareWord( WORD_ID a, WORD_ID b ) const
 {
-  // cerr << "c(" << m_vcb.GetWord(a) << ":" << m_vcb.GetWord(b) << ")=" << m_vcb.GetWord(a).compare( m_vcb.GetWord(b) ) << endl;
+  if (a < m_rank.size() && b < m_rank.size()) {
+    return (m_rank[a] < m_rank[b]) ? -1 : (m_rank[a] > m_rank[b]) ? 1 : 0;
+  }
+  // words added to the vocabulary after indexing
   return m_vcb.GetWord(a).compare( m_vcb.GetWord(b) );
 }
 
@@ -183,10 +156,9 @@ SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX st
     INDEX mid = ( start + end + (direction>0 ? 0 : 1) )/2;
 
     int match = Match( phrase, mid );
-    int matchNext = Match( phrase, mid+direction );
-    //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << "," << matchNext << endl;
+    //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << endl;
 
-    if (match == 0 && matchNext != 0) return mid;
+    if (match == 0 && !NextMatches( phrase.size(), mid, direction )) return mid;
 
     if (match == 0) // mid point is a match
       start = mid;
@@ -212,6 +184,17 @@ SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &
   }
 }
 
+/* given that the suffix at index matches a phrase, does its neighbour in
+ direction match too? The LCP array answers that without comparing words. */
+
+bool SuffixArray::NextMatches( size_t phraseLength, INDEX index, int direction ) const
+{
+  if (direction > 0) {
+    return index+1 < m_size && m_lcp[ index+1 ] >= phraseLength;
+  }
+  return index > 0 && m_lcp[ index ] >= phraseLength;
+}
+
 int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
 {
   INDEX pos = m_index[ index ];
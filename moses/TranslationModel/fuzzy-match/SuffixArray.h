@@ -1,5 +1,9 @@
 #include "Vocabulary.h"
 
+#include <boost/scoped_ptr.hpp>
+
+#include "util/suffix_array.hh"
+
 #pragma once
 
 #define LINE_MAX_LENGTH 10000
@@ -15,9 +19,17 @@ public:
 private:
   std::vector< std::vector< WORD_ID > > corpus;
 
-  WORD_ID *m_array;
-  INDEX *m_index;
-  INDEX *m_buffer;
+  // corpus, suffix array and LCP array: either mapped from a persistent
+  // index (see util::SuffixArrayFile) or built in memory
+  boost::scoped_ptr< util::SuffixArrayFile > m_file;
+  std::vector< WORD_ID > m_arrayBuffer;
+  std::vector< INDEX > m_indexBuffer;
+  std::vector< INDEX > m_lcpBuffer;
+  const WORD_ID *m_array;
+  const INDEX *m_index;
+  const INDEX *m_lcp;
+  // rank of each word id in string order, for comparing words as integers
+  std::vector< WORD_ID > m_rank;
   char *m_wordInSentence;
   size_t *m_sentence;
   char *m_sentenceLength;
@@ -26,11 +38,11 @@ private:
   INDEX m_size;
 
 public:
+  // fileName is either a tokenized corpus, one sentence per line, or a
+  // persistent index of one (e.g. from phrase-lookup --create --save)
   SuffixArray( std::string fileName );
   ~SuffixArray();
 
-  void Sort(INDEX start, INDEX end);
-  int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
   bool MinCount( const std::vector< WORD > &phrase, INDEX min );
@@ -39,6 +51,7 @@ public:
   int LimitedCount( const std::vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = -1, INDEX search_end = 0 );
   INDEX FindFirst( const std::vector< WORD > &phrase, INDEX &start, INDEX &end );
   INDEX FindLast( const std::vector< WORD > &phrase, INDEX start, INDEX end, int direction );
+  bool NextMatches( size_t phraseLength, INDEX index, int direction ) const;
   int Match( const std::vector< WORD > &phrase, INDEX index );
   void List( INDEX start, INDEX end );
   inline INDEX GetPosition( INDEX index ) {
@@ -2,4 +2,15 @@
 
 #include <string>
 
-void create_xml(const std::string &inPath);
+class CreateXMLRetValues
+{
+public:
+  std::string frame, ruleS, ruleT, ruleAlignment, ruleAlignmentInv;
+};
+
+// Hierarchical rule and XML frame for an input sentence, given a fuzzy match
+// (source, target and word alignment) and the edit path between the input
+// and the match's source.
+CreateXMLRetValues createXML(const std::string &source, const std::string &input,
+                             const std::string &target, const std::string &align,
+                             const std::string &path);
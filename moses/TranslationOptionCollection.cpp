@@ -39,6 +39,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/FF/LexicalReordering/LexicalReordering.h"
 #include "moses/FF/InputFeature.h"
 #include "TranslationTask.h"
+#include "Metrics.h"
 #include "util/exception.hh"
 
 #include <boost/foreach.hpp>
@@ -344,6 +345,7 @@ CreateTranslationOptions()
 
   // length of the sentence
   const size_t size = m_source.GetSize();
+  const double start = util::WallTime();
 
   // loop over all decoding graphs, each generates translation options
   for (size_t gidx = 0 ; gidx < decodeGraphList.size() ; gidx++) {
@@ -374,7 +376,10 @@ CreateTranslationOptions()
   VERBOSE(3,"Translation Option Collection\n " << *this << endl);
   Prune();
   Sort();
+  const double lookedUp = util::WallTime();
+  Metrics::Instance().Observe(Metrics::Lookup, lookedUp - start);
   CalcEstimatedScore(); // future score matrix
+  Metrics::Instance().Observe(Metrics::FutureCost, util::WallTime() - lookedUp);
   CacheLexReordering(); // Cached lex reodering costs
 }
 
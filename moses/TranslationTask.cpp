@@ -6,6 +6,7 @@
 #include "moses/TypeDef.h"
 #include "moses/Util.h"
 #include "moses/Timer.h"
+#include "moses/Metrics.h"
 #include "moses/InputType.h"
 #include "moses/OutputCollector.h"
 #include "moses/Incremental.h"
@@ -214,6 +215,8 @@ void TranslationTask::Run()
   additionalReportingTime.start();
   boost::shared_ptr<IOWrapper> const& io = m_ioWrapper;
 
+  Timer outputTime;
+  outputTime.start();
   manager->OutputBest(io->GetSingleBestOutputCollector());
 
   // output word graph
@@ -238,7 +241,10 @@ void TranslationTask::Run()
   additionalReportingTime.start();
 
   // output n-best list
+  Timer nbestTime;
+  nbestTime.start();
   manager->OutputNBest(io->GetNBestOutputCollector());
+  nbestTime.stop();
 
   //lattice samples
   manager->OutputLatticeSamples(io->GetLatticeSamplesCollector());
@@ -254,6 +260,12 @@ void TranslationTask::Run()
   manager->OutputUnknowns(io->GetUnknownsCollector());
 
   manager->OutputAlignment(io->GetAlignmentInfoCollector());
+  outputTime.stop();
+  if (m_options->nbest.nbest_size) {
+    Metrics::Instance().Observe(Metrics::NBest, nbestTime.get_elapsed_time());
+  }
+  Metrics::Instance().Observe(Metrics::Output, outputTime.get_elapsed_time()
+                              - nbestTime.get_elapsed_time());
 
   // report additional statistics
   manager->CalcDecoderStatistics();
@@ -349,7 +349,8 @@ ProcessAndStripXMLTags(AllOptions const& opts, string &line,
           // update model
           VERBOSE(3,"Updating " << pdName << " ||| " << source << " ||| " << target << " ||| " << alignment << endl);
           Mmsapt* pdsa = reinterpret_cast<Mmsapt*>(pd);
-          pdsa->add(source, target, alignment);
+          // wait for the merge, so that this sentence sees the update
+          pdsa->add(source, target, alignment, true);
 #else
           TRACE_ERR("ERROR: recompile with --with-mm to update PhraseDictionary at runtime" << endl);
           return false;
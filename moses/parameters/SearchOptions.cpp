@@ -16,6 +16,7 @@ namespace Moses
     , beam_width(DEFAULT_BEAM_WIDTH)
     , timeout(0)
     , consensus(false)
+    , hypothesis_arena(false)
     , early_discarding_threshold(DEFAULT_EARLY_DISCARDING_THRESHOLD)
     , trans_opt_threshold(DEFAULT_TRANSLATION_OPTION_THRESHOLD)
   { }
@@ -50,6 +51,7 @@ namespace Moses
 
     param.SetParameter(consensus, "consensus-decoding", false);
     param.SetParameter(disable_discarding, "disable-discarding", false);
+    param.SetParameter(hypothesis_arena, "hypothesis-arena", false);
     
     // transformation to log of a few scores
     beam_width = TransformScore(beam_width);
@@ -28,6 +28,8 @@ namespace Moses
     int segment_timeout;
 
     bool consensus; //! Use Consensus decoding  (DeNero et al 2009)
+
+    bool hypothesis_arena; //! allocate hypotheses and states from a per-sentence arena
     
     // reordering options
     // bool  reorderingConstraint; //! use additional reordering constraints
@@ -46,6 +46,7 @@ ServerOptions()
   , keepaliveTimeout(15)
   , keepaliveMaxConn(30)
   , timeout(15)
+  , resultCacheSize(0)
 { }
 
 ServerOptions::
@@ -71,6 +72,7 @@ init(Parameter const& P)
   P.SetParameter(this->keepaliveTimeout,"server-keepalive-timeout", 15);
   P.SetParameter(this->keepaliveMaxConn,"server-keepalive-maxconn", 30);
   P.SetParameter(this->timeout,"server-timeout",15);
+  P.SetParameter(this->resultCacheSize, "server-result-cache", size_t(0));
 
   // the stuff below is related to Moses translation sessions
   std::string timeout_spec;
@@ -21,6 +21,8 @@ namespace Moses
     int keepaliveTimeout;  // this is for the abyss server
     int keepaliveMaxConn;  // this is for the abyss server
     int timeout;           // this is for the abyss server
+
+    size_t resultCacheSize; // translations cached, 0 to decode every request
     
     bool init(Parameter const& param);
     ServerOptions(Parameter const& param);
@@ -0,0 +1,33 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "MetricsReporter.h"
+#include "Server.h"
+#include "moses/Metrics.h"
+#include <sstream>
+
+namespace MosesServer
+{
+  MetricsReporter::
+  MetricsReporter(Server& server)
+    : m_server(server)
+  {
+    this->_signature = "s:";
+    this->_help = "Returns decoder metrics in the Prometheus text format";
+  }
+
+  void
+  MetricsReporter::
+  execute(xmlrpc_c::paramList const& paramList,
+          xmlrpc_c::value *   const  retvalP)
+  {
+    paramList.verifyEnd(0);
+    std::ostringstream out;
+    Moses::Metrics::Instance().Write(out);
+    ResultCache const& cache = m_server.result_cache();
+    out << "# TYPE moses_server_result_cache_total counter\n"
+        << "moses_server_result_cache_total{result=\"hit\"} "
+        << cache.hits() << "\n"
+        << "moses_server_result_cache_total{result=\"miss\"} "
+        << cache.misses() << "\n";
+    *retvalP = xmlrpc_c::value_string(out.str());
+  }
+}
@@ -0,0 +1,24 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace MosesServer
+{
+  class Server;
+
+  // The "metrics" method: returns the decoder metrics and the counters of
+  // the result cache as a string in the Prometheus text format.
+  class
+  MetricsReporter : public xmlrpc_c::method
+  {
+    Server& m_server;
+  public:
+    MetricsReporter(Server& server);
+
+    void execute(xmlrpc_c::paramList const& paramList,
+                 xmlrpc_c::value *   const  retvalP);
+  };
+
+}
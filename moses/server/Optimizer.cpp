@@ -6,7 +6,8 @@ namespace MosesServer
 using namespace std;
 
 Optimizer::
-Optimizer()
+Optimizer(ResultCache& result_cache)
+  : m_result_cache(result_cache)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
@@ -53,6 +54,7 @@ execute(xmlrpc_c::paramList const& paramList,
   // = (PhraseDictionaryMultiModel*) FindPhraseDictionary(model_name);
   PhraseDictionaryMultiModel* pdmm = FindPhraseDictionary(model_name);
   vector<float> weight_vector = pdmm->MinimizePerplexity(phrase_pairs);
+  m_result_cache.clear();
 
   vector<xmlrpc_c::value> weight_vector_ret;
   for (size_t i=0; i < weight_vector.size(); i++)
@@ -3,14 +3,16 @@
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
+#include "ResultCache.h"
 
 namespace MosesServer
 {
 class
   Optimizer : public xmlrpc_c::method
 {
+  ResultCache& m_result_cache;
 public:
-  Optimizer();
+  Optimizer(ResultCache& result_cache);
   void execute(xmlrpc_c::paramList const& paramList,
                xmlrpc_c::value *   const  retvalP);
 };
@@ -0,0 +1,172 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "ResultCache.h"
+#include <cctype>
+#include <sstream>
+#include <vector>
+
+namespace MosesServer
+{
+  using namespace std;
+
+  namespace
+  {
+    // appends a canonical form of v; false for types we do not key on
+    bool
+    serialize(xmlrpc_c::value const& v, ostringstream& out)
+    {
+      switch (v.type())
+        {
+        case xmlrpc_c::value::TYPE_INT:
+          out << 'i' << int(xmlrpc_c::value_int(v));
+          return true;
+        case xmlrpc_c::value::TYPE_I8:
+          out << 'l' << (long long)(xmlrpc_c::value_i8(v));
+          return true;
+        case xmlrpc_c::value::TYPE_BOOLEAN:
+          out << 'b' << bool(xmlrpc_c::value_boolean(v));
+          return true;
+        case xmlrpc_c::value::TYPE_DOUBLE:
+          out << 'd' << double(xmlrpc_c::value_double(v));
+          return true;
+        case xmlrpc_c::value::TYPE_STRING:
+          {
+            string s = xmlrpc_c::value_string(v);
+            out << 's' << s.size() << ':' << s;
+            return true;
+          }
+        case xmlrpc_c::value::TYPE_ARRAY:
+          {
+            vector<xmlrpc_c::value> a = xmlrpc_c::value_array(v).vectorValueValue();
+            out << 'a' << a.size() << '[';
+            for (size_t i = 0; i < a.size(); ++i)
+              if (!serialize(a[i], out)) return false;
+            out << ']';
+            return true;
+          }
+        case xmlrpc_c::value::TYPE_STRUCT:
+          {
+            ResultCache::params_t m = xmlrpc_c::value_struct(v);
+            out << 'm' << m.size() << '{';
+            for (ResultCache::params_t::const_iterator i = m.begin(); i != m.end(); ++i)
+              {
+                out << i->first.size() << ':' << i->first;
+                if (!serialize(i->second, out)) return false;
+              }
+            out << '}';
+            return true;
+          }
+        default:
+          return false;
+        }
+    }
+  }
+
+  ResultCache::
+  ResultCache(size_t capacity)
+    : m_capacity(capacity), m_generation(0), m_hits(0), m_misses(0)
+  { }
+
+  bool
+  ResultCache::
+  key(params_t const& params, string& key)
+  {
+    params_t::const_iterator si = params.find("text");
+    if (si == params.end()) return false;
+
+    // the output of a request in a session depends on the session's context
+    // and scope, which earlier requests change, so it is not repeatable
+    if (params.count("session-id")) return false;
+
+    ostringstream out;
+    out.precision(17);
+
+    // collapse runs of white space, as the input is tokenized on it anyway
+    string text = xmlrpc_c::value_string(si->second);
+    bool space = false;
+    for (size_t i = 0; i < text.size(); ++i)
+      {
+        if (isspace(static_cast<unsigned char>(text[i])))
+          space = true;
+        else
+          {
+            if (space && out.tellp() > 0) out << ' ';
+            out << text[i];
+            space = false;
+          }
+      }
+    out << '\n';
+
+    // scheduling parameters do not change the output
+    for (si = params.begin(); si != params.end(); ++si)
+      {
+        if (si->first == "text" || si->first == "priority"
+            || si->first == "deadline")
+          continue;
+        out << si->first.size() << ':' << si->first;
+        if (!serialize(si->second, out)) return false;
+      }
+    key = out.str();
+    return true;
+  }
+
+  bool
+  ResultCache::
+  get(string const& key, params_t& result, uint64_t& generation)
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    generation = m_generation;
+    boost::unordered_map<string, Entry>::iterator m = m_entries.find(key);
+    if (m == m_entries.end())
+      {
+        ++m_misses;
+        return false;
+      }
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, m->second.position);
+    result = m->second.result;
+    return true;
+  }
+
+  void
+  ResultCache::
+  put(string const& key, params_t const& result, uint64_t generation)
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    if (generation != m_generation || m_entries.count(key)) return;
+    while (m_entries.size() >= m_capacity)
+      {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+      }
+    m_lru.push_front(key);
+    Entry& e = m_entries[key];
+    e.result = result;
+    e.position = m_lru.begin();
+  }
+
+  void
+  ResultCache::
+  clear()
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    ++m_generation;
+    m_entries.clear();
+    m_lru.clear();
+  }
+
+  uint64_t
+  ResultCache::
+  hits() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    return m_hits;
+  }
+
+  uint64_t
+  ResultCache::
+  misses() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    return m_misses;
+  }
+}
@@ -0,0 +1,59 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <xmlrpc-c/base.hpp>
+
+namespace MosesServer
+{
+  // Exact-match cache of translation responses. A request is keyed on its
+  // source text with whitespace normalized and on every other request
+  // parameter that can change the output (options, weights, context), so
+  // that only truly identical requests share an entry. Requests in a
+  // session are never cached. The least recently used entry is dropped when
+  // the cache is full.
+  class ResultCache
+  {
+  public:
+    typedef std::map<std::string, xmlrpc_c::value> params_t;
+
+    ResultCache(size_t capacity);
+
+    //! false if requests with these parameters must always be decoded
+    static bool key(params_t const& params, std::string& key);
+
+    //! generation is set to the one to pass to put() after decoding
+    bool get(std::string const& key, params_t& result, uint64_t& generation);
+    void put(std::string const& key, params_t const& result,
+             uint64_t generation);
+
+    //! drop everything, e.g. after the model or weights changed
+    void clear();
+
+    bool enabled() const { return m_capacity > 0; }
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+  private:
+    typedef std::list<std::string> lru_t;
+    struct Entry
+    {
+      params_t result;
+      lru_t::iterator position;
+    };
+
+    size_t m_capacity;
+    mutable boost::mutex m_lock;
+    boost::unordered_map<std::string, Entry> m_entries;
+    lru_t m_lru; // most recently used first
+    // bumped by clear(), so that a decode that started before an update
+    // does not store its stale result
+    uint64_t m_generation;
+    uint64_t m_hits, m_misses;
+  };
+}
@@ -7,15 +7,18 @@ namespace MosesServer
   Server::
   Server(Moses::Parameter& params)
     : m_server_options(params),
-      m_updater(new Updater),
-      m_optimizer(new Optimizer),
+      m_result_cache(m_server_options.resultCacheSize),
+      m_updater(new Updater(m_result_cache)),
+      m_optimizer(new Optimizer(m_result_cache)),
       m_translator(new Translator(*this)),
-      m_close_session(new CloseSession(*this))
+      m_close_session(new CloseSession(*this)),
+      m_metrics(new MetricsReporter(*this))
   {
     m_registry.addMethod("translate", m_translator);
     m_registry.addMethod("updater",   m_updater);
     m_registry.addMethod("optimize",  m_optimizer);
     m_registry.addMethod("close_session", m_close_session);
+    m_registry.addMethod("metrics", m_metrics);
   }
 
   Server::
@@ -73,6 +76,13 @@ namespace MosesServer
     return m_session_cache[session_id];
   }
 
+  ResultCache&
+  Server::
+  result_cache()
+  {
+    return m_result_cache;
+  }
+
   void
   Server::
   delete_session(uint64_t const session_id)
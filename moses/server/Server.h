@@ -14,7 +14,9 @@
 #include "Optimizer.h"
 #include "Updater.h"
 #include "CloseSession.h"
+#include "MetricsReporter.h"
 #include "Session.h"
+#include "ResultCache.h"
 #include "moses/parameters/ServerOptions.h"
 #include <string>
 
@@ -24,11 +26,13 @@ namespace MosesServer
   {
     Moses::ServerOptions m_server_options;
     SessionCache   m_session_cache;
+    ResultCache    m_result_cache;
     xmlrpc_c::registry m_registry;
     xmlrpc_c::methodPtr const m_updater;
     xmlrpc_c::methodPtr const m_optimizer;
     xmlrpc_c::methodPtr const m_translator;
     xmlrpc_c::methodPtr const m_close_session;
+    xmlrpc_c::methodPtr const m_metrics;
     std::string m_pidfile;
   public:
     Server(Moses::Parameter& params);
@@ -42,5 +46,8 @@ namespace MosesServer
     Session const& 
     get_session(uint64_t session_id);
 
+    ResultCache&
+    result_cache();
+
   };
 }
@@ -4,6 +4,9 @@
 #include <boost/foreach.hpp>
 #include "moses/Util.h"
 #include "moses/Hypothesis.h"
+#include "moses/Metrics.h"
+#include "util/usage.hh"
+#include <algorithm>
 
 namespace MosesServer
 {
@@ -55,6 +58,16 @@ void
 TranslationRequest::
 Run()
 {
+  if (m_deadline && util::WallTime() >= m_deadline) {
+    m_expired = true;
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_done = true;
+    }
+    m_cond.notify_one();
+    return;
+  }
+
   typedef std::map<std::string,xmlrpc_c::value> param_t;
   param_t const& params = m_paramList.getStruct(0);
   parse_request(params);
@@ -229,9 +242,20 @@ TranslationRequest::
 TranslationRequest(xmlrpc_c::paramList const& paramList,
                    boost::condition_variable& cond, boost::mutex& mut)
   : m_cond(cond), m_mutex(mut), m_done(false), m_paramList(paramList)
-  , m_session_id(0)
+  , m_session_id(0), m_priority(0), m_deadline(0), m_budget(0)
+  , m_expired(false)
 { 
-
+  typedef std::map<std::string,xmlrpc_c::value> param_t;
+  param_t const& params = paramList.getStruct(0);
+  param_t::const_iterator si = params.find("priority");
+  if (si != params.end())
+    m_priority = xmlrpc_c::value_int(si->second);
+  // the deadline is given in milliseconds from the arrival of the request
+  si = params.find("deadline");
+  if (si != params.end()) {
+    m_budget = xmlrpc_c::value_int(si->second) / 1000.0;
+    m_deadline = util::WallTime() + m_budget;
+  }
 }
 
 bool
@@ -276,6 +300,17 @@ parse_request(std::map<std::string, xmlrpc_c::value> const& params)
   boost::shared_ptr<Moses::AllOptions> opts(new Moses::AllOptions(*StaticData::Instance().options()));
   opts->update(params);
 
+  // with less than half of the time budget left, shrink the search in
+  // proportion so that the answer still arrives in time
+  if (m_deadline) {
+    double left = m_deadline - util::WallTime();
+    if (left < m_budget / 2) {
+      double scale = std::max(2 * left / m_budget, 0.1);
+      opts->search.stack_size = std::max<size_t>(opts->search.stack_size * scale, 1);
+      opts->cube.pop_limit = std::max<size_t>(opts->cube.pop_limit * scale, 1);
+    }
+  }
+
   m_withGraphInfo = check(params, "sg");
   if (m_withGraphInfo || opts->nbest.nbest_size > 0) {
     opts->output.SearchGraph = "true";
@@ -512,13 +547,19 @@ run_phrase_decoder()
 {
   Manager manager(this->self());
   manager.Decode();
-  pack_hypothesis(manager, manager.GetBestHypothesis(), "text", m_retData);
-  if (m_session_id)
-    m_retData["session-id"] = xmlrpc_c::value_int(m_session_id);
+  {
+    Moses::MetricsTimer timer(Moses::Metrics::Output);
+    pack_hypothesis(manager, manager.GetBestHypothesis(), "text", m_retData);
+    if (m_session_id)
+      m_retData["session-id"] = xmlrpc_c::value_int(m_session_id);
   
-  if (m_withGraphInfo) insertGraphInfo(manager,m_retData);
-  if (m_withTopts) insertTranslationOptions(manager,m_retData);
-  if (m_options->nbest.nbest_size) outputNBest(manager, m_retData);
+    if (m_withGraphInfo) insertGraphInfo(manager,m_retData);
+    if (m_withTopts) insertTranslationOptions(manager,m_retData);
+  }
+  if (m_options->nbest.nbest_size) {
+    Moses::MetricsTimer timer(Moses::Metrics::NBest);
+    outputNBest(manager, m_retData);
+  }
 
 }
 }
@@ -45,6 +45,13 @@ TranslationRequest : public virtual Moses::TranslationTask
   bool m_withScoreBreakdown;
   uint64_t m_session_id; // 0 means none, 1 means new
 
+  // scheduling: a higher priority is dequeued first; a request whose
+  // deadline (wall time in seconds, 0 for none) passes while queued is
+  // dropped, one that starts late searches with smaller limits
+  int m_priority;
+  double m_deadline, m_budget;
+  bool m_expired;
+
   void
   parse_request();
 
@@ -114,6 +121,17 @@ public:
     return m_done;
   }
 
+  //! the deadline passed before decoding started
+  bool
+  IsExpired() const {
+    return m_expired;
+  }
+
+  int
+  GetPriority() const {
+    return m_priority;
+  }
+
   std::map<std::string, xmlrpc_c::value> const&
   GetRetData() {
     return m_retData;
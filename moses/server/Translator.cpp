@@ -27,6 +27,22 @@ Translator::
 execute(xmlrpc_c::paramList const& paramList,
         xmlrpc_c::value *   const  retvalP)
 {
+  ResultCache& cache = m_server.result_cache();
+  std::string key;
+  uint64_t generation = 0;
+  bool cacheable = cache.enabled() && ResultCache::key(paramList.getStruct(0), key);
+  if (cacheable) {
+    ResultCache::params_t result;
+    bool hit = cache.get(key, result, generation);
+    XVERBOSE(2, "Result cache " << (hit ? "hit" : "miss") << ", "
+             << cache.hits() << " hits, " << cache.misses() << " misses"
+             << std::endl);
+    if (hit) {
+      *retvalP = xmlrpc_c::value_struct(result);
+      return;
+    }
+  }
+
   boost::condition_variable cond;
   boost::mutex mut;
   boost::shared_ptr<TranslationRequest> task;
@@ -35,6 +51,11 @@ execute(xmlrpc_c::paramList const& paramList,
   boost::unique_lock<boost::mutex> lock(mut);
   while (!task->IsDone())
     cond.wait(lock);
+  if (task->IsExpired())
+    throw xmlrpc_c::fault("Deadline exceeded before translation started",
+                          xmlrpc_c::fault::CODE_TIMEOUT);
+  if (cacheable)
+    cache.put(key, task->GetRetData(), generation);
   *retvalP = xmlrpc_c::value_struct(task->GetRetData());
 }
 
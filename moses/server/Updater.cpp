@@ -7,7 +7,8 @@ using namespace Moses;
 using namespace std;
 
 Updater::
-Updater()
+Updater(ResultCache& result_cache)
+  : m_result_cache(result_cache)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
@@ -25,7 +26,10 @@ execute(xmlrpc_c::paramList const& paramList,
   const params_t params = paramList.getStruct(0);
   breakOutParams(params);
   Mmsapt* pdsa = reinterpret_cast<Mmsapt*>(PhraseDictionary::GetColl()[0]);
-  pdsa->add(m_src, m_trg, m_aln);
+  // with "wait", the pair is in the table when the call returns, and no
+  // translation cached before it can come back
+  pdsa->add(m_src, m_trg, m_aln, m_wait);
+  m_result_cache.clear();
   XVERBOSE(1,"Done inserting\n");
   *retvalP = xmlrpc_c::value_string("Phrase table updated");
 #endif
@@ -53,6 +57,7 @@ breakOutParams(const params_t& params)
   XVERBOSE(1,"alignment = " << m_aln << endl);
   m_bounded  = ((si = params.find("bounded")) != params.end());
   m_add2ORLM = ((si = params.find("updateORLM")) != params.end());
+  m_wait     = ((si = params.find("wait")) != params.end());
 };
 
 }
@@ -15,6 +15,7 @@
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
+#include "ResultCache.h"
 
 
 namespace MosesServer
@@ -27,10 +28,11 @@ class
 
 
   std::string m_src, m_trg, m_aln;
-  bool m_bounded, m_add2ORLM;
+  bool m_bounded, m_add2ORLM, m_wait;
+  ResultCache& m_result_cache;
 
 public:
-  Updater();
+  Updater(ResultCache& result_cache);
 
   void
   execute(xmlrpc_c::paramList const& paramList,
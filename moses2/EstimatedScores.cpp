@@ -36,23 +36,18 @@ namespace Moses2
 
 float EstimatedScores::CalcEstimatedScore(Bitmap const &bitmap) const
 {
-  const size_t notInGap = numeric_limits<size_t>::max();
-  size_t startGap = notInGap;
+  // jump from each gap to the next translated word and on to the next gap
   float estimatedScore = 0.0f;
-  for (size_t currPos = 0; currPos < bitmap.GetSize(); currPos++) {
-    // start of a new gap?
-    if (bitmap.GetValue(currPos) == false && startGap == notInGap) {
-      startGap = currPos;
-    }
-    // end of a gap?
-    else if (bitmap.GetValue(currPos) == true && startGap != notInGap) {
-      estimatedScore += GetValue(startGap, currPos - 1);
-      startGap = notInGap;
+  size_t startGap = bitmap.GetFirstGapPos();
+  while (startGap != NOT_FOUND) {
+    size_t endGap = bitmap.GetNextPos(startGap);
+    if (endGap == NOT_FOUND) {
+      // coverage ending with gap
+      estimatedScore += GetValue(startGap, bitmap.GetSize() - 1);
+      break;
     }
-  }
-  // coverage ending with gap?
-  if (startGap != notInGap) {
-    estimatedScore += GetValue(startGap, bitmap.GetSize() - 1);
+    estimatedScore += GetValue(startGap, endGap - 1);
+    startGap = bitmap.GetNextGapPos(endGap);
   }
 
   return estimatedScore;
@@ -20,6 +20,8 @@
 #include "../../PhraseBased/TargetPhraseImpl.h"
 #include "../../legacy/InputFileStream.h"
 #include "../../legacy/Util2.h"
+#include "probingpt/hash.h"
+#include "probingpt/reordering.h"
 
 #ifdef HAVE_CMPH
 #include "../../TranslationModel/CompactPT/LexicalReorderingTableCompact.h"
@@ -42,6 +44,8 @@ LexicalReordering::LexicalReordering(size_t startInd, const std::string &line)
 #ifdef HAVE_CMPH
   , m_compactModel(NULL)
 #endif
+  , m_probingModel(NULL)
+  , m_loadMethod(util::POPULATE_OR_LAZY)
 {
   ReadParameters();
   assert(m_configuration);
@@ -55,6 +59,7 @@ LexicalReordering::~LexicalReordering()
 #ifdef HAVE_CMPH
   delete m_compactModel;
 #endif
+  delete m_probingModel;
 }
 
 void LexicalReordering::Load(System &system)
@@ -63,6 +68,18 @@ void LexicalReordering::Load(System &system)
 
   if (m_propertyInd >= 0) {
     // Using integrate Lex RO. No loading needed
+  } else if (FileExists(m_path + ".probinglr")) {
+    // mapped, not loaded, so processes on a machine share one copy
+    m_probingModel = new probingpt::ReorderingTable(m_path + ".probinglr",
+        m_loadMethod);
+    UTIL_THROW_IF2(m_probingModel->GetNumScores() != m_numScores,
+                   m_path << ".probinglr has " << m_probingModel->GetNumScores()
+                   << " scores, expected " << m_numScores);
+    // the text model logs and floors every score, so a table of raw
+    // probabilities would silently give different scores
+    UTIL_THROW_IF2(!m_probingModel->IsLogProb(),
+                   m_path << ".probinglr holds raw probabilities. "
+                   << "Rebuild it with CreateProbingLR without --raw-prob");
 #ifdef HAVE_CMPH
   } else if (FileExists(m_path + ".minlexr")) {
     m_compactModel = new LexicalReorderingTableCompact(m_path + ".minlexr",
@@ -110,6 +127,18 @@ void LexicalReordering::SetParameter(const std::string& key,
     m_FactorsE = Tokenize<FactorType>(value);
   } else if (key == "property-index") {
     m_propertyInd = Scan<int>(value);
+  } else if (key == "load") {
+    if (value == "lazy") {
+      m_loadMethod = util::LAZY;
+    } else if (value == "populate_or_lazy") {
+      m_loadMethod = util::POPULATE_OR_LAZY;
+    } else if (value == "populate_or_read" || value == "populate") {
+      m_loadMethod = util::POPULATE_OR_READ;
+    } else if (value == "read") {
+      m_loadMethod = util::READ;
+    } else {
+      UTIL_THROW2("load method not supported" << value);
+    }
   } else {
     StatefulFeatureFunction::SetParameter(key, value);
   }
@@ -148,6 +177,36 @@ void LexicalReordering::EvaluateInIsolation(MemPool &pool, const System &system,
 void LexicalReordering::EvaluateAfterTablePruning(MemPool &pool,
     const TargetPhrases &tps, const Phrase<Moses2::Word> &sourcePhrase) const
 {
+  if (m_probingModel) {
+    // hash every target phrase first and prefetch its bucket, so that the
+    // cache misses on a large mapped table overlap instead of queueing up
+    std::vector<uint64_t> ids;
+    GetProbingIDs(sourcePhrase, m_FactorsF, ids);
+    uint64_t sourceKey = probingpt::getLRSourceKey(ids.data(), ids.size());
+
+    uint64_t *keys = pool.Allocate<uint64_t>(tps.GetSize());
+    size_t i = 0;
+    BOOST_FOREACH(const TargetPhraseImpl *tp, tps) {
+      GetProbingIDs(*tp, m_FactorsE, ids);
+      keys[i] = probingpt::getLRKey(sourceKey, ids.data(), ids.size());
+      m_probingModel->Prefetch(keys[i]);
+      ++i;
+    }
+
+    i = 0;
+    BOOST_FOREACH(const TargetPhraseImpl *tp, tps) {
+      const float *values = m_probingModel->Find(keys[i++]);
+      if (values) {
+        SCORE *scoreArr = pool.Allocate<SCORE>(m_numScores);
+        std::copy(values, values + m_numScores, scoreArr);
+        tp->ffData[m_PhraseTableInd] = scoreArr;
+      } else {
+        tp->ffData[m_PhraseTableInd] = NULL;
+      }
+    }
+    return;
+  }
+
   BOOST_FOREACH(const TargetPhraseImpl *tp, tps) {
     EvaluateAfterTablePruning(pool, *tp, sourcePhrase);
   }
@@ -216,6 +275,25 @@ const LexicalReordering::Values *LexicalReordering::GetValues(
   }
 }
 
+void LexicalReordering::GetProbingIDs(const Phrase<Moses2::Word> &phrase,
+                                      const FactorList &factors, std::vector<uint64_t> &ids) const
+{
+  // the vocab ids of probingpt: the sum of the hashes of the factors
+  size_t size = phrase.GetSize();
+  ids.resize(size);
+  for (size_t pos = 0; pos < size; ++pos) {
+    const Word &word = phrase[pos];
+    uint64_t id = 0;
+    if (factors.empty()) {
+      id = probingpt::getHash(word[0]->GetString());
+    }
+    for (size_t i = 0; i < factors.size(); ++i) {
+      id += probingpt::getHash(word[factors[i]]->GetString());
+    }
+    ids[pos] = id;
+  }
+}
+
 void LexicalReordering::EvaluateWhenApplied(const SCFG::Manager &mgr,
     const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
     FFState &state) const
@@ -12,6 +12,12 @@
 #include "../../TypeDef.h"
 #include "../../Phrase.h"
 #include "../../legacy/Range.h"
+#include "util/mmap.hh"
+
+namespace probingpt
+{
+class ReorderingTable;
+}
 
 namespace Moses2
 {
@@ -80,6 +86,13 @@ protected:
   LexicalReorderingTableCompact *m_compactModel;
 #endif
 
+  // PROBING MODEL
+  probingpt::ReorderingTable *m_probingModel;
+  util::LoadMethod m_loadMethod;
+
+  void GetProbingIDs(const Phrase<Moses2::Word> &phrase,
+                     const FactorList &factors, std::vector<uint64_t> &ids) const;
+
   Phrase<Moses2::Word> *m_blank;
 
   // MEMORY MODEL
@@ -1,9 +1,116 @@
 #include "KenOSM.h"
 
+#include <boost/lexical_cast.hpp>
+#include "../../System.h"
+#include "../../legacy/FactorCollection.h"
+#include "util/murmur_hash.hh"
+#include "util/tokenize_piece.hh"
+
 namespace Moses2
 {
 
-OSMLM* ConstructOSMLM(const char *file, util::LoadMethod load_method)
+namespace
+{
+// Jumps back over fewer gaps have their ids looked up when loading
+const int kIndexedJumpBacks = 64;
+
+// The operation as the decoder composes it: the target words, then the
+// source words, both by factor id
+uint64_t OperationKey(KenOSMBase::WordOperation op,
+                      const std::vector<size_t> &english,
+                      const std::vector<size_t> &german)
+{
+  uint64_t key = util::MurmurHashNative(english.empty() ? NULL : &english[0],
+                                        english.size() * sizeof(size_t), op);
+  key = util::MurmurHashNative(german.empty() ? NULL : &german[0],
+                               german.size() * sizeof(size_t), key);
+  // 0 marks empty entries of the table
+  return key ? key : 1;
+}
+
+// Factor ids of the words of a cept, which are joined by ^_^
+void CeptFactors(StringPiece cept, const System &system, std::vector<size_t> &out)
+{
+  FactorCollection &factors = system.GetVocab();
+  out.clear();
+  for (util::TokenIter<util::MultiCharacter> word(cept, util::MultiCharacter("^_^")); word; ++word) {
+    out.push_back(factors.AddFactor(*word, system, false)->GetId());
+  }
+}
+}
+
+KenOSMBase::KenOSMBase(const System &system)
+  : m_system(system)
+  , m_translateSelfFactor(system.GetVocab().AddFactor("_TRANS_SLF_", system, false)->GetId())
+{
+}
+
+void KenOSMBase::IndexOperations()
+{
+  m_insertGap = Index("_INS_GAP_");
+  m_jumpForward = Index("_JMP_FWD_");
+  m_continueCept = Index("_CONT_CEPT_");
+  m_translateSelf = Index("_TRANS_SLF_");
+  m_jumpBack.resize(kIndexedJumpBacks);
+  for (int gaps = 0; gaps < kIndexedJumpBacks; ++gaps) {
+    m_jumpBack[gaps] = Index("_JMP_BCK_" + boost::lexical_cast<std::string>(gaps));
+  }
+}
+
+lm::WordIndex KenOSMBase::JumpBack(int gaps) const
+{
+  if (gaps >= 0 && gaps < static_cast<int>(m_jumpBack.size())) {
+    return m_jumpBack[gaps];
+  }
+  return Index("_JMP_BCK_" + boost::lexical_cast<std::string>(gaps));
+}
+
+void KenOSMBase::Add(lm::WordIndex index, const StringPiece &str)
+{
+  if (str.starts_with("_TRANS_")) {
+    const StringPiece cepts = str.substr(7);
+    // the words may contain _TO_ too, so the operation is entered for each
+    // way of reading it, as each would compose to this operation
+    for (size_t to = cepts.find("_TO_"); to != StringPiece::npos; to = cepts.find("_TO_", to + 1)) {
+      CeptFactors(cepts.substr(0, to), m_system, m_english);
+      CeptFactors(cepts.substr(to + 4), m_system, m_german);
+      AddWordOperation(Translate, index);
+    }
+  } else if (str.starts_with("_INS_")) {
+    m_english.clear();
+    m_german.assign(1, m_system.GetVocab().AddFactor(str.substr(5), m_system, false)->GetId());
+    AddWordOperation(Insert, index);
+  } else if (str.starts_with("_DEL_")) {
+    m_english.assign(1, m_system.GetVocab().AddFactor(str.substr(5), m_system, false)->GetId());
+    m_german.clear();
+    AddWordOperation(Delete, index);
+  }
+}
+
+void KenOSMBase::AddWordOperation(WordOperation op, lm::WordIndex index)
+{
+  OperationEntry entry;
+  entry.key = OperationKey(op, m_english, m_german);
+  entry.index = index;
+  OperationTable::MutableIterator it;
+  if (m_wordOperations.FindOrInsert(entry, it)) {
+    it->index = index;
+  }
+}
+
+lm::WordIndex KenOSMBase::Index(WordOperation op,
+                                const std::vector<size_t> &english,
+                                const std::vector<size_t> &german) const
+{
+  OperationTable::ConstIterator it;
+  if (m_wordOperations.Find(OperationKey(op, english, german), it)) {
+    return it->index;
+  }
+  return 0; // <unk>
+}
+
+OSMLM* ConstructOSMLM(const char *file, util::LoadMethod load_method,
+                      const System &system)
 {
   lm::ngram::ModelType model_type;
   lm::ngram::Config config;
@@ -11,22 +118,22 @@ OSMLM* ConstructOSMLM(const char *file, util::LoadMethod load_method)
   if (lm::ngram::RecognizeBinary(file, model_type)) {
     switch(model_type) {
     case lm::ngram::PROBING:
-      return new KenOSM<lm::ngram::ProbingModel>(file, config);
+      return new KenOSM<lm::ngram::ProbingModel>(file, config, system);
     case lm::ngram::REST_PROBING:
-      return new KenOSM<lm::ngram::RestProbingModel>(file, config);
+      return new KenOSM<lm::ngram::RestProbingModel>(file, config, system);
     case lm::ngram::TRIE:
-      return new KenOSM<lm::ngram::TrieModel>(file, config);
+      return new KenOSM<lm::ngram::TrieModel>(file, config, system);
     case lm::ngram::QUANT_TRIE:
-      return new KenOSM<lm::ngram::QuantTrieModel>(file, config);
+      return new KenOSM<lm::ngram::QuantTrieModel>(file, config, system);
     case lm::ngram::ARRAY_TRIE:
-      return new KenOSM<lm::ngram::ArrayTrieModel>(file, config);
+      return new KenOSM<lm::ngram::ArrayTrieModel>(file, config, system);
     case lm::ngram::QUANT_ARRAY_TRIE:
-      return new KenOSM<lm::ngram::QuantArrayTrieModel>(file, config);
+      return new KenOSM<lm::ngram::QuantArrayTrieModel>(file, config, system);
     default:
       UTIL_THROW2("Unrecognized kenlm model type " << model_type);
     }
   } else {
-    return new KenOSM<lm::ngram::ProbingModel>(file, config);
+    return new KenOSM<lm::ngram::ProbingModel>(file, config, system);
   }
 }
 
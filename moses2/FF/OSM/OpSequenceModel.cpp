@@ -34,7 +34,7 @@ OpSequenceModel::~OpSequenceModel()
 
 void OpSequenceModel::Load(System &system)
 {
-  readLanguageModel(m_lmPath.c_str());
+  readLanguageModel(m_lmPath.c_str(), system);
 }
 
 FFState* OpSequenceModel::BlankState(MemPool &pool, const System &sys) const
@@ -52,51 +52,64 @@ void OpSequenceModel::EmptyHypothesisState(FFState &state,
   stateCast.setState(startState);
 }
 
+osmHypothesis &OpSequenceModel::GetHypothesis() const
+{
+  osmHypothesis *obj = m_hypothesis.get();
+  if (obj == NULL) {
+    obj = new osmHypothesis(*OSM);
+    m_hypothesis.reset(obj);
+  } else {
+    obj->clear();
+  }
+  return *obj;
+}
+
+void OpSequenceModel::SetTargetPhrase(osmHypothesis &obj, const System &system,
+                                      const TargetPhrase<Moses2::Word> &target) const
+{
+  vector <size_t> &myTargetPhrase = obj.targetPhrase();
+  for (size_t i = 0; i < target.GetSize(); i++) {
+    if (&target.pt == system.featureFunctions.GetUnknownWordPenalty() && sFactor == 0 && tFactor == 0)
+      myTargetPhrase.push_back(OSM->TranslateSelfFactor());
+    else
+      myTargetPhrase.push_back(target[i][tFactor]->GetId());
+  }
+
+  const AlignmentInfo &align = target.GetAlignTerm();
+  AlignmentInfo::const_iterator iter;
+
+  for (iter = align.begin(); iter != align.end(); ++iter) {
+    obj.addAlignment(iter->first, iter->second);
+  }
+}
+
 void OpSequenceModel::EvaluateInIsolation(MemPool &pool,
     const System &system, const Phrase<Moses2::Word> &source,
     const TargetPhraseImpl &targetPhrase, Scores &scores,
     SCORE &estimatedScore) const
 {
-  osmHypothesis obj;
+  osmHypothesis &obj = GetHypothesis();
   obj.setState(OSM->NullContextState());
 
   Bitmap myBitmap (pool, source.GetSize());
   myBitmap.Init(std::vector<bool>());
 
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
-  vector<float> scoresVec;
-  vector <int> alignments;
   int startIndex = 0;
   int endIndex = source.GetSize();
 
-  const AlignmentInfo &align = targetPhrase.GetAlignTerm();
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-  for (size_t i = 0; i < targetPhrase.GetSize(); i++) {
-    if (&targetPhrase.pt == system.featureFunctions.GetUnknownWordPenalty() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(targetPhrase[i][tFactor]->GetString().as_string());
-  }
+  SetTargetPhrase(obj, system, targetPhrase);
 
+  vector <size_t> &mySourcePhrase = obj.sourcePhrase();
   for (size_t i = 0; i < source.GetSize(); i++) {
-    mySourcePhrase.push_back(source[i][sFactor]->GetString().as_string());
+    mySourcePhrase.push_back(source[i][sFactor]->GetId());
   }
 
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
-  obj.constructCepts(alignments,startIndex,endIndex-1,targetPhrase.GetSize());
+  obj.constructCepts(startIndex,endIndex-1,targetPhrase.GetSize());
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
-  obj.populateScores(scoresVec,numFeatures);
 
   SCORE weightedScore = Scores::CalcWeightedScore(system, *this,
-                        scoresVec.data());
+                        obj.populateScores(numFeatures).data());
   estimatedScore += weightedScore;
 
 }
@@ -118,81 +131,29 @@ void OpSequenceModel::EvaluateWhenApplied(const ManagerBase &mgr,
   const ManagerBase &manager = hypo.GetManager();
   const InputType &source = manager.GetInput();
   const Sentence &sourceSentence = static_cast<const Sentence&>(source);
-
-  osmHypothesis obj;
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
-  vector<float> scoresVec;
-
-
-  //target.GetWord(0)
-
-  //cerr << target <<" --- "<<target.GetSourcePhrase()<< endl;  // English ...
-
-  //cerr << align << endl;   // Alignments ...
-  //cerr << cur_hypo.GetCurrSourceWordsRange() << endl;
-
-  //cerr << source <<endl;
-
-// int a = sourceRange.GetStartPos();
-// cerr << source.GetWord(a);
-  //cerr <<a<<endl;
-
-  //const Sentence &sentence = static_cast<const Sentence&>(curr_hypo.GetManager().GetSource());
-
+  osmHypothesis &obj = GetHypothesis();
 
   const Range & sourceRange = hypo.GetInputPath().range;
   int startIndex  = sourceRange.GetStartPos();
   int endIndex = sourceRange.GetEndPos();
-  const AlignmentInfo &align = hypo.GetTargetPhrase().GetAlignTerm();
-  // osmState * statePtr;
-
-  vector <int> alignments;
-
-
-
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    //cerr << iter->first << "----" << iter->second << " ";
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-
-  //cerr<<bitmap<<endl;
-  //cerr<<startIndex<<" "<<endIndex<<endl;
 
+  SetTargetPhrase(obj, mgr.system, target);
 
+  vector <size_t> &mySourcePhrase = obj.sourcePhrase();
   for (int i = startIndex; i <= endIndex; i++) {
     myBitmap.SetValue(i,0); // resetting coverage of this phrase ...
-    mySourcePhrase.push_back(sourceSentence[i][sFactor]->GetString().as_string());
-    // cerr<<mySourcePhrase[i]<<endl;
-  }
-
-  for (size_t i = 0; i < target.GetSize(); i++) {
-    if (&target.pt == mgr.system.featureFunctions.GetUnknownWordPenalty() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(target[i][tFactor]->GetString().as_string());
-
+    mySourcePhrase.push_back(sourceSentence[i][sFactor]->GetId());
   }
 
-
-  //cerr<<myBitmap<<endl;
-
   obj.setState(&prevState);
-  obj.constructCepts(alignments,startIndex,endIndex,target.GetSize());
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
+  obj.constructCepts(startIndex,endIndex,target.GetSize());
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
-  obj.populateScores(scoresVec,numFeatures);
-  //obj.print();
 
-  scores.PlusEquals(mgr.system, *this, scoresVec);
+  scores.PlusEquals(mgr.system, *this, obj.populateScores(numFeatures));
 
   osmState &stateCast = static_cast<osmState&>(state);
-  obj.saveState(stateCast);
+  obj.saveState(stateCast, mgr.GetPool());
 }
 
 void OpSequenceModel::EvaluateWhenApplied(const SCFG::Manager &mgr,
@@ -235,10 +196,10 @@ void OpSequenceModel::SetParameter(const std::string& key, const std::string& va
   }
 }
 
-void OpSequenceModel :: readLanguageModel(const char *lmFile)
+void OpSequenceModel :: readLanguageModel(const char *lmFile, const System &system)
 {
   string unkOp = "_TRANS_SLF_";
-  OSM = ConstructOSMLM(m_lmPath.c_str(), load_method);
+  OSM = ConstructOSMLM(m_lmPath.c_str(), load_method, system);
 
   lm::ngram::State startState = OSM->NullContextState();
   lm::ngram::State endState;
@@ -1,9 +1,11 @@
+#include <boost/thread/tss.hpp>
 #include "../StatefulFeatureFunction.h"
 #include "util/mmap.hh"
 #include "KenOSM.h"
 
 namespace Moses2
 {
+class osmHypothesis;
 
 
 class OpSequenceModel : public StatefulFeatureFunction
@@ -48,7 +50,13 @@ public:
 protected:
   std::string m_lmPath;
 
-  void readLanguageModel(const char *);
+  // reused by the phrases a thread scores
+  mutable boost::thread_specific_ptr<osmHypothesis> m_hypothesis;
+
+  osmHypothesis &GetHypothesis() const;
+  void SetTargetPhrase(osmHypothesis &obj, const System &system,
+                       const TargetPhrase<Moses2::Word> &target) const;
+  void readLanguageModel(const char *, const System &system);
 
 };
 
@@ -1,4 +1,5 @@
 #include "osmHyp.h"
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
@@ -10,13 +11,17 @@ void osmState::setState(const lm::ngram::State & val)
 {
   j = 0;
   E = 0;
+  gap = NULL;
+  gapSize = 0;
   lmState = val;
 }
 
-void osmState::saveState(int jVal, int eVal, map <int , string> & gapVal)
+void osmState::saveState(int jVal, int eVal, const vector <int> & gapVal, MemPool &pool)
 {
-  gap.clear();
-  gap = gapVal;
+  gapSize = gapVal.size();
+  int *copy = pool.Allocate<int>(gapSize);
+  std::copy(gapVal.begin(), gapVal.end(), copy);
+  gap = copy;
   j = jVal;
   E = eVal;
 }
@@ -26,7 +31,7 @@ size_t osmState::hash() const
   size_t ret = j;
 
   boost::hash_combine(ret, E);
-  boost::hash_combine(ret, gap);
+  boost::hash_range(ret, gap, gap + gapSize);
   boost::hash_combine(ret, lmState.length);
 
   return ret;
@@ -39,7 +44,7 @@ bool osmState::operator==(const FFState& otherBase) const
     return false;
   if (E != other.E)
     return false;
-  if (gap != other.gap)
+  if (gapSize != other.gapSize || !std::equal(gap, gap + gapSize, other.gap))
     return false;
   if (lmState.length != other.lmState.length)
     return false;
@@ -55,17 +60,31 @@ std::string osmState :: getName() const
 
 //////////////////////////////////////////////////
 
-osmHypothesis :: osmHypothesis()
+osmHypothesis :: osmHypothesis(const OSMLM & osm)
+  : osm(osm)
+{
+  clear();
+}
+
+void osmHypothesis :: clear()
 {
   opProb = 0;
   gapWidth = 0;
   gapCount = 0;
   openGapCount = 0;
   deletionCount = 0;
-  gapCount = 0;
   j = 0;
   E = 0;
+  startIndex = 0;
   gap.clear();
+  operations.clear();
+  currE.clear();
+  currF.clear();
+  alignments.clear();
+  ceptF.clear();
+  ceptE.clear();
+  ceptFEnd.clear();
+  ceptEEnd.clear();
 }
 
 void osmHypothesis :: setState(const FFState* prev_state)
@@ -73,60 +92,21 @@ void osmHypothesis :: setState(const FFState* prev_state)
 
   if(prev_state != NULL) {
 
-    j = static_cast <const osmState *> (prev_state)->getJ();
-    E =  static_cast <const osmState *> (prev_state)->getE();
-    gap = static_cast <const osmState *> (prev_state)->getGap();
-    lmState = static_cast <const osmState *> (prev_state)->getLMState();
+    const osmState *state = static_cast <const osmState *> (prev_state);
+    j = state->getJ();
+    E = state->getE();
+    gap.assign(state->getGap(), state->getGap() + state->getGapSize());
+    lmState = state->getLMState();
   }
 }
 
-void osmHypothesis :: saveState(osmState &state)
+void osmHypothesis :: saveState(osmState &state, MemPool &pool)
 {
   state.setState(lmState);
-  state.saveState(j,E,gap);
-}
-
-int osmHypothesis :: isTranslationOperation(int x)
-{
-  if (operations[x].find("_JMP_BCK_") != -1)
-    return 0;
-
-  if (operations[x].find("_JMP_FWD_") != -1)
-    return 0;
-
-  if (operations[x].find("_CONT_CEPT_") != -1)
-    return 0;
-
-  if (operations[x].find("_INS_GAP_") != -1)
-    return 0;
-
-  return 1;
-
+  state.saveState(j,E,gap,pool);
 }
 
-void osmHypothesis :: removeReorderingOperations()
-{
-  gapCount = 0;
-  deletionCount = 0;
-  openGapCount = 0;
-  gapWidth = 0;
-
-  std::vector <std::string> tupleSequence;
-
-  for (int x = 0; x < operations.size(); x++) {
-    // cout<<operations[x]<<endl;
-
-    if(isTranslationOperation(x) == 1) {
-      tupleSequence.push_back(operations[x]);
-    }
-
-  }
-
-  operations.clear();
-  operations = tupleSequence;
-}
-
-void osmHypothesis :: calculateOSMProb(OSMLM& ptrOp)
+void osmHypothesis :: calculateOSMProb(const OSMLM& ptrOp)
 {
 
   opProb = 0;
@@ -160,13 +140,24 @@ int osmHypothesis :: firstOpenGap(vector <int> & coverageVector)
 
 }
 
-string osmHypothesis :: intToString(int num)
+bool osmHypothesis :: isTargetNull(int j1) const
 {
-  return SPrint(num);
+  return j1 >= startIndex && j1 - startIndex < (int) targetNullWords.size() && targetNullWords[j1 - startIndex];
+}
 
+bool osmHypothesis :: isSourceNull(int targetIndex) const
+{
+  return targetIndex < (int) sourceNullWords.size() && sourceNullWords[targetIndex];
 }
 
-void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , Bitmap & coverageVector , string english , string german , set <int> & targetNullWords , vector <string> & currF)
+bool osmHypothesis :: isDone(int targetIndex) const
+{
+  return targetIndex < (int) doneTargetIndexes.size() && doneTargetIndexes[targetIndex];
+}
+
+// contFlag 0 translates the cept in ceptEnglish and ceptSource, 1 continues
+// it and 2 inserts the unaligned source word at j1
+void osmHypothesis :: generateOperations(int j1 , int contFlag , Bitmap & coverageVector)
 {
 
   int gFlag = 0;
@@ -177,14 +168,14 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if ( j < j1) { // j1 is the index of the source word we are about to generate ...
     //if(coverageVector[j]==0) // if source word at j is not generated yet ...
     if(coverageVector.GetValue(j)==0) { // if source word at j is not generated yet ...
-      operations.push_back("_INS_GAP_");
+      operations.push_back(osm.InsertGap());
       gFlag++;
-      gap[j]="Unfilled";
+      setGap(j, false);
     }
     if (j == E) {
       j = j1;
     } else {
-      operations.push_back("_JMP_FWD_");
+      operations.push_back(osm.JumpForward());
       j=E;
     }
   }
@@ -192,34 +183,34 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if (j1 < j) {
     // if(j < E && coverageVector[j]==0)
     if(j < E && coverageVector.GetValue(j)==0) {
-      operations.push_back("_INS_GAP_");
+      operations.push_back(osm.InsertGap());
       gFlag++;
-      gap[j]="Unfilled";
+      setGap(j, false);
     }
 
-    j=closestGap(gap,j1,gp);
-    operations.push_back("_JMP_BCK_"+ intToString(gp));
+    j=closestGap(j1,gp);
+    operations.push_back(osm.JumpBack(gp));
 
     //cout<<"I am j "<<j<<endl;
     //cout<<"I am j1 "<<j1<<endl;
 
     if(j==j1)
-      gap[j]="Filled";
+      setGap(j, true);
   }
 
   if (j < j1) {
-    operations.push_back("_INS_GAP_");
-    gap[j] = "Unfilled";
+    operations.push_back(osm.InsertGap());
+    setGap(j, false);
     gFlag++;
     j=j1;
   }
 
   if(contFlag == 0) { // First words of the multi-word cept ...
 
-    if(english == "_TRANS_SLF_") { // Unknown word ...
-      operations.push_back("_TRANS_SLF_");
+    if(ceptEnglish.size() == 1 && ceptEnglish[0] == osm.TranslateSelfFactor()) { // Unknown word ...
+      operations.push_back(osm.TranslateSelf());
     } else {
-      operations.push_back("_TRANS_" + english + "_TO_" + german);
+      operations.push_back(osm.Index(OSMLM::Translate, ceptEnglish, ceptSource));
     }
 
     //ans = firstOpenGap(coverageVector);
@@ -230,14 +221,15 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   } else if (contFlag == 2) {
 
-    operations.push_back("_INS_" + german);
+    oneWord.assign(1, currF[j1-startIndex]);
+    operations.push_back(osm.Index(OSMLM::Insert, noWords, oneWord));
     ans = coverageVector.GetFirstGapPos();
 
     if (ans != -1)
       gapWidth += j - ans;
     deletionCount++;
   } else {
-    operations.push_back("_CONT_CEPT_");
+    operations.push_back(osm.ContinueCept());
   }
 
   //coverageVector[j]=1;
@@ -254,11 +246,8 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   //if (coverageVector[j] == 0 && targetNullWords.find(j) != targetNullWords.end())
   if (j < coverageVector.GetSize()) {
-    if (coverageVector.GetValue(j) == 0 && targetNullWords.find(j) != targetNullWords.end()) {
-      j1 = j;
-      german = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , german , targetNullWords , currF);
+    if (coverageVector.GetValue(j) == 0 && isTargetNull(j)) {
+      generateOperations(j, 2 , coverageVector);
     }
   }
 
@@ -282,7 +271,17 @@ void osmHypothesis :: print()
   cerr<<"_______________"<<endl;
 }
 
-int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
+void osmHypothesis :: setGap(int pos, bool filled)
+{
+  vector <int> :: iterator iter = lower_bound(gap.begin(), gap.end(), pos << 1);
+
+  if (iter == gap.end() || (*iter >> 1) != pos)
+    iter = gap.insert(iter, 0);
+
+  *iter = (pos << 1) | (filled ? 1 : 0);
+}
+
+int osmHypothesis :: closestGap(int j1, int & gp)
 {
 
   int dist=1172;
@@ -291,37 +290,34 @@ int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
   gp=0;
   int opGap=0;
 
-  map <int,string> :: iterator iter;
-
-  iter=gap.end();
-
-  do {
-    iter--;
-    //cout<<"Trapped "<<iter->first<<endl;
+  for (vector <int> :: reverse_iterator iter = gap.rbegin(); iter != gap.rend(); iter++) {
+    const int pos = *iter >> 1;
+    const bool unfilled = (*iter & 1) == 0;
+    //cout<<"Trapped "<<pos<<endl;
 
-    if(iter->first==j1 && iter->second== "Unfilled") {
+    if(pos==j1 && unfilled) {
       opGap++;
       gp = opGap;
       return j1;
 
     }
 
-    if(iter->second =="Unfilled") {
+    if(unfilled) {
       opGap++;
-      temp = iter->first - j1;
+      temp = pos - j1;
 
       if(temp<0)
         temp=temp * -1;
 
-      if(dist>temp && iter->first < j1) {
+      if(dist>temp && pos < j1) {
         dist=temp;
-        value=iter->first;
+        value=pos;
         gp=opGap;
       }
     }
 
 
-  } while(iter!=gap.begin());
+  }
 
   return value;
 }
@@ -330,11 +326,11 @@ int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
 
 int osmHypothesis :: getOpenGaps()
 {
-  map <int,string> :: iterator iter;
+  vector <int> :: iterator iter;
 
   int nd = 0;
   for (iter = gap.begin(); iter!=gap.end(); iter++) {
-    if(iter->second == "Unfilled")
+    if((*iter & 1) == 0)
       nd++;
   }
 
@@ -342,19 +338,19 @@ int osmHypothesis :: getOpenGaps()
 
 }
 
-void osmHypothesis :: generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes)
+void osmHypothesis :: generateDeleteOperations(int currTargetIndex)
 {
 
-  operations.push_back("_DEL_" + english);
+  oneWord.assign(1, currE[currTargetIndex]);
+  operations.push_back(osm.Index(OSMLM::Delete, oneWord, noWords));
   currTargetIndex++;
 
-  while(doneTargetIndexes.find(currTargetIndex) != doneTargetIndexes.end()) {
+  while(isDone(currTargetIndex)) {
     currTargetIndex++;
   }
 
-  if (sourceNullWords.find(currTargetIndex) != sourceNullWords.end()) {
-    english = currE[currTargetIndex];
-    generateDeleteOperations(english,currTargetIndex,doneTargetIndexes);
+  if (isSourceNull(currTargetIndex)) {
+    generateDeleteOperations(currTargetIndex);
   }
 
 }
@@ -362,87 +358,67 @@ void osmHypothesis :: generateDeleteOperations(std::string english, int currTarg
 void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector)
 {
 
-  set <int> doneTargetIndexes;
-  set <int> eSide;
-  set <int> fSide;
-  set <int> :: iterator iter;
-  string english;
-  string source;
   int j1;
   int targetIndex = 0;
-  doneTargetIndexes.clear();
-
+  this->startIndex = startIndex;
+  doneTargetIndexes.assign(currE.size(), 0);
 
-  if (targetNullWords.size() != 0) { // Source words to be deleted in the start of this phrase ...
-    iter = targetNullWords.begin();
 
-    if (*iter == startIndex) {
-
-      j1 = startIndex;
-      source = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , source , targetNullWords , currF);
-    }
+  if (!targetNullWords.empty() && targetNullWords[0]) { // Source words to be deleted in the start of this phrase ...
+    generateOperations(startIndex, 2 , coverageVector);
   }
 
-  if (sourceNullWords.find(targetIndex) != sourceNullWords.end()) { // first word has to be deleted ...
-    english = currE[targetIndex];
-    generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+  if (isSourceNull(targetIndex)) { // first word has to be deleted ...
+    generateDeleteOperations(targetIndex);
   }
 
 
-  for (size_t i = 0; i < ceptsInPhrase.size(); i++) {
-    source = "";
-    english = "";
-
-    fSide = ceptsInPhrase[i].first;
-    eSide = ceptsInPhrase[i].second;
+  for (size_t i = 0; i < ceptFEnd.size(); i++) {
+    const int *fSide = &ceptF[i ? ceptFEnd[i - 1] : 0];
+    const int *fEnd = &ceptF[0] + ceptFEnd[i];
+    const int *eSide = &ceptE[i ? ceptEEnd[i - 1] : 0];
+    const int *eEnd = &ceptE[0] + ceptEEnd[i];
+    const int *iter;
 
-    iter = eSide.begin();
+    iter = eSide;
     targetIndex = *iter;
-    english += currE[*iter];
+    ceptEnglish.assign(1, currE[*iter]);
     iter++;
 
-    for (; iter != eSide.end(); iter++) {
+    for (; iter != eEnd; iter++) {
       if(*iter == targetIndex+1)
         targetIndex++;
       else
-        doneTargetIndexes.insert(*iter);
+        doneTargetIndexes[*iter] = 1;
 
-      english += "^_^";
-      english += currE[*iter];
+      ceptEnglish.push_back(currE[*iter]);
     }
 
-    iter = fSide.begin();
-    source += currF[*iter];
-    iter++;
-
-    for (; iter != fSide.end(); iter++) {
-      source += "^_^";
-      source += currF[*iter];
+    ceptSource.clear();
+    for (iter = fSide; iter != fEnd; iter++) {
+      ceptSource.push_back(currF[*iter]);
     }
 
-    iter = fSide.begin();
+    iter = fSide;
     j1 = *iter + startIndex;
     iter++;
 
-    generateOperations(startIndex, j1, 0 , coverageVector , english , source , targetNullWords , currF);
+    generateOperations(j1, 0 , coverageVector);
 
 
-    for (; iter != fSide.end(); iter++) {
+    for (; iter != fEnd; iter++) {
       j1 = *iter + startIndex;
-      generateOperations(startIndex, j1, 1 , coverageVector , english , source , targetNullWords , currF);
+      generateOperations(j1, 1 , coverageVector);
     }
 
     targetIndex++; // Check whether the next target word is unaligned ...
 
-    while(doneTargetIndexes.find(targetIndex) != doneTargetIndexes.end()) {
+    while(isDone(targetIndex)) {
       targetIndex++;
     }
 
-    if(sourceNullWords.find(targetIndex) != sourceNullWords.end()) {
-      english = currE[targetIndex];
-      generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+    if(isSourceNull(targetIndex)) {
+      generateDeleteOperations(targetIndex);
     }
   }
 
@@ -452,148 +428,73 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
 
 }
 
-void osmHypothesis :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <int , vector <int> > & tS , map <int , vector <int> > & sT)
+int osmHypothesis :: findComponent(int node)
 {
-  set <int> :: iterator iter;
-
-  int sz = eSide.size();
-  vector <int> t;
-
-  for (iter = eSide.begin(); iter != eSide.end(); iter++) {
-    t = tS[*iter];
-
-    for (size_t i = 0; i < t.size(); i++) {
-      fSide.insert(t[i]);
-    }
-
-  }
-
-  for (iter = fSide.begin(); iter != fSide.end(); iter++) {
-
-    t = sT[*iter];
-
-    for (size_t i = 0 ; i<t.size(); i++) {
-      eSide.insert(t[i]);
-    }
-
+  while (component[node] != node) {
+    node = component[node] = component[component[node]];
   }
-
-  if (eSide.size () > sz) {
-    getMeCepts(eSide,fSide,tS,sT);
-  }
-
+  return node;
 }
 
-void osmHypothesis :: constructCepts(vector <int> & align , int startIndex , int endIndex, int targetPhraseLength)
+// Cepts are the connected parts of the alignment of the phrase
+void osmHypothesis :: constructCepts(int startIndex , int endIndex, int targetPhraseLength)
 {
+  const int sourceLength = endIndex - startIndex + 1;
 
-  std::map <int , vector <int> > sT;
-  std::map <int , vector <int> > tS;
-  std::set <int> eSide;
-  std::set <int> fSide;
-  std::set <int> :: iterator iter;
-  std :: map <int , vector <int> > :: iterator iter2;
-  std :: pair < set <int> , set <int> > cept;
-  int src;
-  int tgt;
-
-
-  for (size_t i = 0;  i < align.size(); i+=2) {
-    src = align[i];
-    tgt = align[i+1];
-    tS[tgt].push_back(src);
-    sT[src].push_back(tgt);
+  // source word i is node i, target word i is node sourceLength + i
+  component.resize(sourceLength + targetPhraseLength);
+  for (size_t i = 0; i < component.size(); i++) {
+    component[i] = i;
   }
-
-  for (int i = startIndex; i<= endIndex; i++) { // What are unaligned source words in this phrase ...
-    if (sT.find(i-startIndex) == sT.end()) {
-      targetNullWords.insert(i);
-    }
+  targetNullWords.assign(sourceLength, 1);
+  sourceNullWords.assign(targetPhraseLength, 1);
+
+  for (size_t i = 0;  i < alignments.size(); i+=2) {
+    const int src = alignments[i];
+    const int tgt = alignments[i+1];
+    targetNullWords[src] = 0;
+    sourceNullWords[tgt] = 0;
+    component[findComponent(src)] = findComponent(sourceLength + tgt);
   }
 
-  for (int i = 0; i < targetPhraseLength; i++) { // What are unaligned target words in this phrase ...
-    if (tS.find(i) == tS.end()) {
-      sourceNullWords.insert(i);
+  // a cept is complete when its first target word comes up
+  for (int tgt = 0; tgt < targetPhraseLength; tgt++) {
+    if (sourceNullWords[tgt])
+      continue;
+    const int root = findComponent(sourceLength + tgt);
+    bool seen = false;
+    for (int other = 0; other < tgt && !seen; other++) {
+      seen = !sourceNullWords[other] && findComponent(sourceLength + other) == root;
     }
-  }
+    if (seen)
+      continue;
 
-
-  while (tS.size() != 0 && sT.size() != 0) {
-
-    iter2 = tS.begin();
-
-    eSide.clear();
-    fSide.clear();
-    eSide.insert (iter2->first);
-
-    getMeCepts(eSide, fSide, tS , sT);
-
-    for (iter = eSide.begin(); iter != eSide.end(); iter++) {
-      iter2 = tS.find(*iter);
-      tS.erase(iter2);
+    for (int src = 0; src < sourceLength; src++) {
+      if (!targetNullWords[src] && findComponent(src) == root)
+        ceptF.push_back(src);
     }
-
-    for (iter = fSide.begin(); iter != fSide.end(); iter++) {
-      iter2 = sT.find(*iter);
-      sT.erase(iter2);
+    for (int other = tgt; other < targetPhraseLength; other++) {
+      if (!sourceNullWords[other] && findComponent(sourceLength + other) == root)
+        ceptE.push_back(other);
     }
-
-    cept = make_pair (fSide , eSide);
-    ceptsInPhrase.push_back(cept);
+    ceptFEnd.push_back(ceptF.size());
+    ceptEEnd.push_back(ceptE.size());
   }
-
-
-
-  /*
-
-      cerr<<"Extracted Cepts "<<endl;
-      for (int i = 0; i < ceptsInPhrase.size(); i++)
-        {
-
-          fSide = ceptsInPhrase[i].first;
-          eSide = ceptsInPhrase[i].second;
-
-          for (iter = eSide.begin(); iter != eSide.end(); iter++)
-          {
-              cerr<<*iter<<" ";
-          }
-              cerr<<"<---> ";
-
-          for (iter = fSide.begin(); iter != fSide.end(); iter++)
-          {
-            cerr<<*iter<<" ";
-          }
-
-          cerr<<endl;
-        }
-        cerr<<endl;
-
-      cerr<<"Unaligned Target Words"<<endl;
-
-      for (iter = sourceNullWords.begin(); iter != sourceNullWords.end(); iter++)
-        cerr<<*iter<<"<--->"<<endl;
-
-      cerr<<"Unaligned Source Words"<<endl;
-
-      for (iter = targetNullWords.begin(); iter != targetNullWords.end(); iter++)
-        cerr<<*iter<<"<--->"<<endl;
-
-  */
-
 }
 
-void osmHypothesis :: populateScores(vector <float> & scores , const int numFeatures)
+const vector <float> & osmHypothesis :: populateScores(const int numFeatures)
 {
   scores.clear();
   scores.push_back(opProb);
 
   if (numFeatures == 1)
-    return;
+    return scores;
 
   scores.push_back(gapWidth);
   scores.push_back(gapCount);
   scores.push_back(openGapCount);
   scores.push_back(deletionCount);
+  return scores;
 }
 
 
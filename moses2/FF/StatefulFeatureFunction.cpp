@@ -13,6 +13,7 @@
 
 #include <boost/foreach.hpp>
 #include "StatefulFeatureFunction.h"
+#include "util/exception.hh"
 #include "../PhraseBased/Hypothesis.h"
 
 using namespace std;
@@ -65,5 +66,10 @@ void StatefulFeatureFunction::EvaluateWhenAppliedBatch(
 #endif
 }
 
+void StatefulFeatureFunction::IncrementalCallback(SCFG::Manager &mgr) const
+{
+  UTIL_THROW2(GetName() << " cannot be used for incremental search");
+}
+
 }
 
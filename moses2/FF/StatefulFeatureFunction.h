@@ -56,6 +56,9 @@ public:
     const System &system,
     const Batch &batch) const;
 
+  //! incremental search calls this on the language model it is to use
+  virtual void IncrementalCallback(SCFG::Manager &mgr) const;
+
 protected:
   size_t m_statefulInd;
 
@@ -52,7 +52,8 @@ void HypothesisColl::Add(
   Recycler<HypothesisBase*> &hypoRecycle,
   ArcLists &arcLists)
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
+  ++mgr.stats.created;
 
   if (GetSize() > maxStackSize * 2) {
     //cerr << "maxStackSize=" << maxStackSize << " " << GetSize() << endl;
@@ -72,11 +73,15 @@ void HypothesisColl::Add(
     // beam threshold or really bad hypo that won't make the pruning cut
     // as more hypos are added, the m_worstScore stat gets out of date and isn't the optimum cut-off point
     //cerr << "Discard, really bad score:" << hypo->Debug(mgr.system) << endl;
+    ++mgr.stats.discarded;
     hypoRecycle.Recycle(hypo);
     return;
   }
 
   StackAdd added = Add(hypo);
+  if (added.other) {
+    ++mgr.stats.recombined;
+  }
 
   size_t nbestSize = mgr.system.options.nbest.nbest_size;
   if (nbestSize) {
@@ -177,8 +182,9 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
     // prune
     Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
-    size_t maxStackSize = mgr.system.options.search.stack_size;
+    size_t maxStackSize = mgr.GetStackSize();
     if (maxStackSize && m_sortedHypos->size() > maxStackSize) {
+      mgr.stats.pruned += m_sortedHypos->size() - maxStackSize;
       for (size_t i = maxStackSize; i < m_sortedHypos->size(); ++i) {
         HypothesisBase *hypo = const_cast<HypothesisBase*>((*m_sortedHypos)[i]);
         recycler.Recycle(hypo);
@@ -198,7 +204,7 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
 
 void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
 
   Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
@@ -209,6 +215,7 @@ void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
   m_worstScore = sortedHypos[maxStackSize - 1]->GetFutureScore();
 
   // prune
+  mgr.stats.pruned += GetSize() - maxStackSize;
   for (size_t i = maxStackSize; i < GetSize(); ++i) {
     HypothesisBase *hypo = const_cast<HypothesisBase*>(sortedHypos[i]);
 
@@ -227,7 +234,7 @@ void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
 
 void HypothesisColl::SortHypos(const ManagerBase &mgr, const HypothesisBase **sortedHypos) const
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
   //assert(maxStackSize); // can't do stack=0 - unlimited stack size. No-one ever uses that
   //assert(GetSize() > maxStackSize);
   //assert(sortedHypos.size() == GetSize());
@@ -412,6 +412,12 @@ lm::WordIndex *KENLM<Model>::LastIDs(const Hypothesis &hypo,
   }
 }
 
+template<class Model>
+void KENLM<Model>::IncrementalCallback(SCFG::Manager &mgr) const
+{
+  mgr.LMCallback(*m_ngram, m_lmIdLookup, m_factorType, *this);
+}
+
 template<class Model>
 void KENLM<Model>::EvaluateWhenApplied(const SCFG::Manager &mgr,
                                        const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
@@ -57,6 +57,8 @@ public:
                                    const SCFG::Hypothesis &hypo, int featureID, Scores &scores,
                                    FFState &state) const;
 
+  virtual void IncrementalCallback(SCFG::Manager &mgr) const;
+
 protected:
   std::string m_path;
   FactorType m_factorType;
@@ -12,6 +12,7 @@
 #include "legacy/ThreadPool.h"
 #include "legacy/Timer.h"
 #include "legacy/Util2.h"
+#include "Metrics.h"
 #include "util/usage.hh"
 
 using namespace std;
@@ -37,6 +38,12 @@ int main(int argc, char** argv)
     return EXIT_SUCCESS;
   }
 
+  const Moses2::PARAM_VEC *metricsDump = params.GetParam("metrics-dump");
+  if (metricsDump && metricsDump->size()) {
+    Moses2::Metrics::Instance().StartDump(Moses2::Scan<double>((*metricsDump)[0]),
+                                          metricsDump->size() > 1 ? (*metricsDump)[1] : "");
+  }
+
   //cerr << "system.numThreads=" << system.options.server.numThreads << endl;
 
   Moses2::ThreadPool pool(system.options.server.numThreads, system.cpuAffinityOffset, system.cpuAffinityOffsetIncr);
@@ -26,6 +26,8 @@ ManagerBase::ManagerBase(System &sys, const TranslationTask &task,
   ,task(task)
   ,m_inputStr(inputStr)
   ,m_translationId(translationId)
+  ,m_stackSize(sys.options.search.stack_size)
+  ,m_cubePopLimit(sys.options.cube.pop_limit)
   ,m_pool(NULL)
   ,m_systemPool(NULL)
   ,m_hypoRecycle(NULL)
@@ -44,6 +46,18 @@ ManagerBase::~ManagerBase()
   }
 }
 
+void ManagerBase::AddToMetrics(double searchSeconds) const
+{
+  Metrics &metrics = Metrics::Instance();
+  metrics.Observe(Metrics::Search, searchSeconds);
+  metrics.Observe(Metrics::LM, stats.statefulSampled * 16);
+  metrics.Add(Metrics::Sentences, 1);
+  metrics.Add(Metrics::HyposCreated, stats.created);
+  metrics.Add(Metrics::HyposRecombined, stats.recombined);
+  metrics.Add(Metrics::HyposPruned, stats.pruned);
+  metrics.Add(Metrics::HyposDiscarded, stats.discarded);
+}
+
 void ManagerBase::InitPools()
 {
   m_pool = &system.GetManagerPool();
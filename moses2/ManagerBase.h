@@ -17,6 +17,7 @@
 #include "EstimatedScores.h"
 #include "ArcLists.h"
 #include "legacy/Bitmaps.h"
+#include "Metrics.h"
 
 namespace Moses2
 {
@@ -36,6 +37,7 @@ public:
   const System &system;
   const TranslationTask &task;
   mutable ArcLists arcLists;
+  mutable DecodeStats stats;
 
   ManagerBase(System &sys, const TranslationTask &task,
               const std::string &inputStr, long translationId);
@@ -65,9 +67,25 @@ public:
     return m_translationId;
   }
 
+  //! search limits for this input, from the options unless lowered
+  size_t GetStackSize() const {
+    return m_stackSize;
+  }
+  size_t GetCubePopLimit() const {
+    return m_cubePopLimit;
+  }
+  void SetSearchLimits(size_t stackSize, size_t cubePopLimit) {
+    m_stackSize = stackSize;
+    m_cubePopLimit = cubePopLimit;
+  }
+
+  //! add the search time and the stats of this sentence to the metrics
+  void AddToMetrics(double searchSeconds) const;
+
 protected:
   std::string m_inputStr;
   long m_translationId;
+  size_t m_stackSize, m_cubePopLimit;
   InputType *m_input;
 
   mutable MemPool *m_pool, *m_systemPool;
@@ -0,0 +1,102 @@
+/*
+ * Metrics.h
+ *
+ *  Process-wide decoder metrics.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include <boost/atomic.hpp>
+#include "util/usage.hh"
+
+namespace Moses2
+{
+
+/**
+ * Process-wide decoder metrics, collected for every sentence regardless of
+ * the verbosity: a latency histogram per decoding phase and counts of what
+ * happened to the hypotheses. Updates are lock-free; Write() prints them
+ * in the Prometheus text format.
+ */
+class Metrics
+{
+public:
+  enum Phase {
+    Lookup,     // collecting translation options
+    FutureCost, // the future cost matrix
+    Search,
+    LM,         // stateful feature functions, estimated from a sample
+    NBest,
+    Output,
+    NumPhases
+  };
+
+  enum Counter {
+    Sentences,
+    HyposCreated,
+    HyposRecombined,
+    HyposPruned,
+    HyposDiscarded,
+    NumCounters
+  };
+
+  static Metrics &Instance();
+
+  void Observe(Phase phase, double seconds);
+
+  void Add(Counter counter, uint64_t n) {
+    m_counters[counter].fetch_add(n, boost::memory_order_relaxed);
+  }
+
+  void Write(std::ostream &out) const;
+
+  /** Rewrite the metrics to path (stderr if empty) every interval seconds */
+  void StartDump(double interval, const std::string &path);
+
+private:
+  static const size_t NumBuckets = 12;
+  static const double s_bucketBounds[NumBuckets];
+
+  Metrics();
+
+  // the last bucket counts observations above all bounds
+  boost::atomic<uint64_t> m_buckets[NumPhases][NumBuckets + 1];
+  boost::atomic<uint64_t> m_microseconds[NumPhases];
+  boost::atomic<uint64_t> m_counters[NumCounters];
+};
+
+/** Counts for one sentence, added to the metrics when its search is done */
+struct DecodeStats {
+  DecodeStats()
+    :created(0), recombined(0), pruned(0), discarded(0), evaluations(0)
+    ,statefulSampled(0) {
+  }
+
+  //! true for the evaluations of stateful features that should be timed
+  bool SampleStatefulEvaluation() {
+    return (evaluations++ & 15) == 0;
+  }
+
+  size_t created, recombined, pruned, discarded, evaluations;
+  double statefulSampled; // time in 1 of 16 evaluations
+};
+
+/** Observes the wall time from construction to destruction */
+class MetricsTimer
+{
+public:
+  MetricsTimer(Metrics::Phase phase)
+    : m_phase(phase), m_start(util::WallTime()) {}
+  ~MetricsTimer() {
+    Metrics::Instance().Observe(m_phase, util::WallTime() - m_start);
+  }
+
+private:
+  Metrics::Phase m_phase;
+  double m_start;
+};
+
+}
@@ -86,7 +86,7 @@ CubeEdge::CubeEdge(Manager &mgr, const Hypotheses &hypos, const InputPath &path,
                    const TargetPhrases &tps, const Bitmap &newBitmap) :
   hypos(hypos), path(path), tps(tps), newBitmap(newBitmap)
 {
-  estimatedScore = mgr.GetEstimatedScores().CalcEstimatedScore(newBitmap);
+  estimatedScore = newBitmap.GetEstimatedScore();
 }
 
 std::string CubeEdge::Debug(const System &system) const
@@ -120,7 +120,7 @@ void Search::Decode(size_t stackInd)
    */
 
   size_t pops = 0;
-  while (!m_queue.empty() && pops < mgr.system.options.cube.pop_limit) {
+  while (!m_queue.empty() && pops < mgr.GetCubePopLimit()) {
     // get best hypo from queue, add to stack
     //cerr << "queue=" << queue.size() << endl;
     QueueItem *item = m_queue.top();
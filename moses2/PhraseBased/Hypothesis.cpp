@@ -181,9 +181,15 @@ void Hypothesis::EvaluateWhenApplied()
 {
   const std::vector<const StatefulFeatureFunction*> &sfffs =
     GetManager().system.featureFunctions.GetStatefulFeatureFunctions();
+  DecodeStats &stats = GetManager().stats;
+  const bool timed = stats.SampleStatefulEvaluation();
+  const double start = timed ? util::WallTime() : 0;
   BOOST_FOREACH(const StatefulFeatureFunction *sfff, sfffs) {
     EvaluateWhenApplied(*sfff);
   }
+  if (timed) {
+    stats.statefulSampled += util::WallTime() - start;
+  }
 //cerr << *this << endl;
 }
 
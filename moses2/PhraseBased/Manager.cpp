@@ -70,6 +70,7 @@ void Manager::Init()
   const Sentence &sentence = static_cast<const Sentence&>(GetInput());
   //cerr << "sentence=" << sentence.GetSize() << " " << sentence.Debug(system) << endl;
 
+  const double start = util::WallTime();
   m_inputPaths.Init(sentence, *this);
 
   // xml
@@ -85,9 +86,12 @@ void Manager::Init()
     pt.Lookup(*this, m_inputPaths);
   }
   //m_inputPaths.DeleteUnusedPaths();
+  const double lookedUp = util::WallTime();
+  Metrics::Instance().Observe(Metrics::Lookup, lookedUp - start);
   CalcFutureScore();
 
-  m_bitmaps->Init(sentence.GetSize(), vector<bool>(0));
+  m_bitmaps->Init(sentence.GetSize(), vector<bool>(0), *m_estimatedScores);
+  Metrics::Instance().Observe(Metrics::FutureCost, util::WallTime() - lookedUp);
 
   switch (system.options.search.algo) {
   case Normal:
@@ -125,7 +129,9 @@ void Manager::Decode()
   //cerr << "Start Decode " << this << endl;
 
   Init();
+  const double start = util::WallTime();
   m_search->Decode();
+  AddToMetrics(util::WallTime() - start);
 
   //cerr << "Finished Decode " << this << endl;
 }
@@ -103,7 +103,7 @@ void Search::Extend(const Hypothesis &hypo, const InputPath &path)
   // extend this hypo
   const Bitmap &newBitmap = mgr.GetBitmaps().GetBitmap(hypoBitmap, pathRange);
   //SCORE estimatedScore = mgr.GetEstimatedScores().CalcFutureScore2(bitmap, pathRange.GetStartPos(), pathRange.GetEndPos());
-  SCORE estimatedScore = mgr.GetEstimatedScores().CalcEstimatedScore(newBitmap);
+  SCORE estimatedScore = newBitmap.GetEstimatedScore();
 
   size_t numPt = mgr.system.mappings.size();
   const TargetPhrases **tpsAllPt = path.targetPhrases;
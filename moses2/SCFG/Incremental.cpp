@@ -0,0 +1,384 @@
+/*
+ * Incremental.cpp
+ *
+ * Incremental search (Heafield et al.) for the SCFG decoder, using the
+ * search/ library. Rules are looked up exactly as for cube pruning, but
+ * hypotheses are kept in search::Vertex objects, one per span and left-hand
+ * side, and only expanded as far as the pop limit requires.
+ */
+#include <boost/foreach.hpp>
+#include <boost/pool/object_pool.hpp>
+#include <boost/unordered_map.hpp>
+#include <cmath>
+#include <sstream>
+#include <vector>
+#include "lm/left.hh"
+#include "lm/model.hh"
+#include "search/applied.hh"
+#include "search/config.hh"
+#include "search/context.hh"
+#include "search/edge_generator.hh"
+#include "search/nbest.hh"
+#include "search/rule.hh"
+#include "search/vertex_generator.hh"
+#include "util/exception.hh"
+#include "../System.h"
+#include "../legacy/Util2.h"
+#include "../Scores.h"
+#include "../FF/StatefulFeatureFunction.h"
+#include "Manager.h"
+#include "InputPath.h"
+#include "TargetPhraseImpl.h"
+#include "TargetPhrases.h"
+#include "ActiveChart.h"
+#include "Sentence.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace SCFG
+{
+
+namespace
+{
+// Natural logarithm of 10.
+const float log_10 = logf(10);
+
+lm::WordIndex Convert(const std::vector<lm::WordIndex> &vocabMapping,
+                      FactorType factorType, const SCFG::Word &word)
+{
+  size_t factor = word[factorType]->GetId();
+  return (factor >= vocabMapping.size() ? 0 : vocabMapping[factor]);
+}
+
+// Vertices of one span, by left-hand side.
+typedef boost::unordered_map<SCFG::Word, search::Vertex*> Cell;
+
+// Called by EdgeGenerator. Routes hypotheses to a separate vertex for each
+// left-hand side.
+template<class Best>
+class HypothesisCallback
+{
+  typedef search::VertexGenerator<Best> Gen;
+public:
+  HypothesisCallback(search::ContextBase &context, Best &best, Cell &out,
+                     boost::object_pool<search::Vertex> &vertexPool)
+    :m_context(context)
+    ,m_best(best)
+    ,m_out(out)
+    ,m_vertexPool(vertexPool) {
+  }
+
+  void NewHypothesis(search::PartialEdge partial) {
+    const SCFG::TargetPhraseImpl &tp =
+      *static_cast<const SCFG::TargetPhraseImpl*>(partial.GetNote().vp);
+    Gen *&gen = m_gens[tp.lhs];
+    if (gen == NULL) {
+      gen = m_genPool.construct(boost::ref(m_context),
+                                boost::ref(*m_vertexPool.construct()),
+                                boost::ref(m_best));
+    }
+    gen->NewHypothesis(partial);
+  }
+
+  void FinishedSearch() {
+    BOOST_FOREACH(typename Gens::value_type &valPair, m_gens) {
+      Gen &gen = *valPair.second;
+      gen.FinishedSearch();
+      m_out[valPair.first] = &gen.Generating();
+    }
+  }
+
+private:
+  typedef boost::unordered_map<SCFG::Word, Gen*> Gens;
+
+  search::ContextBase &m_context;
+  Best &m_best;
+  Cell &m_out;
+  boost::object_pool<search::Vertex> &m_vertexPool;
+  boost::object_pool<Gen> m_genPool;
+  Gens m_gens;
+};
+
+// Turns the rules of one input path into search::PartialEdge objects.
+template<class Model>
+class Fill
+{
+public:
+  Fill(search::Context<Model> &context,
+       const std::vector<lm::WordIndex> &vocabMapping,
+       FactorType factorType,
+       const std::vector<Cell> &cells,
+       size_t inputSize)
+    :m_context(context)
+    ,m_vocabMapping(vocabMapping)
+    ,m_factorType(factorType)
+    ,m_cells(cells)
+    ,m_inputSize(inputSize) {
+  }
+
+  void Add(const SCFG::InputPath &path) {
+    BOOST_FOREACH(const InputPath::Coll::value_type &valPair, path.targetPhrases) {
+      Add(valPair.first, *valPair.second);
+    }
+  }
+
+  template<class Best>
+  void Search(Best &best, Cell &out,
+              boost::object_pool<search::Vertex> &vertexPool) {
+    HypothesisCallback<Best> callback(m_context, best, out, vertexPool);
+    m_edges.Search(m_context, callback);
+  }
+
+  // Root: everything into one vertex.
+  template<class Best>
+  search::History RootSearch(Best &best) {
+    search::Vertex vertex;
+    search::RootVertexGenerator<Best> gen(vertex, best);
+    m_edges.Search(m_context, gen);
+    return vertex.BestChild();
+  }
+
+private:
+  void Add(const SymbolBind &symbolBind, const SCFG::TargetPhrases &tps);
+
+  search::Context<Model> &m_context;
+  const std::vector<lm::WordIndex> &m_vocabMapping;
+  FactorType m_factorType;
+  const std::vector<Cell> &m_cells;
+  size_t m_inputSize;
+
+  search::EdgeGenerator m_edges;
+};
+
+template<class Model>
+void Fill<Model>::Add(const SymbolBind &symbolBind,
+                      const SCFG::TargetPhrases &tps)
+{
+  // best hypotheses of the non-terminals, in source order
+  std::vector<search::PartialVertex> vertices;
+  vertices.reserve(symbolBind.numNT);
+  float belowScore = 0;
+  for (size_t i = 0; i < symbolBind.coll.size(); ++i) {
+    const SymbolBindElement &ele = symbolBind.coll[i];
+    if (ele.hypos == NULL) {
+      continue;
+    }
+    const Range &range = ele.GetRange();
+    const Cell &cell = m_cells[range.GetStartPos() * (m_inputSize + 1)
+                               + range.GetNumWordsCovered()];
+    Cell::const_iterator iter = cell.find(*ele.word);
+    UTIL_THROW_IF2(iter == cell.end(), "No vertex for non-terminal in " << range);
+
+    vertices.push_back(iter->second->RootAlternate());
+    UTIL_THROW_IF2(vertices.back().Empty(), "Hypothesis with empty stack");
+    belowScore += vertices.back().Bound();
+  }
+
+  std::vector<lm::WordIndex> words;
+  for (size_t i = 0; i < tps.GetSize(); ++i) {
+    const SCFG::TargetPhraseImpl &tp = tps[i];
+    const AlignmentInfo::NonTermIndexMap &align =
+      tp.GetAlignNonTerm().GetNonTermIndexMap();
+
+    search::PartialEdge edge(m_edges.AllocateEdge(vertices.size()));
+    search::PartialVertex *nt = edge.NT();
+    words.clear();
+    for (size_t pos = 0; pos < tp.GetSize(); ++pos) {
+      const SCFG::Word &word = tp[pos];
+      if (word.isNonTerminal) {
+        *(nt++) = vertices[align[pos]];
+        words.push_back(search::kNonTerminal);
+      } else {
+        words.push_back(Convert(m_vocabMapping, m_factorType, word));
+      }
+    }
+
+    // the estimated score already holds the rule's LM score
+    edge.SetScore(tp.GetFutureScore() + belowScore);
+    search::ScoreRule(m_context.LanguageModel(), words, edge.Between());
+
+    search::Note note;
+    note.vp = &tp;
+    edge.SetNote(note);
+
+    m_edges.AddEdge(edge);
+  }
+}
+
+}
+
+template<class Model, class Best>
+search::History Manager::IncrementalSearch(
+  const Model &model,
+  const std::vector<lm::WordIndex> &vocabMapping,
+  FactorType factorType,
+  SCORE lmWeight,
+  Best &best)
+{
+  search::Config config(lmWeight * log_10,
+                        GetCubePopLimit(),
+                        search::NBestConfig(system.options.nbest.nbest_size));
+  search::Context<Model> context(config, model);
+
+  const SCFG::Sentence &sentence = static_cast<const SCFG::Sentence&>(GetInput());
+  size_t inputSize = sentence.GetSize();
+
+  boost::object_pool<search::Vertex> vertexPool(
+    std::max<size_t>(inputSize * inputSize / 2, 32));
+  std::vector<Cell> cells(inputSize * (inputSize + 1));
+
+  for (int startPos = inputSize - 1; startPos >= 0; --startPos) {
+    SCFG::InputPath &initPath = *m_inputPaths.GetMatrix().GetValue(startPos, 0);
+    InitActiveChart(initPath);
+
+    int maxPhraseSize = inputSize - startPos + 1;
+    for (int phraseSize = 1; phraseSize < maxPhraseSize; ++phraseSize) {
+      SCFG::InputPath &path = *m_inputPaths.GetMatrix().GetValue(startPos, phraseSize);
+      Lookup(path);
+
+      Fill<Model> filler(context, vocabMapping, factorType, cells, inputSize);
+      filler.Add(path);
+
+      // full range uses RootSearch
+      if (startPos == 0 && phraseSize == (int) inputSize) {
+        return filler.RootSearch(best);
+      }
+
+      Cell &cell = cells[startPos * (inputSize + 1) + phraseSize];
+      filler.Search(best, cell, vertexPool);
+
+      // let rule lookup for larger spans see the labels of this one
+      Stack &stack = m_stacks.GetStack(startPos, phraseSize);
+      BOOST_FOREACH(const Cell::value_type &valPair, cell) {
+        stack.AddLabel(valPair.first);
+      }
+
+      LookupUnary(path);
+    }
+  }
+
+  return search::History();
+}
+
+template<class Model>
+void Manager::LMCallback(const Model &model,
+                         const std::vector<lm::WordIndex> &vocabMapping,
+                         FactorType factorType,
+                         const StatefulFeatureFunction &lm)
+{
+  const SCORE lmWeight = system.weights.GetWeights(lm)[0];
+  const size_t nbestSize = system.options.nbest.nbest_size;
+
+  search::SingleBest singleBest;
+  search::NBest nbest((search::NBestConfig(nbestSize)));
+  std::vector<search::Applied> derivations;
+  if (nbestSize <= 1) {
+    search::History ret = IncrementalSearch(model, vocabMapping, factorType,
+                                            lmWeight, singleBest);
+    if (ret) {
+      derivations.push_back(search::Applied(ret));
+    }
+  } else {
+    search::History ret = IncrementalSearch(model, vocabMapping, factorType,
+                                            lmWeight, nbest);
+    if (ret) {
+      derivations = nbest.Extract(ret);
+    }
+  }
+
+  // the search objects own the derivations, so format the output now
+  const typename Model::Vocabulary &lmVocab = model.GetVocabulary();
+  stringstream nbestStrm;
+  std::vector<const SCFG::Word*> words;
+  for (size_t i = 0; i < derivations.size(); ++i) {
+    const search::Applied &applied = derivations[i];
+
+    Scores *scores = new (GetPool().Allocate<Scores>())
+    Scores(system, GetPool(), system.featureFunctions.GetNumScores());
+    words.clear();
+    OutputIncremental(applied, words, *scores);
+
+    // The rules hold the LM score of the n-grams inside each rule only.
+    // Replace it with the score of the whole sentence, as the cube pruning
+    // path reports it.  The LM is the only stateful feature, so nothing
+    // else depends on the derivation.
+    lm::ngram::ChartState ignored;
+    lm::ngram::RuleScore<Model> lmScore(model, ignored);
+    size_t begin = 0, end = words.size();
+    if (begin < end && Convert(vocabMapping, factorType, *words[begin]) == lmVocab.BeginSentence()) {
+      lmScore.BeginSentence();
+      ++begin;
+    }
+    for (size_t pos = begin; pos < words.size(); ++pos) {
+      lmScore.Terminal(Convert(vocabMapping, factorType, *words[pos]));
+    }
+    if (nbestSize) {
+      scores->PlusEquals(system, lm, TransformLMScore(lmScore.Finish())
+                         - scores->GetScores(lm)[0]);
+    }
+
+    // leave out the sentence boundaries
+    if (end > begin && Convert(vocabMapping, factorType, *words[end - 1]) == lmVocab.EndSentence()) {
+      --end;
+    }
+    stringstream strm;
+    for (size_t pos = begin; pos < end; ++pos) {
+      if (pos > begin) {
+        strm << " ";
+      }
+      words[pos]->OutputToStream(system, strm);
+    }
+    const string out = strm.str();
+
+    if (i == 0) {
+      m_incrementalBest = out;
+      if (system.options.output.ReportHypoScore) {
+        m_incrementalBest = SPrint(applied.GetScore()) + " " + m_incrementalBest;
+      }
+    }
+
+    if (nbestSize) {
+      nbestStrm << GetTranslationId() << " ||| " << out << " ||| ";
+      scores->OutputBreakdown(nbestStrm, system);
+      nbestStrm << "||| " << applied.GetScore() << endl;
+    }
+  }
+
+  if (derivations.empty() && system.options.output.ReportHypoScore) {
+    m_incrementalBest = "0 ";
+  }
+  m_incrementalNBest = nbestStrm.str();
+}
+
+void Manager::OutputIncremental(const search::Applied &applied,
+                                std::vector<const SCFG::Word*> &words,
+                                Scores &scores) const
+{
+  const SCFG::TargetPhraseImpl &tp =
+    *static_cast<const SCFG::TargetPhraseImpl*>(applied.GetNote().vp);
+  scores.PlusEquals(system, tp.GetScores());
+
+  // children are in target order
+  const search::Applied *child = applied.Children();
+  for (size_t pos = 0; pos < tp.GetSize(); ++pos) {
+    const SCFG::Word &word = tp[pos];
+    if (word.isNonTerminal) {
+      OutputIncremental(*child++, words, scores);
+    } else {
+      words.push_back(&word);
+    }
+  }
+}
+
+template void Manager::LMCallback<lm::ngram::ProbingModel>(const lm::ngram::ProbingModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+template void Manager::LMCallback<lm::ngram::RestProbingModel>(const lm::ngram::RestProbingModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+template void Manager::LMCallback<lm::ngram::TrieModel>(const lm::ngram::TrieModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+template void Manager::LMCallback<lm::ngram::QuantTrieModel>(const lm::ngram::QuantTrieModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+template void Manager::LMCallback<lm::ngram::ArrayTrieModel>(const lm::ngram::ArrayTrieModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+template void Manager::LMCallback<lm::ngram::QuantArrayTrieModel>(const lm::ngram::QuantArrayTrieModel &model, const std::vector<lm::WordIndex> &vocabMapping, FactorType factorType, const StatefulFeatureFunction &lm);
+
+}
+}
@@ -0,0 +1,223 @@
+/*
+ * IncrementalTest.cpp
+ *
+ * Incremental search must find the same translations, with the same feature
+ * scores, as cube pruning when neither search prunes anything.
+ */
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE Moses2Incremental
+#include <boost/test/unit_test.hpp>
+
+#include "util/exception.hh"
+#include "../System.h"
+#include "../TranslationTask.h"
+#include "../TypeDef.h"
+#include "../legacy/Parameter.h"
+#include "../legacy/Util2.h"
+#include "Manager.h"
+
+using namespace Moses2;
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+const char *kArpa =
+  "\\data\\\n"
+  "ngram 1=10\n"
+  "ngram 2=8\n"
+  "\n"
+  "\\1-grams:\n"
+  "-1.0\t<unk>\t0\n"
+  "-99\t<s>\t-0.5\n"
+  "-0.7\t</s>\t0\n"
+  "-0.8\tthe\t-0.3\n"
+  "-1.2\tthat\t-0.2\n"
+  "-1.0\thouse\t-0.3\n"
+  "-1.1\thome\t-0.2\n"
+  "-0.9\tis\t-0.3\n"
+  "-1.1\tsmall\t-0.2\n"
+  "-1.3\tlittle\t-0.1\n"
+  "\n"
+  "\\2-grams:\n"
+  "-0.2\t<s> the\n"
+  "-0.5\t<s> that\n"
+  "-0.3\tthe house\n"
+  "-0.4\thouse is\n"
+  "-0.6\thome is\n"
+  "-0.3\tis small\n"
+  "-0.5\tis little\n"
+  "-0.2\tsmall </s>\n"
+  "\n"
+  "\\end\\\n";
+
+// a glue grammar, ambiguous lexical rules and a reordering rule
+const char *kRules =
+  "<s> [X] ||| <s> [S] ||| 1 ||| |||\n"
+  "[X][S] </s> [X] ||| [X][S] </s> [S] ||| 1 ||| 0-0 |||\n"
+  "[X][S] [X][X] [X] ||| [X][S] [X][X] [S] ||| 2.718 ||| 0-0 1-1 |||\n"
+  "das [X] ||| the [X] ||| 0.6 ||| |||\n"
+  "das [X] ||| that [X] ||| 0.4 ||| |||\n"
+  "haus [X] ||| house [X] ||| 0.7 ||| |||\n"
+  "haus [X] ||| home [X] ||| 0.3 ||| |||\n"
+  "das haus [X] ||| the home [X] ||| 0.5 ||| |||\n"
+  "ist [X] ||| is [X] ||| 1 ||| |||\n"
+  "klein [X] ||| small [X] ||| 0.6 ||| |||\n"
+  "klein [X] ||| little [X] ||| 0.4 ||| |||\n"
+  "[X][X] ist [X][X] [X] ||| [X][X] is [X][X] [X] ||| 0.8 ||| 0-0 2-2 |||\n"
+  "[X][X] [X][X] [X] ||| [X][X] [X][X] [X] ||| 0.5 ||| 0-0 1-1 |||\n"
+  "[X][X] [X][X] [X] ||| [X][X] [X][X] [X] ||| 0.1 ||| 0-1 1-0 |||\n";
+
+// writes the model files to a temporary directory and removes them again
+class ToyModel
+{
+public:
+  explicit ToyModel(size_t numLMs = 1)
+    : m_dir(fs::temp_directory_path() / fs::unique_path()) {
+    fs::create_directory(m_dir);
+    Write("lm.arpa", kArpa);
+    Write("rules.txt", kRules);
+
+    string lms, weights;
+    for (size_t i = 0; i < numLMs; ++i) {
+      lms += "KENLM name=LM" + SPrint(i) + " factor=0 order=2 path="
+             + Path("lm.arpa") + "\n";
+      weights += "LM" + SPrint(i) + "= 0.5\n";
+    }
+    Write("moses.ini",
+          "[input-factors]\n0\n"
+          "[mapping]\n0 T 0\n"
+          "[cube-pruning-pop-limit]\n1000\n"
+          "[non-terminals]\nX\n"
+          "[inputtype]\n3\n"
+          "[max-chart-span]\n20\n1000\n"
+          "[search-algorithm]\n3\n"
+          "[n-best-list]\n" + Path("nbest") + "\n5\n"
+          "[feature]\n"
+          + lms +
+          "WordPenalty\n"
+          "PhrasePenalty\n"
+          "UnknownWordPenalty\n"
+          "PhraseDictionaryMemory name=TranslationModel0 num-features=1 "
+          "input-factor=0 output-factor=0 path=" + Path("rules.txt") + "\n"
+          "[weight]\n"
+          + weights +
+          "WordPenalty0= -0.3\n"
+          "PhrasePenalty0= 0.2\n"
+          "UnknownWordPenalty0= 1\n"
+          "TranslationModel0= 0.3\n");
+    BOOST_REQUIRE(m_params.LoadParam(Path("moses.ini")));
+  }
+
+  ~ToyModel() {
+    fs::remove_all(m_dir);
+  }
+
+  const Parameter &GetParams() const {
+    return m_params;
+  }
+
+private:
+  fs::path m_dir;
+  Parameter m_params;
+
+  string Path(const string &name) const {
+    return (m_dir / name).string();
+  }
+
+  void Write(const string &name, const string &text) const {
+    ofstream out(Path(name).c_str());
+    out << text;
+  }
+};
+
+// owns the manager the task creates, which we do not use
+class TestTask : public TranslationTask
+{
+public:
+  explicit TestTask(System &system) : TranslationTask(system, "", 0) {}
+  ~TestTask() {
+    delete m_mgr;
+  }
+};
+
+struct Result {
+  string best;
+  string nbest;
+};
+
+Result Decode(System &system, SearchAlgorithm algo, const string &input)
+{
+  system.options.search.algo = algo;
+  TestTask task(system);
+  SCFG::Manager mgr(system, task, input, 0);
+  mgr.Decode();
+  Result ret;
+  ret.best = mgr.OutputBest();
+  ret.nbest = mgr.OutputNBest();
+  return ret;
+}
+
+// n-best lists must agree on the translations and, up to rounding, on the
+// feature scores and totals
+void CheckSameNBest(const string &expected, const string &actual)
+{
+  vector<string> expectedLines = Tokenize(expected, "\n");
+  vector<string> actualLines = Tokenize(actual, "\n");
+  BOOST_REQUIRE_EQUAL(expectedLines.size(), actualLines.size());
+  for (size_t i = 0; i < expectedLines.size(); ++i) {
+    vector<string> e = TokenizeMultiCharSeparator(expectedLines[i], "|||");
+    vector<string> a = TokenizeMultiCharSeparator(actualLines[i], "|||");
+    BOOST_REQUIRE_EQUAL(e.size(), 4);
+    BOOST_REQUIRE_EQUAL(a.size(), 4);
+    BOOST_CHECK_EQUAL(e[1], a[1]);
+
+    vector<string> eScores = Tokenize(e[2]);
+    vector<string> aScores = Tokenize(a[2]);
+    BOOST_REQUIRE_EQUAL(eScores.size(), aScores.size());
+    for (size_t j = 0; j < eScores.size(); ++j) {
+      if (eScores[j][eScores[j].size() - 1] == '=') {
+        BOOST_CHECK_EQUAL(eScores[j], aScores[j]);
+      } else {
+        BOOST_CHECK_CLOSE(Scan<float>(eScores[j]), Scan<float>(aScores[j]), 0.001);
+      }
+    }
+    BOOST_CHECK_CLOSE(Scan<float>(e[3]), Scan<float>(a[3]), 0.001);
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(incremental)
+
+BOOST_AUTO_TEST_CASE(matches_cube_pruning)
+{
+  ToyModel model;
+  System system(model.GetParams());
+
+  const char *inputs[] = {
+    "das haus ist klein", "das haus", "ist klein das haus", "haus ist das",
+    "klein", "das unbekannt"
+  };
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+    Result cube = Decode(system, CYKPlus, inputs[i]);
+    Result incremental = Decode(system, ChartIncremental, inputs[i]);
+    BOOST_CHECK_EQUAL(cube.best, incremental.best);
+    CheckSameNBest(cube.nbest, incremental.nbest);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(one_stateful_feature)
+{
+  ToyModel model(2);
+  System system(model.GetParams());
+  BOOST_CHECK_THROW(Decode(system, ChartIncremental, "das haus"),
+                    util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include <sstream>
 #include "../System.h"
 #include "../TranslationModel/PhraseTable.h"
+#include "../FF/StatefulFeatureFunction.h"
 #include "Manager.h"
 #include "InputPath.h"
 #include "Hypothesis.h"
@@ -30,6 +31,7 @@ namespace SCFG
 Manager::Manager(System &sys, const TranslationTask &task,
                  const std::string &inputStr, long translationId)
   :ManagerBase(sys, task, inputStr, translationId)
+  ,m_incremental(sys.options.search.algo == ChartIncremental)
 {
 
 }
@@ -61,6 +63,20 @@ void Manager::Decode()
   m_stacks.Init(*this, inputSize);
   //cerr << "CREATED m_stacks" << endl;
 
+  // rule lookup is interleaved with the search, so both count as search
+  const double start = util::WallTime();
+
+  if (m_incremental) {
+    const std::vector<const StatefulFeatureFunction*> &sfffs =
+      system.featureFunctions.GetStatefulFeatureFunctions();
+    UTIL_THROW_IF2(sfffs.size() != 1,
+                   "Incremental search supports exactly one stateful feature, "
+                   "the language model, but there are " << sfffs.size());
+    sfffs[0]->IncrementalCallback(*this);
+    AddToMetrics(util::WallTime() - start);
+    return;
+  }
+
   for (int startPos = inputSize - 1; startPos >= 0; --startPos) {
     //cerr << endl << "startPos=" << startPos << endl;
     SCFG::InputPath &initPath = *m_inputPaths.GetMatrix().GetValue(startPos, 0);
@@ -96,6 +112,7 @@ void Manager::Decode()
   cerr << "stack 0,12:" << stack->Debug(system) << endl;
   */
   //m_stacks.OutputStacks();
+  AddToMetrics(util::WallTime() - start);
 }
 
 void Manager::InitActiveChart(SCFG::InputPath &path)
@@ -180,7 +197,7 @@ void Manager::Decode(SCFG::InputPath &path, Stack &stack)
 
   // MAIN LOOP
   size_t pops = 0;
-  while (!m_queue.empty() && pops < system.options.cube.pop_limit) {
+  while (!m_queue.empty() && pops < GetCubePopLimit()) {
     //cerr << "pops=" << pops << endl;
     QueueItem *item = m_queue.top();
     m_queue.pop();
@@ -326,6 +343,10 @@ bool Manager::IncrPrevHypoIndices(
 
 std::string Manager::OutputBest() const
 {
+  if (m_incremental) {
+    return m_incrementalBest;
+  }
+
   string out;
   const Stack &lastStack = m_stacks.GetLastStack();
   const SCFG::Hypothesis *bestHypo = lastStack.GetBestHypo();
@@ -357,6 +378,10 @@ std::string Manager::OutputBest() const
 
 std::string Manager::OutputNBest()
 {
+  if (m_incremental) {
+    return m_incrementalNBest;
+  }
+
   stringstream out;
   //Moses2::FixPrecision(out);
 
@@ -371,6 +396,10 @@ std::string Manager::OutputNBest()
 
 std::string Manager::OutputTransOpt()
 {
+  if (m_incremental) {
+    return "";
+  }
+
   const Stack &lastStack = m_stacks.GetLastStack();
   const SCFG::Hypothesis *bestHypo = lastStack.GetBestHypo();
 
@@ -11,13 +11,23 @@
 #include <cstddef>
 #include <string>
 #include <deque>
+#include <vector>
+#include "lm/word_index.hh"
+#include "search/types.hh"
 #include "../ManagerBase.h"
 #include "Stacks.h"
 #include "InputPaths.h"
 #include "Misc.h"
 
+namespace search
+{
+class Applied;
+}
+
 namespace Moses2
 {
+class Scores;
+class StatefulFeatureFunction;
 
 namespace SCFG
 {
@@ -49,6 +59,14 @@ public:
     return m_stacks;
   }
 
+  // Incremental search (search-algorithm 5). Called back by the language
+  // model, which is the only stateful feature function this search scores.
+  template<class Model>
+  void LMCallback(const Model &model,
+                  const std::vector<lm::WordIndex> &vocabMapping,
+                  FactorType factorType,
+                  const StatefulFeatureFunction &lm);
+
 protected:
   Stacks m_stacks;
   SCFG::InputPaths m_inputPaths;
@@ -79,6 +97,21 @@ protected:
     const SCFG::InputPath &path,
     const SymbolBind &symbolBind,
     const SCFG::TargetPhrases &tps);
+
+  // incremental search
+  bool m_incremental;
+  std::string m_incrementalBest;
+  std::string m_incrementalNBest;
+
+  template<class Model, class Best>
+  search::History IncrementalSearch(const Model &model,
+                                const std::vector<lm::WordIndex> &vocabMapping,
+                                FactorType factorType,
+                                SCORE lmWeight,
+                                Best &best);
+  void OutputIncremental(const search::Applied &applied,
+                         std::vector<const SCFG::Word*> &words,
+                         Scores &scores) const;
 };
 
 }
@@ -35,6 +35,12 @@ public:
 
   const Hypothesis *GetBestHypo() const;
 
+  // Make nt visible to rule lookup without adding a hypothesis. Used by
+  // incremental search, which keeps its hypotheses outside the stacks.
+  void AddLabel(const SCFG::Word &nt) {
+    GetColl(nt);
+  }
+
   std::string Debug(const System &system) const;
 
 protected:
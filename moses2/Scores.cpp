@@ -248,7 +248,7 @@ void Scores::OutputBreakdown(std::ostream &out, const System &system) const
 
 // static functions to work out estimated scores
 SCORE Scores::CalcWeightedScore(const System &system,
-                                const FeatureFunction &featureFunction, SCORE scores[])
+                                const FeatureFunction &featureFunction, const SCORE scores[])
 {
   SCORE ret = 0;
 
@@ -67,7 +67,7 @@ public:
 
   // static functions to work out estimated scores
   static SCORE CalcWeightedScore(const System &system,
-                                 const FeatureFunction &featureFunction, SCORE scores[]);
+                                 const FeatureFunction &featureFunction, const SCORE scores[]);
 
   static SCORE CalcWeightedScore(const System &system,
                                  const FeatureFunction &featureFunction, SCORE score);
@@ -211,6 +211,7 @@ void System::IsPb()
     isPb = true;
     break;
   case CYKPlus:
+  case ChartIncremental:
     isPb = false;
     break;
   default:
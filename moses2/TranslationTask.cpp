@@ -3,6 +3,7 @@
 #include "InputType.h"
 #include "PhraseBased/Manager.h"
 #include "SCFG/Manager.h"
+#include "Metrics.h"
 
 using namespace std;
 
@@ -31,10 +32,14 @@ void TranslationTask::Run()
 
   string out;
 
-  out = m_mgr->OutputBest() + "\n";
-  m_mgr->system.bestCollector->Write(m_mgr->GetTranslationId(), out);
+  {
+    MetricsTimer timer(Metrics::Output);
+    out = m_mgr->OutputBest() + "\n";
+    m_mgr->system.bestCollector->Write(m_mgr->GetTranslationId(), out);
+  }
 
   if (m_mgr->system.options.nbest.nbest_size) {
+    MetricsTimer timer(Metrics::NBest);
     out = m_mgr->OutputNBest();
     m_mgr->system.nbestCollector->Write(m_mgr->GetTranslationId(), out);
   }
@@ -26,30 +26,31 @@ namespace Moses2
 {
 
 Bitmap::Bitmap(MemPool &pool, size_t size) :
-  m_bitmap(pool, size)
+  m_bitmap(pool, NumWords(size)),
+  m_size(size),
+  m_id(NOT_FOUND),
+  m_estimatedScore(0)
 {
 }
 
 void Bitmap::Init(const std::vector<bool>& initializer)
 {
-
-  for (size_t i = 0; i < initializer.size(); ++i) {
-    m_bitmap[i] = initializer[i];
+  for (size_t i = 0; i < m_bitmap.size(); ++i) {
+    m_bitmap[i] = 0;
   }
 
-  // The initializer may not be of the same length.  Change to the desired
-  // length.  If we need to add any elements, initialize them to false.
-  for (size_t i = initializer.size(); i < m_bitmap.size(); ++i) {
-    m_bitmap[i] = false;
+  // The initializer may not be of the same length. Positions past its end
+  // are not translated.
+  m_numWordsCovered = 0;
+  for (size_t i = 0; i < initializer.size() && i < m_size; ++i) {
+    if (initializer[i]) {
+      m_bitmap[i / 64] |= uint64_t(1) << (i % 64);
+      ++m_numWordsCovered;
+    }
   }
 
-  m_numWordsCovered = std::count(m_bitmap.begin(), m_bitmap.end(), true);
-
   // Find the first gap, and cache it.
-  Array<char>::const_iterator first_gap = std::find(m_bitmap.begin(),
-                                          m_bitmap.end(), false);
-  m_firstGap = ((first_gap == m_bitmap.end()) ?
-                NOT_FOUND: first_gap - m_bitmap.begin());
+  m_firstGap = FindForward(0, false);
 }
 
 void Bitmap::Init(const Bitmap &copy, const Range &range)
@@ -71,13 +72,13 @@ size_t Bitmap::hash() const
 
 bool Bitmap::operator==(const Bitmap& other) const
 {
-  return m_bitmap == other.m_bitmap;
+  return m_size == other.m_size && m_bitmap == other.m_bitmap;
 }
 
 // friend
 std::ostream& operator<<(std::ostream& out, const Bitmap& bitmap)
 {
-  for (size_t i = 0; i < bitmap.m_bitmap.size(); i++) {
+  for (size_t i = 0; i < bitmap.m_size; i++) {
     out << int(bitmap.GetValue(i));
   }
   return out;
@@ -28,6 +28,7 @@
 #include <cstring>
 #include <cmath>
 #include <cstdlib>
+#include <stdint.h>
 #include "Range.h"
 #include "../Array.h"
 
@@ -39,38 +40,67 @@ typedef unsigned long WordsBitmapID;
 
 /** Vector of boolean to represent whether a word has been translated or not.
  *
- * Implemented using a vector of char, which is usually the same representation
- * for the elements that a C array of bool would use.  A vector of bool, or a
- * Boost dynamic_bitset, could be much more efficient in theory.  Unfortunately
- * algorithms like std::find() are not optimized for vector<bool> on gcc or
- * clang, and dynamic_bitset lacks all the optimized search operations we want.
- * Only benchmarking will tell what works best.  Perhaps dynamic_bitset could
- * still be a dramatic improvement, if we flip the meaning of the bits around
- * so we can use its find_first() and find_next() for the most common searches.
+ * The bits are packed into 64-bit words, so that the searches for gaps and
+ * translated words, overlap tests, hashing and comparison work on a word at
+ * a time rather than a position at a time. Bits past the end of the sentence
+ * are always 0.
  */
 class Bitmap
 {
   friend std::ostream& operator<<(std::ostream& out, const Bitmap& bitmap);
+  friend class Bitmaps;
 private:
-  Array<char> m_bitmap; //! Ticks of words in sentence that have been done.
+  Array<uint64_t> m_bitmap; //! Ticks of words in sentence that have been done, 64 to a word.
+  size_t m_size; //! Number of words in the sentence
   size_t m_firstGap; //! Cached position of first gap, or NOT_FOUND.
   size_t m_numWordsCovered;
+  size_t m_id; //! Index given by Bitmaps when the bitmap is interned
+  float m_estimatedScore; //! Future score of the gaps, set by Bitmaps when the bitmap is interned
 
   Bitmap(); // not implemented
   Bitmap& operator=(const Bitmap& other);
 
+  static size_t NumWords(size_t size) {
+    return (size + 63) / 64;
+  }
+
+  //! bits from startPos to endPos inclusive, within the word holding them
+  static uint64_t Mask(size_t startPos, size_t endPos) {
+    uint64_t upper = (endPos % 64 == 63) ? ~uint64_t(0) : ((uint64_t(1) << (endPos % 64 + 1)) - 1);
+    return upper & (~uint64_t(0) << (startPos % 64));
+  }
+
+  //! position of the first word at or after pos which is (covered=true) or isn't translated, or NOT_FOUND
+  size_t FindForward(size_t pos, bool covered) const {
+    for (size_t i = pos / 64; i < m_bitmap.size(); ++i) {
+      uint64_t bits = covered ? m_bitmap[i] : ~m_bitmap[i];
+      if (i == pos / 64) bits &= ~uint64_t(0) << (pos % 64);
+      if (bits) {
+        size_t found = i * 64 + __builtin_ctzll(bits);
+        return found < m_size ? found : NOT_FOUND;
+      }
+    }
+    return NOT_FOUND;
+  }
+
+  //! position of the last word at or before pos which is (covered=true) or isn't translated, or NOT_FOUND
+  size_t FindBackward(size_t pos, bool covered) const {
+    for (size_t i = pos / 64 + 1; i > 0; --i) {
+      uint64_t bits = covered ? m_bitmap[i - 1] : ~m_bitmap[i - 1];
+      if (i - 1 == pos / 64) bits &= Mask(0, pos);
+      if (bits) {
+        return (i - 1) * 64 + 63 - __builtin_clzll(bits);
+      }
+    }
+    return NOT_FOUND;
+  }
+
   /** Update the first gap, when bits are flipped */
   void UpdateFirstGap(size_t startPos, size_t endPos, bool value) {
     if (value) {
       //may remove gap
       if (startPos <= m_firstGap && m_firstGap <= endPos) {
-        m_firstGap = NOT_FOUND;
-        for (size_t i = endPos + 1; i < m_bitmap.size(); ++i) {
-          if (!m_bitmap[i]) {
-            m_firstGap = i;
-            break;
-          }
-        }
+        m_firstGap = FindForward(endPos + 1, false);
       }
 
     } else {
@@ -87,8 +117,10 @@ private:
     size_t startPos = range.GetStartPos();
     size_t endPos = range.GetEndPos();
 
-    for(size_t pos = startPos; pos <= endPos; pos++) {
-      m_bitmap[pos] = true;
+    for (size_t i = startPos / 64; i <= endPos / 64; ++i) {
+      size_t from = (i == startPos / 64) ? startPos : 0;
+      size_t to = (i == endPos / 64) ? endPos : 63;
+      m_bitmap[i] |= Mask(from, to);
     }
 
     m_numWordsCovered += range.GetNumWordsCovered();
@@ -112,39 +144,37 @@ public:
     return m_firstGap;
   }
 
+  //! position of 1st word not yet translated at or after pos, or NOT_FOUND
+  size_t GetNextGapPos(size_t pos) const {
+    return FindForward(pos, false);
+  }
+
+  //! position of 1st translated word at or after pos, or NOT_FOUND
+  size_t GetNextPos(size_t pos) const {
+    return FindForward(pos, true);
+  }
+
   //! position of last word not yet translated, or NOT_FOUND if everything already translated
   size_t GetLastGapPos() const {
-    for (int pos = int(m_bitmap.size()) - 1; pos >= 0; pos--) {
-      if (!m_bitmap[pos]) {
-        return pos;
-      }
-    }
-    // no starting pos
-    return NOT_FOUND;
+    return m_size ? FindBackward(m_size - 1, false) : NOT_FOUND;
   }
 
   //! position of last translated word
   size_t GetLastPos() const {
-    for (int pos = int(m_bitmap.size()) - 1; pos >= 0; pos--) {
-      if (m_bitmap[pos]) {
-        return pos;
-      }
-    }
-    // no starting pos
-    return NOT_FOUND;
+    return m_size ? FindBackward(m_size - 1, true) : NOT_FOUND;
   }
 
   //! whether a word has been translated at a particular position
   bool GetValue(size_t pos) const {
-    return bool(m_bitmap[pos]);
+    return (m_bitmap[pos / 64] >> (pos % 64)) & 1;
   }
   //! set value at a particular position
   void SetValue( size_t pos, bool value ) {
-    bool origValue = m_bitmap[pos];
+    bool origValue = GetValue(pos);
     if (origValue == value) {
       // do nothing
     } else {
-      m_bitmap[pos] = value;
+      m_bitmap[pos / 64] ^= uint64_t(1) << (pos % 64);
       UpdateFirstGap(pos, pos, value);
       if (value) {
         ++m_numWordsCovered;
@@ -160,39 +190,44 @@ public:
   }
   //! whether the wordrange overlaps with any translated word in this bitmap
   bool Overlap(const Range &compare) const {
-    for (size_t pos = compare.GetStartPos(); pos <= compare.GetEndPos(); pos++) {
-      if (m_bitmap[pos])
+    size_t startPos = compare.GetStartPos();
+    size_t endPos = compare.GetEndPos();
+    for (size_t i = startPos / 64; i <= endPos / 64; ++i) {
+      size_t from = (i == startPos / 64) ? startPos : 0;
+      size_t to = (i == endPos / 64) ? endPos : 63;
+      if (m_bitmap[i] & Mask(from, to))
         return true;
     }
     return false;
   }
   //! number of elements
   size_t GetSize() const {
-    return m_bitmap.size();
+    return m_size;
   }
 
   inline size_t GetEdgeToTheLeftOf(size_t l) const {
     if (l == 0) return l;
-    while (l && !m_bitmap[l-1]) {
-      --l;
-    }
-    return l;
+    size_t pos = FindBackward(l - 1, true);
+    return pos == NOT_FOUND ? 0 : pos + 1;
   }
 
   inline size_t GetEdgeToTheRightOf(size_t r) const {
-    if (r+1 == m_bitmap.size()) return r;
-    return (
-             std::find(m_bitmap.begin() + r + 1, m_bitmap.end(), true) -
-             m_bitmap.begin()
-           ) - 1;
+    if (r+1 == m_size) return r;
+    size_t pos = FindForward(r + 1, true);
+    return (pos == NOT_FOUND ? m_size : pos) - 1;
+  }
+
+  //! future score of the gaps, cached when the bitmap is taken from Bitmaps
+  float GetEstimatedScore() const {
+    return m_estimatedScore;
   }
 
   //! converts bitmap into an integer ID: it consists of two parts: the first 16 bit are the pattern between the first gap and the last word-1, the second 16 bit are the number of filled positions. enforces a sentence length limit of 65535 and a max distortion of 16
   WordsBitmapID GetID() const {
-    assert(m_bitmap.size() < (1<<16));
+    assert(m_size < (1<<16));
 
     size_t start = GetFirstGapPos();
-    if (start == NOT_FOUND) start = m_bitmap.size(); // nothing left
+    if (start == NOT_FOUND) start = m_size; // nothing left
 
     size_t end = GetLastPos();
     if (end == NOT_FOUND) end = 0;// nothing translated yet
@@ -207,10 +242,10 @@ public:
 
   //! converts bitmap into an integer ID, with an additional span covered
   WordsBitmapID GetIDPlus( size_t startPos, size_t endPos ) const {
-    assert(m_bitmap.size() < (1<<16));
+    assert(m_size < (1<<16));
 
     size_t start = GetFirstGapPos();
-    if (start == NOT_FOUND) start = m_bitmap.size(); // nothing left
+    if (start == NOT_FOUND) start = m_size; // nothing left
 
     size_t end = GetLastPos();
     if (end == NOT_FOUND) end = 0;// nothing translated yet
@@ -1,6 +1,7 @@
 #include <boost/foreach.hpp>
 #include "Bitmaps.h"
 #include "Util2.h"
+#include "../EstimatedScores.h"
 
 using namespace std;
 
@@ -8,7 +9,10 @@ namespace Moses2
 {
 
 Bitmaps::Bitmaps(MemPool &pool) :
-  m_pool(pool)
+  m_collSize(0),
+  m_next(1024, ~uint64_t(0)),
+  m_pool(pool),
+  m_estimatedScores(NULL)
 {
 }
 
@@ -17,11 +21,52 @@ Bitmaps::~Bitmaps()
 }
 
 void Bitmaps::Init(size_t inputSize,
-                   const std::vector<bool> &initSourceCompleted)
+                   const std::vector<bool> &initSourceCompleted,
+                   const EstimatedScores &estimatedScores)
 {
+  m_estimatedScores = &estimatedScores;
+  m_coll.assign(1024, NULL);
+  m_collSize = 0;
+  m_next.Clear();
+
   m_initBitmap = new (m_pool.Allocate<Bitmap>()) Bitmap(m_pool, inputSize);
   m_initBitmap->Init(initSourceCompleted);
-  m_coll[m_initBitmap];
+  Intern(m_initBitmap);
+}
+
+// Returns the bitmap already interned with the same bits, or interns bm and
+// returns it
+const Bitmap *Bitmaps::Intern(Bitmap *bm)
+{
+  size_t mask = m_coll.size() - 1;
+  size_t slot = bm->hash() & mask;
+  while (m_coll[slot]) {
+    if (*m_coll[slot] == *bm) {
+      return m_coll[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  bm->m_id = m_collSize++;
+  bm->m_estimatedScore = m_estimatedScores->CalcEstimatedScore(*bm);
+  m_coll[slot] = bm;
+
+  // keep the table at most half full
+  if (2 * m_collSize > m_coll.size()) {
+    std::vector<const Bitmap*> old(2 * m_coll.size(), NULL);
+    old.swap(m_coll);
+    mask = m_coll.size() - 1;
+    BOOST_FOREACH(const Bitmap *interned, old) {
+      if (interned) {
+        slot = interned->hash() & mask;
+        while (m_coll[slot]) {
+          slot = (slot + 1) & mask;
+        }
+        m_coll[slot] = interned;
+      }
+    }
+  }
+  return bm;
 }
 
 const Bitmap &Bitmaps::GetNextBitmap(const Bitmap &bm, const Range &range)
@@ -36,35 +81,29 @@ const Bitmap &Bitmaps::GetNextBitmap(const Bitmap &bm, const Range &range)
 
   newBM->Init(bm, range);
 
-  Coll::const_iterator iter = m_coll.find(newBM);
-  if (iter == m_coll.end()) {
-    m_coll[newBM] = NextBitmaps();
-    return *newBM;
-  } else {
+  const Bitmap *interned = Intern(newBM);
+  if (interned != newBM) {
     m_recycler.push(newBM);
-
-    return *iter->first;
   }
+  return *interned;
 }
 
 const Bitmap &Bitmaps::GetBitmap(const Bitmap &bm, const Range &range)
 {
-  Coll::iterator iter = m_coll.find(&bm);
-  assert(iter != m_coll.end());
+  assert(bm.m_id != NOT_FOUND);
+  assert(bm.GetSize() < (1<<16));
+
+  // bitmap id in the upper 32 bits, start and end of the range below
+  NextBitmap link;
+  link.key = (uint64_t(bm.m_id) << 32) | (uint64_t(range.GetStartPos()) << 16)
+             | uint64_t(range.GetEndPos());
 
-  const Bitmap *newBM;
-  NextBitmaps &next = iter->second;
-  NextBitmaps::const_iterator iterNext = next.find(&range);
-  if (iterNext == next.end()) {
+  NextBitmaps::MutableIterator iter;
+  if (!m_next.FindOrInsert(link, iter)) {
     // not seen the link yet.
-    newBM = &GetNextBitmap(bm, range);
-    next[&range] = newBM;
-  } else {
-    // link exist
-    //std::cerr << "link exists" << endl;
-    newBM = iterNext->second;
+    iter->bitmap = &GetNextBitmap(bm, range);
   }
-  return *newBM;
+  return *iter->bitmap;
 }
 
 }
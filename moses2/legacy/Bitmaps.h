@@ -1,33 +1,54 @@
 #pragma once
 
-#include <boost/unordered_set.hpp>
-#include <boost/unordered_map.hpp>
-#include <set>
+#include <vector>
 #include <stack>
+#include <stdint.h>
 #include "Bitmap.h"
 #include "Util2.h"
+#include "util/murmur_hash.hh"
+#include "util/probing_hash_table.hh"
 
 namespace Moses2
 {
 class MemPool;
+class EstimatedScores;
 
 class Bitmaps
 {
-  typedef boost::unordered_map<const Range*, const Bitmap*> NextBitmaps;
-  typedef boost::unordered_map<const Bitmap*, NextBitmaps,
-		  UnorderedComparer<Bitmap>, UnorderedComparer<Bitmap> > Coll;
-  //typedef std::set<const Bitmap*, OrderedComparer<Bitmap> > Coll;
-  Coll m_coll;
+  //! link from an interned bitmap and a source range to the bitmap they make
+  struct NextBitmap {
+    typedef uint64_t Key;
+    uint64_t key;
+    const Bitmap *bitmap;
+
+    uint64_t GetKey() const {
+      return key;
+    }
+    void SetKey(uint64_t to) {
+      key = to;
+    }
+  };
+
+  // packed keys differ in few bits
+  typedef util::AutoProbing<NextBitmap, util::MurmurMixHash> NextBitmaps;
+
+  //! open addressing on the bit pattern, NULL for empty slots. Size is a power of 2
+  std::vector<const Bitmap*> m_coll;
+  size_t m_collSize;
+  NextBitmaps m_next;
   Bitmap *m_initBitmap;
 
   MemPool &m_pool;
+  const EstimatedScores *m_estimatedScores;
   std::stack<Bitmap*> m_recycler;
 
   const Bitmap &GetNextBitmap(const Bitmap &bm, const Range &range);
+  const Bitmap *Intern(Bitmap *bm);
 public:
   Bitmaps(MemPool &pool);
   virtual ~Bitmaps();
-  void Init(size_t inputSize, const std::vector<bool> &initSourceCompleted);
+  void Init(size_t inputSize, const std::vector<bool> &initSourceCompleted,
+            const EstimatedScores &estimatedScores);
 
   const Bitmap &GetInitialBitmap() const {
     return *m_initBitmap;
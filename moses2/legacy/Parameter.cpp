@@ -54,6 +54,8 @@ Parameter::Parameter()
 
   AddParam(main_opts, "verbose", "v", "verbosity level of the logging");
   AddParam(main_opts, "show-weights", "print feature weights and exit");
+  AddParam(main_opts, "metrics-dump",
+           "write decoder metrics every N seconds, to the given file or stderr: N [file]");
   //AddParam(main_opts, "time-out",
   //    "seconds after which is interrupted (-1=no time-out, default is -1)");
 
@@ -308,6 +310,8 @@ Parameter::Parameter()
            "Max. number of seconds the server will keep a persistent connection alive.");
   AddParam(server_opts,"server-timeout",
            "Max. number of seconds the server will wait for a client to submit a request once a connection has been established.");
+  AddParam(server_opts,"server-result-cache",
+           "Max. No. of translations the server caches for repeated requests (default 0 = no cache).");
 
   po::options_description irstlm_opts("IRSTLM Options");
   //AddParam(irstlm_opts, "clean-lm-cache",
@@ -40,7 +40,7 @@ namespace Moses2
 
 ThreadPool::ThreadPool(size_t numThreads, int cpuAffinityOffset,
                        int cpuAffinityIncr) :
-  m_stopped(false), m_stopping(false), m_queueLimit(numThreads*2)
+  m_stopped(false), m_stopping(false), m_queueLimit(numThreads*2), m_submitted(0)
 {
 #if defined(_WIN32) || defined(_WIN64)
   size_t numCPU = std::thread::hardware_concurrency();
@@ -100,7 +100,7 @@ void ThreadPool::Execute()
         m_threadNeeded.wait(lock);
       }
       if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
+        task = m_tasks.top().task;
         m_tasks.pop();
       }
     }
@@ -124,7 +124,8 @@ void ThreadPool::Submit(boost::shared_ptr<Task> task)
   while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
     m_threadAvailable.wait(lock);
   }
-  m_tasks.push(task);
+  QueuedTask queued = { task->GetPriority(), m_submitted++, task };
+  m_tasks.push(queued);
   m_threadNeeded.notify_all();
 }
 
@@ -54,6 +54,10 @@ public:
   virtual bool DeleteAfterExecution() {
     return true;
   }
+  //! Queued tasks with a higher priority run first, equal ones in order
+  virtual int GetPriority() const {
+    return 0;
+  }
   virtual ~Task() {
   }
 };
@@ -95,7 +99,20 @@ private:
    **/
   void Execute();
 
-  std::queue<boost::shared_ptr<Task> > m_tasks;
+  struct QueuedTask {
+    int priority;
+    size_t order; //! submission count, for FIFO among equal priorities
+    boost::shared_ptr<Task> task;
+
+    //! whether this task runs after other
+    bool operator<(const QueuedTask &other) const {
+      if (priority != other.priority) return priority < other.priority;
+      return order > other.order;
+    }
+  };
+
+  std::priority_queue<QueuedTask> m_tasks;
+  size_t m_submitted;
   boost::thread_group m_threads;
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
@@ -0,0 +1,107 @@
+/*
+ * BatchTranslator.cpp
+ *
+ *  Translates several segments per XML-RPC call.
+ */
+#include <boost/shared_ptr.hpp>
+#include "BatchTranslator.h"
+#include "Translator.h"
+#include "TranslationRequest.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+BatchTranslator::BatchTranslator(Translator &translator)
+  : m_translator(translator)
+{
+  this->_signature = "S:S";
+  this->_help = "Translates an array of segments";
+}
+
+BatchTranslator::~BatchTranslator()
+{
+}
+
+void BatchTranslator::execute(xmlrpc_c::paramList const& paramList,
+                              xmlrpc_c::value *const  retvalP)
+{
+  typedef std::map<std::string,xmlrpc_c::value> param_t;
+  param_t const& params = paramList.getStruct(0);
+  param_t::const_iterator si;
+  si = params.find("texts");
+  if (si == params.end()) {
+    throw xmlrpc_c::fault("Missing source texts", xmlrpc_c::fault::CODE_PARSE);
+  }
+  vector<xmlrpc_c::value> const texts = xmlrpc_c::value_array(si->second).vectorValueValue();
+
+  // every segment is converted, and looked up in the result cache, before
+  // anything is queued, so a malformed segment cannot leave requests behind
+  // that still refer to cond and mut below
+  ResultCache &cache = m_translator.GetResultCache();
+  vector<string> lines(texts.size());
+  vector<ResultCache::Params> cached(texts.size());
+  vector<string> keys(texts.size());
+  vector<uint64_t> generations(texts.size());
+  vector<bool> cacheable(texts.size(), false);
+  vector<bool> hit(texts.size(), false);
+  for (size_t i = 0; i < texts.size(); ++i) {
+    lines[i] = static_cast<string>(xmlrpc_c::value_string(texts[i]));
+    if (cache.IsEnabled()) {
+      param_t segment = params;
+      segment.erase("texts");
+      segment["text"] = texts[i];
+      cacheable[i] = ResultCache::GetKey(segment, keys[i]);
+      hit[i] = cacheable[i] && cache.Get(keys[i], cached[i], generations[i]);
+    }
+  }
+
+  // all segments are queued at once; this connection thread waits only
+  // for the one it needs next. A segment that misses the deadline gets
+  // an "error" entry instead of "text". Segments found in the result cache
+  // are not queued at all
+  boost::condition_variable cond;
+  boost::mutex mut;
+  vector<boost::shared_ptr<TranslationRequest> > tasks(texts.size());
+  try {
+    for (size_t i = 0; i < texts.size(); ++i) {
+      if (!hit[i]) {
+        tasks[i] = m_translator.Submit(paramList, cond, mut, lines[i]);
+      }
+    }
+  } catch (...) {
+    // the queued requests notify cond when they finish, so it has to
+    // outlive them
+    boost::unique_lock<boost::mutex> lock(mut);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      while (tasks[i] && !tasks[i]->IsDone()) {
+        cond.wait(lock);
+      }
+    }
+    throw;
+  }
+
+  vector<xmlrpc_c::value> translations;
+  translations.reserve(tasks.size());
+  boost::unique_lock<boost::mutex> lock(mut);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    if (!tasks[i]) {
+      translations.push_back(xmlrpc_c::value_struct(cached[i]));
+      continue;
+    }
+    while (!tasks[i]->IsDone()) {
+      cond.wait(lock);
+    }
+    if (cacheable[i] && !tasks[i]->IsExpired()) {
+      cache.Put(keys[i], tasks[i]->GetRetData(), generations[i]);
+    }
+    translations.push_back(xmlrpc_c::value_struct(tasks[i]->GetRetData()));
+  }
+
+  param_t ret;
+  ret["translations"] = xmlrpc_c::value_array(translations);
+  *retvalP = xmlrpc_c::value_struct(ret);
+}
+
+} /* namespace Moses2 */
@@ -0,0 +1,36 @@
+/*
+ * BatchTranslator.h
+ *
+ *  Translates several segments per XML-RPC call.
+ */
+
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace Moses2
+{
+class Translator;
+
+/** The translate_batch method. The "texts" member of the parameter struct
+ * holds an array of segments, which are decoded in parallel on the thread
+ * pool of the translate method. The result holds the translations, in the
+ * order of the segments, as an array of structs like the one returned by
+ * translate.
+ */
+class BatchTranslator : public xmlrpc_c::method
+{
+public:
+  BatchTranslator(Translator &translator);
+  virtual ~BatchTranslator();
+
+  void execute(xmlrpc_c::paramList const& paramList,
+               xmlrpc_c::value *   const  retvalP);
+
+protected:
+  Translator &m_translator;
+
+};
+
+} /* namespace Moses2 */
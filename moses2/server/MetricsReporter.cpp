@@ -0,0 +1,42 @@
+/*
+ * MetricsReporter.cpp
+ *
+ *  The metrics method of the server.
+ */
+#include <sstream>
+#include "MetricsReporter.h"
+#include "Translator.h"
+#include "../Metrics.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+MetricsReporter::MetricsReporter(Translator &translator)
+  : m_translator(translator)
+{
+  this->_signature = "s:";
+  this->_help = "Returns decoder metrics in the Prometheus text format";
+}
+
+MetricsReporter::~MetricsReporter()
+{
+}
+
+void MetricsReporter::execute(xmlrpc_c::paramList const& paramList,
+                              xmlrpc_c::value *const  retvalP)
+{
+  paramList.verifyEnd(0);
+  ostringstream out;
+  Metrics::Instance().Write(out);
+  const ResultCache &cache = m_translator.GetResultCache();
+  out << "# TYPE moses2_server_result_cache_total counter\n"
+      << "moses2_server_result_cache_total{result=\"hit\"} "
+      << cache.GetHits() << "\n"
+      << "moses2_server_result_cache_total{result=\"miss\"} "
+      << cache.GetMisses() << "\n";
+  *retvalP = xmlrpc_c::value_string(out.str());
+}
+
+} /* namespace Moses2 */
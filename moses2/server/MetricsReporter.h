@@ -0,0 +1,33 @@
+/*
+ * MetricsReporter.h
+ *
+ *  The metrics method of the server.
+ */
+
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace Moses2
+{
+class Translator;
+
+/** Returns the decoder metrics and the counters of the result cache as a
+ * string in the Prometheus text format.
+ */
+class MetricsReporter : public xmlrpc_c::method
+{
+public:
+  MetricsReporter(Translator &translator);
+  virtual ~MetricsReporter();
+
+  void execute(xmlrpc_c::paramList const& paramList,
+               xmlrpc_c::value *   const  retvalP);
+
+protected:
+  Translator &m_translator;
+
+};
+
+} /* namespace Moses2 */
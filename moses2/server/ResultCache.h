@@ -0,0 +1,65 @@
+/*
+ * ResultCache.h
+ *
+ *  Exact-match cache of translation responses.
+ */
+
+#pragma once
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <xmlrpc-c/base.hpp>
+
+namespace Moses2
+{
+
+/** Translation responses keyed on the source text, with white space
+ * normalized, and on every other request parameter, so that only identical
+ * requests share an entry. The least recently used entry is dropped when
+ * the cache is full.
+ */
+class ResultCache
+{
+public:
+  typedef std::map<std::string, xmlrpc_c::value> Params;
+
+  ResultCache(size_t capacity);
+
+  //! false if requests with these parameters must always be decoded
+  static bool GetKey(const Params &params, std::string &key);
+
+  //! generation is set to the one to pass to Put() after decoding
+  bool Get(const std::string &key, Params &result, uint64_t &generation);
+  void Put(const std::string &key, const Params &result, uint64_t generation);
+
+  //! drop everything, e.g. after the model or weights changed
+  void Clear();
+
+  bool IsEnabled() const {
+    return m_capacity > 0;
+  }
+  uint64_t GetHits() const;
+  uint64_t GetMisses() const;
+
+protected:
+  typedef std::list<std::string> Lru;
+  struct Entry {
+    Params result;
+    Lru::iterator position;
+  };
+
+  size_t m_capacity;
+  mutable boost::mutex m_mutex;
+  boost::unordered_map<std::string, Entry> m_entries;
+  Lru m_lru; // most recently used first
+  // bumped by Clear(), so that a decode that started before an update
+  // does not store its stale result
+  uint64_t m_generation;
+  uint64_t m_hits, m_misses;
+};
+
+} /* namespace Moses2 */
@@ -8,6 +8,8 @@
 #include "../System.h"
 #include "Server.h"
 #include "Translator.h"
+#include "BatchTranslator.h"
+#include "MetricsReporter.h"
 #include "../parameters/ServerOptions.h"
 
 using namespace std;
@@ -18,8 +20,12 @@ namespace Moses2
 Server::Server(ServerOptions &server_options, System &system)
   :m_server_options(server_options)
   ,m_translator(new Translator(*this, system))
+  ,m_batchTranslator(new BatchTranslator(*static_cast<Translator*>(m_translator.get())))
+  ,m_metrics(new MetricsReporter(*static_cast<Translator*>(m_translator.get())))
 {
   m_registry.addMethod("translate", m_translator);
+  m_registry.addMethod("translate_batch", m_batchTranslator);
+  m_registry.addMethod("metrics", m_metrics);
 }
 
 Server::~Server()
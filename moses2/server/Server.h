@@ -32,6 +32,8 @@ protected:
   std::string m_pidfile;
   xmlrpc_c::registry m_registry;
   xmlrpc_c::methodPtr const m_translator;
+  xmlrpc_c::methodPtr const m_batchTranslator;
+  xmlrpc_c::methodPtr const m_metrics;
 
 };
 
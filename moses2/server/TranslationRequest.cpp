@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <boost/foreach.hpp>
 #include "TranslationRequest.h"
 #include "../ManagerBase.h"
 #include "../System.h"
+#include "../Metrics.h"
+#include "util/usage.hh"
 
 using namespace std;
 
@@ -18,8 +21,23 @@ TranslationRequest(xmlrpc_c::paramList const& paramList,
   ,m_cond(cond)
   ,m_mutex(mut)
   ,m_done(false)
+  ,m_priority(0)
+  ,m_deadline(0)
+  ,m_budget(0)
+  ,m_expired(false)
 {
-
+  typedef std::map<std::string,xmlrpc_c::value> param_t;
+  param_t const& params = paramList.getStruct(0);
+  param_t::const_iterator si = params.find("priority");
+  if (si != params.end()) {
+    m_priority = xmlrpc_c::value_int(si->second);
+  }
+  // the deadline is given in milliseconds from the arrival of the request
+  si = params.find("deadline");
+  if (si != params.end()) {
+    m_budget = xmlrpc_c::value_int(si->second) / 1000.0;
+    m_deadline = util::WallTime() + m_budget;
+  }
 }
 
 boost::shared_ptr<TranslationRequest>
@@ -43,17 +61,43 @@ void
 TranslationRequest::
 Run()
 {
+  if (m_deadline) {
+    double left = m_deadline - util::WallTime();
+    if (left <= 0) {
+      m_expired = true;
+      m_retData["error"] = xmlrpc_c::value_string("deadline exceeded");
+      delete m_mgr;
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_done = true;
+      m_cond.notify_all();
+      return;
+    }
+    // with less than half of the budget left, shrink the search in
+    // proportion so that the answer still arrives in time
+    if (left < m_budget / 2) {
+      double scale = std::max(2 * left / m_budget, 0.1);
+      m_mgr->SetSearchLimits(
+        std::max<size_t>(m_mgr->GetStackSize() * scale, 1),
+        std::max<size_t>(m_mgr->GetCubePopLimit() * scale, 1));
+    }
+  }
+
   m_mgr->Decode();
 
-  string out;
-  out = m_mgr->OutputBest();
-  m_retData["text"] = xmlrpc_c::value_string(out);
+  {
+    MetricsTimer timer(Metrics::Output);
+    string out;
+    out = m_mgr->OutputBest();
+    m_retData["text"] = xmlrpc_c::value_string(out);
+  }
 
   {
+    // notify under the lock: the waiter may destroy m_cond as soon as it
+    // sees m_done, and a batch waiter may be waiting for another request
     boost::lock_guard<boost::mutex> lock(m_mutex);
     m_done = true;
+    m_cond.notify_all();
   }
-  m_cond.notify_one();
 
   delete m_mgr;
 }
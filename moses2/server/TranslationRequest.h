@@ -32,6 +32,13 @@ protected:
   boost::mutex& m_mutex;
   bool m_done;
 
+  // scheduling: a higher priority is dequeued first; a request whose
+  // deadline (wall time in seconds, 0 for none) passes while queued is
+  // dropped, one that starts late searches with smaller limits
+  int m_priority;
+  double m_deadline, m_budget;
+  bool m_expired;
+
   TranslationRequest(xmlrpc_c::paramList const& paramList,
                      boost::condition_variable& cond,
                      boost::mutex& mut,
@@ -67,6 +74,17 @@ public:
     return m_done;
   }
 
+  //! the deadline passed before decoding started
+  bool
+  IsExpired() const {
+    return m_expired;
+  }
+
+  int
+  GetPriority() const {
+    return m_priority;
+  }
+
   std::map<std::string, xmlrpc_c::value> const&
   GetRetData() {
     return m_retData;
@@ -19,13 +19,19 @@ Translator::Translator(Server& server, System &system)
   : m_server(server),
     m_threadPool(server.options().numThreads),
     m_system(system),
-    m_translationId(0)
+    m_translationId(0),
+    m_resultCache(server.options().resultCacheSize)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
   // system.methodHelp RPC.
   this->_signature = "S:S";
   this->_help = "Does translation";
+
+  // never block the xmlrpc thread in Submit(): requests wait in the pool's
+  // queue, where they are ordered by priority and dropped once their
+  // deadline has passed
+  m_threadPool.SetQueueLimit(0);
 }
 
 Translator::~Translator()
@@ -45,24 +51,54 @@ void Translator::execute(xmlrpc_c::paramList const& paramList,
   }
 
   string line = xmlrpc_c::value_string(si->second);
-  long translationId;
 
-  // get unique id. Thread safe
-  {
-    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-    translationId = m_translationId++;
+  string key;
+  uint64_t generation = 0;
+  bool cacheable = m_resultCache.IsEnabled() && ResultCache::GetKey(params, key);
+  if (cacheable) {
+    ResultCache::Params result;
+    if (m_resultCache.Get(key, result, generation)) {
+      *retvalP = xmlrpc_c::value_struct(result);
+      return;
+    }
   }
 
   boost::condition_variable cond;
   boost::mutex mut;
   boost::shared_ptr<TranslationRequest> task;
-  task = TranslationRequest::create(this, paramList,cond,mut, m_system, line, translationId);
-  m_threadPool.Submit(task);
+  task = Submit(paramList, cond, mut, line);
   boost::unique_lock<boost::mutex> lock(mut);
   while (!task->IsDone()) {
     cond.wait(lock);
   }
+  if (task->IsExpired()) {
+    throw xmlrpc_c::fault("Deadline exceeded before translation started",
+                          xmlrpc_c::fault::CODE_TIMEOUT);
+  }
+  if (cacheable) {
+    m_resultCache.Put(key, task->GetRetData(), generation);
+  }
   *retvalP = xmlrpc_c::value_struct(task->GetRetData());
 }
 
+boost::shared_ptr<TranslationRequest>
+Translator::Submit(xmlrpc_c::paramList const& paramList,
+                   boost::condition_variable& cond,
+                   boost::mutex& mut,
+                   const std::string &line)
+{
+  long translationId;
+
+  // get unique id. Thread safe
+  {
+    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+    translationId = m_translationId++;
+  }
+
+  boost::shared_ptr<TranslationRequest> task;
+  task = TranslationRequest::create(this, paramList,cond,mut, m_system, line, translationId);
+  m_threadPool.Submit(task);
+  return task;
+}
+
 } /* namespace Moses2 */
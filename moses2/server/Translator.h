@@ -6,17 +6,21 @@
  */
 
 #pragma once
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
 #include "../legacy/ThreadPool.h"
+#include "ResultCache.h"
 
 namespace Moses2
 {
 class Server;
 class System;
 class Manager;
+class TranslationRequest;
 
 class Translator : public xmlrpc_c::method
 {
@@ -27,12 +31,24 @@ public:
   void execute(xmlrpc_c::paramList const& paramList,
                xmlrpc_c::value *   const  retvalP);
 
+  //! queue a translation of line; the request notifies cond when it is done
+  boost::shared_ptr<TranslationRequest>
+  Submit(xmlrpc_c::paramList const& paramList,
+         boost::condition_variable& cond,
+         boost::mutex& mut,
+         const std::string &line);
+
+  ResultCache &GetResultCache() {
+    return m_resultCache;
+  }
+
 protected:
   Server& m_server;
   Moses2::ThreadPool m_threadPool;
   System &m_system;
   long m_translationId;
   boost::shared_mutex m_accessLock;
+  ResultCache m_resultCache;
 
 };
 
@@ -0,0 +1,68 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExtractionOutput.h"
+
+#include "util/exception.hh"
+
+namespace MosesTraining
+{
+
+ExtractionOutput::ExtractionOutput(const std::vector<std::ostream*> &streams, bool ordered)
+  : m_streams(streams)
+  , m_ordered(ordered)
+  , m_next(0)
+{
+}
+
+void ExtractionOutput::Write(std::size_t id, std::vector<std::string> &outputs)
+{
+  UTIL_THROW_IF(outputs.size() != m_streams.size(), util::Exception,
+                "Expected " << m_streams.size() << " outputs, got " << outputs.size());
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  if (!m_ordered) {
+    WriteToStreams(outputs);
+    return;
+  }
+  if (id != m_next) {
+    m_pending[id].swap(outputs);
+    return;
+  }
+  WriteToStreams(outputs);
+  ++m_next;
+  std::map<std::size_t, std::vector<std::string> >::iterator pending;
+  while ((pending = m_pending.find(m_next)) != m_pending.end()) {
+    WriteToStreams(pending->second);
+    m_pending.erase(pending);
+    ++m_next;
+  }
+}
+
+void ExtractionOutput::WriteToStreams(const std::vector<std::string> &outputs)
+{
+  for (std::size_t i = 0; i < outputs.size(); ++i) {
+    if (!outputs[i].empty()) {
+      m_streams[i]->write(outputs[i].data(), outputs[i].size());
+    }
+  }
+}
+
+}
@@ -0,0 +1,66 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace MosesTraining
+{
+
+/**
+ * Writes what extraction tasks produce for each sentence to a set of output
+ * streams. Tasks that run on several threads may finish out of order; in
+ * ordered mode the output of a sentence is held back until the output of all
+ * earlier sentences has been written, otherwise it is written as it comes.
+ */
+class ExtractionOutput
+{
+public:
+  ExtractionOutput(const std::vector<std::ostream*> &streams, bool ordered);
+
+  /**
+   * Write the output of the task with the given id, one string per stream.
+   * Ids count from 0, without gaps. Empty strings are not written, so
+   * streams that are not open may be left empty.
+   */
+  void Write(std::size_t id, std::vector<std::string> &outputs);
+
+private:
+  void WriteToStreams(const std::vector<std::string> &outputs);
+
+  std::vector<std::ostream*> m_streams;
+  bool m_ordered;
+  std::size_t m_next;
+  std::map<std::size_t, std::vector<std::string> > m_pending;
+
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
+
+}
@@ -0,0 +1,264 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "LineSorter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+#include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/file_stream.hh"
+
+namespace MosesTraining
+{
+
+namespace
+{
+
+// Runs merged at once. More runs are merged in several passes.
+const std::size_t kMaxMerge = 64;
+
+class CompareLines
+{
+public:
+  explicit CompareLines(const char *text) : m_text(text) {}
+
+  bool operator()(const std::pair<std::size_t, std::size_t> &first,
+                  const std::pair<std::size_t, std::size_t> &second) const {
+    return StringPiece(m_text + first.first, first.second)
+           < StringPiece(m_text + second.first, second.second);
+  }
+
+private:
+  const char *m_text;
+};
+
+// Reads the lines of a run from the start, through a buffer that only grows
+// for lines longer than it.
+class RunReader
+{
+public:
+  RunReader(int fd, std::size_t bufferSize)
+    : m_fd(fd), m_buffer(bufferSize), m_begin(0), m_end(0), m_eof(false) {
+    util::SeekOrThrow(fd, 0);
+  }
+
+  // The line is valid until the next call.
+  bool ReadLine(StringPiece &line) {
+    while (true) {
+      char *data = &m_buffer[0];
+      const char *newline = static_cast<const char*>(std::memchr(data + m_begin, '\n', m_end - m_begin));
+      if (newline) {
+        line = StringPiece(data + m_begin, newline - data - m_begin);
+        m_begin = newline - data + 1;
+        return true;
+      }
+      if (m_eof) {
+        UTIL_THROW_IF(m_begin != m_end, util::Exception, "Temporary run does not end with a newline");
+        return false;
+      }
+      std::memmove(data, data + m_begin, m_end - m_begin);
+      m_end -= m_begin;
+      m_begin = 0;
+      if (m_end == m_buffer.size()) {
+        m_buffer.resize(2 * m_buffer.size());
+        data = &m_buffer[0];
+      }
+      const std::size_t got = util::ReadOrEOF(m_fd.get(), data + m_end, m_buffer.size() - m_end);
+      m_eof = !got;
+      m_end += got;
+    }
+  }
+
+private:
+  util::scoped_fd m_fd;
+  std::vector<char> m_buffer;
+  std::size_t m_begin, m_end;
+  bool m_eof;
+};
+
+} // namespace
+
+// Merges sorted runs, keeping one line of each run in a heap.
+class LineMerger
+{
+public:
+  LineMerger(const std::vector<int> &runs, std::size_t bufferSize) : m_pending(kNone) {
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+      m_runs.push_back(new RunReader(runs[i], bufferSize));
+    }
+    for (std::size_t i = 0; i < m_runs.size(); ++i) {
+      Advance(i);
+    }
+  }
+
+  bool Next(StringPiece &line) {
+    // The run of the last line is only read now, so that the line stays valid.
+    if (m_pending != kNone) {
+      Advance(m_pending);
+      m_pending = kNone;
+    }
+    if (m_heads.empty()) return false;
+    line = m_heads.top().first;
+    m_pending = m_heads.top().second;
+    m_heads.pop();
+    return true;
+  }
+
+private:
+  typedef std::pair<StringPiece, std::size_t> Head;
+  static const std::size_t kNone = static_cast<std::size_t>(-1);
+
+  void Advance(std::size_t run) {
+    StringPiece line;
+    if (m_runs[run].ReadLine(line)) {
+      m_heads.push(Head(line, run));
+    }
+  }
+
+  boost::ptr_vector<RunReader> m_runs;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head> > m_heads;
+  std::size_t m_pending;
+};
+
+LineSorter::LineSorter(const std::string &tempPrefix, std::size_t memory)
+  : m_tempPrefix(tempPrefix)
+  , m_memory(memory)
+  , m_sorted(false)
+  , m_nextLine(0)
+{
+}
+
+LineSorter::~LineSorter()
+{
+}
+
+void LineSorter::AddFile(const std::string &fileName)
+{
+  util::FilePiece in(fileName.c_str());
+  StringPiece line;
+  while (in.ReadLineOrEOF(line, '\n', false)) {
+    Add(line);
+  }
+}
+
+void LineSorter::Add(const StringPiece &line)
+{
+  UTIL_THROW_IF(m_sorted, util::Exception, "Adding lines after sorting them");
+  if (!m_lines.empty() &&
+      m_text.size() + line.size() + 1 + (m_lines.size() + 1) * sizeof(Line) > m_memory) {
+    WriteRun();
+  }
+  if (m_text.capacity() == 0) {
+    // so that the text is not copied while it grows
+    m_text.reserve(m_memory);
+  }
+  m_lines.push_back(Line(m_text.size(), line.size()));
+  m_text.append(line.data(), line.size());
+  m_text += '\n';
+}
+
+void LineSorter::AddLines(const StringPiece &text)
+{
+  UTIL_THROW_IF(!text.empty() && text[text.size() - 1] != '\n', util::Exception, "Adding an incomplete line");
+  const char *line = text.data();
+  const char *end = text.data() + text.size();
+  while (line < end) {
+    const char *newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+    Add(StringPiece(line, newline - line));
+    line = newline + 1;
+  }
+}
+
+void LineSorter::SortBuffer()
+{
+  std::sort(m_lines.begin(), m_lines.end(), CompareLines(m_text.data()));
+}
+
+void LineSorter::WriteRun()
+{
+  SortBuffer();
+  m_runs.push_back(new util::scoped_fd(util::MakeTemp(m_tempPrefix)));
+  util::FileStream out(m_runs.back().get(), 1 << 20);
+  for (std::size_t i = 0; i < m_lines.size(); ++i) {
+    // with its newline
+    out.write(m_text.data() + m_lines[i].first, m_lines[i].second + 1);
+  }
+  out.flush();
+  m_text.clear();
+  m_lines.clear();
+}
+
+void LineSorter::Sort()
+{
+  UTIL_THROW_IF(m_sorted, util::Exception, "Sorting lines twice");
+  m_sorted = true;
+  if (m_runs.empty()) {
+    // everything fit into memory
+    SortBuffer();
+    return;
+  }
+  if (!m_lines.empty()) {
+    WriteRun();
+  }
+  std::string().swap(m_text);
+  std::vector<Line>().swap(m_lines);
+
+  const std::size_t bufferSize = std::max<std::size_t>(m_memory / kMaxMerge, 1 << 16);
+  while (m_runs.size() > kMaxMerge) {
+    std::vector<int> runs;
+    for (std::size_t i = 0; i < kMaxMerge; ++i) {
+      runs.push_back(m_runs[i].release());
+    }
+    m_runs.erase(m_runs.begin(), m_runs.begin() + kMaxMerge);
+    LineMerger merger(runs, bufferSize);
+    m_runs.push_back(new util::scoped_fd(util::MakeTemp(m_tempPrefix)));
+    util::FileStream out(m_runs.back().get(), 1 << 20);
+    StringPiece line;
+    while (merger.Next(line)) {
+      out.write(line.data(), line.size());
+      out.write("\n", 1);
+    }
+    out.flush();
+  }
+
+  std::vector<int> runs;
+  for (std::size_t i = 0; i < m_runs.size(); ++i) {
+    runs.push_back(m_runs[i].release());
+  }
+  m_runs.clear();
+  m_merger.reset(new LineMerger(runs, bufferSize));
+}
+
+bool LineSorter::Next(StringPiece &line)
+{
+  UTIL_THROW_IF(!m_sorted, util::Exception, "Reading lines before sorting them");
+  if (m_merger) {
+    return m_merger->Next(line);
+  }
+  if (m_nextLine == m_lines.size()) return false;
+  const Line &next = m_lines[m_nextLine++];
+  line = StringPiece(m_text.data() + next.first, next.second);
+  return true;
+}
+
+}
@@ -0,0 +1,88 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "util/file.hh"
+#include "util/string_piece.hh"
+
+namespace MosesTraining
+{
+
+class LineMerger;
+
+/**
+ * Sorts lines in byte order, as LC_ALL=C sort does, in bounded memory.
+ * Lines are collected in a buffer of at most the given size. A full buffer
+ * is sorted and written to a temporary file as a run, and the runs are
+ * merged from disk when the sorted lines are read. The sorter of util::stream
+ * is not used, as it sorts fixed-size records and extract lines vary in length.
+ */
+class LineSorter
+{
+public:
+  /** Temporary files are created with tempPrefix */
+  LineSorter(const std::string &tempPrefix, std::size_t memory);
+  ~LineSorter();
+
+  /** Add the lines of a file, which may be compressed */
+  void AddFile(const std::string &fileName);
+
+  /** Add one line, without its newline */
+  void Add(const StringPiece &line);
+
+  /** Add complete lines, each ending with a newline */
+  void AddLines(const StringPiece &text);
+
+  /** Sort the lines added so far; no more lines may be added */
+  void Sort();
+
+  /**
+   * Next line in sorted order, without its newline. The line is valid until
+   * the next call.
+   */
+  bool Next(StringPiece &line);
+
+private:
+  // offset and length of a buffered line
+  typedef std::pair<std::size_t, std::size_t> Line;
+
+  void SortBuffer();
+  void WriteRun();
+
+  std::string m_tempPrefix;
+  std::size_t m_memory;
+  bool m_sorted;
+
+  std::string m_text;
+  std::vector<Line> m_lines;
+  std::size_t m_nextLine;
+
+  boost::ptr_vector<util::scoped_fd> m_runs;
+  boost::scoped_ptr<LineMerger> m_merger;
+};
+
+}
@@ -0,0 +1,104 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "LineSorter.h"
+
+#define  BOOST_TEST_MODULE MosesTrainingLineSorter
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace MosesTraining;
+using namespace std;
+
+namespace
+{
+
+vector<string> SortAll(LineSorter &sorter)
+{
+  sorter.Sort();
+  vector<string> sorted;
+  StringPiece line;
+  while (sorter.Next(line)) {
+    sorted.push_back(line.as_string());
+  }
+  return sorted;
+}
+
+vector<string> RandomLines(LineSorter &sorter, size_t count)
+{
+  vector<string> lines;
+  srand(1234);
+  for (size_t i = 0; i < count; ++i) {
+    string line(rand() % 30, 'a');
+    for (size_t j = 0; j < line.size(); ++j) {
+      line[j] += rand() % 3;
+    }
+    lines.push_back(line);
+    sorter.Add(line);
+  }
+  sort(lines.begin(), lines.end());
+  return lines;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(byte_order)
+{
+  LineSorter sorter("line_sorter_test", 1 << 20);
+  sorter.Add("das Haus ||| the house ||| 0-0 1-1");
+  sorter.Add("das ||| the ||| 0-0");
+  sorter.AddLines("das Haus ||| the house ||| 0-0 1-1\nHaus ||| house ||| 0-0\n");
+  sorter.Add("");
+  sorter.Add("\xc3\xa4 ||| a ||| 0-0");
+
+  vector<string> sorted = SortAll(sorter);
+  BOOST_REQUIRE_EQUAL(sorted.size(), 6);
+  BOOST_CHECK_EQUAL(sorted[0], "");
+  BOOST_CHECK_EQUAL(sorted[1], "Haus ||| house ||| 0-0");
+  BOOST_CHECK_EQUAL(sorted[2], "das Haus ||| the house ||| 0-0 1-1");
+  BOOST_CHECK_EQUAL(sorted[3], "das Haus ||| the house ||| 0-0 1-1");
+  BOOST_CHECK_EQUAL(sorted[4], "das ||| the ||| 0-0");
+  BOOST_CHECK_EQUAL(sorted[5], "\xc3\xa4 ||| a ||| 0-0");
+}
+
+BOOST_AUTO_TEST_CASE(external_merge)
+{
+  // Small enough memory that the lines are merged from several runs
+  LineSorter sorter("line_sorter_test", 1 << 18);
+  vector<string> lines = RandomLines(sorter, 50000);
+  BOOST_CHECK(SortAll(sorter) == lines);
+}
+
+BOOST_AUTO_TEST_CASE(merge_passes)
+{
+  // Hundreds of runs, more than are merged at once
+  LineSorter sorter("line_sorter_test", 1 << 12);
+  vector<string> lines = RandomLines(sorter, 50000);
+  BOOST_CHECK(SortAll(sorter) == lines);
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+  LineSorter sorter("line_sorter_test", 1 << 20);
+  BOOST_CHECK(SortAll(sorter).empty());
+}
@@ -25,6 +25,9 @@
 #include <cassert>
 
 #include <boost/assign/list_of.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 namespace MosesTraining
 {
@@ -32,6 +35,14 @@ namespace MosesTraining
 std::vector<float> PhraseOrientation::m_l2rOrientationPriorCounts = boost::assign::list_of(0)(0)(0)(0)(0);
 std::vector<float> PhraseOrientation::m_r2lOrientationPriorCounts = boost::assign::list_of(0)(0)(0)(0)(0);
 
+#ifdef WITH_THREADS
+namespace
+{
+// prior counts are collected by extraction tasks running on several threads
+boost::mutex priorCountsMutex;
+}
+#endif
+
 PhraseOrientation::PhraseOrientation(int sourceSize,
                                      int targetSize,
                                      const Alignment &alignment)
@@ -450,6 +461,9 @@ bool PhraseOrientation::IsAligned(int fi, int ei) const
 void PhraseOrientation::IncrementPriorCount(REO_DIR direction, REO_CLASS orient, float increment)
 {
   assert(direction==REO_DIR_L2R || direction==REO_DIR_R2L);
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(priorCountsMutex);
+#endif
   if (direction == REO_DIR_L2R) {
     m_l2rOrientationPriorCounts[orient] += increment;
   } else if (direction == REO_DIR_R2L) {
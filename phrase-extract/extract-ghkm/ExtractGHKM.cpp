@@ -29,11 +29,15 @@
 #include <vector>
 
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include "moses/ThreadPool.h"
 #include "syntax-common/exception.h"
 #include "syntax-common/xml_tree_parser.h"
+#include "util/file_piece.hh"
 
-#include "InputFileStream.h"
+#include "ExtractionOutput.h"
 #include "OutputFileStream.h"
 #include "SyntaxNode.h"
 #include "SyntaxNodeCollection.h"
@@ -60,9 +64,154 @@ namespace Syntax
 namespace GHKM
 {
 
+namespace
+{
+
+// streams of the ExtractionOutput
+enum ExtractOutputStream {
+  EXTRACT_FWD = 0,
+  EXTRACT_INV,
+  EXTRACT_OUTPUT_STREAMS
+};
+
+// sentences queued per thread when extracting on several threads
+const std::size_t kQueuePerThread = 16;
+
+// Extracts and writes the rules of one sentence.  The sentences are parsed on
+// the main thread, since the parsers collect the label sets.
+class ExtractTask : public Moses::Task
+{
+public:
+  // sourceNodeCollection is only read if source labels are used, which
+  // requires the task to run before the next source tree is parsed.
+  ExtractTask(std::size_t id, std::size_t lineNum,
+              std::auto_ptr<SyntaxTree> targetParseTree,
+              std::size_t targetWordCount,
+              const std::vector<std::string> &sourceTokens,
+              const SyntaxNodeCollection *sourceNodeCollection,
+              const Alignment &alignment, const Options &options,
+              ExtractionOutput &output)
+    : m_id(id)
+    , m_lineNum(lineNum)
+    , m_targetParseTree(targetParseTree.release())
+    , m_targetWordCount(targetWordCount)
+    , m_sourceTokens(sourceTokens)
+    , m_sourceNodeCollection(sourceNodeCollection)
+    , m_alignment(alignment)
+    , m_options(options)
+    , m_output(output) {}
+
+  void Run();
+
+private:
+  std::size_t m_id;
+  std::size_t m_lineNum;
+  boost::scoped_ptr<SyntaxTree> m_targetParseTree;
+  std::size_t m_targetWordCount;
+  std::vector<std::string> m_sourceTokens;
+  const SyntaxNodeCollection *m_sourceNodeCollection;
+  Alignment m_alignment;
+  const Options &m_options;
+  ExtractionOutput &m_output;
+};
+
+void ExtractTask::Run()
+{
+  const Options &options = m_options;
+  std::ostringstream fwdExtractStream;
+  std::ostringstream invExtractStream;
+  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
+  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
+
+  // Form an alignment graph from the target tree, source words, and
+  // alignment.
+  AlignmentGraph graph(m_targetParseTree.get(), m_sourceTokens, m_alignment);
+
+  // Extract minimal rules, adding each rule to its root node's rule set.
+  graph.ExtractMinimalRules(options);
+
+  // Extract composed rules.
+  if (!options.minimal) {
+    graph.ExtractComposedRules(options);
+  }
+
+  // Initialize phrase orientation scoring object
+  PhraseOrientation phraseOrientation(m_sourceTokens.size(),
+                                      m_targetWordCount, m_alignment);
+
+  // Write the rules, subject to scope pruning.
+  const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
+  for (std::vector<Node *>::const_iterator p = targetNodes.begin();
+       p != targetNodes.end(); ++p) {
+
+    const std::vector<const Subgraph *> &rules = (*p)->GetRules();
+
+    PhraseOrientation::REO_CLASS l2rOrientation=PhraseOrientation::REO_CLASS_UNKNOWN, r2lOrientation=PhraseOrientation::REO_CLASS_UNKNOWN;
+    if (options.phraseOrientation && !rules.empty()) {
+      int sourceSpanBegin = *((*p)->GetSpan().begin());
+      int sourceSpanEnd   = *((*p)->GetSpan().rbegin());
+      l2rOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_L2R);
+      r2lOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_R2L);
+      // std::cerr << "span " << sourceSpanBegin << " " << sourceSpanEnd << std::endl;
+      // std::cerr << "phraseOrientation " << phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd) << std::endl;
+    }
+
+    for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
+         q != rules.end(); ++q) {
+      // STSG output.
+      if (options.stsg) {
+        StsgRule rule(**q);
+        if (rule.Scope() <= options.maxScope) {
+          stsgWriter.Write(rule);
+        }
+        continue;
+      }
+      // SCFG output.
+      ScfgRule *r = 0;
+      if (options.sourceLabels) {
+        r = new ScfgRule(**q, m_sourceNodeCollection);
+      } else {
+        r = new ScfgRule(**q);
+      }
+      // TODO Can scope pruning be done earlier?
+      if (r->Scope() <= options.maxScope) {
+        scfgWriter.Write(*r,m_lineNum,false);
+        if (options.treeFragments) {
+          fwdExtractStream << " {{Tree ";
+          (*q)->PrintTree(fwdExtractStream);
+          fwdExtractStream << "}}";
+        }
+        if (options.partsOfSpeech) {
+          fwdExtractStream << " {{POS";
+          (*q)->PrintPartsOfSpeech(fwdExtractStream);
+          fwdExtractStream << "}}";
+        }
+        if (options.phraseOrientation) {
+          fwdExtractStream << " {{Orientation ";
+          phraseOrientation.WriteOrientation(fwdExtractStream,l2rOrientation);
+          fwdExtractStream << " ";
+          phraseOrientation.WriteOrientation(fwdExtractStream,r2lOrientation);
+          fwdExtractStream << "}}";
+          phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,l2rOrientation,1);
+          phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,r2lOrientation,1);
+        }
+        fwdExtractStream << "\n";
+        invExtractStream << "\n";
+      }
+      delete r;
+    }
+  }
+
+  std::vector<std::string> outputs(EXTRACT_OUTPUT_STREAMS);
+  outputs[EXTRACT_FWD] = fwdExtractStream.str();
+  outputs[EXTRACT_INV] = invExtractStream.str();
+  m_output.Write(m_id, outputs);
+}
+
+}  // namespace
+
 int ExtractGHKM::Main(int argc, char *argv[])
 {
-  using Moses::InputFileStream;
   using Moses::OutputFileStream;
 
   // Process command-line options.
@@ -80,9 +229,9 @@ int ExtractGHKM::Main(int argc, char *argv[])
                                     : options.targetFile;
   std::string effectiveSourceFile = options.t2s ? options.targetFile
                                     : options.sourceFile;
-  InputFileStream targetStream(effectiveTargetFile);
-  InputFileStream sourceStream(effectiveSourceFile);
-  InputFileStream alignmentStream(options.alignmentFile);
+  util::FilePiece targetStream(effectiveTargetFile.c_str());
+  util::FilePiece sourceStream(effectiveSourceFile.c_str());
+  util::FilePiece alignmentStream(options.alignmentFile.c_str());
 
   // Open output files.
   OutputFileStream fwdExtractStream;
@@ -129,30 +278,46 @@ int ExtractGHKM::Main(int argc, char *argv[])
   std::map<std::string, int> sourceWordCount;
   std::map<std::string, std::string> sourceWordLabel;
 
+  // The rules of a sentence refer to the source labels of the parser, which
+  // only hold until the next source tree is parsed.
+  if (options.sourceLabels) {
+    options.threads = 1;
+  }
+
+  std::vector<std::ostream*> outputStreams(EXTRACT_OUTPUT_STREAMS);
+  outputStreams[EXTRACT_FWD] = &fwdExtractStream;
+  outputStreams[EXTRACT_INV] = &invExtractStream;
+  ExtractionOutput output(outputStreams, !options.unorderedOutput);
+
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (options.threads > 1) {
+    pool.reset(new Moses::ThreadPool(options.threads));
+    pool->SetQueueLimit(kQueuePerThread * options.threads);
+  }
+#endif
+
+  StringPiece targetPiece;
+  StringPiece sourcePiece;
+  StringPiece alignmentPiece;
   std::string targetLine;
   std::string sourceLine;
   std::string alignmentLine;
   Alignment alignment;
   XmlTreeParser targetXmlTreeParser;
   XmlTreeParser sourceXmlTreeParser;
-  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
-  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
   size_t lineNum = options.sentenceOffset;
-  while (true) {
-    std::getline(targetStream, targetLine);
-    std::getline(sourceStream, sourceLine);
-    std::getline(alignmentStream, alignmentLine);
-
-    if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
-      break;
-    }
-
-    if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
+  size_t taskId = 0;
+  while (targetStream.ReadLineOrEOF(targetPiece, '\n', false)) {
+    if (!sourceStream.ReadLineOrEOF(sourcePiece, '\n', false) ||
+        !alignmentStream.ReadLineOrEOF(alignmentPiece, '\n', false)) {
       Error("Files must contain same number of lines");
     }
+    targetLine.assign(targetPiece.data(), targetPiece.size());
+    sourceLine.assign(sourcePiece.data(), sourcePiece.size());
+    alignmentLine.assign(alignmentPiece.data(), alignmentPiece.size());
 
     ++lineNum;
-
     // Parse target tree.
     if (targetLine.size() == 0) {
       std::cerr << "skipping line " << lineNum << " with empty target tree\n";
@@ -220,85 +385,32 @@ int ExtractGHKM::Main(int argc, char *argv[])
                              sourceWordLabel);
     }
 
-    // Form an alignment graph from the target tree, source words, and
-    // alignment.
-    AlignmentGraph graph(targetParseTree.get(), sourceTokens, alignment);
-
-    // Extract minimal rules, adding each rule to its root node's rule set.
-    graph.ExtractMinimalRules(options);
-
-    // Extract composed rules.
-    if (!options.minimal) {
-      graph.ExtractComposedRules(options);
+    boost::shared_ptr<ExtractTask> task(
+      new ExtractTask(taskId++, lineNum, targetParseTree,
+                      targetXmlTreeParser.words().size(), sourceTokens,
+                      &sourceXmlTreeParser.node_collection(), alignment,
+                      options, output));
+#ifdef WITH_THREADS
+    if (pool) {
+      pool->Submit(task);
+    } else {
+      task->Run();
     }
+#else
+    task->Run();
+#endif
+  }
 
-    // Initialize phrase orientation scoring object
-    PhraseOrientation phraseOrientation(sourceTokens.size(),
-                                        targetXmlTreeParser.words().size(), alignment);
-
-    // Write the rules, subject to scope pruning.
-    const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
-    for (std::vector<Node *>::const_iterator p = targetNodes.begin();
-         p != targetNodes.end(); ++p) {
-
-      const std::vector<const Subgraph *> &rules = (*p)->GetRules();
-
-      PhraseOrientation::REO_CLASS l2rOrientation=PhraseOrientation::REO_CLASS_UNKNOWN, r2lOrientation=PhraseOrientation::REO_CLASS_UNKNOWN;
-      if (options.phraseOrientation && !rules.empty()) {
-        int sourceSpanBegin = *((*p)->GetSpan().begin());
-        int sourceSpanEnd   = *((*p)->GetSpan().rbegin());
-        l2rOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_L2R);
-        r2lOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_R2L);
-        // std::cerr << "span " << sourceSpanBegin << " " << sourceSpanEnd << std::endl;
-        // std::cerr << "phraseOrientation " << phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd) << std::endl;
-      }
+  if (sourceStream.ReadLineOrEOF(sourcePiece, '\n', false) ||
+      alignmentStream.ReadLineOrEOF(alignmentPiece, '\n', false)) {
+    Error("Files must contain same number of lines");
+  }
 
-      for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
-           q != rules.end(); ++q) {
-        // STSG output.
-        if (options.stsg) {
-          StsgRule rule(**q);
-          if (rule.Scope() <= options.maxScope) {
-            stsgWriter.Write(rule);
-          }
-          continue;
-        }
-        // SCFG output.
-        ScfgRule *r = 0;
-        if (options.sourceLabels) {
-          r = new ScfgRule(**q, &sourceXmlTreeParser.node_collection());
-        } else {
-          r = new ScfgRule(**q);
-        }
-        // TODO Can scope pruning be done earlier?
-        if (r->Scope() <= options.maxScope) {
-          scfgWriter.Write(*r,lineNum,false);
-          if (options.treeFragments) {
-            fwdExtractStream << " {{Tree ";
-            (*q)->PrintTree(fwdExtractStream);
-            fwdExtractStream << "}}";
-          }
-          if (options.partsOfSpeech) {
-            fwdExtractStream << " {{POS";
-            (*q)->PrintPartsOfSpeech(fwdExtractStream);
-            fwdExtractStream << "}}";
-          }
-          if (options.phraseOrientation) {
-            fwdExtractStream << " {{Orientation ";
-            phraseOrientation.WriteOrientation(fwdExtractStream,l2rOrientation);
-            fwdExtractStream << " ";
-            phraseOrientation.WriteOrientation(fwdExtractStream,r2lOrientation);
-            fwdExtractStream << "}}";
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,l2rOrientation,1);
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,r2lOrientation,1);
-          }
-          fwdExtractStream << std::endl;
-          invExtractStream << std::endl;
-        }
-        delete r;
-      }
-    }
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
   }
+#endif
 
   if (options.phraseOrientation) {
     std::string phraseOrientationPriorsFileName = options.extractFile + std::string(".phraseOrientationPriors");
@@ -456,6 +568,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
    "output STSG rules (default is SCFG)")
   ("T2S",
    "enable tree-to-string rule extraction (string-to-tree is assumed by default)")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "extract on this many threads")
   ("TreeFragments",
    "output parse tree information")
   ("SourceLabels",
@@ -481,6 +596,8 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
    "write dummy value to unknown word label file, and mappings from dummy value to other labels to named file")
   ("UnknownWordUniform",
    "write uniform weights to unknown word label file")
+  ("UnorderedOutput",
+   "write the rules of each sentence as soon as they are extracted, instead of in corpus order")
   ("UnpairedExtractFormat",
    "do not pair non-terminals in extract files")
   ;
@@ -587,10 +704,23 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   if (vm.count("UnknownWordUniform")) {
     options.unknownWordUniform = true;
   }
+  if (vm.count("UnorderedOutput")) {
+    options.unorderedOutput = true;
+  }
   if (vm.count("UnpairedExtractFormat")) {
     options.unpairedExtractFormat = true;
   }
 
+  if (options.threads < 1) {
+    options.threads = 1;
+  }
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    std::cerr << "thread support not compiled in, extracting with one thread\n";
+    options.threads = 1;
+  }
+#endif
+
   // Workaround for extract-parallel issue.
   if (options.sentenceOffset > 0) {
     options.targetUnknownWordFile.clear();
@@ -49,9 +49,11 @@ public:
     , stripBitParLabels(false)
     , stsg(false)
     , t2s(false)
+    , threads(1)
     , treeFragments(false)
     , unknownWordMinRelFreq(0.03f)
     , unknownWordUniform(false)
+    , unorderedOutput(false)
     , unpairedExtractFormat(false) {}
 
   // Positional options
@@ -83,10 +85,12 @@ public:
   bool stsg;
   bool t2s;
   std::string targetUnknownWordFile;
+  int threads;
   bool treeFragments;
   float unknownWordMinRelFreq;
   std::string unknownWordSoftMatchesFile;
   bool unknownWordUniform;
+  bool unorderedOutput;
   bool unpairedExtractFormat;
 };
 
@@ -84,10 +84,9 @@ int main(int argc, char* argv[])
 namespace MosesTraining
 {
 
-const std::string *Vocab::GetOrAdd(const std::string &word)
+ExtractLex::ExtractLex()
 {
-  const string *ret = &(*m_coll.insert(word).first);
-  return ret;
+  m_nullWord = m_vocab.storeIfNew("NULL");
 }
 
 void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource, vector<string> &toksAlign, size_t lineCount)
@@ -118,11 +117,8 @@ void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource,
     m_sourceAligned[ alignPos[0] ] = true;
     m_targetAligned[ alignPos[1] ] = true;
 
-    const string &tmpSource = toksSource[ alignPos[0] ];
-    const string &tmpTarget = toksTarget[ alignPos[1] ];
-
-    const string *source = m_vocab.GetOrAdd(tmpSource);
-    const string *target = m_vocab.GetOrAdd(tmpTarget);
+    WORD_ID source = m_vocab.storeIfNew(toksSource[ alignPos[0] ]);
+    WORD_ID target = m_vocab.storeIfNew(toksTarget[ alignPos[1] ]);
 
     Process(target, source);
 
@@ -131,47 +127,42 @@ void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource,
   ProcessUnaligned(toksTarget, toksSource, m_sourceAligned, m_targetAligned);
 }
 
-void ExtractLex::Process(const std::string *target, const std::string *source)
-{
-  WordCount &wcS2T = m_collS2T[source];
-  WordCount &wcT2S = m_collT2S[target];
-
-  wcS2T.AddCount(COUNT_INCR);
-  wcT2S.AddCount(COUNT_INCR);
-
-  Process(wcS2T, target);
-  Process(wcT2S, source);
-}
-
-void ExtractLex::Process(WordCount &wcIn, const std::string *out)
+void ExtractLex::Process(WORD_ID target, WORD_ID source)
 {
-  std::map<const std::string*, WordCount> &collOut = wcIn.GetColl();
-  WordCount &wcOut = collOut[out];
-  wcOut.AddCount(COUNT_INCR);
+  if (m_countS.size() < m_vocab.vocab.size()) {
+    m_countS.resize(m_vocab.vocab.size(), 0);
+    m_countT.resize(m_vocab.vocab.size(), 0);
+  }
+  m_countS[source] += COUNT_INCR;
+  m_countT[target] += COUNT_INCR;
+
+  WordPairEntry<float> entry;
+  entry.key = getWordPairKey(source, target);
+  entry.value = COUNT_INCR;
+  PairCounts::MutableIterator it;
+  if (m_pairCounts.FindOrInsert(entry, it)) {
+    it->value += COUNT_INCR;
+  }
 }
 
 void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &toksSource
                                   , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned)
 {
-  const string *nullWord = m_vocab.GetOrAdd("NULL");
-
   for (size_t pos = 0; pos < m_sourceAligned.size(); ++pos) {
     bool isAlignedCurr = m_sourceAligned[pos];
     if (!isAlignedCurr) {
-      const string &tmpWord = toksSource[pos];
-      const string *sourceWord = m_vocab.GetOrAdd(tmpWord);
+      WORD_ID sourceWord = m_vocab.storeIfNew(toksSource[pos]);
 
-      Process(nullWord, sourceWord);
+      Process(m_nullWord, sourceWord);
     }
   }
 
   for (size_t pos = 0; pos < m_targetAligned.size(); ++pos) {
     bool isAlignedCurr = m_targetAligned[pos];
     if (!isAlignedCurr) {
-      const string &tmpWord = toksTarget[pos];
-      const string *targetWord = m_vocab.GetOrAdd(tmpWord);
+      WORD_ID targetWord = m_vocab.storeIfNew(toksTarget[pos]);
 
-      Process(targetWord, nullWord);
+      Process(targetWord, m_nullWord);
     }
   }
 
@@ -179,40 +170,18 @@ void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &to
 
 void ExtractLex::Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S)
 {
-  Output(m_collS2T, streamLexS2T);
-  Output(m_collT2S, streamLexT2S);
-}
-
-void ExtractLex::Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream)
-{
-  std::map<const std::string*, WordCount>::const_iterator iterOuter;
-  for (iterOuter = coll.begin(); iterOuter != coll.end(); ++iterOuter) {
-    const string &inStr = *iterOuter->first;
-    const WordCount &inWC = iterOuter->second;
-
-    const std::map<const std::string*, WordCount> &outColl = inWC.GetColl();
-
-    std::map<const std::string*, WordCount>::const_iterator iterInner;
-    for (iterInner = outColl.begin(); iterInner != outColl.end(); ++iterInner) {
-      const string &outStr = *iterInner->first;
-      const WordCount &outWC = iterInner->second;
-
-      float prob = outWC.GetCount() / inWC.GetCount();
-      outStream << outStr << " "  << inStr << " " << prob << endl;
+  for (PairCounts::ConstIterator it = m_pairCounts.RawBegin(); it != m_pairCounts.RawEnd(); ++it) {
+    if (it->key == 0) {
+      continue;
     }
-  }
-}
+    WORD_ID source = getWordPairFirst(it->key);
+    WORD_ID target = getWordPairSecond(it->key);
+    const string &sourceStr = m_vocab.getWord(source);
+    const string &targetStr = m_vocab.getWord(target);
 
-std::ostream& operator<<(std::ostream &out, const WordCount &obj)
-{
-  out << "(" << obj.GetCount() << ")";
-  return out;
-}
-
-void WordCount::AddCount(float incr)
-{
-  m_count += incr;
+    streamLexS2T << targetStr << " " << sourceStr << " " << it->value / m_countS[source] << "\n";
+    streamLexT2S << sourceStr << " " << targetStr << " " << it->value / m_countT[target] << "\n";
+  }
 }
 
 } // namespace
-
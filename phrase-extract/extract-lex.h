@@ -1,67 +1,34 @@
 #pragma once
 
-#include <map>
-#include <set>
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include "tables-core.h"
+#include "util/probing_hash_table.hh"
 
 namespace MosesTraining
 {
 
-class WordCount
-{
-  friend std::ostream& operator<<(std::ostream&, const WordCount&);
-public:
-  float m_count;
-
-  std::map<const std::string*, WordCount> m_coll;
-
-  WordCount()
-    :m_count(0) {
-  }
-
-  //WordCount(const WordCount &copy);
-
-  WordCount(float count)
-    :m_count(count) {
-  }
-
-  void AddCount(float incr);
-
-  std::map<const std::string*, WordCount> &GetColl() {
-    return m_coll;
-  }
-  const std::map<const std::string*, WordCount> &GetColl() const {
-    return m_coll;
-  }
-
-  const float GetCount() const {
-    return m_count;
-  }
-
-};
-
-class Vocab
-{
-  std::set<std::string> m_coll;
-public:
-  const std::string *GetOrAdd(const std::string &word);
-};
-
 class ExtractLex
 {
-  Vocab m_vocab;
-  std::map<const std::string*, WordCount> m_collS2T, m_collT2S;
+  // source and target words share one vocabulary, as NULL appears on both sides
+  Vocabulary m_vocab;
+  WORD_ID m_nullWord;
+
+  // counts of aligned (source, target) word pairs, and of the source and
+  // target words on their own. Each direction divides the same pair count
+  typedef util::AutoProbing< WordPairEntry< float >, WordPairHash > PairCounts;
+  PairCounts m_pairCounts;
+  std::vector<float> m_countS, m_countT;
 
-  void Process(const std::string *target, const std::string *source);
-  void Process(WordCount &wcIn, const std::string *out);
+  void Process(WORD_ID target, WORD_ID source);
   void ProcessUnaligned(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource
                         , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned);
 
-  void Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream);
-
 public:
+  ExtractLex();
+
   void Process(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource, std::vector<std::string> &toksAlign, size_t lineCount);
   void Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S);
 
@@ -11,14 +11,20 @@
 #include <set>
 #include <vector>
 #include <limits>
+#include <algorithm>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "tables-core.h"
-#include "InputFileStream.h"
+#include "ExtractionOutput.h"
 #include "OutputFileStream.h"
 #include "PhraseExtractionOptions.h"
 #include "SentenceAlignmentWithSyntax.h"
 #include "SyntaxNode.h"
+#include "moses/ThreadPool.h"
 #include "moses/Util.h"
+#include "util/file_piece.hh"
 
 using namespace std;
 using namespace MosesTraining;
@@ -67,25 +73,33 @@ bool isAligned (SentenceAlignmentWithSyntax &, int, int);
 
 int sentenceOffset = 0;
 
+// streams of the ExtractionOutput
+enum ExtractOutputStream {
+  EXTRACT = 0,
+  EXTRACT_INV,
+  EXTRACT_ORIENTATION,
+  EXTRACT_CONTEXT,
+  EXTRACT_CONTEXT_INV,
+  EXTRACT_OUTPUT_STREAMS
+};
+
+// sentences queued per thread when extracting on several threads
+const size_t kQueuePerThread = 64;
 
-class ExtractTask
+
+class ExtractTask : public Moses::Task
 {
 public:
+  // takes ownership of sentence
   ExtractTask(
-    size_t id, SentenceAlignmentWithSyntax &sentence,
+    size_t id, SentenceAlignmentWithSyntax *sentence,
     PhraseExtractionOptions &initoptions,
-    Moses::OutputFileStream &extractFile,
-    Moses::OutputFileStream &extractFileInv,
-    Moses::OutputFileStream &extractFileOrientation,
-    Moses::OutputFileStream &extractFileContext,
-    Moses::OutputFileStream &extractFileContextInv):
-    m_sentence(sentence),
+    ExtractionOutput &output):
+    m_id(id),
+    m_ownSentence(sentence),
+    m_sentence(*sentence),
     m_options(initoptions),
-    m_extractFile(extractFile),
-    m_extractFileInv(extractFileInv),
-    m_extractFileOrientation(extractFileOrientation),
-    m_extractFileContext(extractFileContext),
-    m_extractFileContextInv(extractFileContextInv) {}
+    m_output(output) {}
   void Run();
 private:
   vector< string > m_extractedPhrases;
@@ -94,7 +108,6 @@ private:
   vector< string > m_extractedPhrasesSid;
   vector< string > m_extractedPhrasesContext;
   vector< string > m_extractedPhrasesContextInv;
-  void extractBase();
   void extract();
   void addPhrase(int, int, int, int, const std::string &);
   void writePhrasesToFile();
@@ -113,13 +126,11 @@ private:
                           const HSentenceVertices& outBottomRight,
                           std::string &orientationInfo) const;
 
+  size_t m_id;
+  boost::scoped_ptr<SentenceAlignmentWithSyntax> m_ownSentence;
   SentenceAlignmentWithSyntax &m_sentence;
   const PhraseExtractionOptions &m_options;
-  Moses::OutputFileStream &m_extractFile;
-  Moses::OutputFileStream &m_extractFileInv;
-  Moses::OutputFileStream &m_extractFileOrientation;
-  Moses::OutputFileStream &m_extractFileContext;
-  Moses::OutputFileStream &m_extractFileContextInv;
+  ExtractionOutput &m_output;
 };
 }
 
@@ -131,7 +142,7 @@ int main(int argc, char* argv[])
   if (argc < 6) {
     cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] ";
     cerr << "| --OnlyOutputSpanInfo | --NoTTable | --GZOutput | --IncludeSentenceId | --SentenceOffset n | --InstanceWeights filename ";
-    cerr << "| --TargetConstituentConstrained | --TargetConstituentBoundaries ]" << std::endl;
+    cerr << "| --TargetConstituentConstrained | --TargetConstituentBoundaries | --Threads n | --UnorderedOutput ]" << std::endl;
     exit(1);
   }
 
@@ -145,6 +156,8 @@ int main(int argc, char* argv[])
   const char* const &fileNameA = argv[3];
   const string fileNameExtract = string(argv[4]);
   PhraseExtractionOptions options(atoi(argv[5]));
+  size_t threads = 1;
+  bool unorderedOutput = false;
 
   for(int i=6; i<argc; i++) {
     if (strcmp(argv[i],"--OnlyOutputSpanInfo") == 0) {
@@ -232,6 +245,18 @@ int main(int argc, char* argv[])
       }
 
       options.initAllModelsOutputFlag(true);
+    } else if (strcmp(argv[i], "--Threads") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, used switch --Threads without a number" << endl;
+        exit(1);
+      }
+      threads = std::max(1, atoi(argv[++i]));
+#ifndef WITH_THREADS
+      cerr << "extract: thread support not compiled in, extracting with one thread" << endl;
+      threads = 1;
+#endif
+    } else if (strcmp(argv[i], "--UnorderedOutput") == 0) {
+      unorderedOutput = true;
     } else if (strcmp(argv[i], "--Placeholders") == 0) {
       ++i;
       string str = argv[i];
@@ -249,20 +274,19 @@ int main(int argc, char* argv[])
     options.initWordType(REO_MSD);
   }
 
-  // open input files
-  Moses::InputFileStream eFile(fileNameE);
-  Moses::InputFileStream fFile(fileNameF);
-  Moses::InputFileStream aFile(fileNameA);
+  // span info is printed to stdout as it is found
+  if (options.isOnlyOutputSpanInfo()) {
+    threads = 1;
+  }
 
-  istream *eFileP = &eFile;
-  istream *fFileP = &fFile;
-  istream *aFileP = &aFile;
+  // open input files
+  util::FilePiece eFile(fileNameE);
+  util::FilePiece fFile(fileNameF);
+  util::FilePiece aFile(fileNameA);
 
-  istream *iwFileP = NULL;
-  auto_ptr<Moses::InputFileStream> instanceWeightsFile;
+  boost::scoped_ptr<util::FilePiece> instanceWeightsFile;
   if (options.getInstanceWeightsFile().length()) {
-    instanceWeightsFile.reset(new Moses::InputFileStream(options.getInstanceWeightsFile()));
-    iwFileP = instanceWeightsFile.get();
+    instanceWeightsFile.reset(new util::FilePiece(options.getInstanceWeightsFile().c_str()));
   }
 
   // open output files
@@ -287,22 +311,42 @@ int main(int argc, char* argv[])
   map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
   const bool targetSyntax = true;
 
+  std::vector<std::ostream*> outputStreams(EXTRACT_OUTPUT_STREAMS);
+  outputStreams[EXTRACT] = &extractFile;
+  outputStreams[EXTRACT_INV] = &extractFileInv;
+  outputStreams[EXTRACT_ORIENTATION] = &extractFileOrientation;
+  outputStreams[EXTRACT_CONTEXT] = &extractFileContext;
+  outputStreams[EXTRACT_CONTEXT_INV] = &extractFileContextInv;
+  ExtractionOutput output(outputStreams, !unorderedOutput);
+
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (threads > 1) {
+    pool.reset(new Moses::ThreadPool(threads));
+    pool->SetQueueLimit(kQueuePerThread * threads);
+  }
+#endif
+
   int i = sentenceOffset;
+  size_t taskId = 0;
 
+  StringPiece englishLine;
   string englishString, foreignString, alignmentString, weightString;
 
-  while (getline(*eFileP, englishString)) {
+  while (eFile.ReadLineOrEOF(englishLine, '\n', false)) {
     // Print progress dots to stderr.
     i++;
     if (i%10000 == 0) cerr << "." << flush;
 
-    getline(*fFileP, foreignString);
-    getline(*aFileP, alignmentString);
-    if (iwFileP) {
-      getline(*iwFileP, weightString);
+    // sentences are parsed here, since parsing collects the labels
+    englishString.assign(englishLine.data(), englishLine.size());
+    foreignString = fFile.ReadLine('\n', false).as_string();
+    alignmentString = aFile.ReadLine('\n', false).as_string();
+    if (instanceWeightsFile) {
+      weightString = instanceWeightsFile->ReadLine('\n', false).as_string();
     }
 
-    SentenceAlignmentWithSyntax sentence
+    SentenceAlignmentWithSyntax *sentence = new SentenceAlignmentWithSyntax
     (targetLabelCollection, sourceLabelCollection,
      targetTopLabelCollection, sourceTopLabelCollection,
      targetSyntax, false);
@@ -314,25 +358,35 @@ int main(int argc, char* argv[])
       cout << "LOG: ALT: " << alignmentString << endl;
       cout << "LOG: PHRASES_BEGIN:" << endl;
     }
-    if (sentence.create( englishString.c_str(),
-                         foreignString.c_str(),
-                         alignmentString.c_str(),
-                         weightString.c_str(),
-                         i, false)) {
+    if (sentence->create( englishString.c_str(),
+                          foreignString.c_str(),
+                          alignmentString.c_str(),
+                          weightString.c_str(),
+                          i, false)) {
       if (options.placeholders.size()) {
-        sentence.invertAlignment();
+        sentence->invertAlignment();
+      }
+      boost::shared_ptr<ExtractTask> task(new ExtractTask(taskId++, sentence, options, output));
+#ifdef WITH_THREADS
+      if (pool) {
+        pool->Submit(task);
+      } else {
+        task->Run();
       }
-      ExtractTask *task = new ExtractTask(i-1, sentence, options, extractFile , extractFileInv, extractFileOrientation, extractFileContext, extractFileContextInv);
+#else
       task->Run();
-      delete task;
-
+#endif
+    } else {
+      delete sentence;
     }
     if (options.isOnlyOutputSpanInfo()) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
   }
 
-  eFile.Close();
-  fFile.Close();
-  aFile.Close();
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
 
   //az: only close if we actually opened it
   if (!options.isOnlyOutputSpanInfo()) {
@@ -1065,51 +1119,17 @@ void ExtractTask::writePhrasesToFile()
     outextractFileContextInv<<phrase->data();
   }
 
-  m_extractFile << outextractFile.str();
-  m_extractFileInv  << outextractFileInv.str();
-  m_extractFileOrientation << outextractFileOrientation.str();
+  std::vector<std::string> outputs(EXTRACT_OUTPUT_STREAMS);
+  outputs[EXTRACT] = outextractFile.str();
+  outputs[EXTRACT_INV] = outextractFileInv.str();
+  outputs[EXTRACT_ORIENTATION] = outextractFileOrientation.str();
   if (m_options.isFlexScoreFlag()) {
-    m_extractFileContext  << outextractFileContext.str();
-    m_extractFileContextInv << outextractFileContextInv.str();
-  }
-}
-
-// if proper conditioning, we need the number of times a source phrase occured
-
-void ExtractTask::extractBase()
-{
-  ostringstream outextractFile;
-  ostringstream outextractFileInv;
-
-  int countF = m_sentence.source.size();
-  for(int startF=0; startF<countF; startF++) {
-    for(int endF=startF;
-        (endF<countF && endF<startF+m_options.maxPhraseLength);
-        endF++) {
-      for(int fi=startF; fi<=endF; fi++) {
-        outextractFile << m_sentence.source[fi] << " ";
-      }
-      outextractFile << "|||" << endl;
-    }
+    outputs[EXTRACT_CONTEXT] = outextractFileContext.str();
+    outputs[EXTRACT_CONTEXT_INV] = outextractFileContextInv.str();
   }
-
-  int countE = m_sentence.target.size();
-  for(int startE=0; startE<countE; startE++) {
-    for(int endE=startE;
-        (endE<countE && endE<startE+m_options.maxPhraseLength);
-        endE++) {
-      for(int ei=startE; ei<=endE; ei++) {
-        outextractFileInv << m_sentence.target[ei] << " ";
-      }
-      outextractFileInv << "|||" << endl;
-    }
-  }
-  m_extractFile << outextractFile.str();
-  m_extractFileInv << outextractFileInv.str();
-
+  m_output.Write(m_id, outputs);
 }
 
-
 bool ExtractTask::checkPlaceholders(int startE, int endE, int startF, int endF) const
 {
   for (int pos = startF; pos <= endF; ++pos) {
@@ -36,7 +36,11 @@
 //#include <vld.h>
 #endif
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include "ExtractedRule.h"
+#include "ExtractionOutput.h"
 #include "Hole.h"
 #include "HoleCollection.h"
 #include "RuleExist.h"
@@ -44,9 +48,10 @@
 #include "SyntaxNode.h"
 #include "tables-core.h"
 #include "XmlTree.h"
-#include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "PhraseOrientation.h"
+#include "moses/ThreadPool.h"
+#include "util/file_piece.hh"
 
 using namespace std;
 using namespace MosesTraining;
@@ -54,15 +59,26 @@ using namespace MosesTraining;
 typedef vector< int > LabelIndex;
 typedef map< int, int > WordIndex;
 
-class ExtractTask
+// streams of the ExtractionOutput
+enum ExtractOutputStream {
+  EXTRACT = 0,
+  EXTRACT_INV,
+  EXTRACT_CONTEXT,
+  EXTRACT_CONTEXT_INV,
+  EXTRACT_OUTPUT_STREAMS
+};
+
+// sentences queued per thread when extracting on several threads
+const size_t kQueuePerThread = 16;
+
+class ExtractTask : public Moses::Task
 {
 private:
+  size_t m_id;
+  boost::scoped_ptr<SentenceAlignmentWithSyntax> m_ownSentence;
   SentenceAlignmentWithSyntax &m_sentence;
   const RuleExtractionOptions &m_options;
-  Moses::OutputFileStream& m_extractFile;
-  Moses::OutputFileStream& m_extractFileInv;
-  Moses::OutputFileStream& m_extractFileContext;
-  Moses::OutputFileStream& m_extractFileContextInv;
+  ExtractionOutput &m_output;
   PhraseOrientation m_phraseOrientation;
 
   vector< ExtractedRule > m_extractedRules;
@@ -97,13 +113,13 @@ private:
   }
 
 public:
-  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv, Moses::OutputFileStream &extractFileContext, Moses::OutputFileStream &extractFileContextInv):
-    m_sentence(sentence),
+  // takes ownership of sentence
+  ExtractTask(size_t id, SentenceAlignmentWithSyntax *sentence, const RuleExtractionOptions &options, ExtractionOutput &output):
+    m_id(id),
+    m_ownSentence(sentence),
+    m_sentence(*sentence),
     m_options(options),
-    m_extractFile(extractFile),
-    m_extractFileInv(extractFileInv),
-    m_extractFileContext(extractFileContext),
-    m_extractFileContextInv(extractFileContextInv) {}
+    m_output(output) {}
   void Run();
 
 };
@@ -124,9 +140,8 @@ int main(int argc, char* argv[])
 
   RuleExtractionOptions options;
   int sentenceOffset = 0;
-#ifdef WITH_THREADS
-  int thread_count = 1;
-#endif
+  size_t thread_count = 1;
+  bool unorderedOutput = false;
   if (argc < 5) {
     cerr << "syntax: extract-rules corpus.target corpus.source corpus.align extract ["
 
@@ -147,7 +162,9 @@ int main(int argc, char* argv[])
          << " | --ConditionOnTargetLHS ]"
          << " | --BoundaryRules[" << options.boundaryRules << "]"
          << " | --FlexibilityScore"
-         << " | --PhraseOrientation\n";
+         << " | --PhraseOrientation"
+         << " | --Threads n"
+         << " | --UnorderedOutput\n";
 
     exit(1);
   }
@@ -280,11 +297,13 @@ int main(int argc, char* argv[])
                strcmp(argv[i],"--threads") == 0 ||
                strcmp(argv[i],"--Threads") == 0) {
 #ifdef WITH_THREADS
-      thread_count = atoi(argv[++i]);
+      thread_count = std::max(1, atoi(argv[++i]));
 #else
       cerr << "thread support not compiled in." << '\n';
       exit(1);
 #endif
+    } else if (strcmp(argv[i],"--UnorderedOutput") == 0) {
+      unorderedOutput = true;
     } else if (strcmp(argv[i], "--SentenceOffset") == 0) {
       if (i+1 >= argc || argv[i+1][0] < '0' || argv[i+1][0] > '9') {
         cerr << "extract: syntax error, used switch --SentenceOffset without a number" << endl;
@@ -301,14 +320,15 @@ int main(int argc, char* argv[])
 
   cerr << "extracting hierarchical rules" << endl;
 
-  // open input files
-  Moses::InputFileStream tFile(fileNameT);
-  Moses::InputFileStream sFile(fileNameS);
-  Moses::InputFileStream aFile(fileNameA);
+  // span info is printed to stdout as it is found
+  if (options.onlyOutputSpanInfo) {
+    thread_count = 1;
+  }
 
-  istream *tFileP = &tFile;
-  istream *sFileP = &sFile;
-  istream *aFileP = &aFile;
+  // open input files
+  util::FilePiece tFile(fileNameT);
+  util::FilePiece sFile(fileNameS);
+  util::FilePiece aFile(fileNameA);
 
   // open output files
   string fileNameExtractInv = fileNameExtract + ".inv" + (options.gzOutput?".gz":"");
@@ -333,19 +353,38 @@ int main(int argc, char* argv[])
   set< string > targetLabelCollection, sourceLabelCollection;
   map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
 
+  std::vector<std::ostream*> outputStreams(EXTRACT_OUTPUT_STREAMS);
+  outputStreams[EXTRACT] = &extractFile;
+  outputStreams[EXTRACT_INV] = &extractFileInv;
+  outputStreams[EXTRACT_CONTEXT] = &extractFileContext;
+  outputStreams[EXTRACT_CONTEXT_INV] = &extractFileContextInv;
+  ExtractionOutput output(outputStreams, !unorderedOutput);
+
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (thread_count > 1) {
+    pool.reset(new Moses::ThreadPool(thread_count));
+    pool->SetQueueLimit(kQueuePerThread * thread_count);
+  }
+#endif
+
   // loop through all sentence pairs
   size_t i=sentenceOffset;
+  size_t taskId = 0;
+  StringPiece targetLine;
   string targetString, sourceString, alignmentString;
 
-  while(getline(*tFileP, targetString)) {
+  while(tFile.ReadLineOrEOF(targetLine, '\n', false)) {
     i++;
 
-    getline(*sFileP, sourceString);
-    getline(*aFileP, alignmentString);
+    // sentences are parsed here, since parsing collects the labels
+    targetString.assign(targetLine.data(), targetLine.size());
+    sourceString = sFile.ReadLine('\n', false).as_string();
+    alignmentString = aFile.ReadLine('\n', false).as_string();
 
     if (i%1000 == 0) cerr << i << " " << flush;
 
-    SentenceAlignmentWithSyntax sentence
+    SentenceAlignmentWithSyntax *sentence = new SentenceAlignmentWithSyntax
     (targetLabelCollection, sourceLabelCollection,
      targetTopLabelCollection, sourceTopLabelCollection,
      options.targetSyntax, options.sourceSyntax);
@@ -357,20 +396,31 @@ int main(int argc, char* argv[])
       cout << "LOG: PHRASES_BEGIN:" << endl;
     }
 
-    if (sentence.create(targetString.c_str(), sourceString.c_str(), alignmentString.c_str(),"", i, options.boundaryRules)) {
+    if (sentence->create(targetString.c_str(), sourceString.c_str(), alignmentString.c_str(),"", i, options.boundaryRules)) {
       if (options.unknownWordLabelFlag) {
-        collectWordLabelCounts(sentence);
+        collectWordLabelCounts(*sentence);
+      }
+      boost::shared_ptr<ExtractTask> task(new ExtractTask(taskId++, sentence, options, output));
+#ifdef WITH_THREADS
+      if (pool) {
+        pool->Submit(task);
+      } else {
+        task->Run();
       }
-      ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv, extractFileContext, extractFileContextInv);
+#else
       task->Run();
-      delete task;
+#endif
+    } else {
+      delete sentence;
     }
     if (options.onlyOutputSpanInfo) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
   }
 
-  tFile.Close();
-  sFile.Close();
-  aFile.Close();
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
   // only close if we actually opened it
   if (!options.onlyOutputSpanInfo) {
     extractFile.Close();
@@ -1223,10 +1273,12 @@ void ExtractTask::writeRulesToFile()
       }
     }
   }
-  m_extractFile << out.str();
-  m_extractFileInv << outInv.str();
-  m_extractFileContext << outContext.str();
-  m_extractFileContextInv << outContextInv.str();
+  std::vector<std::string> outputs(EXTRACT_OUTPUT_STREAMS);
+  outputs[EXTRACT] = out.str();
+  outputs[EXTRACT_INV] = outInv.str();
+  outputs[EXTRACT_CONTEXT] = outContext.str();
+  outputs[EXTRACT_CONTEXT_INV] = outContextInv.str();
+  m_output.Write(m_id, outputs);
 }
 
 void writeGlueGrammar( const string & fileName, RuleExtractionOptions &options, set< string > &targetLabelCollection, map< string, int > &targetTopLabelCollection )
@@ -26,16 +26,24 @@
 #include <vector>
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#endif
 
 #include "ScoreFeature.h"
 #include "tables-core.h"
 #include "ExtractionPhrasePair.h"
 #include "score.h"
 #include "InputFileStream.h"
+#include "LineSorter.h"
 #include "OutputFileStream.h"
 
 #include "moses/Util.h"
+#include "util/usage.hh"
 
 using namespace boost::algorithm;
 using namespace MosesTraining;
@@ -96,6 +104,12 @@ std::vector<float> orientationClassPriorsR2L(4,0); // mono swap dleft dright
 Vocabulary vcbT;
 Vocabulary vcbS;
 
+size_t scoreThreads = 1;
+#ifdef WITH_THREADS
+// Guards the statistics that outputPhrasePair collects across phrase pairs
+boost::mutex statisticsMutex;
+#endif
+
 } // namespace
 
 
@@ -112,6 +126,11 @@ void writeLeftHandSideLabelCounts( const boost::unordered_map<std::string,float>
 void writeLabelSet( const std::set<std::string> &labelSet, const std::string &fileName );
 void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource, std::ostream &phraseTableFile,
                          const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb );
+void flushPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource,
+                       std::vector< std::vector< ExtractionPhrasePair* > > &pendingGroups, size_t &pendingPairs,
+                       bool final, std::ostream &phraseTableFile,
+                       const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb );
+bool nextExtractLine( std::istream *extractFile, LineSorter *sortedExtract, std::string &line );
 void outputPhrasePair(const ExtractionPhrasePair &phrasePair, float, int, std::ostream &phraseTableFile, const ScoreFeatureManager &featureManager, const MaybeLog &maybeLog );
 double computeLexicalTranslation( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *alignmentTargetToSource );
 double computeUnalignedPenalty( const ALIGNMENT *alignmentTargetToSource );
@@ -154,7 +173,12 @@ int main(int argc, char* argv[])
               "[--TargetSyntacticPreferences] "
               "[--UnpairedExtractFormat] "
               "[--ConditionOnTargetLHS] "
-              "[--CrossedNonTerm]"
+              "[--CrossedNonTerm] "
+              "[--Threads count] "
+              "[--Sort] "
+              "[--SortOutput] "
+              "[--SortMemory size] "
+              "[--TempDir dir]"
               << std::endl;
     std::cerr << featureManager.usage() << std::endl;
     exit(1);
@@ -172,6 +196,10 @@ int main(int argc, char* argv[])
   std::string fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts;
   std::string fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts;
   std::string fileNamePhraseOrientationPriors;
+  bool sortExtractFlag = false;
+  bool sortOutputFlag = false;
+  std::string sortMemory = "1G";
+  std::string tempDir = "/tmp/";
   // All unknown args are passed to feature manager.
   std::vector<std::string> featureArgs;
 
@@ -290,6 +318,25 @@ int main(int argc, char* argv[])
     } else if (strcmp(argv[i],"--TargetConstituentBoundaries") == 0) {
       targetConstituentBoundariesFlag = true;
       std::cerr << "including target constituent boundaries information" << std::endl;
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      scoreThreads = std::max(1, std::atoi( argv[++i] ));
+#ifdef WITH_THREADS
+      std::cerr << "scoring with " << scoreThreads << " threads" << std::endl;
+#else
+      std::cerr << "thread support not compiled in, scoring with one thread" << std::endl;
+      scoreThreads = 1;
+#endif
+    } else if (strcmp(argv[i],"--Sort") == 0) {
+      sortExtractFlag = true;
+      std::cerr << "sorting the extract file" << std::endl;
+    } else if (strcmp(argv[i],"--SortOutput") == 0) {
+      sortOutputFlag = true;
+      std::cerr << "sorting the phrase table" << std::endl;
+    } else if (strcmp(argv[i],"--SortMemory") == 0) {
+      sortMemory = argv[++i];
+    } else if (strcmp(argv[i],"--TempDir") == 0) {
+      tempDir = argv[++i];
+      util::NormalizeTempPrefix(tempDir);
     } else {
       featureArgs.push_back(argv[i]);
       ++i;
@@ -326,18 +373,35 @@ int main(int argc, char* argv[])
     loadOrientationPriors(fileNamePhraseOrientationPriors,orientationClassPriorsL2R,orientationClassPriorsR2L);
   }
 
-  // sorted phrase extraction file
-  Moses::InputFileStream extractFile(fileNameExtract);
+  const std::size_t sortMemoryBytes = util::ParseSize(sortMemory);
+  const std::string tempPrefix = tempDir + "score";
 
-  if (extractFile.fail()) {
-    std::cerr << "ERROR: could not open extract file " << fileNameExtract << std::endl;
-    exit(1);
+  // sorted phrase extraction file, or sorted here
+  boost::scoped_ptr<Moses::InputFileStream> extractFile;
+  boost::scoped_ptr<LineSorter> sortedExtract;
+
+  if (sortExtractFlag) {
+    sortedExtract.reset(new LineSorter(tempPrefix, sortMemoryBytes));
+    sortedExtract->AddFile(fileNameExtract);
+    sortedExtract->Sort();
+  } else {
+    extractFile.reset(new Moses::InputFileStream(fileNameExtract));
+    if (extractFile->fail()) {
+      std::cerr << "ERROR: could not open extract file " << fileNameExtract << std::endl;
+      exit(1);
+    }
   }
 
   // output file: phrase translation table
   std::ostream *phraseTableFile;
-
-  if (fileNamePhraseTable == "-") {
+  boost::scoped_ptr<LineSorter> sortedPhraseTable;
+  std::ostringstream sortBuffer;
+
+  if (sortOutputFlag) {
+    // collected here, sorted and written at the end
+    sortedPhraseTable.reset(new LineSorter(tempPrefix, sortMemoryBytes));
+    phraseTableFile = &sortBuffer;
+  } else if (fileNamePhraseTable == "-") {
     phraseTableFile = &std::cout;
   } else {
     Moses::OutputFileStream *outputFile = new Moses::OutputFileStream();
@@ -363,7 +427,10 @@ int main(int argc, char* argv[])
   float tmpCount=0.0f, tmpPcfgSum=0.0f;
 
   int i=0;
-  if ( getline(extractFile, line) ) {
+  std::vector< std::vector< ExtractionPhrasePair* > > pendingGroups; // scored together when running several threads
+  size_t pendingPairs = 0;
+
+  if ( nextExtractLine(extractFile.get(), sortedExtract.get(), line) ) {
     ++i;
     tmpPhraseSource = new PHRASE();
     tmpPhraseTarget = new PHRASE();
@@ -385,7 +452,7 @@ int main(int argc, char* argv[])
     lastLine = line;
   }
 
-  while ( getline(extractFile, line) ) {
+  while ( nextExtractLine(extractFile.get(), sortedExtract.get(), line) ) {
 
     // Print progress dots to stderr.
     if ( ++i % 100000 == 0 ) {
@@ -447,12 +514,12 @@ int main(int argc, char* argv[])
 
       if ( !phrasePairsWithSameSource.empty() &&
            !sourceMatch ) {
-        processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
-        for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
-              iter!=phrasePairsWithSameSource.end(); ++iter) {
-          delete *iter;
+        flushPhrasePairs( phrasePairsWithSameSource, pendingGroups, pendingPairs, false,
+                          *phraseTableFile, featureManager, maybeLogProb );
+        if (sortedPhraseTable) {
+          sortedPhraseTable->AddLines(sortBuffer.str());
+          sortBuffer.str("");
         }
-        phrasePairsWithSameSource.clear();
         if ( hierarchicalFlag ) {
           phrasePairsWithSameSourceAndTarget.clear();
         }
@@ -482,13 +549,30 @@ int main(int argc, char* argv[])
   // We've been printing progress dots to stderr.  End the line.
   std::cerr << std::endl;
 
-  processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
-  for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
-        iter!=phrasePairsWithSameSource.end(); ++iter) {
-    delete *iter;
-  }
-  phrasePairsWithSameSource.clear();
+  flushPhrasePairs( phrasePairsWithSameSource, pendingGroups, pendingPairs, true,
+                    *phraseTableFile, featureManager, maybeLogProb );
 
+  if (sortedPhraseTable) {
+    sortedPhraseTable->AddLines(sortBuffer.str());
+    sortBuffer.str("");
+    sortedPhraseTable->Sort();
+    if (fileNamePhraseTable == "-") {
+      phraseTableFile = &std::cout;
+    } else {
+      Moses::OutputFileStream *outputFile = new Moses::OutputFileStream();
+      if (!outputFile->Open(fileNamePhraseTable)) {
+        std::cerr << "ERROR: could not open file phrase table file "
+                  << fileNamePhraseTable << std::endl;
+        exit(1);
+      }
+      phraseTableFile = outputFile;
+    }
+    StringPiece sortedLine;
+    while (sortedPhraseTable->Next(sortedLine)) {
+      phraseTableFile->write(sortedLine.data(), sortedLine.size());
+      phraseTableFile->put('\n');
+    }
+  }
 
   phraseTableFile->flush();
   if (phraseTableFile != &std::cout) {
@@ -598,6 +682,20 @@ void processLine( std::string line,
 }
 
 
+bool nextExtractLine( std::istream *extractFile, LineSorter *sortedExtract, std::string &line )
+{
+  if (sortedExtract) {
+    StringPiece sortedLine;
+    if (!sortedExtract->Next(sortedLine)) {
+      return false;
+    }
+    line.assign(sortedLine.data(), sortedLine.size());
+    return true;
+  }
+  return static_cast<bool>(getline(*extractFile, line));
+}
+
+
 void writeCountOfCounts( const std::string &fileNameCountOfCounts )
 {
   // open file
@@ -710,6 +808,72 @@ void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSa
   }
 }
 
+#ifdef WITH_THREADS
+void scorePhrasePairGroups( std::vector< std::vector< ExtractionPhrasePair* > > &groups,
+                            size_t first, size_t stride, std::vector< std::string > &out,
+                            const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+{
+  std::ostringstream buffer;
+  for (size_t i = first; i < groups.size(); i += stride) {
+    buffer.str("");
+    processPhrasePairs( groups[i], buffer, featureManager, maybeLogProb );
+    out[i] = buffer.str();
+  }
+}
+#endif
+
+// Scores the phrase pairs of a source phrase and frees them. With several
+// threads, source phrases are collected and scored together, and their
+// output is written in the original order.
+void flushPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource,
+                       std::vector< std::vector< ExtractionPhrasePair* > > &pendingGroups, size_t &pendingPairs,
+                       bool final, std::ostream &phraseTableFile,
+                       const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+{
+  static const size_t kPairsPerThread = 20000;
+
+  if (scoreThreads <= 1) {
+    processPhrasePairs( phrasePairsWithSameSource, phraseTableFile, featureManager, maybeLogProb );
+    for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
+          iter!=phrasePairsWithSameSource.end(); ++iter) {
+      delete *iter;
+    }
+    phrasePairsWithSameSource.clear();
+    return;
+  }
+
+#ifdef WITH_THREADS
+  if (!phrasePairsWithSameSource.empty()) {
+    pendingPairs += phrasePairsWithSameSource.size();
+    pendingGroups.push_back(std::vector< ExtractionPhrasePair* >());
+    pendingGroups.back().swap(phrasePairsWithSameSource);
+  }
+  if (pendingGroups.empty() || (!final && pendingPairs < kPairsPerThread * scoreThreads)) {
+    return;
+  }
+
+  std::vector< std::string > out(pendingGroups.size());
+  const size_t threads = std::min(scoreThreads, pendingGroups.size());
+  boost::thread_group workers;
+  for (size_t t = 1; t < threads; ++t) {
+    workers.create_thread(boost::bind(&scorePhrasePairGroups, boost::ref(pendingGroups), t, threads,
+                                      boost::ref(out), boost::cref(featureManager), boost::cref(maybeLogProb)));
+  }
+  scorePhrasePairGroups(pendingGroups, 0, threads, out, featureManager, maybeLogProb);
+  workers.join_all();
+
+  for (size_t i = 0; i < pendingGroups.size(); ++i) {
+    phraseTableFile << out[i];
+    for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=pendingGroups[i].begin();
+          iter!=pendingGroups[i].end(); ++iter) {
+      delete *iter;
+    }
+  }
+  pendingGroups.clear();
+  pendingPairs = 0;
+#endif
+}
+
 void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
                       float totalCount, int distinctCount,
                       std::ostream &phraseTableFile,
@@ -725,6 +889,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
     totalDistinct++;
     int countInt = count + 0.99999;
     if ((countInt <= COC_MAX) &&
@@ -874,6 +1041,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // parts-of-speech
   if (partsOfSpeechFlag && !inverseFlag) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
     phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
     const std::string *bestPartOfSpeech = phrasePair.FindBestPropertyValue("POS");
     if (bestPartOfSpeech) {
@@ -883,6 +1053,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // syntax labels
   if ((sourceSyntaxLabelsFlag || targetSyntacticPreferencesFlag) && !inverseFlag) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
     unsigned nNTs = 1;
     for(size_t j=0; j<phraseSource->size()-1; ++j) {
       if (isNonTerminal(vcbS.getWord( phraseSource->at(j) )))
@@ -1219,7 +1392,13 @@ void LexicalTable::load( const std::string &fileName )
     double prob = std::atof( token[2].c_str() );
     WORD_ID wordT = vcbT.storeIfNew( token[0] );
     WORD_ID wordS = vcbS.storeIfNew( token[1] );
-    ltable[ wordS ][ wordT ] = prob;
+    WordPairEntry< double > entry;
+    entry.key = getWordPairKey( wordS, wordT );
+    entry.value = prob;
+    Table::MutableIterator it;
+    if (ltable.FindOrInsert( entry, it )) {
+      it->value = prob;
+    }
   }
   std::cerr << std::endl;
 }
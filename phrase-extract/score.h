@@ -20,21 +20,24 @@
 #pragma once
 
 #include <string>
-#include <map>
+#include "tables-core.h"
+#include "util/probing_hash_table.hh"
 
 namespace MosesTraining
 {
 class LexicalTable
 {
 public:
-  std::map< WORD_ID, std::map< WORD_ID, double > > ltable;
+  // one probe per word pair, instead of a tree of trees
+  typedef util::AutoProbing< WordPairEntry< double >, WordPairHash > Table;
+  Table ltable;
   void load( const std::string &filePath );
-  double permissiveLookup( WORD_ID wordS, WORD_ID wordT ) {
+  double permissiveLookup( WORD_ID wordS, WORD_ID wordT ) const {
     // cout << endl << vcbS.getWord( wordS ) << "-" << vcbT.getWord( wordT ) << ":";
-    if (ltable.find( wordS ) == ltable.end()) return 1.0;
-    if (ltable[ wordS ].find( wordT ) == ltable[ wordS ].end()) return 1.0;
-    // cout << ltable[ wordS ][ wordT ];
-    return ltable[ wordS ][ wordT ];
+    Table::ConstIterator entry;
+    if (!ltable.Find( getWordPairKey( wordS, wordT ), entry )) return 1.0;
+    // cout << entry->value;
+    return entry->value;
   }
 };
 
@@ -1,5 +1,6 @@
 // $Id$
 //#include "beammain.h"
+#include <algorithm>
 #include "util/tokenize.hh"
 #include "tables-core.h"
 
@@ -11,51 +12,137 @@ using namespace std;
 namespace MosesTraining
 {
 
-WORD_ID Vocabulary::storeIfNew( const WORD& word )
+namespace
+{
+uint64_t hashWord( const WORD& word )
+{
+  return util::MurmurHashNative( word.data(), word.size() );
+}
+
+uint64_t hashPhrase( const PHRASE& phrase )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+  return util::MurmurHashNative( phrase.empty() ? NULL : &phrase[0],
+                                 phrase.size() * sizeof(WORD_ID) );
+}
+
+struct WordEquals {
+  const std::vector< WORD > &vocab;
+  const WORD &word;
+  WordEquals( const std::vector< WORD > &v, const WORD &w ) : vocab(v), word(w) {}
+  bool operator()( unsigned int id ) const {
+    return vocab[ id ] == word;
+  }
+};
+
+struct PhraseEquals {
+  const std::vector< WORD_ID > &arena;
+  const std::vector< size_t > &offsets;
+  const PHRASE &phrase;
+  PhraseEquals( const std::vector< WORD_ID > &a, const std::vector< size_t > &o, const PHRASE &p )
+    : arena(a), offsets(o), phrase(p) {}
+  bool operator()( unsigned int id ) const {
+    const WORD_ID *words = &arena[ offsets[ id ] ];
+    return words[0] == phrase.size()
+           && std::equal( phrase.begin(), phrase.end(), words + 1 );
+  }
+};
+}
 
-  if( i != lookup.end() )
-    return i->second;
+void IdIndex::insert( uint64_t hash, unsigned int id )
+{
+  // keep at most 3/4 of the buckets in use, so that probes stay short
+  if ((m_size + 1) * 4 > m_buckets.size() * 3) {
+    grow();
+  }
+  size_t mask = m_buckets.size() - 1;
+  size_t i = hash & mask;
+  while (m_buckets[i].id != EMPTY) {
+    i = (i + 1) & mask;
+  }
+  m_buckets[i].hash = hash;
+  m_buckets[i].id = id;
+  ++m_size;
+}
 
-  WORD_ID id = vocab.size();
+void IdIndex::clear()
+{
+  m_buckets.clear();
+  m_size = 0;
+}
+
+void IdIndex::grow()
+{
+  Bucket empty;
+  empty.hash = 0;
+  empty.id = EMPTY;
+  std::vector< Bucket > old( m_buckets.empty() ? 16 : m_buckets.size() * 2, empty );
+  old.swap( m_buckets );
+
+  size_t mask = m_buckets.size() - 1;
+  for (size_t b = 0; b < old.size(); ++b) {
+    if (old[b].id == EMPTY) continue;
+    size_t i = old[b].hash & mask;
+    while (m_buckets[i].id != EMPTY) {
+      i = (i + 1) & mask;
+    }
+    m_buckets[i] = old[b];
+  }
+}
+
+WORD_ID Vocabulary::storeIfNew( const WORD& word )
+{
+  uint64_t hash = hashWord( word );
+  WORD_ID id;
+  if( m_index.find( hash, WordEquals( vocab, word ), id ) )
+    return id;
+
+  id = vocab.size();
   vocab.push_back( word );
-  lookup[ word ] = id;
+  m_index.insert( hash, id );
   return id;
 }
 
 WORD_ID Vocabulary::getWordID( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
-  if( i == lookup.end() )
+  WORD_ID id;
+  if( !m_index.find( hashWord( word ), WordEquals( vocab, word ), id ) )
     return 0;
-  return i->second;
+  return id;
 }
 
-PHRASE_ID PhraseTable::storeIfNew( const PHRASE& phrase )
+bool PhraseTable::find( const PHRASE& phrase, uint64_t hash, PHRASE_ID &id ) const
 {
-  map< PHRASE, PHRASE_ID >::iterator i = lookup.find( phrase );
-  if( i != lookup.end() )
-    return i->second;
+  return m_index.find( hash, PhraseEquals( m_arena, m_offsets, phrase ), id );
+}
 
-  PHRASE_ID id  = phraseTable.size();
-  phraseTable.push_back( phrase );
-  lookup[ phrase ] = id;
+PHRASE_ID PhraseTable::storeIfNew( const PHRASE& phrase )
+{
+  uint64_t hash = hashPhrase( phrase );
+  PHRASE_ID id;
+  if( find( phrase, hash, id ) )
+    return id;
+
+  id = m_offsets.size();
+  m_offsets.push_back( m_arena.size() );
+  m_arena.push_back( phrase.size() );
+  m_arena.insert( m_arena.end(), phrase.begin(), phrase.end() );
+  m_index.insert( hash, id );
   return id;
 }
 
 PHRASE_ID PhraseTable::getPhraseID( const PHRASE& phrase )
 {
-  map< PHRASE, PHRASE_ID >::iterator i = lookup.find( phrase );
-  if( i == lookup.end() )
+  PHRASE_ID id;
+  if( !find( phrase, hashPhrase( phrase ), id ) )
     return 0;
-  return i->second;
+  return id;
 }
 
 void PhraseTable::clear()
 {
-  lookup.clear();
-  phraseTable.clear();
+  m_arena.clear();
+  m_offsets.clear();
+  m_index.clear();
 }
 
 void DTable::init()
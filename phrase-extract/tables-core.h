@@ -10,7 +10,10 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
+#include <stdint.h>
+#include "util/murmur_hash.hh"
 
 namespace MosesTraining
 {
@@ -18,31 +21,116 @@ namespace MosesTraining
 typedef std::string WORD;
 typedef unsigned int WORD_ID;
 
+// open addressing index from a hash to ids, for the tables below. Buckets
+// keep the full hash, so the ids are only compared on a probable match
+class IdIndex
+{
+public:
+  IdIndex() : m_size(0) {}
+
+  // equal(id) compares the stored item with the one sought
+  template <class Equal>
+  bool find( uint64_t hash, const Equal &equal, unsigned int &id ) const {
+    if (m_buckets.empty()) return false;
+    size_t mask = m_buckets.size() - 1;
+    for (size_t i = hash & mask; m_buckets[i].id != EMPTY; i = (i + 1) & mask) {
+      if (m_buckets[i].hash == hash && equal( m_buckets[i].id )) {
+        id = m_buckets[i].id;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // the item must not be in the index yet
+  void insert( uint64_t hash, unsigned int id );
+  void clear();
+
+private:
+  static const unsigned int EMPTY = ~0u;
+  struct Bucket {
+    uint64_t hash;
+    unsigned int id;
+  };
+  std::vector< Bucket > m_buckets;
+  size_t m_size;
+
+  void grow();
+};
+
 class Vocabulary
 {
 public:
-  std::map<WORD, WORD_ID>  lookup;
   std::vector< WORD > vocab;
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
   inline WORD &getWord( const WORD_ID id ) {
     return vocab[ id ];
   }
+private:
+  IdIndex m_index;
 };
 
 typedef std::vector< WORD_ID > PHRASE;
 typedef unsigned int PHRASE_ID;
 
+// stores every distinct phrase once, in one array, rather than as a
+// vector per phrase plus a copy as the key of a tree
 class PhraseTable
 {
 public:
-  std::map< PHRASE, PHRASE_ID > lookup;
-  std::vector< PHRASE > phraseTable;
   PHRASE_ID storeIfNew( const PHRASE& );
   PHRASE_ID getPhraseID( const PHRASE& );
   void clear();
-  inline PHRASE &getPhrase( const PHRASE_ID id ) {
-    return phraseTable[ id ];
+  PHRASE getPhrase( const PHRASE_ID id ) const {
+    const WORD_ID *words = &m_arena[ m_offsets[ id ] ];
+    return PHRASE( words + 1, words + 1 + words[0] );
+  }
+  size_t size() const {
+    return m_offsets.size();
+  }
+private:
+  std::vector< WORD_ID > m_arena; // each phrase as its length, then its words
+  std::vector< size_t > m_offsets;
+  IdIndex m_index;
+
+  bool find( const PHRASE&, uint64_t hash, PHRASE_ID &id ) const;
+};
+
+// a pair of word ids as a single key for util::ProbingHashTable and
+// util::AutoProbing. 0 marks an empty bucket, so no pair maps to it
+inline uint64_t getWordPairKey( WORD_ID first, WORD_ID second )
+{
+  return ((static_cast<uint64_t>(first) << 32) | second) + 1;
+}
+
+inline WORD_ID getWordPairFirst( uint64_t key )
+{
+  return static_cast<WORD_ID>((key - 1) >> 32);
+}
+
+inline WORD_ID getWordPairSecond( uint64_t key )
+{
+  return static_cast<WORD_ID>(key - 1);
+}
+
+struct WordPairHash {
+  uint64_t operator()( uint64_t key ) const {
+    return util::MurmurHashNative( &key, sizeof(key) );
+  }
+};
+
+template <class Value>
+struct WordPairEntry {
+  typedef uint64_t Key;
+  Key key;
+  Value value;
+
+  Key GetKey() const {
+    return key;
+  }
+  void SetKey( Key to ) {
+    key = to;
   }
 };
 
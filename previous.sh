@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam -j1 --with-re2=/usr cxxflags=-I/tmp/glibshim linkflags=-L/tmp/glibshim contrib/c++tokenizer//tokenizer_test contrib/c++tokenizer//tokenizer_benchmark contrib/c++tokenizer//tokenizer
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <string>
+#include <boost/program_options.hpp>
+#include "reordering.h"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+  string inPath, outPath;
+  bool log_prob = true;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()
+  ("help", "Print help messages")
+  ("input-lr", po::value<string>()->required(), "Text lexical reordering table")
+  ("output", po::value<string>()->required(), "Binary file to write. moses2 looks for the table path + .probinglr")
+  ("raw-prob", "store the scores as they are instead of log (and floor) probabilities. moses2 refuses such a table")
+  ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc),
+              vm); // can throw
+
+    /** --help option
+     */
+    if ( vm.count("help")) {
+      std::cout << desc << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm); // throws on error, so do after help in case
+    // there are any problems
+  } catch(po::error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    std::cerr << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("input-lr")) inPath = vm["input-lr"].as<string>();
+  if (vm.count("output")) outPath = vm["output"].as<string>();
+  if (vm.count("raw-prob")) log_prob = false;
+
+  probingpt::createProbingLR(inPath, outPath, log_prob);
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "reordering.h"
+#include "hash.h"
+#include "probing_hash_utils.h"
+#include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/murmur_hash.hh"
+#include "util/tokenize_piece.hh"
+#include "moses2/legacy/Util2.h"
+
+using namespace std;
+
+namespace probingpt
+{
+
+namespace
+{
+const char LR_MAGIC[8] = { 'P', 'R', 'O', 'B', 'L', 'R', '0', '1' };
+
+// like getVocabIDs(), but tolerates the padding around "|||"
+void getWordIDs(const StringPiece &phrase, vector<uint64_t> &ids)
+{
+  ids.clear();
+  for (util::TokenIter<util::AnyCharacter, true> itWord(phrase, util::AnyCharacter(" \t")); itWord; ++itWord) {
+    uint64_t id = 0;
+    for (util::TokenIter<util::SingleCharacter> itFactor(*itWord, util::SingleCharacter('|')); itFactor; ++itFactor) {
+      id += getHash(*itFactor);
+    }
+    ids.push_back(id);
+  }
+}
+}
+
+uint64_t getLRSourceKey(const uint64_t words[], size_t size)
+{
+  return util::MurmurHashNative(words, size * sizeof(uint64_t));
+}
+
+uint64_t getLRKey(uint64_t sourceKey, const uint64_t words[], size_t size)
+{
+  uint64_t key = util::MurmurHashNative(words, size * sizeof(uint64_t), sourceKey);
+  // 0 marks an empty bucket
+  return key ? key : 1;
+}
+
+void createProbingLR(const std::string &inPath, const std::string &outPath,
+                     bool logProb)
+{
+  util::FilePiece in(inPath.c_str(), &std::cerr);
+  std::ofstream out(outPath.c_str(), std::ios::binary);
+  UTIL_THROW_IF2(!out, "Couldn't open " << outPath << " for writing");
+
+  ReorderingHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LR_MAGIC, sizeof(LR_MAGIC));
+  header.version = LR_API_VERSION;
+  header.logProb = logProb;
+  // rewritten once the sizes are known
+  out.write((const char*) &header, sizeof(header));
+
+  // only the keys are kept in memory, the scores go straight to disk
+  vector<ReorderingEntry> entries;
+  vector<uint64_t> sourceIDs, targetIDs;
+  vector<float> scores;
+  size_t lineNum = 0;
+
+  try {
+    while (true) {
+      StringPiece line = in.ReadLine();
+      ++lineNum;
+
+      util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||"));
+      StringPiece toks[3];
+      for (size_t i = 0; i < 3; ++i, ++it) {
+        UTIL_THROW_IF2(!it, "Expected source ||| target ||| scores on line "
+                       << lineNum << " of " << inPath);
+        toks[i] = *it;
+      }
+
+      scores.clear();
+      for (util::TokenIter<util::AnyCharacter, true> itScore(toks[2], util::AnyCharacter(" \t")); itScore; ++itScore) {
+        float score = strtod(itScore->as_string().c_str(), NULL);
+        if (logProb) {
+          score = Moses2::FloorScore(Moses2::TransformScore(score));
+        }
+        scores.push_back(score);
+      }
+      if (header.numScores == 0) {
+        header.numScores = scores.size();
+      }
+      UTIL_THROW_IF2(scores.size() != header.numScores || scores.empty(),
+                     "Line " << lineNum << " has " << scores.size()
+                     << " scores instead of " << header.numScores);
+      out.write((const char*) &scores[0], scores.size() * sizeof(float));
+
+      getWordIDs(toks[0], sourceIDs);
+      getWordIDs(toks[1], targetIDs);
+      uint64_t sourceKey = getLRSourceKey(sourceIDs.data(), sourceIDs.size());
+
+      ReorderingEntry entry;
+      entry.key = getLRKey(sourceKey, targetIDs.data(), targetIDs.size());
+      entry.value = entries.size();
+      entries.push_back(entry);
+    }
+  } catch (const util::EndOfFileException &e) {
+  }
+
+  header.numEntries = entries.size();
+  header.tableSize = ReorderingHashTable::Size(entries.size(), 1.2);
+  vector<ReorderingEntry> buckets(header.tableSize / sizeof(ReorderingEntry));
+  ReorderingHashTable table(buckets.data(), header.tableSize);
+
+  size_t duplicates = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    ReorderingHashTable::MutableIterator it;
+    if (table.FindOrInsert(entries[i], it)) {
+      // repeated phrase pair, or a hash collision. Keep the first
+      ++duplicates;
+    }
+  }
+  if (duplicates) {
+    std::cerr << "Ignored " << duplicates << " entries with duplicate keys" << std::endl;
+  }
+
+  // align the table to its entries
+  uint64_t pos = sizeof(header) + header.numEntries * header.numScores * sizeof(float);
+  header.tableOffset = (pos + sizeof(ReorderingEntry) - 1) / sizeof(ReorderingEntry) * sizeof(ReorderingEntry);
+  for (; pos < header.tableOffset; ++pos) {
+    out.put(0);
+  }
+  out.write((const char*) buckets.data(), header.tableSize);
+
+  out.seekp(0);
+  out.write((const char*) &header, sizeof(header));
+  out.close();
+  UTIL_THROW_IF2(!out, "Error writing " << outPath);
+}
+
+ReorderingTable::ReorderingTable(const std::string &path, util::LoadMethod load_method)
+{
+  const char *mem = readTable(path.c_str(), load_method, m_file, m_memory);
+  const ReorderingHeader *header = (const ReorderingHeader*) mem;
+
+  UTIL_THROW_IF2(m_memory.size() < sizeof(ReorderingHeader)
+                 || memcmp(header->magic, LR_MAGIC, sizeof(LR_MAGIC)),
+                 path << " is not a probing lexical reordering table");
+  UTIL_THROW_IF2(header->version != LR_API_VERSION,
+                 "The probing lexical reordering format has changed. "
+                 << header->version << "!=" << LR_API_VERSION
+                 << " Please rebinarize " << path);
+  UTIL_THROW_IF2(header->tableOffset + header->tableSize > m_memory.size(),
+                 path << " is truncated");
+
+  m_numScores = header->numScores;
+  m_logProb = header->logProb;
+  m_scores = (const float*) (mem + sizeof(ReorderingHeader));
+  m_table = ReorderingHashTable((void*) (mem + header->tableOffset), header->tableSize);
+}
+
+}
+
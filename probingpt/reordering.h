@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "util/file.hh"
+#include "util/mmap.hh"
+#include "util/probing_hash_table.hh"
+#include "util/string_piece.hh"
+
+namespace probingpt
+{
+
+#define LR_API_VERSION 2
+
+/** Lexical reordering table in a single binary file, written by
+ * CreateProbingLR and mapped read-only, so that every decoder on a machine
+ * shares the same pages. Source and target phrases are not stored; an entry
+ * is found by a hash of both, see getLRSourceKey() and getLRKey().
+ *
+ * Layout: ReorderingHeader, then numEntries * numScores floats, then the
+ * hash table mapping a key to the index of its scores. logProb records
+ * whether the scores were log-transformed and floored when the table was
+ * built, as moses2 expects.
+ */
+struct ReorderingHeader {
+  char magic[8];
+  uint64_t version;
+  uint64_t numScores;
+  uint64_t logProb;
+  uint64_t numEntries;
+  uint64_t tableOffset;
+  uint64_t tableSize;
+};
+
+struct ReorderingEntry {
+  typedef uint64_t Key;
+  Key key;
+
+  Key GetKey() const {
+    return key;
+  }
+
+  void SetKey(Key to) {
+    key = to;
+  }
+
+  uint64_t value;
+};
+
+// keys are already hashes
+typedef util::ProbingHashTable<ReorderingEntry, util::IdentityHash> ReorderingHashTable;
+
+//! words are vocab ids as in getVocabIDs(), ie. the sum of their factor hashes
+uint64_t getLRSourceKey(const uint64_t words[], size_t size);
+uint64_t getLRKey(uint64_t sourceKey, const uint64_t words[], size_t size);
+
+//! log() and floor the scores if logProb, as the moses2 text model does
+void createProbingLR(const std::string &inPath, const std::string &outPath,
+                     bool logProb);
+
+class ReorderingTable
+{
+public:
+  ReorderingTable(const std::string &path, util::LoadMethod load_method);
+
+  size_t GetNumScores() const {
+    return m_numScores;
+  }
+
+  //! whether the scores were stored as log probabilities
+  bool IsLogProb() const {
+    return m_logProb;
+  }
+
+  //! scores of the entry, NULL if there is none
+  const float *Find(uint64_t key) const {
+    ReorderingHashTable::ConstIterator it = m_table.Ideal(key);
+    if (!m_table.FindFromIdeal(key, it)) {
+      return NULL;
+    }
+    return m_scores + it->value * m_numScores;
+  }
+
+  //! start loading the bucket of key, for a Find() shortly after
+  void Prefetch(uint64_t key) const {
+    __builtin_prefetch(m_table.Ideal(key));
+  }
+
+protected:
+  util::scoped_fd m_file;
+  util::scoped_memory m_memory;
+  size_t m_numScores;
+  bool m_logProb;
+  const float *m_scores;
+  ReorderingHashTable m_table;
+};
+
+}
+
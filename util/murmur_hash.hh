@@ -13,6 +13,20 @@ uint64_t MurmurHash64B(const void * key, std::size_t len, uint64_t seed = 0);
 // architectures, really only use it for in-memory structures.
 uint64_t MurmurHashNative(const void * key, std::size_t len, uint64_t seed = 0);
 
+// The 64-bit finalizer of MurmurHash3 as a hash functor.  Every bit of the
+// key affects every bit of the result, so it suits probing tables keyed on
+// integers that differ in few bits, such as packed ids.
+struct MurmurMixHash {
+  std::size_t operator()(uint64_t key) const {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+};
+
 } // namespace util
 
 #endif // UTIL_MURMUR_HASH_H
@@ -0,0 +1,261 @@
+#include "util/suffix_array.hh"
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/scoped.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace util {
+namespace {
+
+const uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+const char kMagic[16] = "SuffixArrayIdx\n";
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[16];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t size;
+  uint64_t vocab_size;
+  uint64_t vocab_bytes;
+};
+
+std::size_t Align8(std::size_t in) {
+  return (in + 7) & ~static_cast<std::size_t>(7);
+}
+
+// Bucket boundaries for symbols [0, upper]: sum_s[c] is the start of the
+// S-type part of bucket c, sum_l[c] the start of bucket c.
+struct Buckets {
+  std::vector<uint32_t> sum_l, sum_s;
+};
+
+// Induce the order of all suffixes from the LMS suffixes in lms (in the order
+// they should be placed in their buckets).
+void Induce(const uint32_t *s, std::size_t n, const std::vector<bool> &ls, const Buckets &buckets, const std::vector<uint32_t> &lms, uint32_t *sa) {
+  std::fill(sa, sa + n, kEmpty);
+  std::vector<uint32_t> buf(buckets.sum_s);
+  for (std::size_t i = 0; i < lms.size(); ++i) {
+    sa[buf[s[lms[i]]]++] = lms[i];
+  }
+  buf = buckets.sum_l;
+  sa[buf[s[n - 1]]++] = n - 1;
+  for (std::size_t i = 0; i < n; ++i) {
+    uint32_t v = sa[i];
+    if (v != kEmpty && v >= 1 && !ls[v - 1]) {
+      sa[buf[s[v - 1]]++] = v - 1;
+    }
+  }
+  buf = buckets.sum_l;
+  for (std::size_t i = n; i-- > 0;) {
+    uint32_t v = sa[i];
+    if (v != kEmpty && v >= 1 && ls[v - 1]) {
+      sa[--buf[s[v - 1] + 1]] = v - 1;
+    }
+  }
+}
+
+// SA-IS on s[0,n) with symbols in [0, upper].
+void SAIS(const uint32_t *s, std::size_t n, uint32_t upper, uint32_t *sa) {
+  if (n == 0) return;
+  if (n == 1) {
+    sa[0] = 0;
+    return;
+  }
+  if (n == 2) {
+    sa[0] = (s[0] < s[1]) ? 0 : 1;
+    sa[1] = 1 - sa[0];
+    return;
+  }
+
+  // ls[i]: suffix i is S-type (smaller than suffix i+1).  The last suffix is
+  // L-type since the empty suffix sorts before it.
+  std::vector<bool> ls(n, false);
+  for (std::size_t i = n - 1; i-- > 0;) {
+    ls[i] = (s[i] == s[i + 1]) ? ls[i + 1] : (s[i] < s[i + 1]);
+  }
+
+  Buckets buckets;
+  buckets.sum_l.assign(upper + 1, 0);
+  buckets.sum_s.assign(upper + 1, 0);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!ls[i]) {
+      ++buckets.sum_s[s[i]];
+    } else {
+      // S-type symbols are never the largest one.
+      ++buckets.sum_l[s[i] + 1];
+    }
+  }
+  for (uint32_t c = 0; c <= upper; ++c) {
+    buckets.sum_s[c] += buckets.sum_l[c];
+    if (c < upper) buckets.sum_l[c + 1] += buckets.sum_s[c];
+  }
+
+  // Leftmost S-type positions and their index among them.
+  std::vector<uint32_t> lms_map(n + 1, kEmpty);
+  std::vector<uint32_t> lms;
+  for (std::size_t i = 1; i < n; ++i) {
+    if (!ls[i - 1] && ls[i]) {
+      lms_map[i] = lms.size();
+      lms.push_back(i);
+    }
+  }
+  const std::size_t m = lms.size();
+
+  Induce(s, n, ls, buckets, lms, sa);
+  if (!m) return;
+
+  // The LMS substrings are now sorted; name them and sort the reduced string
+  // recursively if the names are not unique.
+  std::vector<uint32_t> sorted_lms;
+  sorted_lms.reserve(m);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (lms_map[sa[i]] != kEmpty) sorted_lms.push_back(sa[i]);
+  }
+  std::vector<uint32_t> rec_s(m);
+  uint32_t rec_upper = 0;
+  rec_s[lms_map[sorted_lms[0]]] = 0;
+  for (std::size_t i = 1; i < m; ++i) {
+    std::size_t l = sorted_lms[i - 1], r = sorted_lms[i];
+    std::size_t end_l = (lms_map[l] + 1 < m) ? lms[lms_map[l] + 1] : n;
+    std::size_t end_r = (lms_map[r] + 1 < m) ? lms[lms_map[r] + 1] : n;
+    bool same = true;
+    if (end_l - l != end_r - r) {
+      same = false;
+    } else {
+      while (l < end_l && s[l] == s[r]) {
+        ++l;
+        ++r;
+      }
+      if (l == n || s[l] != s[r]) same = false;
+    }
+    if (!same) ++rec_upper;
+    rec_s[lms_map[sorted_lms[i]]] = rec_upper;
+  }
+
+  std::vector<uint32_t> rec_sa(m);
+  SAIS(&rec_s[0], m, rec_upper, &rec_sa[0]);
+  for (std::size_t i = 0; i < m; ++i) {
+    sorted_lms[i] = lms[rec_sa[i]];
+  }
+  Induce(s, n, ls, buckets, sorted_lms, sa);
+}
+
+struct StringIdLess {
+  explicit StringIdLess(const std::vector<std::string> &vocab) : vocab_(vocab) {}
+  bool operator()(uint32_t a, uint32_t b) const {
+    return vocab_[a] < vocab_[b];
+  }
+  const std::vector<std::string> &vocab_;
+};
+
+} // namespace
+
+void BuildSuffixArray(const uint32_t *text, std::size_t size, uint32_t alphabet, uint32_t *out) {
+  UTIL_THROW_IF(size >= kEmpty, Exception, "Text of " << size << " symbols is too long for a 32-bit suffix array");
+  SAIS(text, size, alphabet ? alphabet - 1 : 0, out);
+}
+
+void BuildLCP(const uint32_t *text, std::size_t size, const uint32_t *sa, uint32_t *lcp) {
+  if (!size) return;
+  std::vector<uint32_t> rank(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    rank[sa[i]] = i;
+  }
+  lcp[0] = 0;
+  std::size_t h = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (rank[i] == 0) {
+      h = 0;
+      continue;
+    }
+    std::size_t j = sa[rank[i] - 1];
+    while (i + h < size && j + h < size && text[i + h] == text[j + h]) ++h;
+    lcp[rank[i]] = h;
+    if (h) --h;
+  }
+}
+
+void RankVocabulary(const std::vector<std::string> &vocab, std::vector<uint32_t> &rank) {
+  std::vector<uint32_t> order(vocab.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), StringIdLess(vocab));
+  rank.resize(vocab.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    rank[order[i]] = i;
+  }
+}
+
+bool SuffixArrayFile::Recognize(const char *file) {
+  scoped_fd fd(OpenReadOrThrow(file));
+  char got[sizeof(kMagic)];
+  std::size_t have = 0;
+  while (have < sizeof(kMagic)) {
+    std::size_t read = ReadOrEOF(fd.get(), got + have, sizeof(kMagic) - have);
+    if (!read) return false;
+    have += read;
+  }
+  return !std::memcmp(got, kMagic, sizeof(kMagic));
+}
+
+void SuffixArrayFile::Write(const char *file, const std::vector<std::string> &vocab, const uint32_t *text, const uint32_t *sa, const uint32_t *lcp, std::size_t size) {
+  std::string strings;
+  for (std::size_t i = 0; i < vocab.size(); ++i) {
+    strings.append(vocab[i]);
+    strings.push_back('\0');
+  }
+  strings.resize(Align8(strings.size()), '\0');
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.size = size;
+  header.vocab_size = vocab.size();
+  header.vocab_bytes = strings.size();
+
+  scoped_fd out(CreateOrThrow(file));
+  WriteOrThrow(out.get(), &header, sizeof(header));
+  WriteOrThrow(out.get(), strings.data(), strings.size());
+  if (size) {
+    WriteOrThrow(out.get(), text, size * sizeof(uint32_t));
+    WriteOrThrow(out.get(), sa, size * sizeof(uint32_t));
+    WriteOrThrow(out.get(), lcp, size * sizeof(uint32_t));
+  }
+}
+
+SuffixArrayFile::SuffixArrayFile(const char *file, LoadMethod method) {
+  scoped_fd fd(OpenReadOrThrow(file));
+  uint64_t file_size = SizeOrThrow(fd.get());
+  UTIL_THROW_IF(file_size < sizeof(Header), Exception, "Suffix array index " << file << " is truncated");
+  MapRead(method, fd.get(), 0, file_size, mem_);
+
+  const Header *header = static_cast<const Header*>(mem_.get());
+  UTIL_THROW_IF(std::memcmp(header->magic, kMagic, sizeof(kMagic)), Exception, file << " is not a suffix array index");
+  UTIL_THROW_IF(header->version != kVersion, Exception, "Suffix array index " << file << " has version " << header->version << " but this code reads version " << kVersion);
+  size_ = header->size;
+  UTIL_THROW_IF(file_size != sizeof(Header) + header->vocab_bytes + 3 * size_ * sizeof(uint32_t), Exception, "Suffix array index " << file << " has the wrong size");
+
+  const char *strings = static_cast<const char*>(mem_.get()) + sizeof(Header);
+  const char *strings_end = strings + header->vocab_bytes;
+  vocab_.reserve(header->vocab_size);
+  for (const char *i = strings; vocab_.size() < header->vocab_size;) {
+    const char *end = static_cast<const char*>(std::memchr(i, '\0', strings_end - i));
+    UTIL_THROW_IF(!end, Exception, "Suffix array index " << file << " has a corrupt vocabulary");
+    vocab_.push_back(StringPiece(i, end - i));
+    i = end + 1;
+  }
+
+  text_ = reinterpret_cast<const uint32_t*>(strings_end);
+  sa_ = text_ + size_;
+  lcp_ = sa_ + size_;
+}
+
+} // namespace util
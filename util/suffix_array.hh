@@ -0,0 +1,70 @@
+// Suffix arrays over word-id text: linear-time construction (SA-IS), the LCP
+// array, and a persistent on-disk index that can be memory mapped.
+
+#ifndef UTIL_SUFFIX_ARRAY_H
+#define UTIL_SUFFIX_ARRAY_H
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace util {
+
+// Fill out[0,size) with the suffix array of text, whose symbols must be in
+// [0, alphabet).  A suffix that is a prefix of another sorts first.  Uses the
+// induced sorting algorithm of Nong, Zhang and Chan (2009): O(size) time and
+// O(size + alphabet) extra memory, regardless of how repetitive the text is.
+void BuildSuffixArray(const uint32_t *text, std::size_t size, uint32_t alphabet, uint32_t *out);
+
+// Fill lcp[0,size) with the length of the longest common prefix of the
+// suffixes at sa[i-1] and sa[i]; lcp[0] is 0.  Kasai et al. (2001), O(size).
+void BuildLCP(const uint32_t *text, std::size_t size, const uint32_t *sa, uint32_t *lcp);
+
+// Map each word id to its rank in byte-wise string order of the vocabulary,
+// so that integer comparison of ranks agrees with comparing the strings.
+void RankVocabulary(const std::vector<std::string> &vocab, std::vector<uint32_t> &rank);
+
+/* Persistent suffix array index, built once and memory mapped by every
+ * process that uses it.  Layout (native endian):
+ *   header (magic, version, size of text, size of vocabulary, vocabulary bytes)
+ *   vocabulary strings in id order, each followed by '\0', padded to 8 bytes
+ *   text[size]  word ids
+ *   sa[size]    suffix array (positions in text), in string order of the words
+ *   lcp[size]   LCP array of sa
+ */
+class SuffixArrayFile {
+  public:
+    // Does the file start with the magic string of this format?
+    static bool Recognize(const char *file);
+
+    // Write text with its suffix array and LCP array, as built by
+    // BuildSuffixArray and BuildLCP over the ranks of the words.
+    static void Write(const char *file, const std::vector<std::string> &vocab, const uint32_t *text, const uint32_t *sa, const uint32_t *lcp, std::size_t size);
+
+    explicit SuffixArrayFile(const char *file, LoadMethod method = LAZY);
+
+    std::size_t Size() const { return size_; }
+
+    const uint32_t *Text() const { return text_; }
+    const uint32_t *Array() const { return sa_; }
+    const uint32_t *LCP() const { return lcp_; }
+
+    std::size_t VocabSize() const { return vocab_.size(); }
+    StringPiece Word(uint32_t id) const { return vocab_[id]; }
+
+  private:
+    scoped_memory mem_;
+
+    std::size_t size_;
+    const uint32_t *text_, *sa_, *lcp_;
+
+    std::vector<StringPiece> vocab_;
+};
+
+} // namespace util
+
+#endif // UTIL_SUFFIX_ARRAY_H
@@ -0,0 +1,111 @@
+#include "util/suffix_array.hh"
+
+#include "util/file.hh"
+
+#define BOOST_TEST_MODULE SuffixArrayTest
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace util {
+namespace {
+
+struct SuffixLess {
+  explicit SuffixLess(const std::vector<uint32_t> &text) : text_(text) {}
+  bool operator()(uint32_t a, uint32_t b) const {
+    return std::lexicographical_compare(text_.begin() + a, text_.end(), text_.begin() + b, text_.end());
+  }
+  const std::vector<uint32_t> &text_;
+};
+
+void CheckAgainstNaive(const std::vector<uint32_t> &text, uint32_t alphabet) {
+  std::vector<uint32_t> expected(text.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) expected[i] = i;
+  std::sort(expected.begin(), expected.end(), SuffixLess(text));
+
+  std::vector<uint32_t> sa(text.size()), lcp(text.size());
+  if (text.empty()) return;
+  BuildSuffixArray(&text[0], text.size(), alphabet, &sa[0]);
+  BOOST_CHECK(expected == sa);
+
+  BuildLCP(&text[0], text.size(), &sa[0], &lcp[0]);
+  BOOST_CHECK_EQUAL(0U, lcp[0]);
+  for (std::size_t i = 1; i < text.size(); ++i) {
+    uint32_t h = 0;
+    while (sa[i - 1] + h < text.size() && sa[i] + h < text.size() && text[sa[i - 1] + h] == text[sa[i] + h]) ++h;
+    BOOST_CHECK_EQUAL(h, lcp[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Small) {
+  std::vector<uint32_t> text;
+  CheckAgainstNaive(text, 1);
+  text.push_back(0);
+  CheckAgainstNaive(text, 1);
+  text.push_back(0);
+  CheckAgainstNaive(text, 1);
+  // banana
+  const uint32_t banana[] = {1, 0, 2, 0, 2, 0};
+  text.assign(banana, banana + 6);
+  CheckAgainstNaive(text, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Repetitive) {
+  std::vector<uint32_t> text(1000, 7);
+  CheckAgainstNaive(text, 8);
+  for (std::size_t i = 0; i < text.size(); i += 3) text[i] = 2;
+  CheckAgainstNaive(text, 8);
+}
+
+BOOST_AUTO_TEST_CASE(Random) {
+  std::srand(42);
+  for (unsigned int round = 0; round < 200; ++round) {
+    uint32_t alphabet = 1 + std::rand() % 6;
+    std::vector<uint32_t> text(1 + std::rand() % 300);
+    for (std::size_t i = 0; i < text.size(); ++i) text[i] = std::rand() % alphabet;
+    CheckAgainstNaive(text, alphabet);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FileRoundTrip) {
+  std::vector<std::string> vocab;
+  vocab.push_back("the");
+  vocab.push_back("cat");
+  vocab.push_back("<s>");
+  vocab.push_back("sat");
+  const uint32_t words[] = {0, 1, 3, 2, 0, 3, 2};
+  std::vector<uint32_t> text(words, words + 7);
+
+  scoped_fd temp(MakeTemp("suffix_array_test"));
+  std::string name(NameFromFD(temp.get()));
+  std::vector<uint32_t> rank, ranked;
+  RankVocabulary(vocab, rank);
+  for (std::size_t i = 0; i < text.size(); ++i) ranked.push_back(rank[text[i]]);
+  std::vector<uint32_t> sa(text.size()), lcp(text.size());
+  BuildSuffixArray(&ranked[0], ranked.size(), vocab.size(), &sa[0]);
+  BuildLCP(&ranked[0], ranked.size(), &sa[0], &lcp[0]);
+  SuffixArrayFile::Write(name.c_str(), vocab, &text[0], &sa[0], &lcp[0], text.size());
+  BOOST_CHECK(SuffixArrayFile::Recognize(name.c_str()));
+
+  SuffixArrayFile file(name.c_str());
+  BOOST_REQUIRE_EQUAL(text.size(), file.Size());
+  BOOST_REQUIRE_EQUAL(vocab.size(), file.VocabSize());
+  for (std::size_t i = 0; i < vocab.size(); ++i) {
+    BOOST_CHECK_EQUAL(StringPiece(vocab[i]), file.Word(i));
+  }
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    BOOST_CHECK_EQUAL(text[i], file.Text()[i]);
+    BOOST_CHECK_EQUAL(sa[i], file.Array()[i]);
+    BOOST_CHECK_EQUAL(lcp[i], file.LCP()[i]);
+  }
+  // Suffixes are in string order of the words: "<s>" < "cat" < "sat" < "the".
+  for (std::size_t i = 1; i < text.size(); ++i) {
+    BOOST_CHECK(vocab[text[sa[i - 1]]] <= vocab[text[sa[i]]]);
+  }
+  std::remove(name.c_str());
+}
+
+} // namespace
+} // namespace util